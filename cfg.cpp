@@ -24,19 +24,24 @@
 #include <cstdio>
 #include <cctype>
 #include <cfloat>
+#include <clocale>
+#include <cmath>
 #include <ctime>
 #include <cinttypes>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <memory>
+#include <new>
 #include <vector>
 
 // The UnixTerminal runs a background input thread. Not needed for Windows.
-#ifdef CFG_BUILD_UNIX_TERMINAL
-    #include <atomic>
+// Thread-safe CVars also need std::this_thread::yield().
+#if defined(CFG_BUILD_UNIX_TERMINAL) || CFG_THREAD_SAFE_CVARS
     #include <thread>
-#endif // CFG_BUILD_UNIX_TERMINAL
+#endif // CFG_BUILD_UNIX_TERMINAL || CFG_THREAD_SAFE_CVARS
 
 // ========================================================
 // Configurable library macros:
@@ -109,6 +114,15 @@
     #define CFG_COMMAND_HIST_FILE "cmdhist.txt"
 #endif // CFG_COMMAND_HIST_FILE
 
+//
+// Maximum ratio of used to allocated slots in the hash tables of CVars and
+// Commands. Tables double in size when they exceed it. Lower values make
+// lookups faster at the expense of memory. Clamped to the [0.1, 0.95] range.
+//
+#ifndef CFG_HASH_TABLE_MAX_LOAD_FACTOR
+    #define CFG_HASH_TABLE_MAX_LOAD_FACTOR 0.7f
+#endif // CFG_HASH_TABLE_MAX_LOAD_FACTOR
+
 //
 // If no filename is provided to the saveConfig/reloadConfig commands,
 // this filename is used. Assumes the CWD. No paths will be created.
@@ -117,6 +131,88 @@
     #define CFG_DEFAULT_CONFIG_FILE "default.cfg"
 #endif // CFG_DEFAULT_CONFIG_FILE
 
+//
+// "saveConfig -incremental" appends the modified CVars to "<filename>.journal".
+// Once the journal has more than this many entries, it is compacted into the
+// main file by a full save. Lower values make "reloadConfig -incremental" faster,
+// at the expense of more frequent full rewrites.
+//
+#ifndef CFG_CONFIG_JOURNAL_MAX_ENTRIES
+    #define CFG_CONFIG_JOURNAL_MAX_ENTRIES 1024
+#endif // CFG_CONFIG_JOURNAL_MAX_ENTRIES
+
+//
+// Size in bytes of each block allocated by the memory arenas of managers
+// created with 'useMemoryArena'. Objects and strings of the CVars/Commands
+// are packed into these blocks, so larger sizes mean fewer allocations.
+//
+#ifndef CFG_MEMORY_ARENA_BLOCK_SIZE
+    #define CFG_MEMORY_ARENA_BLOCK_SIZE 65536
+#endif // CFG_MEMORY_ARENA_BLOCK_SIZE
+
+//
+// Values of string CVars shorter than this many chars (including the
+// null terminator) are stored inline in the CVar, without allocating.
+//
+#ifndef CFG_CVAR_STRING_INLINE_SIZE
+    #define CFG_CVAR_STRING_INLINE_SIZE 48
+#endif // CFG_CVAR_STRING_INLINE_SIZE
+
+//
+// Size in bytes of the lock-free queue used by CommandManager::submitCommandText().
+// Must be a power of two. Text submitted while the queue is full is rejected,
+// so raise it if many threads submit commands between execBufferedCommands().
+//
+#ifndef CFG_COMMAND_SUBMIT_QUEUE_SIZE
+    #define CFG_COMMAND_SUBMIT_QUEUE_SIZE 16384
+#endif // CFG_COMMAND_SUBMIT_QUEUE_SIZE
+
+//
+// Size in chars of the output buffer of the NativeTerminals. Text printed
+// to the terminal is written in blocks of up to this size, or once per
+// update(). Zero disables the batching, writing each print() immediately.
+//
+#ifndef CFG_TERMINAL_OUTPUT_BUFFER_SIZE
+    #define CFG_TERMINAL_OUTPUT_BUFFER_SIZE 16384
+#endif // CFG_TERMINAL_OUTPUT_BUFFER_SIZE
+
+//
+// Limits of the RemoteTerminalServer. Connections above the max number of
+// sessions are refused. A client that doesn't read its output and has more
+// than the max pending output chars queued up is disconnected.
+//
+#ifndef CFG_REMOTE_TERMINAL_MAX_SESSIONS
+    #define CFG_REMOTE_TERMINAL_MAX_SESSIONS 256
+#endif // CFG_REMOTE_TERMINAL_MAX_SESSIONS
+#ifndef CFG_REMOTE_TERMINAL_MAX_PENDING_OUTPUT
+    #define CFG_REMOTE_TERMINAL_MAX_PENDING_OUTPUT (1024 * 1024)
+#endif // CFG_REMOTE_TERMINAL_MAX_PENDING_OUTPUT
+
+//
+// If defined to nonzero, every allocation made through the MemoryAllocCallbacks
+// is accounted for by category (see getMemoryStats() and the 'memStats' command).
+// Each allocation then carries a small header with its size and category.
+//
+#ifndef CFG_MEMORY_STATS
+    #define CFG_MEMORY_STATS 0
+#endif // CFG_MEMORY_STATS
+
+//
+// If defined to nonzero, CommandManager::execConfigFiles() reads and
+// tokenizes the files on worker threads. Otherwise the files are
+// loaded one by one on the calling thread. Needs std::thread support,
+// and thread-safe FileIOCallbacks, MemoryAllocCallbacks and error callback.
+//
+#ifndef CFG_PARALLEL_CONFIG_LOADING
+    #define CFG_PARALLEL_CONFIG_LOADING 0
+#endif // CFG_PARALLEL_CONFIG_LOADING
+
+#if CFG_PARALLEL_CONFIG_LOADING
+    #include <condition_variable>
+    #include <mutex>
+    #include <thread>
+#endif // CFG_PARALLEL_CONFIG_LOADING
+
 //
 // Compatibility macros and includes for isatty() and friends.
 // This is only really needed for the NativeTerminal implementations.
@@ -127,6 +223,10 @@
     #if defined(__APPLE__) || defined(__linux__) || defined(__unix__)
         #include <unistd.h>        // isatty()
         #include <termios.h>       // tcsetattr/tcgetattr
+        #ifdef CFG_BUILD_UNIX_TERMINAL
+            #include <fcntl.h>     // fcntl
+            #include <poll.h>      // poll
+        #endif // CFG_BUILD_UNIX_TERMINAL
         #define CFG_ISATTY(fh)     isatty(fh)
         #define CFG_STDIN_FILENO   STDIN_FILENO
         #define CFG_STDOUT_FILENO  STDOUT_FILENO
@@ -141,6 +241,27 @@
     #endif // Apple/Win/Linux
 #endif // CFG_BUILD_UNIX_TERMINAL || CFG_BUILD_WIN_TERMINAL || CFG_USE_ANSI_COLOR_CODES
 
+//
+// POSIX sockets for the RemoteTerminalServer.
+//
+#ifdef CFG_BUILD_REMOTE_TERMINAL
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/uio.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #ifdef MSG_NOSIGNAL
+        #define CFG_SOCKET_SEND_FLAGS MSG_NOSIGNAL
+    #else // !MSG_NOSIGNAL
+        #define CFG_SOCKET_SEND_FLAGS 0 // SO_NOSIGPIPE is set on the sockets instead.
+    #endif // MSG_NOSIGNAL
+#endif // CFG_BUILD_REMOTE_TERMINAL
+
 namespace cfg
 {
 
@@ -285,15 +406,152 @@ MemoryAllocCallbacks getMemoryAllocCallbacks() noexcept
     return g_memAlloc;
 }
 
+// ========================================================
+// Memory statistics:
+// ========================================================
+
+const char * getMemoryCategoryName(const MemoryCategory category) noexcept
+{
+    static const char * const categoryNames[]
+    {
+        "hash tables",
+        "cvars",
+        "strings",
+        "value lists",
+        "commands",
+        "command buffer",
+        "terminals",
+        "memory arenas",
+        "other"
+    };
+    static_assert(lengthOfArray(categoryNames) == static_cast<int>(MemoryCategory::Count), "Keep this list in sync!");
+
+    const auto index = static_cast<int>(category);
+    return (index >= 0 && index < lengthOfArray(categoryNames)) ? categoryNames[index] : "?";
+}
+
+#if CFG_MEMORY_STATS
+
+//
+// Counters of each category, plus the total in the last entry.
+// Atomics since the terminals and the submit queue can allocate
+// from other threads. The peaks are only approximate in that case.
+//
+struct MemoryStatsCounters final
+{
+    std::atomic<std::size_t>   liveBytes;
+    std::atomic<std::size_t>   peakBytes;
+    std::atomic<std::uint64_t> allocCount;
+    std::atomic<std::uint64_t> freeCount;
+};
+
+static MemoryStatsCounters g_memStats[static_cast<int>(MemoryCategory::Count) + 1];
+
+// Placed in front of each allocation. Sized to keep the user memory max aligned.
+union MemoryStatsHeader
+{
+    struct
+    {
+        std::size_t    sizeInBytes;
+        MemoryCategory category;
+    } info;
+    std::max_align_t alignment;
+};
+
+static void memStatsUpdate(MemoryStatsCounters & counters, const std::size_t sizeInBytes, const bool isAlloc) noexcept
+{
+    if (isAlloc)
+    {
+        const std::size_t live = counters.liveBytes.fetch_add(sizeInBytes, std::memory_order_relaxed) + sizeInBytes;
+        counters.allocCount.fetch_add(1, std::memory_order_relaxed);
+
+        std::size_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+    }
+    else
+    {
+        counters.liveBytes.fetch_sub(sizeInBytes, std::memory_order_relaxed);
+        counters.freeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static void memStatsRecord(const MemoryCategory category, const std::size_t sizeInBytes, const bool isAlloc) noexcept
+{
+    memStatsUpdate(g_memStats[static_cast<int>(category)], sizeInBytes, isAlloc);
+    memStatsUpdate(g_memStats[static_cast<int>(MemoryCategory::Count)], sizeInBytes, isAlloc);
+}
+
+static MemoryCategoryStats memStatsLoad(const MemoryStatsCounters & counters) noexcept
+{
+    MemoryCategoryStats stats;
+    stats.liveBytes  = counters.liveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes  = counters.peakBytes.load(std::memory_order_relaxed);
+    stats.allocCount = counters.allocCount.load(std::memory_order_relaxed);
+    stats.freeCount  = counters.freeCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool getMemoryStats(MemoryStats * outStats) noexcept
+{
+    if (outStats == nullptr)
+    {
+        return false;
+    }
+    for (int c = 0; c < static_cast<int>(MemoryCategory::Count); ++c)
+    {
+        outStats->categories[c] = memStatsLoad(g_memStats[c]);
+    }
+    outStats->total = memStatsLoad(g_memStats[static_cast<int>(MemoryCategory::Count)]);
+    return true;
+}
+
+void resetMemoryPeaks() noexcept
+{
+    for (MemoryStatsCounters & counters : g_memStats)
+    {
+        counters.peakBytes.store(counters.liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+#else // !CFG_MEMORY_STATS
+
+bool getMemoryStats(MemoryStats * outStats) noexcept
+{
+    if (outStats != nullptr)
+    {
+        std::memset(outStats, 0, sizeof(*outStats));
+    }
+    return false;
+}
+
+void resetMemoryPeaks() noexcept
+{ }
+
+#endif // CFG_MEMORY_STATS
+
 // ========================================================
 // Internal memory allocator:
 // ========================================================
 
 template<typename T>
-static T * memAlloc(const std::size_t countInItems)
+static T * memAlloc(const std::size_t countInItems, const MemoryCategory category = MemoryCategory::Other)
 {
     CFG_ASSERT(countInItems != 0);
+    #if CFG_MEMORY_STATS
+    const std::size_t sizeInBytes = countInItems * sizeof(T);
+    auto header = static_cast<MemoryStatsHeader *>(g_memAlloc.alloc(sizeof(MemoryStatsHeader) + sizeInBytes, g_memAlloc.userContext));
+    if (header == nullptr)
+    {
+        return nullptr;
+    }
+    header->info.sizeInBytes = sizeInBytes;
+    header->info.category    = category;
+    memStatsRecord(category, sizeInBytes, true);
+    return reinterpret_cast<T *>(header + 1);
+    #else // !CFG_MEMORY_STATS
+    (void)category;
     return static_cast<T *>(g_memAlloc.alloc(countInItems * sizeof(T), g_memAlloc.userContext));
+    #endif // CFG_MEMORY_STATS
 }
 
 template<typename T>
@@ -301,8 +559,14 @@ static void memFree(T * ptrToFree) noexcept
 {
     if (ptrToFree != nullptr)
     {
-        // The incoming pointer may be const, hence the C-style cast.
+        // The incoming pointer may be const, hence the C-style casts.
+        #if CFG_MEMORY_STATS
+        auto header = (MemoryStatsHeader *)ptrToFree - 1;
+        memStatsRecord(header->info.category, header->info.sizeInBytes, false);
+        g_memAlloc.dealloc(header, g_memAlloc.userContext);
+        #else // !CFG_MEMORY_STATS
         g_memAlloc.dealloc((void *)ptrToFree, g_memAlloc.userContext);
+        #endif // CFG_MEMORY_STATS
     }
 }
 
@@ -327,6 +591,214 @@ static void destroy(T * obj) noexcept
     }
 }
 
+// ========================================================
+// template class MemAllocator:
+// ========================================================
+
+//
+// Standard allocator over memAlloc()/memFree(), so the std containers used
+// internally go through the user callbacks and are accounted to 'Category'
+// in the MemoryStats like the rest of the library allocations.
+//
+template<typename T, MemoryCategory Category>
+class MemAllocator
+{
+public:
+
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = MemAllocator<U, Category>; };
+
+    MemAllocator() noexcept = default;
+
+    template<typename U>
+    MemAllocator(const MemAllocator<U, Category> &) noexcept { }
+
+    T * allocate(const std::size_t countInItems)
+    {
+        T * ptr = memAlloc<T>(countInItems, Category);
+        if (ptr == nullptr)
+        {
+            throw std::bad_alloc{}; // Same as std::allocator. Containers can't handle a null.
+        }
+        return ptr;
+    }
+
+    void deallocate(T * ptr, std::size_t) noexcept
+    {
+        memFree(ptr);
+    }
+};
+
+template<typename T, typename U, MemoryCategory Category>
+static inline bool operator == (const MemAllocator<T, Category> &, const MemAllocator<U, Category> &) noexcept
+{
+    return true;
+}
+
+template<typename T, typename U, MemoryCategory Category>
+static inline bool operator != (const MemAllocator<T, Category> &, const MemAllocator<U, Category> &) noexcept
+{
+    return false;
+}
+
+template<typename T, MemoryCategory Category>
+using MemVector = std::vector<T, MemAllocator<T, Category>>;
+
+template<MemoryCategory Category>
+using MemString = std::basic_string<char, std::char_traits<char>, MemAllocator<char, Category>>;
+
+// ========================================================
+// class MemoryArena:
+// ========================================================
+
+//
+// Optional storage for the CVar/Command objects and their strings, owned
+// by a manager created with 'useMemoryArena'. Allocations are bump-allocated
+// from large blocks taken from memAlloc() and carry a small header with their
+// size class, so freed memory goes into a free-list for reuse by an allocation
+// of the same class. Anything above the largest class uses memAlloc() directly.
+//
+class MemoryArena final
+{
+public:
+
+    // Alignment and granularity of the allocations.
+    static constexpr std::size_t Alignment = 8;
+
+    // Not copyable.
+    MemoryArena(const MemoryArena &) = delete;
+    MemoryArena & operator = (const MemoryArena &) = delete;
+
+    MemoryArena() noexcept
+        : blocks(nullptr)
+    {
+        clearArray(freeLists);
+    }
+
+    ~MemoryArena()
+    {
+        releaseAll();
+    }
+
+    // Allocations too big for a size class are made apart, accounted to 'category'.
+    void * allocate(const std::size_t sizeInBytes, const MemoryCategory category)
+    {
+        const std::size_t units = std::max<std::size_t>((sizeInBytes + Alignment - 1) / Alignment, 1);
+        if (units > MaxSizeClass)
+        {
+            AllocHeader * header = memAlloc<AllocHeader>(units + 1, category);
+            (*header) = 0; // Not from a block.
+            return header + 1;
+        }
+
+        if (FreeNode * node = freeLists[units])
+        {
+            freeLists[units] = node->next;
+            return node; // Header still in place.
+        }
+
+        const std::size_t bytesNeeded = (units + 1) * Alignment;
+        if (blocks == nullptr || blocks->used + bytesNeeded > BlockSize)
+        {
+            Block * newBlock = reinterpret_cast<Block *>(memAlloc<std::uint8_t>(BlockSize, MemoryCategory::MemoryArenas));
+            newBlock->next   = blocks;
+            newBlock->used   = sizeof(Block);
+            blocks           = newBlock;
+        }
+
+        auto header = reinterpret_cast<AllocHeader *>(reinterpret_cast<std::uint8_t *>(blocks) + blocks->used);
+        blocks->used += bytesNeeded;
+        (*header) = units;
+        return header + 1;
+    }
+
+    void deallocate(const void * ptr) noexcept
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+
+        // The incoming pointer may be const, hence the C-style cast.
+        AllocHeader * header = (AllocHeader *)ptr - 1;
+        if (*header == 0)
+        {
+            memFree(header);
+            return;
+        }
+
+        auto node = static_cast<FreeNode *>((void *)ptr);
+        node->next = freeLists[*header];
+        freeLists[*header] = node;
+    }
+
+    // Frees all the blocks at once. The objects in the arena must
+    // have been destroyed first, since that also frees the allocations
+    // that didn't fit in a size class.
+    void releaseAll() noexcept
+    {
+        while (blocks != nullptr)
+        {
+            Block * next = blocks->next;
+            memFree(blocks);
+            blocks = next;
+        }
+        clearArray(freeLists);
+    }
+
+private:
+
+    static constexpr std::size_t MaxSizeClass = 64; // In Alignment units. Larger sizes use memAlloc().
+    static constexpr std::size_t BlockSize    = CFG_MEMORY_ARENA_BLOCK_SIZE;
+    static_assert(BlockSize >= 1024, "CFG_MEMORY_ARENA_BLOCK_SIZE too small!");
+
+    using AllocHeader = std::uint64_t; // Size class in Alignment units, or zero if not from a block.
+
+    struct FreeNode
+    {
+        FreeNode * next;
+    };
+
+    struct Block
+    {
+        Block *     next;
+        std::size_t used; // Bytes used, including this header.
+    };
+
+    Block *    blocks;                      // Newest block first. Allocations only come from the first one.
+    FreeNode * freeLists[MaxSizeClass + 1]; // Freed allocations of each size class.
+};
+
+//
+// memAlloc/memFree variants that use the arena if not null.
+//
+template<typename T>
+static T * memAlloc(MemoryArena * arena, const std::size_t countInItems, const MemoryCategory category)
+{
+    static_assert(alignof(T) <= MemoryArena::Alignment, "Type is over-aligned for the MemoryArena!");
+    CFG_ASSERT(countInItems != 0);
+    if (arena == nullptr)
+    {
+        return memAlloc<T>(countInItems, category);
+    }
+    return static_cast<T *>(arena->allocate(countInItems * sizeof(T), category));
+}
+
+template<typename T>
+static void memFree(MemoryArena * arena, T * ptrToFree) noexcept
+{
+    if (arena == nullptr)
+    {
+        memFree(ptrToFree);
+    }
+    else
+    {
+        arena->deallocate(ptrToFree);
+    }
+}
+
 // ========================================================
 // class DefaultFileIOCallbacksStdIn:
 // ========================================================
@@ -345,7 +817,8 @@ public:
         }
 
         FILE * file;
-        const char * const modeStr = (mode == FileOpenMode::Read ? "rt" : "wt");
+        static const char * const modeStrings[]{ "rt", "wt", "rb", "wb", "at" };
+        const char * const modeStr = modeStrings[static_cast<int>(mode)];
 
         // fopen_s avoids a deprecation warning for std::fopen on MSVC.
         #ifdef _MSC_VER
@@ -436,6 +909,51 @@ public:
             return false;
         }
     }
+
+    bool mapFile(FileHandle fh, const char ** outData, std::size_t * outSizeInChars) override
+    {
+        if (fh == nullptr || outData == nullptr || outSizeInChars == nullptr)
+        {
+            return false;
+        }
+
+        // Size of the rest of the file. In text mode this might be more than what
+        // fread() gives back (CRLF conversion), but never less, so it's a safe bound.
+        FILE * file = static_cast<FILE *>(fh);
+        const long startPos = std::ftell(file);
+        if (startPos < 0 || std::fseek(file, 0, SEEK_END) != 0)
+        {
+            return false;
+        }
+        const long endPos = std::ftell(file);
+        std::fseek(file, startPos, SEEK_SET);
+
+        if (endPos <= startPos)
+        {
+            return false; // Empty file or not seekable. Let readLine() handle it.
+        }
+
+        char * data = memAlloc<char>(static_cast<std::size_t>(endPos - startPos));
+        const std::size_t charsRead = std::fread(data, 1, static_cast<std::size_t>(endPos - startPos), file);
+
+        (*outData)        = data;
+        (*outSizeInChars) = charsRead;
+        return true;
+    }
+
+    void unmapFile(FileHandle /* fh */, const char * data) override
+    {
+        memFree(data);
+    }
+
+    bool writeBytes(FileHandle fh, const void * data, std::size_t sizeInBytes) override
+    {
+        if (fh == nullptr || data == nullptr)
+        {
+            return false;
+        }
+        return std::fwrite(data, 1, sizeInBytes, static_cast<FILE *>(fh)) == sizeInBytes;
+    }
 };
 
 // ========================================================
@@ -446,26 +964,116 @@ DefaultFileIOCallbacksStdIn::~DefaultFileIOCallbacksStdIn()
 FileIOCallbacks::~FileIOCallbacks()
 { }
 
-// ========================================================
-// File IO Callbacks:
-// ========================================================
+bool FileIOCallbacks::mapFile(FileHandle, const char **, std::size_t *)
+{
+    return false;
+}
 
-// The DefaultFileIOCallbacksStdIn has an empty default constructor and destructor which
-// will probably end up stripped anyway, so we can silence these if they are being enforced.
-#ifdef __clang__
-    #pragma clang diagnostic push
-    #pragma clang diagnostic ignored "-Wexit-time-destructors"
-    #pragma clang diagnostic ignored "-Wglobal-constructors"
-#endif // __clang__
+void FileIOCallbacks::unmapFile(FileHandle, const char *)
+{ }
 
-static DefaultFileIOCallbacksStdIn g_defaultFileIO{};
-static FileIOCallbacks *           g_fileIO = &g_defaultFileIO;
+bool FileIOCallbacks::writeBytes(FileHandle, const void *, std::size_t)
+{
+    return false;
+}
 
-#ifdef __clang__
-    #pragma clang diagnostic pop
-#endif // __clang__
+// ========================================================
+// class FileLineReader:
+// ========================================================
 
-void setFileIOCallbacks(FileIOCallbacks * fileIO) noexcept
+//
+// Reads lines from a FileIOCallbacks file, using mapFile() to get the whole
+// file in one call if the callbacks support it. Lines are copied to the
+// caller's buffer following the same rules of FileIOCallbacks::readLine().
+//
+class FileLineReader final
+{
+public:
+
+    FileLineReader(const FileLineReader &) = delete;
+    FileLineReader & operator = (const FileLineReader &) = delete;
+
+    FileLineReader(FileIOCallbacks * fileIO, FileHandle fh)
+        : io(fileIO)
+        , file(fh)
+        , data(nullptr)
+        , dataSize(0)
+        , readPos(0)
+    {
+        if (!io->mapFile(file, &data, &dataSize))
+        {
+            data     = nullptr;
+            dataSize = 0;
+        }
+    }
+
+    ~FileLineReader()
+    {
+        release();
+    }
+
+    // Unmaps the file data. Must be called before closing the file.
+    void release()
+    {
+        if (data != nullptr)
+        {
+            io->unmapFile(file, data);
+            data = nullptr;
+        }
+    }
+
+    bool readLine(char * const outBuffer, const int bufferSize)
+    {
+        if (data == nullptr)
+        {
+            return !io->isAtEOF(file) && io->readLine(file, outBuffer, bufferSize);
+        }
+        if (readPos == dataSize || bufferSize <= 1)
+        {
+            return false;
+        }
+
+        // Like fgets(), a line longer than the buffer is returned in pieces.
+        const std::size_t maxChars = std::min(dataSize - readPos, static_cast<std::size_t>(bufferSize - 1));
+        const char * const lineStart = data + readPos;
+        const char * const newline   = static_cast<const char *>(std::memchr(lineStart, '\n', maxChars));
+        const std::size_t  lineChars = (newline != nullptr) ? static_cast<std::size_t>(newline - lineStart) + 1 : maxChars;
+
+        std::memcpy(outBuffer, lineStart, lineChars);
+        outBuffer[lineChars] = '\0';
+        readPos += lineChars;
+        return true;
+    }
+
+private:
+
+    FileIOCallbacks * io;
+    FileHandle        file;
+    const char *      data;
+    std::size_t       dataSize;
+    std::size_t       readPos;
+};
+
+// ========================================================
+// File IO Callbacks:
+// ========================================================
+
+// The DefaultFileIOCallbacksStdIn has an empty default constructor and destructor which
+// will probably end up stripped anyway, so we can silence these if they are being enforced.
+#ifdef __clang__
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wexit-time-destructors"
+    #pragma clang diagnostic ignored "-Wglobal-constructors"
+#endif // __clang__
+
+static DefaultFileIOCallbacksStdIn g_defaultFileIO{};
+static FileIOCallbacks *           g_fileIO = &g_defaultFileIO;
+
+#ifdef __clang__
+    #pragma clang diagnostic pop
+#endif // __clang__
+
+void setFileIOCallbacks(FileIOCallbacks * fileIO) noexcept
 {
     if (fileIO == nullptr) // Use null to restore the default.
     {
@@ -556,18 +1164,32 @@ static int copyString(char * dest, int destSizeInChars, const char * source)
     return static_cast<int>(ptr - dest - 1);
 }
 
-static char * cloneString(const char * const src)
+// Copies 'length' chars of source, truncating to fit dest, which is always null terminated.
+// Returns the length of source, so a return >= destSizeInChars means the output was truncated.
+static int copyStringTruncated(char * const dest, const int destSizeInChars,
+                               const char * const source, const int length)
+{
+    if (dest != nullptr && destSizeInChars > 0)
+    {
+        const int count = std::min(length, destSizeInChars - 1);
+        std::memcpy(dest, source, count);
+        dest[count] = '\0';
+    }
+    return length;
+}
+
+static char * cloneString(const char * const src, MemoryArena * arena = nullptr)
 {
     CFG_ASSERT(src != nullptr);
 
     const int len = lengthOfString(src) + 1;
-    char * newString = memAlloc<char>(len);
+    char * newString = memAlloc<char>(arena, len, MemoryCategory::Strings);
     copyString(newString, len, src);
 
     return newString;
 }
 
-static const char ** cloneStringArray(const char ** strings)
+static const char ** cloneStringArray(const char ** strings, MemoryArena * arena = nullptr)
 {
 // Good ol _CRT_SECURE_NO_WARNINGS for strcpy.
 #ifdef _MSC_VER
@@ -592,7 +1214,7 @@ static const char ** cloneStringArray(const char ** strings)
 
     // Allocate everything (pointers + strings) as a single memory chunk:
     const std::size_t pointerBytes = (i + 1) * sizeof(char *);
-    ptr = reinterpret_cast<const char **>(memAlloc<std::uint8_t>(pointerBytes + totalLength));
+    ptr = reinterpret_cast<const char **>(memAlloc<std::uint8_t>(arena, pointerBytes + totalLength, MemoryCategory::ValueLists));
     str = reinterpret_cast<char *>(reinterpret_cast<std::uint8_t *>(ptr) + pointerBytes);
 
     for (i = 0; strings[i] != nullptr; ++i)
@@ -611,7 +1233,14 @@ static const char ** cloneStringArray(const char ** strings)
 #endif // _MSC_VER
 }
 
-static int compareStringsNoCase(const char * s1, const char * s2, std::uint32_t count)
+// Lowers ASCII letters only, independent of the current locale, like
+// compareStringsNoCase() and the constexpr HashedName::hashOf() do.
+static inline char asciiToLower(const char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static int compareStringsNoCase(const char * s1, const char * s2, std::uint32_t count = ~0u)
 {
     CFG_ASSERT(s1 != nullptr);
     CFG_ASSERT(s2 != nullptr);
@@ -756,6 +1385,7 @@ static bool intToString(std::uint64_t number, char * dest, const int destSizeInC
     return true;
 }
 
+#ifdef CFG_FLOAT_PRINT_FMT // Only needed for the snprintf() float conversion.
 static int trimTrailingZeros(char * str)
 {
     CFG_ASSERT(str != nullptr);
@@ -790,5809 +1420,12780 @@ static int trimTrailingZeros(char * str)
     }
     return length;
 }
+#endif // CFG_FLOAT_PRINT_FMT
 
 // ========================================================
-// StringHasher/StringHasherNoCase Functors:
-//
-// Simple and fast One-at-a-Time (OAT) hash algorithm:
-// http://en.wikipedia.org/wiki/Jenkins_hash_function
+// Number <=> string conversions:
 // ========================================================
 
-struct StringHasher final
+//
+// Locale-independent replacements for strtoll(), strtod() and
+// snprintf("%g") used by the CVar value conversions. Parsing works
+// on (ptr, length) strings and formatting into fixed buffers.
+//
+
+static inline bool isDecimalDigit(const int c) noexcept
 {
-    std::uint32_t operator()(const char * str) const
-    {
-        CFG_ASSERT(str != nullptr);
+    return c >= '0' && c <= '9';
+}
 
-        std::uint32_t h = 0;
-        while (*str != '\0')
-        {
-            h += *str++;
-            h += (h << 10);
-            h ^= (h >> 6);
-        }
+// Value of a digit in base 16 or 99 if not a digit.
+static inline int digitValue(const int c) noexcept
+{
+    if (c >= '0' && c <= '9') { return c - '0'; }
+    if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+    if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+    return 99;
+}
 
-        h += (h << 3);
-        h ^= (h >> 11);
-        h += (h << 15);
-        return h;
+// Same set of chars as std::isspace() in the "C" locale.
+static inline const char * skipNumberWhitespace(const char * ptr, const char * const end) noexcept
+{
+    while (ptr != end && (*ptr == ' ' || (*ptr >= '\t' && *ptr <= '\r')))
+    {
+        ++ptr;
     }
-};
+    return ptr;
+}
 
-struct StringHasherNoCase final
+int parseInt64(const char * const str, const int length, std::int64_t * outValue)
 {
-    std::uint32_t operator()(const char * str) const
+    CFG_ASSERT(str != nullptr && outValue != nullptr);
+
+    const char * const end = str + length;
+    const char * ptr = skipNumberWhitespace(str, end);
+
+    bool negative = false;
+    if (ptr != end && (*ptr == '+' || *ptr == '-'))
     {
-        CFG_ASSERT(str != nullptr);
+        negative = (*ptr++ == '-');
+    }
 
-        std::uint32_t h = 0;
-        while (*str != '\0')
+    // Base prefixes as in strtoll(str, nullptr, 0): "0x" hexadecimal, "0" octal.
+    int base = 10;
+    if (ptr != end && *ptr == '0')
+    {
+        if ((end - ptr) > 2 && (ptr[1] == 'x' || ptr[1] == 'X') && digitValue(ptr[2]) < 16)
         {
-            h += std::tolower(*str++);
-            h += (h << 10);
-            h ^= (h >> 6);
+            base = 16;
+            ptr += 2;
+        }
+        else
+        {
+            base = 8; // The leading zero is an octal digit itself.
         }
-
-        h += (h << 3);
-        h ^= (h >> 11);
-        h += (h << 15);
-        return h;
     }
-};
 
-// ========================================================
-// class HashTableLink:
-//
-// Commands and CVars are stored in a linked hash table
-// to accelerate lookup by name. We use an intrusive data
-// structure to avoid additional memory allocations, so
-// CommandHandler and CVar classes must inherit from this
-// node type to be able to insert themselves into the HT.
-// ========================================================
+    // Above the cutoff, value * base + digit overflows 64 bits.
+    const char * const firstDigit   = ptr;
+    const std::uint64_t cutoff      = (base == 10 ? ~0ull / 10 : (base == 16 ? ~0ull / 16 : ~0ull / 8));
+    const int           cutoffDigit = (base == 10 ? 5 : (base == 16 ? 15 : 7));
+    std::uint64_t value = 0;
+    bool overflow = false;
 
-#if CFG_PACK_STRUCTURES
-    #pragma pack(push, 1)
-#endif // CFG_PACK_STRUCTURES
+    // Common case: the first 18 decimal digits can't overflow.
+    if (base == 10)
+    {
+        const char * const fastEnd = ptr + std::min(static_cast<int>(end - ptr), 18);
+        for (; ptr != fastEnd && isDecimalDigit(*ptr); ++ptr)
+        {
+            value = value * 10 + static_cast<std::uint64_t>(*ptr - '0');
+        }
+    }
 
-template<typename T>
-class HashTableLink
-{
-public:
+    for (int digit; ptr != end && (digit = digitValue(*ptr)) < base; ++ptr)
+    {
+        if (value > cutoff || (value == cutoff && digit > cutoffDigit))
+        {
+            overflow = true;
+        }
+        else
+        {
+            value = value * base + digit;
+        }
+    }
 
-    template<typename IT, typename HF>
-    friend class LinkedHashTable;
+    if (ptr == firstDigit)
+    {
+        *outValue = 0;
+        return 0;
+    }
 
-    HashTableLink() = default;
+    // Out of range values are clamped, like strtoll() does.
+    const std::uint64_t limit = (negative ? static_cast<std::uint64_t>(INT64_MAX) + 1 : INT64_MAX);
+    if (overflow || value > limit)
+    {
+        value = limit;
+    }
 
-    T * getNext() const noexcept
+    if (negative)
     {
-        return listNext;
+        *outValue = (value == limit ? INT64_MIN : -static_cast<std::int64_t>(value));
     }
-    std::uint32_t getHashKey() const noexcept
+    else
     {
-        return hashKey;
+        *outValue = static_cast<std::int64_t>(value);
     }
+    return static_cast<int>(ptr - str);
+}
 
-protected:
-
-    // Hash links are not meant to be directly deleted,
-    // so we don't need a public virtual destructor.
-    ~HashTableLink() = default;
-
-    std::uint32_t hashKey = 0; // Hash value of the node's key. Never zero for a linked node.
-    T * hashNext = nullptr;    // Link to next element in the hash table bucket chain. Null for the last node.
-    T * listNext = nullptr;    // Link to next element is the singly-linked list of all nodes. Null for the last node.
-};
-
-#if CFG_PACK_STRUCTURES
-    #pragma pack(pop)
-#endif // CFG_PACK_STRUCTURES
-
-// ========================================================
-// class LinkedHashTable:
 //
-// The intrusive hash table template used to order
-// Commands and CVars by name. Elements must inherit
-// from HashTableLink to be inserted into this data
-// structure. It doesn't own the nodes, so the table
-// won't try to delete the objects upon destruction.
-// The size of the table in buckets is fixed and never
-// changes once constructed. We supply a reasonable
-// default (DefaultHTSizeHint) that should be enough for
-// most applications. The only issue of getting close
-// to the hash table max size is that item collisions
-// increase, but the structure should continue to work
-// just fine. Key type is fixed to C-style char* strings.
-// ========================================================
-
-template<typename T, typename HF>
-class LinkedHashTable final
+// Slow path of parseDouble() for the cases it can't handle exactly.
+// strtod() is correctly rounded, but expects the decimal point of the
+// current locale, so the local copy of the string is patched for it.
+//
+static int parseDoubleWithStrtod(const char * const str, const int length, double * outValue)
 {
-public:
+    char tempStr[128];
+    const char decimalPoint = *std::localeconv()->decimal_point;
 
-    // Default value: A prime number close to 1024.
-    // If redefining this, make sure to keep it a prime
-    // number to ensure a lower number of hash key collisions.
-    // Larger values should improve lookup speed, but will use
-    // more memory (each table entry is the size of a pointer).
-    static constexpr int DefaultHTSizeHint = 1033;
+    int count = 0;
+    for (; count < length && count < lengthOfArray(tempStr) - 1; ++count)
+    {
+        // The locale point would be taken as a decimal point too, so stop at it.
+        if (str[count] == decimalPoint && decimalPoint != '.')
+        {
+            break;
+        }
+        tempStr[count] = (str[count] == '.' ? decimalPoint : str[count]);
+    }
+    tempStr[count] = '\0';
 
-    // User provided hash functor.
-    // Takes a string and returns an unsigned integer.
-    // See the above StringHasher/StringHasherNoCase.
-    using HashFunc = HF;
+    char * endPtr = nullptr;
+    *outValue = std::strtod(tempStr, &endPtr);
 
-    // Not copyable.
-    LinkedHashTable(const LinkedHashTable &) = delete;
-    LinkedHashTable & operator = (const LinkedHashTable &) = delete;
+    if (endPtr == nullptr || endPtr == tempStr)
+    {
+        *outValue = 0.0;
+        return 0;
+    }
+    return static_cast<int>(endPtr - tempStr);
+}
 
-    LinkedHashTable() = default;
-    ~LinkedHashTable() { deallocate(); }
+int parseDouble(const char * const str, const int length, double * outValue)
+{
+    CFG_ASSERT(str != nullptr && outValue != nullptr);
 
-    void allocate(const int sizeInBuckets = DefaultHTSizeHint)
+    // Powers of ten that are exactly representable as doubles.
+    static const double exactPowersOf10[]
     {
-        if (table != nullptr)
-        {
-            return; // Already allocated.
-        }
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
 
-        table = memAlloc<T *>(sizeInBuckets);
-        bucketCount = sizeInBuckets;
-        clearArray(table, sizeInBuckets);
+    const char * const end = str + length;
+    const char * ptr = skipNumberWhitespace(str, end);
+    const char * const numberStart = ptr;
+
+    bool negative = false;
+    if (ptr != end && (*ptr == '+' || *ptr == '-'))
+    {
+        negative = (*ptr++ == '-');
     }
 
-    void deallocate() noexcept
+    // Hexadecimal floats, "inf" and "nan" are left to strtod().
+    if (ptr == end || (!isDecimalDigit(*ptr) && *ptr != '.') ||
+        ((end - ptr) > 1 && ptr[0] == '0' && (ptr[1] == 'x' || ptr[1] == 'X')))
     {
-        memFree(table);
-        table       = nullptr;
-        listHead    = nullptr;
-        bucketCount = 0;
-        usedBuckets = 0;
+        const int offset = static_cast<int>(numberStart - str);
+        const int count  = parseDoubleWithStrtod(numberStart, length - offset, outValue);
+        return (count != 0 ? count + offset : 0);
     }
 
-    T * findByKey(const char * const key) const
+    // Up to 19 significant digits fit in the 64 bits mantissa.
+    std::uint64_t mantissa = 0;
+    int  mantissaDigits = 0;
+    int  exponent       = 0;
+    bool anyDigits      = false;
+    bool truncated      = false;
+
+    for (; ptr != end && isDecimalDigit(*ptr); ++ptr)
     {
-        CFG_ASSERT(key != nullptr);
-        if (isEmpty())
+        anyDigits = true;
+        const int digit = *ptr - '0';
+        if (mantissaDigits < 19)
         {
-            return nullptr;
+            mantissa = mantissa * 10 + digit;
+            mantissaDigits += (mantissa != 0); // Leading zeros don't count.
         }
+        else
+        {
+            ++exponent;
+            truncated |= (digit != 0);
+        }
+    }
 
-        const std::uint32_t hashKey = hashOf(key);
-        for (T * node = table[hashKey % bucketCount]; node; node = node->hashNext)
+    if (ptr != end && *ptr == '.')
+    {
+        for (++ptr; ptr != end && isDecimalDigit(*ptr); ++ptr)
         {
-            if (hashKey == node->hashKey)
+            anyDigits = true;
+            const int digit = *ptr - '0';
+            if (mantissaDigits < 19)
             {
-                return node;
+                mantissa = mantissa * 10 + digit;
+                mantissaDigits += (mantissa != 0);
+                --exponent;
+            }
+            else
+            {
+                truncated |= (digit != 0);
             }
         }
-        return nullptr; // Not found.
     }
 
-    void linkWithKey(T * node, const char * const key)
+    if (!anyDigits)
     {
-        CFG_ASSERT(key  != nullptr);
-        CFG_ASSERT(node != nullptr);
-        CFG_ASSERT(node->hashKey == 0); // Can't be linked more than once!
-
-        allocate(); // Ensure buckets are allocated if this is the first use.
-
-        const std::uint32_t hashKey = hashOf(key);
-        const std::uint32_t bucket  = hashKey % bucketCount;
-
-        // Make the new head node of its chain:
-        node->hashKey  = hashKey;
-        node->hashNext = table[bucket];
-        table[bucket]  = node;
-
-        // Prepend to the sequential chain of all nodes:
-        node->listNext = listHead;
-        listHead = node;
-
-        ++usedBuckets;
+        *outValue = 0.0;
+        return 0;
     }
 
-    T * unlinkByKey(const char * const key)
+    // The exponent is only consumed if it has digits.
+    if (ptr != end && (*ptr == 'e' || *ptr == 'E'))
     {
-        CFG_ASSERT(key != nullptr);
-        if (isEmpty())
+        const char * expPtr = ptr + 1;
+        bool negativeExp = false;
+        if (expPtr != end && (*expPtr == '+' || *expPtr == '-'))
         {
-            return nullptr;
+            negativeExp = (*expPtr++ == '-');
         }
-
-        const std::uint32_t hashKey = hashOf(key);
-        const std::uint32_t bucket  = hashKey % bucketCount;
-
-        T * previous = nullptr;
-        for (T * node = table[bucket]; node;)
+        if (expPtr != end && isDecimalDigit(*expPtr))
         {
-            if (hashKey == node->hashKey)
+            int expValue = 0;
+            for (; expPtr != end && isDecimalDigit(*expPtr); ++expPtr)
             {
-                if (previous != nullptr)
+                if (expValue < 100000)
                 {
-                    // Not the head of the chain, remove from middle:
-                    previous->hashNext = node->hashNext;
+                    expValue = expValue * 10 + (*expPtr - '0');
                 }
-                else if (node == table[bucket] && node->hashNext == nullptr)
-                {
-                    // Single node bucket, clear the entry:
-                    table[bucket] = nullptr;
-                }
-                else if (node == table[bucket] && node->hashNext != nullptr)
-                {
-                    // Head of chain with other node(s) following:
-                    table[bucket] = node->hashNext;
-                }
-                else
-                {
-                    errorF("LinkedHashTable bucket chain is corrupted!");
-                    return nullptr;
-                }
-
-                node->hashNext = nullptr;
-                node->hashKey  = 0;
-                unlinkFromList(node);
-                --usedBuckets;
-                return node;
             }
-
-            previous = node;
-            node = node->hashNext;
+            exponent += (negativeExp ? -expValue : expValue);
+            ptr = expPtr;
         }
-
-        return nullptr; // No such node with the given key.
     }
 
-    // Misc accessors:
-    T *  getFirst() const noexcept { return listHead; }
-    int  getSize()  const noexcept { return usedBuckets; }
-    bool isEmpty()  const noexcept { return usedBuckets == 0; }
-
-private:
-
-    std::uint32_t hashOf(const char * const key) const
-    {
-        const std::uint32_t hashKey = HashFunc{}(key);
-        CFG_ASSERT(hashKey != 0 && "Null hash indexes not allowed!");
-        return hashKey;
-    }
-
-    void unlinkFromList(T * node)
+    if (!truncated)
     {
-        if (node == listHead) // Easy case, remove the fist node.
+        while (mantissa != 0 && (mantissa % 10) == 0)
         {
-            listHead = listHead->listNext;
-            node->listNext = nullptr;
-            return;
+            mantissa /= 10;
+            ++exponent;
         }
 
-        T * curr = listHead;
-        T * prev = nullptr;
-
-        // Find the element before the node to remove:
-        while (curr != node)
+        // Both the mantissa and the power of ten are exact, so a single
+        // multiply or divide gives the correctly rounded result (Clinger's fast path).
+        if (mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
         {
-            prev = curr;
-            curr = curr->listNext;
+            double value = static_cast<double>(mantissa);
+            value = (exponent < 0 ? value / exactPowersOf10[-exponent] : value * exactPowersOf10[exponent]);
+            *outValue = (negative ? -value : value);
+            return static_cast<int>(ptr - str);
         }
+    }
 
-        // Should have found the node somewhere...
-        CFG_ASSERT(curr != nullptr);
-        CFG_ASSERT(prev != nullptr);
+    // Long mantissas or large exponents need the correctly rounded strtod().
+    const int offset = static_cast<int>(numberStart - str);
+    const int count  = parseDoubleWithStrtod(numberStart, static_cast<int>(ptr - numberStart), outValue);
+    return (count != 0 ? count + offset : 0);
+}
 
-        // Unlink the node by pointing its previous element to what was after it:
-        prev->listNext = node->listNext;
-        node->listNext = nullptr;
-    }
+int formatInt64(const std::int64_t value, char * const destBuf, const int destSizeInChars)
+{
+    char numStr[24];
+    char * ptr = numStr + lengthOfArray(numStr);
 
-    // Array of pointers to items (the buckets).
-    T ** table = nullptr;
+    // Digits are written backwards from the end of the temp buffer.
+    std::uint64_t number = (value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value));
+    do
+    {
+        *--ptr = static_cast<char>('0' + (number % 10));
+        number /= 10;
+    } while (number != 0);
 
-    // First node in the linked list of all table nodes.
-    // This will point to the most recently inserted item.
-    T * listHead = nullptr;
+    if (value < 0)
+    {
+        *--ptr = '-';
+    }
 
-    // Total size in buckets (items) of table[] and buckets used so far.
-    int bucketCount = 0;
-    int usedBuckets = 0;
-};
+    const int length = static_cast<int>((numStr + lengthOfArray(numStr)) - ptr);
+    return copyStringTruncated(destBuf, destSizeInChars, ptr, length);
+}
 
-// ================================================================================================
 //
-//                              CVars - Configuration Variables
+// Shortest round-trip double to string conversion with the Grisu2 algorithm:
+// "Printing Floating-Point Numbers Quickly and Accurately with Integers",
+// Florian Loitsch, 2010. The output always parses back to the same double
+// and is the shortest such string for the vast majority of values.
 //
-// ================================================================================================
-
-// ========================================================
-// CVar helpers:
-// ========================================================
-
-template<typename T>
-struct CVarNumberRange final
+namespace grisu
 {
-    T minValue = 0;
-    T maxValue = 0;
-
-    CVarNumberRange() = default;
-
-    CVarNumberRange(const T min, const T max) noexcept
-        : minValue(min)
-        , maxValue(max)
-    { }
 
-    int getCount() const noexcept
-    {
-        return 2;
-    }
+// Floating-point number with a 64 bits mantissa: f * 2^e.
+struct DiyFp final
+{
+    std::uint64_t f;
+    int           e;
 
-    T getValue(const int index) const
-    {
-        CFG_ASSERT(index >= 0 && index < getCount());
-        return (index == 0 ? minValue : maxValue);
-    }
+    DiyFp(const std::uint64_t fv, const int ev) noexcept : f(fv), e(ev) { }
 
-    void clear() noexcept
+    // Only for finite doubles > 0.
+    explicit DiyFp(const double d) noexcept
     {
-        minValue = 0;
-        maxValue = 0;
-    }
-};
+        std::uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
 
-struct CVarAllowedStrings final
-{
-    // List of strings terminated by a null entry.
-    const char ** strings = nullptr;
+        const std::uint64_t significand = bits & SignificandMask;
+        const int biasedExponent = static_cast<int>((bits & ExponentMask) >> SignificandBits);
 
-    CVarAllowedStrings(const char ** allowedStrings)
-    {
-        if (allowedStrings != nullptr)
+        if (biasedExponent != 0) // Normal
         {
-            strings = cloneStringArray(allowedStrings);
+            f = significand + HiddenBit;
+            e = biasedExponent - ExponentBias;
         }
-    }
-
-    int getCount() const noexcept
-    {
-        int n = 0;
-        if (strings != nullptr)
+        else // Subnormal
         {
-            for (; strings[n] != nullptr; ++n) { }
+            f = significand;
+            e = 1 - ExponentBias;
         }
-        return n;
     }
 
-    std::string getValue(const int index) const
+    DiyFp operator - (const DiyFp & rhs) const noexcept
     {
-        CFG_ASSERT(index >= 0 && index < getCount());
-        return strings[index];
+        return DiyFp(f - rhs.f, e);
     }
 
-    void clear() noexcept
+    // Upper 64 bits of the 128 bits product, rounded.
+    DiyFp operator * (const DiyFp & rhs) const noexcept
     {
-        memFree(strings);
-        strings = nullptr;
+        const std::uint64_t M32 = 0xFFFFFFFFull;
+        const std::uint64_t a = f >> 32;
+        const std::uint64_t b = f & M32;
+        const std::uint64_t c = rhs.f >> 32;
+        const std::uint64_t d = rhs.f & M32;
+        const std::uint64_t ac = a * c;
+        const std::uint64_t bc = b * c;
+        const std::uint64_t ad = a * d;
+        const std::uint64_t bd = b * d;
+        std::uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+        tmp += 1ull << 31;
+        return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
     }
-};
 
-struct CVarEnumConstList final
-{
-    const char  ** names  = nullptr; // List of strings terminated by a null entry.
-    std::int64_t * values = nullptr; // Corresponding values for each name.
-
-    CVarEnumConstList(const std::int64_t * enumConstants, const char ** constNames)
+    DiyFp normalize() const noexcept
     {
-        if (enumConstants != nullptr && constNames != nullptr)
+        DiyFp res = *this;
+        while (!(res.f & (1ull << 63)))
         {
-            names = cloneStringArray(constNames);
-
-            // Expect the same number of names and constant values.
-            int n = 0;
-            for (; constNames[n] != nullptr; ++n) { }
-
-            values = memAlloc<std::int64_t>(n);
-            std::memcpy(values, enumConstants, n * sizeof(std::int64_t));
+            res.f <<= 1;
+            res.e--;
         }
+        return res;
     }
 
-    int getCount() const noexcept
+    // The boundaries m- and m+ halfway to the neighbouring doubles, with the same exponent.
+    void normalizedBoundaries(DiyFp * outMinus, DiyFp * outPlus) const noexcept
     {
-        int n = 0;
-        if (names != nullptr)
+        DiyFp pl = DiyFp((f << 1) + 1, e - 1);
+        while (!(pl.f & (HiddenBit << 1)))
         {
-            for (; names[n] != nullptr; ++n) { }
+            pl.f <<= 1;
+            pl.e--;
         }
-        return n;
-    }
-
-    std::string getValue(const int index) const
-    {
-        CFG_ASSERT(index >= 0 && index < getCount());
-        return names[index];
-    }
+        pl.f <<= (64 - SignificandBits - 2);
+        pl.e -= (64 - SignificandBits - 2);
 
-    void clear() noexcept
-    {
-        memFree(names);
-        names = nullptr;
+        // The lower boundary is closer if f is a power of two.
+        DiyFp mi = (f == HiddenBit ? DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1));
+        mi.f <<= mi.e - pl.e;
+        mi.e = pl.e;
 
-        memFree(values);
-        values = nullptr;
+        *outMinus = mi;
+        *outPlus  = pl;
     }
+
+    static constexpr int           SignificandBits = 52;
+    static constexpr int           ExponentBias    = 0x3FF + SignificandBits;
+    static constexpr std::uint64_t SignificandMask = 0x000FFFFFFFFFFFFFull;
+    static constexpr std::uint64_t ExponentMask    = 0x7FF0000000000000ull;
+    static constexpr std::uint64_t HiddenBit       = 0x0010000000000000ull;
 };
 
-struct CVarEnumConst final
+// Normalized 10^k for k = -348, -340, ..., 340.
+struct CachedPower final
 {
-    const char * name;  // Pointer into the CVarEnumConstList for the CVar.
-    std::int64_t value; // Integer value of the enum constant.
+    std::uint64_t f;
+    int           e;
 };
 
-// Size of small stack-declared strings for things like number => string conversions.
-constexpr int CVarTempStrMaxSize = 128;
-
-// Format specifier to snprintf() float/double values to strings.
-// 'g'  = decimal or scientific notation, whichever is shorter.
-// '.8' = up-to eight decimal digits of precision.
-#ifndef CFG_FLOAT_PRINT_FMT
-    #define CFG_FLOAT_PRINT_FMT "%.8g"
-#endif // CFG_FLOAT_PRINT_FMT
-
-// Portability macro:
-#ifndef CFG_I64_PRINT_FMT
-    #ifdef PRIi64
-        #define CFG_I64_PRINT_FMT "%" PRIi64
-    #else // PRIi64 not defined
-        #define CFG_I64_PRINT_FMT "%lli"
-    #endif // PRIi64
-#endif // CFG_I64_PRINT_FMT
-
-// ========================================================
-// String comparators with configurable case-sensitivity:
-// ========================================================
-
-static inline int cvarCmpStrings(const char * const a, const char * const b)
-{
-    #if CFG_CVAR_CASE_SENSITIVE_STRINGS
-    return std::strcmp(a, b);
-    #else // !CFG_CVAR_CASE_SENSITIVE_STRINGS
-    return compareStringsNoCase(a, b);
-    #endif // CFG_CVAR_CASE_SENSITIVE_STRINGS
-}
+static const CachedPower cachedPowers[] =
+{
+    { 0xFA8FD5A0081C0288ull, -1220 }, { 0xBAAEE17FA23EBF76ull, -1193 },
+    { 0x8B16FB203055AC76ull, -1166 }, { 0xCF42894A5DCE35EAull, -1140 },
+    { 0x9A6BB0AA55653B2Dull, -1113 }, { 0xE61ACF033D1A45DFull, -1087 },
+    { 0xAB70FE17C79AC6CAull, -1060 }, { 0xFF77B1FCBEBCDC4Full, -1034 },
+    { 0xBE5691EF416BD60Cull, -1007 }, { 0x8DD01FAD907FFC3Cull,  -980 },
+    { 0xD3515C2831559A83ull,  -954 }, { 0x9D71AC8FADA6C9B5ull,  -927 },
+    { 0xEA9C227723EE8BCBull,  -901 }, { 0xAECC49914078536Dull,  -874 },
+    { 0x823C12795DB6CE57ull,  -847 }, { 0xC21094364DFB5637ull,  -821 },
+    { 0x9096EA6F3848984Full,  -794 }, { 0xD77485CB25823AC7ull,  -768 },
+    { 0xA086CFCD97BF97F4ull,  -741 }, { 0xEF340A98172AACE5ull,  -715 },
+    { 0xB23867FB2A35B28Eull,  -688 }, { 0x84C8D4DFD2C63F3Bull,  -661 },
+    { 0xC5DD44271AD3CDBAull,  -635 }, { 0x936B9FCEBB25C996ull,  -608 },
+    { 0xDBAC6C247D62A584ull,  -582 }, { 0xA3AB66580D5FDAF6ull,  -555 },
+    { 0xF3E2F893DEC3F126ull,  -529 }, { 0xB5B5ADA8AAFF80B8ull,  -502 },
+    { 0x87625F056C7C4A8Bull,  -475 }, { 0xC9BCFF6034C13053ull,  -449 },
+    { 0x964E858C91BA2655ull,  -422 }, { 0xDFF9772470297EBDull,  -396 },
+    { 0xA6DFBD9FB8E5B88Full,  -369 }, { 0xF8A95FCF88747D94ull,  -343 },
+    { 0xB94470938FA89BCFull,  -316 }, { 0x8A08F0F8BF0F156Bull,  -289 },
+    { 0xCDB02555653131B6ull,  -263 }, { 0x993FE2C6D07B7FACull,  -236 },
+    { 0xE45C10C42A2B3B06ull,  -210 }, { 0xAA242499697392D3ull,  -183 },
+    { 0xFD87B5F28300CA0Eull,  -157 }, { 0xBCE5086492111AEBull,  -130 },
+    { 0x8CBCCC096F5088CCull,  -103 }, { 0xD1B71758E219652Cull,   -77 },
+    { 0x9C40000000000000ull,   -50 }, { 0xE8D4A51000000000ull,   -24 },
+    { 0xAD78EBC5AC620000ull,     3 }, { 0x813F3978F8940984ull,    30 },
+    { 0xC097CE7BC90715B3ull,    56 }, { 0x8F7E32CE7BEA5C70ull,    83 },
+    { 0xD5D238A4ABE98068ull,   109 }, { 0x9F4F2726179A2245ull,   136 },
+    { 0xED63A231D4C4FB27ull,   162 }, { 0xB0DE65388CC8ADA8ull,   189 },
+    { 0x83C7088E1AAB65DBull,   216 }, { 0xC45D1DF942711D9Aull,   242 },
+    { 0x924D692CA61BE758ull,   269 }, { 0xDA01EE641A708DEAull,   295 },
+    { 0xA26DA3999AEF774Aull,   322 }, { 0xF209787BB47D6B85ull,   348 },
+    { 0xB454E4A179DD1877ull,   375 }, { 0x865B86925B9BC5C2ull,   402 },
+    { 0xC83553C5C8965D3Dull,   428 }, { 0x952AB45CFA97A0B3ull,   455 },
+    { 0xDE469FBD99A05FE3ull,   481 }, { 0xA59BC234DB398C25ull,   508 },
+    { 0xF6C69A72A3989F5Cull,   534 }, { 0xB7DCBF5354E9BECEull,   561 },
+    { 0x88FCF317F22241E2ull,   588 }, { 0xCC20CE9BD35C78A5ull,   614 },
+    { 0x98165AF37B2153DFull,   641 }, { 0xE2A0B5DC971F303Aull,   667 },
+    { 0xA8D9D1535CE3B396ull,   694 }, { 0xFB9B7CD9A4A7443Cull,   720 },
+    { 0xBB764C4CA7A44410ull,   747 }, { 0x8BAB8EEFB6409C1Aull,   774 },
+    { 0xD01FEF10A657842Cull,   800 }, { 0x9B10A4E5E9913129ull,   827 },
+    { 0xE7109BFBA19C0C9Dull,   853 }, { 0xAC2820D9623BF429ull,   880 },
+    { 0x80444B5E7AA7CF85ull,   907 }, { 0xBF21E44003ACDD2Dull,   933 },
+    { 0x8E679C2F5E44FF8Full,   960 }, { 0xD433179D9C8CB841ull,   986 },
+    { 0x9E19DB92B4E31BA9ull,  1013 }, { 0xEB96BF6EBADF77D9ull,  1039 },
+    { 0xAF87023B9BF0EE6Bull,  1066 },
+};
 
-static inline int cvarCmpNames(const char * const a, const char * const b)
+static const std::uint64_t powersOf10[] =
 {
-    #if CFG_CVAR_CASE_SENSITIVE_NAMES
-    return std::strcmp(a, b);
-    #else // !CFG_CVAR_CASE_SENSITIVE_NAMES
-    return compareStringsNoCase(a, b);
-    #endif // CFG_CVAR_CASE_SENSITIVE_NAMES
-}
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+    1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+    100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+    1000000000000000000ull, 10000000000000000000ull
+};
 
-static inline bool cvarNameStartsWith(const char * const name, const char * const prefix)
+// Cached 10^-k such that the product with a value of binary exponent 'e' has its exponent in [-60, -32].
+static DiyFp getCachedPower(const int e, int * outK) noexcept
 {
-    CFG_ASSERT(name   != nullptr);
-    CFG_ASSERT(prefix != nullptr);
-
-    const int nameLen   = lengthOfString(name);
-    const int prefixLen = lengthOfString(prefix);
-
-    if (nameLen < prefixLen)
-    {
-        return false;
-    }
-    else if (nameLen == 0 || prefixLen == 0)
+    // ceil((-61 - e) * log10(2)), offset by 347 to keep it positive.
+    const double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0)
     {
-        return false;
+        k++;
     }
 
-    #if CFG_CVAR_CASE_SENSITIVE_NAMES
-    return std::strncmp(name, prefix, prefixLen) == 0;
-    #else // !CFG_CVAR_CASE_SENSITIVE_NAMES
-    return compareStringsNoCase(name, prefix, prefixLen) == 0;
-    #endif // CFG_CVAR_CASE_SENSITIVE_NAMES
-}
+    // The table has every 8th power, starting at 10^-348.
+    const unsigned index = static_cast<unsigned>((k >> 3) + 1);
+    *outK = -(-348 + static_cast<int>(index << 3));
 
-static inline void cvarSortMatches(CVar ** outMatches, const int count)
-{
-    std::sort(outMatches, outMatches + count,
-              [](const CVar * const a, const CVar * const b)
-              {
-                  return cvarCmpNames(a->getNameCString(), b->getNameCString()) < 0;
-              });
+    CFG_ASSERT(index < sizeof(cachedPowers) / sizeof(cachedPowers[0]));
+    return DiyFp(cachedPowers[index].f, cachedPowers[index].e);
 }
 
-static inline void cvarSortMatches(const char ** outMatches, const int count)
+static int countDecimalDigits(const std::uint32_t n) noexcept
 {
-    std::sort(outMatches, outMatches + count,
-              [](const char * const a, const char * const b)
-              {
-                  return cvarCmpNames(a, b) < 0;
-              });
+    int count = 1;
+    while (count < 10 && n >= powersOf10[count])
+    {
+        ++count;
+    }
+    return count;
 }
 
-// ========================================================
-// cvarToX() functions:
-// ========================================================
-
-//
-// int64_t:
-//
-
-static inline std::int64_t cvarToInt64(const std::int64_t val)
+// Moves the last digit closer to the exact value while it stays inside the boundaries.
+static void roundWeed(char * const buffer, const int length, const std::uint64_t delta, std::uint64_t rest,
+                      const std::uint64_t tenKappa, const std::uint64_t distance) noexcept
 {
-    return val;
+    while (rest < distance && delta - rest >= tenKappa &&
+           (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance))
+    {
+        buffer[length - 1]--;
+        rest += tenKappa;
+    }
 }
 
-static inline std::int64_t cvarToInt64(const bool val)
+static int generateDigits(const DiyFp & W, const DiyFp & Mp, std::uint64_t delta, char * const buffer, int * K) noexcept
 {
-    return static_cast<std::int64_t>(val);
-}
+    const DiyFp one(1ull << -Mp.e, Mp.e);
+    const DiyFp distance = Mp - W;
 
-static inline std::int64_t cvarToInt64(const double val)
-{
-    return static_cast<std::int64_t>(val);
-}
+    std::uint32_t p1 = static_cast<std::uint32_t>(Mp.f >> -one.e);
+    std::uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa  = countDecimalDigits(p1);
+    int length = 0;
 
-static inline std::int64_t cvarToInt64(const CVarEnumConst & enumConst)
-{
-    return enumConst.value;
-}
+    // Integral part.
+    while (kappa > 0)
+    {
+        const std::uint32_t digit = static_cast<std::uint32_t>(p1 / powersOf10[kappa - 1]);
+        p1 = static_cast<std::uint32_t>(p1 % powersOf10[kappa - 1]);
+        if (digit != 0 || length != 0)
+        {
+            buffer[length++] = static_cast<char>('0' + digit);
+        }
+        kappa--;
 
-static inline std::int64_t cvarToInt64(const std::string & str, bool * outOkFlag = nullptr)
-{
-    char * endPtr   = nullptr;
-    const auto nPtr = str.c_str();
-    const auto num  = std::strtoll(nPtr, &endPtr, 0);
+        const std::uint64_t rest = (static_cast<std::uint64_t>(p1) << -one.e) + p2;
+        if (rest <= delta)
+        {
+            *K += kappa;
+            roundWeed(buffer, length, delta, rest, powersOf10[kappa] << -one.e, distance.f);
+            return length;
+        }
+    }
 
-    if (endPtr == nullptr || endPtr == nPtr)
+    // Fractional part.
+    for (;;)
     {
-        errorF("No available conversion from \"%s\" to integer number.", str.c_str());
-        if (outOkFlag != nullptr) { *outOkFlag = false; }
-        return 0;
-    }
+        p2    *= 10;
+        delta *= 10;
+        const char digit = static_cast<char>(p2 >> -one.e);
+        if (digit != 0 || length != 0)
+        {
+            buffer[length++] = static_cast<char>('0' + digit);
+        }
+        p2 &= one.f - 1;
+        kappa--;
 
-    if (outOkFlag != nullptr) { *outOkFlag = true; }
-    return num;
+        if (p2 < delta)
+        {
+            *K += kappa;
+            const int index = -kappa;
+            roundWeed(buffer, length, delta, p2, one.f, distance.f * (index < lengthOfArray(powersOf10) ? powersOf10[index] : 0));
+            return length;
+        }
+    }
 }
 
-//
-// double:
-//
-
-static inline double cvarToDouble(const std::int64_t val)
+// Writes the decimal digits of a finite double > 0 and returns
+// their count. The value is then digits * 10^outExponent.
+static int grisu2(const double value, char * const buffer, int * outExponent) noexcept
 {
-    return static_cast<double>(val);
-}
+    const DiyFp v(value);
+    DiyFp mMinus(0, 0), mPlus(0, 0);
+    v.normalizedBoundaries(&mMinus, &mPlus);
 
-static inline double cvarToDouble(const bool val)
-{
-    return static_cast<double>(val);
-}
+    const DiyFp cachedPower = getCachedPower(mPlus.e, outExponent);
+    const DiyFp W  = v.normalize() * cachedPower;
+    DiyFp       Wp = mPlus  * cachedPower;
+    DiyFp       Wm = mMinus * cachedPower;
+    Wm.f++;
+    Wp.f--;
 
-static inline double cvarToDouble(const double val)
-{
-    return val;
+    return generateDigits(W, Wp, Wp.f - Wm.f, buffer, outExponent);
 }
 
-static inline double cvarToDouble(const CVarEnumConst & enumConst)
-{
-    return static_cast<double>(enumConst.value);
-}
+} // namespace grisu
 
-static inline double cvarToDouble(const std::string & str, bool * outOkFlag = nullptr)
+int formatDouble(double value, char * const destBuf, const int destSizeInChars)
 {
-    char * endPtr   = nullptr;
-    const auto nPtr = str.c_str();
-    const auto num  = std::strtod(nPtr, &endPtr);
+    char numStr[32];
+    int length = 0;
 
-    if (endPtr == nullptr || endPtr == nPtr)
+    if (std::isnan(value))
     {
-        errorF("No available conversion from \"%s\" to floating-point number.", str.c_str());
-        if (outOkFlag != nullptr) { *outOkFlag = false; }
-        return 0.0;
+        return copyStringTruncated(destBuf, destSizeInChars, "nan", 3);
+    }
+    if (std::signbit(value))
+    {
+        numStr[length++] = '-';
+        value = -value;
+    }
+    if (value == 0.0)
+    {
+        numStr[length++] = '0';
+        return copyStringTruncated(destBuf, destSizeInChars, numStr, length);
+    }
+    if (std::isinf(value))
+    {
+        numStr[length++] = 'i';
+        numStr[length++] = 'n';
+        numStr[length++] = 'f';
+        return copyStringTruncated(destBuf, destSizeInChars, numStr, length);
     }
 
-    if (outOkFlag != nullptr) { *outOkFlag = true; }
-    return num;
-}
-
-//
-// std::string:
-//
+    char digits[20];
+    int exponent    = 0;
+    int digitCount  = 0;
 
-static inline void cvarToString(std::string * result, const std::int64_t val,
-                                const CVar::NumberFormat numberFormat)
-{
-    int base = 0;
-    switch (numberFormat)
+    // Integers below 2^53 are exact and don't need the digit generation.
+    if (value < 9007199254740992.0 && value == static_cast<double>(static_cast<std::uint64_t>(value)))
     {
-    case CVar::NumberFormat::Binary      : { base = 2;  break; }
-    case CVar::NumberFormat::Octal       : { base = 8;  break; }
-    case CVar::NumberFormat::Decimal     : { base = 10; break; }
-    case CVar::NumberFormat::Hexadecimal : { base = 16; break; }
-    } // switch (numberFormat)
+        char * ptr = digits + lengthOfArray(digits);
+        for (std::uint64_t number = static_cast<std::uint64_t>(value); number != 0; number /= 10)
+        {
+            *--ptr = static_cast<char>('0' + (number % 10));
+        }
+        digitCount = static_cast<int>((digits + lengthOfArray(digits)) - ptr);
+        std::memmove(digits, ptr, digitCount);
 
-    char numStr[CVarTempStrMaxSize];
-    intToString(static_cast<std::uint64_t>(val), numStr, lengthOfArray(numStr), base, (val < 0));
-    *result = numStr;
-}
+        // Trailing zeros go into the exponent.
+        while (digitCount > 1 && digits[digitCount - 1] == '0')
+        {
+            --digitCount;
+            ++exponent;
+        }
+    }
+    else
+    {
+        digitCount = grisu::grisu2(value, digits, &exponent);
+    }
 
-static inline void cvarToString(std::string * result, const bool val, CVar::NumberFormat)
-{
-    // For printing, the first boolean string is always the one used.
-    const BoolCStr * const bStrings = getBoolStrings();
-    *result = (val ? bStrings[0].trueStr : bStrings[0].falseStr);
-}
+    // Position of the decimal point relative to the first digit.
+    const int pointPos = digitCount + exponent;
 
-static inline void cvarToString(std::string * result, const double val, CVar::NumberFormat)
-{
-    char numStr[CVarTempStrMaxSize];
-    std::snprintf(numStr, lengthOfArray(numStr), CFG_FLOAT_PRINT_FMT, val);
-
-    const int length = trimTrailingZeros(numStr);
-    result->assign(numStr, length);
-}
-
-static inline void cvarToString(std::string * result, const CVarEnumConst & enumConst,
-                                const CVar::NumberFormat numberFormat)
-{
-    if (enumConst.name != nullptr && enumConst.name[0] != '\0')
+    if (digitCount <= pointPos && pointPos <= 21) // 1234e7 => 12340000000
     {
-        *result = enumConst.name;
+        std::memcpy(numStr + length, digits, digitCount);
+        length += digitCount;
+        for (int i = digitCount; i < pointPos; ++i)
+        {
+            numStr[length++] = '0';
+        }
     }
-    else // Reuse the int=>string conversion:
+    else if (0 < pointPos && pointPos <= 21) // 1234e-2 => 12.34
     {
-        cvarToString(result, enumConst.value, numberFormat);
+        std::memcpy(numStr + length, digits, pointPos);
+        length += pointPos;
+        numStr[length++] = '.';
+        std::memcpy(numStr + length, digits + pointPos, digitCount - pointPos);
+        length += digitCount - pointPos;
     }
-}
-
-static inline void cvarToString(std::string * result, std::string str, CVar::NumberFormat)
-{
-    *result = std::move(str);
-}
-
-// ========================================================
-// cvarSetX() functions:
-// ========================================================
-
-//
-// int64_t:
-//
-
-static inline bool cvarSetInt64(std::int64_t * outVal, const std::int64_t newVal,
-                                const CVarNumberRange<std::int64_t> * valueRange, CVar::NumberFormat)
-{
-    if (valueRange != nullptr)
+    else if (-6 < pointPos && pointPos <= 0) // 1234e-6 => 0.001234
     {
-        if (newVal < valueRange->minValue)
+        numStr[length++] = '0';
+        numStr[length++] = '.';
+        for (int i = pointPos; i < 0; ++i)
         {
-            return errorF("Value " CFG_I64_PRINT_FMT " below minimum (" CFG_I64_PRINT_FMT ").",
-                          newVal, valueRange->minValue);
+            numStr[length++] = '0';
         }
-        else if (newVal > valueRange->maxValue)
+        std::memcpy(numStr + length, digits, digitCount);
+        length += digitCount;
+    }
+    else // 1234e30 => 1.234e+33
+    {
+        numStr[length++] = digits[0];
+        if (digitCount > 1)
         {
-            return errorF("Value " CFG_I64_PRINT_FMT " above maximum (" CFG_I64_PRINT_FMT ").",
-                          newVal, valueRange->maxValue);
+            numStr[length++] = '.';
+            std::memcpy(numStr + length, digits + 1, digitCount - 1);
+            length += digitCount - 1;
         }
-    }
-    *outVal = newVal;
-    return true;
-}
 
-static inline bool cvarSetInt64(bool * outVal, const std::int64_t newVal,
-                                const CVarNumberRange<bool> *, CVar::NumberFormat)
-{
-    // Range never checked for booleans.
-    // Anything above zero is true, else false.
-    *outVal = (newVal > 0);
-    return true;
-}
+        int exp10 = pointPos - 1;
+        numStr[length++] = 'e';
+        numStr[length++] = (exp10 < 0 ? '-' : '+');
+        exp10 = (exp10 < 0 ? -exp10 : exp10);
 
-static inline bool cvarSetInt64(double * outVal, const std::int64_t newVal,
-                                const CVarNumberRange<double> * valueRange, CVar::NumberFormat)
-{
-    if (valueRange != nullptr)
-    {
-        if (newVal < valueRange->minValue)
+        if (exp10 >= 100)
         {
-            return errorF("Value " CFG_I64_PRINT_FMT " below minimum (%f).",
-                          newVal, valueRange->minValue);
+            numStr[length++] = static_cast<char>('0' + exp10 / 100);
         }
-        else if (newVal > valueRange->maxValue)
+        if (exp10 >= 10)
         {
-            return errorF("Value " CFG_I64_PRINT_FMT " above maximum (%f).",
-                          newVal, valueRange->maxValue);
+            numStr[length++] = static_cast<char>('0' + (exp10 / 10) % 10);
         }
+        numStr[length++] = static_cast<char>('0' + exp10 % 10);
     }
-    *outVal = static_cast<double>(newVal);
-    return true;
+
+    return copyStringTruncated(destBuf, destSizeInChars, numStr, length);
 }
 
-static inline bool cvarSetInt64(CVarEnumConst * outVal, const std::int64_t newVal,
-                                const CVarEnumConstList * enumConstants, CVar::NumberFormat)
+// ========================================================
+// StringHasher/StringHasherNoCase Functors:
+//
+// Simple and fast One-at-a-Time (OAT) hash algorithm:
+// http://en.wikipedia.org/wiki/Jenkins_hash_function
+// ========================================================
+
+struct StringHasher final
 {
-    if (enumConstants != nullptr && enumConstants->names != nullptr)
+    std::uint32_t operator()(const char * str) const
     {
-        for (int c = 0; enumConstants->names[c] != nullptr; ++c)
+        CFG_ASSERT(str != nullptr);
+
+        std::uint32_t h = 0;
+        while (*str != '\0')
         {
-            if (enumConstants->values[c] == newVal)
-            {
-                outVal->name  = enumConstants->names[c];
-                outVal->value = enumConstants->values[c];
-                return true;
-            }
+            h += *str++;
+            h += (h << 10);
+            h ^= (h >> 6);
         }
-        return false; // Value not a member of this enum.
-    }
-    else
-    {
-        outVal->name  = ""; // Can't figure out the constant name without a const list.
-        outVal->value = newVal;
-        return true;
+
+        h += (h << 3);
+        h ^= (h >> 11);
+        h += (h << 15);
+        return h;
     }
-}
+};
 
-static inline bool cvarSetInt64(std::string * outVal, const std::int64_t newVal,
-                                const CVarAllowedStrings * allowedStrings,
-                                const CVar::NumberFormat numberFormat)
+struct StringHasherNoCase final
 {
-    if (allowedStrings != nullptr && allowedStrings->strings != nullptr)
+    std::uint32_t operator()(const char * str) const
     {
-        std::string tempStr;
-        cvarToString(&tempStr, newVal, numberFormat);
+        CFG_ASSERT(str != nullptr);
 
-        for (int s = 0; allowedStrings->strings[s] != nullptr; ++s)
+        std::uint32_t h = 0;
+        while (*str != '\0')
         {
-            if (cvarCmpStrings(allowedStrings->strings[s], tempStr.c_str()) == 0)
-            {
-                *outVal = std::move(tempStr);
-                return true;
-            }
+            h += asciiToLower(*str++);
+            h += (h << 10);
+            h ^= (h >> 6);
         }
-        return false;
-    }
-    else
-    {
-        cvarToString(outVal, newVal, numberFormat);
-        return true;
+
+        h += (h << 3);
+        h ^= (h >> 11);
+        h += (h << 15);
+        return h;
     }
-}
+};
 
+// ========================================================
+// StringKeyCompare/StringKeyCompareNoCase Functors:
 //
-// double:
-//
+// Full key comparison done by the LinkedHashTable after
+// a hash match, so that colliding hashes never make a
+// lookup return the wrong node. Also used to order the
+// keys for prefix searches. Case sensitivity must match
+// the hash functor used with them.
+// ========================================================
 
-static inline bool cvarSetDouble(std::int64_t * outVal, const double newVal,
-                                 const CVarNumberRange<std::int64_t> * valueRange)
+struct StringKeyCompare final
 {
-    if (valueRange != nullptr)
+    int operator()(const char * a, const char * b, const std::uint32_t count = ~0u) const
     {
-        if (newVal < valueRange->minValue)
-        {
-            return errorF("Value %f below minimum (" CFG_I64_PRINT_FMT ").",
-                          newVal, valueRange->minValue);
-        }
-        else if (newVal > valueRange->maxValue)
-        {
-            return errorF("Value %f above maximum (" CFG_I64_PRINT_FMT ").",
-                          newVal, valueRange->maxValue);
-        }
+        return std::strncmp(a, b, count);
     }
-    *outVal = static_cast<std::int64_t>(newVal);
-    return true;
-}
-
-static inline bool cvarSetDouble(bool * outVal, const double newVal,
-                                 const CVarNumberRange<bool> *)
-{
-    *outVal = (newVal > 0.0);
-    return true;
-}
+};
 
-static inline bool cvarSetDouble(double * outVal, const double newVal,
-                                 const CVarNumberRange<double> * valueRange)
+struct StringKeyCompareNoCase final
 {
-    if (valueRange != nullptr)
+    int operator()(const char * a, const char * b, const std::uint32_t count = ~0u) const
     {
-        if (newVal < valueRange->minValue)
-        {
-            return errorF("Value %f below minimum (%f).", newVal, valueRange->minValue);
-        }
-        else if (newVal > valueRange->maxValue)
-        {
-            return errorF("Value %f above maximum (%f).", newVal, valueRange->maxValue);
-        }
+        return compareStringsNoCase(a, b, count);
     }
-    *outVal = newVal;
-    return true;
-}
+};
 
-static inline bool cvarSetDouble(CVarEnumConst * outVal, const double newVal,
-                                 const CVarEnumConstList * enumConstants)
-{
-    // Enums can only be integers, so we can reuse this other function.
-    return cvarSetInt64(outVal, static_cast<std::int64_t>(newVal),
-                        enumConstants, CVar::NumberFormat::Decimal);
-}
+// ========================================================
+// class HashTableLink:
+//
+// Commands and CVars are stored in a linked hash table
+// to accelerate lookup by name. We use an intrusive data
+// structure to avoid additional memory allocations, so
+// CommandHandler and CVar classes must inherit from this
+// node type to be able to insert themselves into the HT.
+// ========================================================
 
-static inline bool cvarSetDouble(std::string * outVal, const double newVal,
-                                 const CVarAllowedStrings * allowedStrings)
+#if CFG_PACK_STRUCTURES
+    #pragma pack(push, 1)
+#endif // CFG_PACK_STRUCTURES
+
+template<typename T>
+class HashTableLink
 {
-    if (allowedStrings != nullptr && allowedStrings->strings != nullptr)
-    {
-        std::string tempStr;
-        cvarToString(&tempStr, newVal, CVar::NumberFormat::Decimal);
+public:
 
-        for (int s = 0; allowedStrings->strings[s] != nullptr; ++s)
-        {
-            if (cvarCmpStrings(allowedStrings->strings[s], tempStr.c_str()) == 0)
-            {
-                *outVal = std::move(tempStr);
-                return true;
-            }
-        }
-        return false;
+    template<typename IT, typename HF, typename KC>
+    friend class LinkedHashTable;
+
+    HashTableLink() = default;
+
+    T * getNext() const noexcept
+    {
+        return listNext;
     }
-    else
+    std::uint32_t getHashKey() const noexcept
     {
-        cvarToString(outVal, newVal, CVar::NumberFormat::Decimal);
-        return true;
+        return hashKey;
     }
-}
 
+protected:
+
+    // Hash links are not meant to be directly deleted,
+    // so we don't need a public virtual destructor.
+    ~HashTableLink() = default;
+
+    std::uint32_t hashKey = 0; // Hash value of the node's key. Never zero for a linked node.
+    T * listPrev = nullptr;    // Link to previous element in the doubly-linked list of all nodes. Null for the first node.
+    T * listNext = nullptr;    // Link to next element is the doubly-linked list of all nodes. Null for the last node.
+    int sortedPos = -1;        // Index of the node in the table's sorted index. Negative if not linked.
+};
+
+#if CFG_PACK_STRUCTURES
+    #pragma pack(pop)
+#endif // CFG_PACK_STRUCTURES
+
+// ========================================================
+// class LinkedHashTable:
 //
-// std::string:
+// The intrusive hash table template used to order
+// Commands and CVars by name. Elements must inherit
+// from HashTableLink to be inserted into this data
+// structure. It doesn't own the nodes, so the table
+// won't try to delete the objects upon destruction.
 //
+// The table uses open addressing with linear probing
+// over an array of {hash, node} pairs, so a lookup
+// usually touches a single cache line of the table and
+// only dereferences nodes with a matching hash, whose
+// names are then compared in full with the KeyCompare
+// functor. The table doubles in size when the load factor
+// exceeds CFG_HASH_TABLE_MAX_LOAD_FACTOR. Removal uses
+// backward shifting, so no tombstones are ever left behind.
+//
+// Next to the hash slots we keep an index of the nodes
+// sorted by key for the prefix searches used by tab
+// completion and listing. New nodes are appended to an
+// unsorted tail that is merged in by the next prefix query,
+// so bulk registration doesn't pay for ordered inserts.
+//
+// Nodes must provide getNameCString() returning their key.
+// Key type is fixed to C-style char* strings.
+// ========================================================
 
-static inline bool cvarSetString(std::int64_t * outVal, std::string newVal,
-                                 const CVarNumberRange<std::int64_t> * valueRange)
+template<typename T, typename HF, typename KC>
+class LinkedHashTable final
 {
-    bool ok;
-    const auto temp = cvarToInt64(newVal, &ok);
-    if (!ok)
-    {
-        return false;
-    }
-    return cvarSetInt64(outVal, temp, valueRange, CVar::NumberFormat::Decimal);
-}
+public:
 
-static inline bool cvarSetString(bool * outVal, std::string newVal,
-                                 const CVarNumberRange<bool> *)
-{
-    const BoolCStr * const bStrings = getBoolStrings();
-    bool bFound = false;
+    // Initial size in slots if no size hint is provided.
+    // Slot counts are always rounded to a power of two.
+    // The table grows as needed, so this is just a starting point.
+    static constexpr int DefaultHTSizeHint = 1024;
 
-    for (int s = 0; bStrings[s].trueStr != nullptr; ++s)
+    // User provided hash functor.
+    // Takes a string and returns an unsigned integer.
+    // See the above StringHasher/StringHasherNoCase.
+    using HashFunc = HF;
+
+    // Key comparison functor used to confirm a hash match and to sort the keys.
+    // See the above StringKeyCompare/StringKeyCompareNoCase.
+    using KeyCompare = KC;
+
+    // Not copyable.
+    LinkedHashTable(const LinkedHashTable &) = delete;
+    LinkedHashTable & operator = (const LinkedHashTable &) = delete;
+
+    LinkedHashTable() = default;
+    ~LinkedHashTable() { deallocate(); }
+
+    void allocate(const int sizeHint = DefaultHTSizeHint)
     {
-        if (cvarCmpStrings(bStrings[s].trueStr, newVal.c_str()) == 0)
+        if (slots != nullptr)
         {
-            bFound  = true;
-            *outVal = true;
-            break;
-        }
-        if (cvarCmpStrings(bStrings[s].falseStr, newVal.c_str()) == 0)
-        {
-            bFound  = true;
-            *outVal = false;
-            break;
+            return; // Already allocated.
         }
+        allocateSlots(roundToPowerOfTwo(sizeHint));
     }
 
-    return (bFound ? true : errorF("Can't set boolean CVar from string \"%s\".", newVal.c_str()));
-}
-
-static inline bool cvarSetString(double * outVal, std::string newVal,
-                                 const CVarNumberRange<double> * valueRange)
-{
-    bool ok;
-    const auto temp = cvarToDouble(newVal, &ok);
-    if (!ok)
+    void deallocate() noexcept
     {
-        return false;
+        memFree(slots);
+        memFree(sortedNodes);
+        slots          = nullptr;
+        sortedNodes    = nullptr;
+        listHead       = nullptr;
+        slotCount      = 0;
+        usedSlots      = 0;
+        growThreshold  = 0;
+        sortedCapacity = 0;
+        sortedCount    = 0;
+        sortedSize     = 0;
+        sortedHoles    = 0;
     }
-    return cvarSetDouble(outVal, temp, valueRange);
-}
 
-static inline bool cvarSetString(CVarEnumConst * outVal, std::string newVal,
-                                 const CVarEnumConstList * enumConstants)
-{
-    if (enumConstants != nullptr && enumConstants->names != nullptr)
+    // Make room for at least this many nodes without rehashing.
+    void reserve(const int nodeCount)
     {
-        for (int c = 0; enumConstants->names[c] != nullptr; ++c)
+        const int slotsNeeded = roundToPowerOfTwo(static_cast<int>(nodeCount / maxLoadFactor) + 1);
+        if (slots == nullptr)
         {
-            if (enumConstants->names[c] == newVal)
-            {
-                outVal->name  = enumConstants->names[c];
-                outVal->value = enumConstants->values[c];
-                return true;
-            }
+            allocateSlots(slotsNeeded);
+        }
+        else if (slotsNeeded > slotCount)
+        {
+            rehash(slotsNeeded);
+        }
+        if (nodeCount > sortedCapacity)
+        {
+            growSortedIndex(nodeCount);
         }
-        return false; // Value not a member of this enum.
     }
-    else
+
+    T * findByKey(const char * const key) const
     {
-        // Assume the value is numeric:
-        std::int64_t temp;
-        if (cvarSetString(&temp, std::move(newVal), nullptr))
+        CFG_ASSERT(key != nullptr);
+        if (isEmpty())
         {
-            outVal->name  = "";
-            outVal->value = temp;
-            return true;
+            return nullptr;
         }
-        return false;
+        return findByKey(key, hashOf(key));
     }
-}
 
-static inline bool cvarSetString(std::string * outVal, std::string newVal,
-                                 const CVarAllowedStrings * allowedStrings)
-{
-    if (allowedStrings != nullptr && allowedStrings->strings != nullptr)
+    // Lookup with a hash computed in advance (e.g.: a HashedName).
+    // Must be the same hash the HashFunc gives for the key.
+    T * findByKey(const char * const key, const std::uint32_t hashKey) const
     {
-        for (int s = 0; allowedStrings->strings[s] != nullptr; ++s)
+        CFG_ASSERT(key != nullptr);
+        if (isEmpty())
         {
-            if (cvarCmpStrings(allowedStrings->strings[s], newVal.c_str()) == 0)
+            return nullptr;
+        }
+
+        const std::uint32_t mask = slotCount - 1;
+
+        for (std::uint32_t index = hashKey & mask; slots[index].node != nullptr; index = (index + 1) & mask)
+        {
+            if (slots[index].hashKey == hashKey && KeyCompare{}(slots[index].node->getNameCString(), key) == 0)
             {
-                *outVal = std::move(newVal);
-                return true;
+                return slots[index].node;
             }
         }
-        return false;
+        return nullptr; // Not found.
     }
-    else
+
+    void linkWithKey(T * node, const char * const key)
     {
-        *outVal = std::move(newVal);
-        return true;
+        CFG_ASSERT(key != nullptr);
+        linkWithKey(node, key, hashOf(key));
     }
-}
-
-// ========================================================
-// class CVarImplBase:
-// ========================================================
-
-class CVarImplBase
-    : public HashTableLink<CVarImplBase>
-    , public CVar
-{
-public:
-    // This empty class serves as glue for the HashTableLink
-    // and CVar, so that CVarManagerImpl can declare a
-    // hash table of CVarImplBases. This is necessary
-    // because CVarImpl is a template, and we want to
-    // store generic pointers in the manger instead.
-    virtual ~CVarImplBase();
 
-    // Sets the string value regardless of ReadOnly or InitOnly if the proper
-    // flags are passed. This is used internally to set CVars from config files
-    // and startup command line. It will also prevent setting the modified flag
-    // again after setting the value.
-    virtual bool setStringValueIgnoreRO(std::string newValue, bool writeRomCVars, bool writeInitCVars) = 0;
-    virtual bool setDefaultValueIgnoreRO(bool writeRomCVars, bool writeInitCVars) = 0;
+    // Insertion with a hash computed in advance. Same rules of findByKey().
+    void linkWithKey(T * node, const char * const key, const std::uint32_t hashKey)
+    {
+        CFG_ASSERT(key  != nullptr);
+        CFG_ASSERT(node != nullptr);
+        CFG_ASSERT(node->hashKey == 0); // Can't be linked more than once!
+        CFG_ASSERT(hashKey == hashOf(key));
 
-    // Formats a 'set' command for config file writing.
-    char * toCfgString(char * outBuffer, int bufferSize) const;
-};
+        allocate(); // Ensure slots are allocated if this is the first use.
+        if (usedSlots + 1 > growThreshold)
+        {
+            rehash(slotCount * 2);
+        }
 
-char * CVarImplBase::toCfgString(char * outBuffer, const int bufferSize) const
-{
-    CFG_ASSERT(outBuffer != nullptr);
+        node->hashKey = hashKey;
+        insertSlot(node->hashKey, node);
+        insertSorted(node);
 
-    std::string varFlagsString;
-    const std::uint32_t flags = getFlags();
+        // Prepend to the sequential chain of all nodes:
+        node->listPrev = nullptr;
+        node->listNext = listHead;
+        if (listHead != nullptr)
+        {
+            listHead->listPrev = node;
+        }
+        listHead = node;
 
-    // Only the ones that will be created dynamically need the flags.
-    // The ones defined in the C++ code already have their flags set.
-    if (flags & Flags::UserDefined)
-    {
-        if (flags & Flags::Persistent) { varFlagsString += "-persistent "; }
-        if (flags & Flags::Volatile)   { varFlagsString += "-volatile ";   }
-        if (flags & Flags::ReadOnly)   { varFlagsString += "-readonly ";   }
-        if (flags & Flags::InitOnly)   { varFlagsString += "-initonly ";   }
-        if (flags & Flags::Modified)   { varFlagsString += "-modified ";   }
+        ++usedSlots;
     }
 
-    const CVar::Type  varType        = getType();
-    const std::string varValueString = getStringValue();
-
-    // set  cvar  value  optional-flags
-    if (!varFlagsString.empty())
+    T * unlinkByKey(const char * const key)
     {
-        if (varType == CVar::Type::String || varType == CVar::Type::Enum)
+        CFG_ASSERT(key != nullptr);
+        if (isEmpty())
         {
-            std::snprintf(outBuffer, bufferSize,
-                          "set %s \"%s\" %s",
-                          getNameCString(), varValueString.c_str(), varFlagsString.c_str());
+            return nullptr;
         }
-        else // No need to quote the value string.
+
+        const std::uint32_t hashKey = hashOf(key);
+        const std::uint32_t mask    = slotCount - 1;
+
+        for (std::uint32_t index = hashKey & mask; slots[index].node != nullptr; index = (index + 1) & mask)
         {
-            std::snprintf(outBuffer, bufferSize,
-                          "set %s %s %s",
-                          getNameCString(), varValueString.c_str(), varFlagsString.c_str());
+            if (slots[index].hashKey == hashKey && KeyCompare{}(slots[index].node->getNameCString(), key) == 0)
+            {
+                T * node = slots[index].node;
+                removeSlot(index);
+                removeSorted(node);
+
+                node->hashKey = 0;
+                unlinkFromList(node);
+                --usedSlots;
+                return node;
+            }
         }
+        return nullptr; // No such node with the given key.
     }
-    else
+
+    // Finds the nodes with keys starting with 'prefix', visiting them in key order.
+    // Calls onMatch(node, index) for up to 'maxMatches' nodes and returns the total
+    // number of matching nodes, which can be > maxMatches. Costs O(log n + matches),
+    // plus merging in any nodes added since the last search.
+    template<typename F>
+    int findByPrefix(const char * const prefix, const int maxMatches, F && onMatch) const
     {
-        if (varType == CVar::Type::String || varType == CVar::Type::Enum)
+        CFG_ASSERT(prefix != nullptr);
+        if (isEmpty() || *prefix == '\0')
         {
-            std::snprintf(outBuffer, bufferSize,
-                          "set %s \"%s\"",
-                          getNameCString(), varValueString.c_str());
+            return 0;
         }
-        else // No need to quote the value string.
+
+        mergeSortedTail();
+
+        const auto prefixLen = static_cast<std::uint32_t>(lengthOfString(prefix));
+        T ** const first = sortedNodes;
+        T ** const last  = sortedNodes + sortedSize;
+
+        // First key not less than the prefix and first key past the prefixed range:
+        T ** const lower = std::lower_bound(first, last, prefix,
+                                            [](const T * const node, const char * const str)
+                                            {
+                                                return KeyCompare{}(node->getNameCString(), str) < 0;
+                                            });
+        T ** const upper = std::upper_bound(lower, last, prefix,
+                                            [prefixLen](const char * const str, const T * const node)
+                                            {
+                                                return KeyCompare{}(str, node->getNameCString(), prefixLen) < 0;
+                                            });
+
+        const int matchesFound = static_cast<int>(upper - lower);
+        const int count = std::min(matchesFound, maxMatches);
+        for (int i = 0; i < count; ++i)
         {
-            std::snprintf(outBuffer, bufferSize,
-                          "set %s %s",
-                          getNameCString(), varValueString.c_str());
+            onMatch(lower[i], i);
         }
+        return matchesFound;
     }
-    return outBuffer;
-}
 
-// ========================================================
-// class CVarImpl:
-// ========================================================
+    // Sets the max ratio of used slots before the table is grown. Clamped to [0.1, 0.95].
+    void setMaxLoadFactor(const float loadFactor)
+    {
+        maxLoadFactor = std::max(0.1f, std::min(loadFactor, 0.95f));
+        growThreshold = static_cast<int>(slotCount * maxLoadFactor);
+        if (slots != nullptr && usedSlots > growThreshold)
+        {
+            reserve(usedSlots);
+        }
+    }
 
-template
-<
-    typename ValueType,
-    typename ValueRange,
-    CVar::Type TypeTag
->
-class CVarImpl final
-    : public CVarImplBase
-{
-public:
+    // Misc accessors:
+    T *   getFirst()         const noexcept { return listHead;      }
+    int   getSize()          const noexcept { return usedSlots;     }
+    int   getSlotCount()     const noexcept { return slotCount;     }
+    float getMaxLoadFactor() const noexcept { return maxLoadFactor; }
+    bool  isEmpty()          const noexcept { return usedSlots == 0; }
 
-    // Not copyable.
-    CVarImpl(const CVarImpl &) = delete;
-    CVarImpl & operator = (const CVarImpl &) = delete;
+private:
 
-    CVarImpl(const char * const varName, const char * const varDesc,
-             const std::uint32_t varFlags, const ValueType & initValue,
-             const ValueRange & range, const CVarValueCompletionCallback completionCb)
-        : currentValue(initValue)
-        , defaultValue(initValue)
-        , valueRange(range)
-        , numberFormat(NumberFormat::Decimal)
-        , flags(varFlags)
-        , name(nullptr)
-        , description(nullptr)
-        , valueCompletionCallback(completionCb)
+    struct Slot final
     {
-        // Must have a name string,
-        CFG_ASSERT(varName != nullptr && *varName != '\0');
-        name = cloneString(varName);
+        std::uint32_t hashKey; // Cached hash of the node's key. Ignored when node is null.
+        T *           node;    // Null for an empty slot.
+    };
 
-        // Description comment is optional.
-        if (varDesc != nullptr && *varDesc != '\0')
+    static int roundToPowerOfTwo(const int value) noexcept
+    {
+        int result = 16;
+        while (result < value)
         {
-            description = cloneString(varDesc);
+            result *= 2;
         }
+        return result;
+    }
 
-        // This would make no sense.
-        if ((varFlags & CVar::Flags::Persistent) && (varFlags & CVar::Flags::Volatile))
-        {
-            errorF("%s: 'Persistent' and 'Volatile' flags are mutually exclusive!", varName);
-        }
+    std::uint32_t hashOf(const char * const key) const
+    {
+        const std::uint32_t hashKey = HashFunc{}(key);
+        CFG_ASSERT(hashKey != 0 && "Null hash indexes not allowed!");
+        return hashKey;
     }
 
-    ~CVarImpl()
+    void allocateSlots(const int count)
     {
-        memFree(name);
-        memFree(description);
-        valueRange.clear();
+        slots         = memAlloc<Slot>(count, MemoryCategory::HashTables);
+        slotCount     = count;
+        growThreshold = static_cast<int>(count * maxLoadFactor);
+        clearArray(slots, count);
     }
 
-    std::string getName() const override
+    void insertSlot(const std::uint32_t hashKey, T * node) noexcept
     {
-        return getNameCString();
+        const std::uint32_t mask = slotCount - 1;
+        std::uint32_t index = hashKey & mask;
+
+        while (slots[index].node != nullptr)
+        {
+            index = (index + 1) & mask;
+        }
+
+        slots[index].hashKey = hashKey;
+        slots[index].node    = node;
     }
 
-    std::string getDesc() const override
+    void removeSlot(std::uint32_t index) noexcept
     {
-        return getDescCString();
+        // Shift back the following entries of the probe sequence
+        // that would become unreachable with a hole at 'index'.
+        const std::uint32_t mask = slotCount - 1;
+        std::uint32_t next = (index + 1) & mask;
+
+        while (slots[next].node != nullptr)
+        {
+            const std::uint32_t home = slots[next].hashKey & mask;
+
+            // Can the entry at 'next' be moved to 'index'? Only if its
+            // home slot is not in the circular range (index, next].
+            const bool inRange = (index <= next) ? (index < home && home <= next)
+                                                 : (index < home || home <= next);
+            if (!inRange)
+            {
+                slots[index] = slots[next];
+                index = next;
+            }
+            next = (next + 1) & mask;
+        }
+
+        slots[index].hashKey = 0;
+        slots[index].node    = nullptr;
     }
 
-    const char * getNameCString() const override
+    void rehash(const int newSlotCount)
     {
-        // Name is never null.
-        CFG_ASSERT(name != nullptr);
-        return name;
+        Slot * const oldSlots     = slots;
+        const int    oldSlotCount = slotCount;
+
+        allocateSlots(newSlotCount);
+        for (int i = 0; i < oldSlotCount; ++i)
+        {
+            if (oldSlots[i].node != nullptr)
+            {
+                insertSlot(oldSlots[i].hashKey, oldSlots[i].node);
+            }
+        }
+        memFree(oldSlots);
     }
 
-    const char * getDescCString() const override
+    static bool keyLess(const T * const a, const T * const b)
     {
-        // Description can be null, returning an empty string for that case.
-        return (description != nullptr ? description : "");
+        return KeyCompare{}(a->getNameCString(), b->getNameCString()) < 0;
     }
 
-    std::string getTypeString() const override
+    void growSortedIndex(const int minCapacity)
     {
-        return getTypeCString();
+        const int newCapacity = std::max(minCapacity, std::max(sortedCapacity * 2, 64));
+        T ** const newNodes = memAlloc<T *>(newCapacity, MemoryCategory::HashTables);
+        if (sortedNodes != nullptr)
+        {
+            std::memcpy(newNodes, sortedNodes, sortedSize * sizeof(T *));
+            memFree(sortedNodes);
+        }
+        sortedNodes    = newNodes;
+        sortedCapacity = newCapacity;
     }
 
-    const char * getTypeCString() const override
+    void insertSorted(T * node)
     {
-        static const char * const typeStrings[]
+        if (sortedSize == sortedCapacity)
         {
-            "int",
-            "bool",
-            "float",
-            "string",
-            "enum"
-        };
-
-        const auto index = static_cast<int>(TypeTag);
-        CFG_ASSERT(index < lengthOfArray(typeStrings));
-        return typeStrings[index];
-    }
+            // Reuse the holes left by removals before growing.
+            if (sortedHoles > 0)
+            {
+                compactSortedIndex();
+            }
+            if (sortedSize == sortedCapacity)
+            {
+                growSortedIndex(sortedSize + 1);
+            }
+        }
 
-    Type getType() const override
-    {
-        return TypeTag;
-    }
+        node->sortedPos = sortedSize;
+        sortedNodes[sortedSize++] = node;
 
-    NumberFormat getNumberFormat() const override
-    {
-        return numberFormat;
+        // Nodes that keep the order extend the sorted range; others wait in the tail.
+        if (sortedCount == sortedSize - 1 &&
+            (sortedCount == 0 || (sortedNodes[sortedCount - 1] != nullptr && !keyLess(node, sortedNodes[sortedCount - 1]))))
+        {
+            ++sortedCount;
+        }
     }
 
-    void setNumberFormat(NumberFormat format) override
+    void removeSorted(T * node)
     {
-        numberFormat = format;
-    }
+        // Leaves a hole, removed by the next compaction. O(1).
+        CFG_ASSERT(node->sortedPos >= 0 && node->sortedPos < sortedSize);
+        CFG_ASSERT(sortedNodes[node->sortedPos] == node);
 
-    std::uint32_t getFlags() const override
-    {
-        return flags;
+        sortedNodes[node->sortedPos] = nullptr;
+        node->sortedPos = -1;
+        ++sortedHoles;
     }
 
-    void setFlags(std::uint32_t newFlags) override
+    void compactSortedIndex() const
     {
-        flags = newFlags;
+        int newCount = 0;
+        int newSize  = 0;
+        for (int i = 0; i < sortedSize; ++i)
+        {
+            if (T * const node = sortedNodes[i])
+            {
+                node->sortedPos = newSize;
+                sortedNodes[newSize++] = node;
+                if (i < sortedCount)
+                {
+                    ++newCount;
+                }
+            }
+        }
+        sortedCount = newCount;
+        sortedSize  = newSize;
+        sortedHoles = 0;
     }
 
-    std::string getFlagsString() const override
+    void mergeSortedTail() const
     {
-        std::string str;
-
-        if (flags & Flags::Modified)    { str += "M "; }
-        if (flags & Flags::Persistent)  { str += "P "; }
-        if (flags & Flags::Volatile)    { str += "V "; }
-        if (flags & Flags::ReadOnly)    { str += "R "; }
-        if (flags & Flags::InitOnly)    { str += "I "; }
-        if (flags & Flags::RangeCheck)  { str += "C "; }
-        if (flags & Flags::UserDefined) { str += "U "; }
-
-        if (str.empty())
+        if (sortedHoles > 0)
         {
-            str = "0";
+            compactSortedIndex();
         }
-        else if (str.back() == ' ')
+        if (sortedCount == sortedSize)
         {
-            str.pop_back();
+            return;
         }
 
-        return str;
-    }
-
-    void setModified() override
-    {
-        flags |= Flags::Modified;
-    }
-
-    void clearModified() override
-    {
-        flags &= ~Flags::Modified;
-    }
-
-    bool isWritable() const override
-    {
-        return !(flags & (Flags::ReadOnly | Flags::InitOnly));
-    }
-
-    bool isModified() const override
-    {
-        return !!(flags & Flags::Modified);
-    }
-
-    bool isPersistent() const override
-    {
-        return !!(flags & Flags::Persistent);
-    }
+        // Merged into a new buffer, so no temporary memory outside of memAlloc().
+        T ** const middle = sortedNodes + sortedCount;
+        T ** const last   = sortedNodes + sortedSize;
+        std::sort(middle, last, &LinkedHashTable::keyLess);
 
-    bool isRangeChecked() const override
-    {
-        return !!(flags & Flags::RangeCheck);
-    }
+        T ** const merged = memAlloc<T *>(sortedCapacity, MemoryCategory::HashTables);
+        std::merge(sortedNodes, middle, middle, last, merged, &LinkedHashTable::keyLess);
+        memFree(sortedNodes);
+        sortedNodes = merged;
 
-    int compareNames(const CVar & other) const override
-    {
-        return cvarCmpNames(getNameCString(), other.getNameCString());
+        for (int i = 0; i < sortedSize; ++i)
+        {
+            sortedNodes[i]->sortedPos = i;
+        }
+        sortedCount = sortedSize;
     }
 
-    bool compareEqual(const CVar & other) const override
+    void unlinkFromList(T * node) noexcept
     {
-        if (getType() != other.getType())
-        {
-            return false;
-        }
-        else if (getFlags() != other.getFlags())
-        {
-            return false;
-        }
-        else if (compareNames(other) != 0)
-        {
-            return false;
-        }
-        else if (getStringValue() != other.getStringValue())
-        {
-            return false;
-        }
-        else if (getDefaultValueString() != other.getDefaultValueString())
-        {
-            return false;
-        }
-        else if (getNumberFormat() != other.getNumberFormat())
+        if (node->listPrev != nullptr)
         {
-            return false;
+            node->listPrev->listNext = node->listNext;
         }
         else
         {
-            // Description not compared. It's just metadata for displaying.
-            // ValueRange also not currently compared. Should it be?
-            return true;
+            CFG_ASSERT(node == listHead);
+            listHead = node->listNext;
         }
-    }
 
-    std::int64_t getIntValue() const override
-    {
-        return cvarToInt64(currentValue);
-    }
-
-    bool setIntValue(std::int64_t newValue) override
-    {
-        if (!isWritable())
+        if (node->listNext != nullptr)
         {
-            return errorF("CVar '%s' is read-only!", name);
+            node->listNext->listPrev = node->listPrev;
         }
 
-        if (cvarSetInt64(&currentValue, newValue, (isRangeChecked() ? &valueRange : nullptr), numberFormat))
-        {
-            setModified();
-            return true;
-        }
-        return false;
+        node->listPrev = nullptr;
+        node->listNext = nullptr;
     }
 
-    bool getBoolValue() const override
-    {
-        return !!cvarToInt64(currentValue);
-    }
+    // Open-addressed array of {hash, node} pairs.
+    Slot * slots = nullptr;
 
-    bool setBoolValue(bool newValue) override
-    {
-        if (!isWritable())
-        {
-            return errorF("CVar '%s' is read-only!", name);
-        }
+    // First node in the linked list of all table nodes.
+    // This will point to the most recently inserted item.
+    T * listHead = nullptr;
 
-        if (cvarSetInt64(&currentValue, newValue, (isRangeChecked() ? &valueRange : nullptr), numberFormat))
-        {
-            setModified();
-            return true;
-        }
-        return false;
-    }
+    // Total size in slots of slots[] (power of two), slots used so
+    // far and how many can be used before the table has to grow.
+    int slotCount     = 0;
+    int usedSlots     = 0;
+    int growThreshold = 0;
+
+    // Max ratio of used slots before growing.
+    float maxLoadFactor = CFG_HASH_TABLE_MAX_LOAD_FACTOR;
+
+    // All nodes sorted by key. Only the first sortedCount entries are in
+    // order, the remaining ones up to sortedSize are merged in lazily.
+    // Removed nodes leave null holes, compacted lazily as well.
+    mutable T ** sortedNodes = nullptr;
+    int sortedCapacity       = 0;
+    mutable int sortedCount  = 0;
+    mutable int sortedSize   = 0;
+    mutable int sortedHoles  = 0;
+};
 
-    double getFloatValue() const override
-    {
-        return cvarToDouble(currentValue);
-    }
+// ========================================================
+// class FlagIndex:
+//
+// Secondary index of Commands or CVars by flag bit,
+// so the searches by flags only walk the matching
+// nodes instead of the whole LinkedHashTable.
+//
+// There's one list of nodes per flag bit. A node is
+// appended to the list of a bit when it gains the flag,
+// and the bits of the lists it is in are kept in the
+// node's flagIndexMask. Clearing a flag leaves a stale
+// entry behind, which is dropped by the next walk of
+// that list, so the Modified flag can be set and cleared
+// cheaply. Only removing the node searches its lists.
+//
+// Entries are never moved while a walk is running. Nodes
+// removed or found stale during a walk leave null holes
+// that are compacted once the outermost walk ends, so the
+// walk callback can also remove nodes.
+//
+// Nodes must provide getFlags() and a flagIndexMask.
+// ========================================================
 
-    bool setFloatValue(double newValue) override
+template<typename T>
+class FlagIndex final
+{
+public:
+
+    static constexpr int FlagBits = 32;
+
+    // Not copyable.
+    FlagIndex(const FlagIndex &) = delete;
+    FlagIndex & operator = (const FlagIndex &) = delete;
+
+    FlagIndex() = default;
+    ~FlagIndex() { clear(); }
+
+    // Adds the node to the lists of any flags it has that are not indexed yet.
+    void update(T * node)
     {
-        if (!isWritable())
-        {
-            return errorF("CVar '%s' is read-only!", name);
-        }
+        std::uint32_t newBits = node->getFlags() & ~node->flagIndexMask;
+        node->flagIndexMask |= newBits;
 
-        if (cvarSetDouble(&currentValue, newValue, (isRangeChecked() ? &valueRange : nullptr)))
+        for (int bit = 0; newBits != 0; ++bit, newBits >>= 1)
         {
-            setModified();
-            return true;
+            if (newBits & 1)
+            {
+                lists[bit].push(node);
+            }
         }
-        return false;
     }
 
-    std::string getStringValue() const override
+    // Must be called before the node is deleted.
+    void remove(T * node)
     {
-        std::string result;
-        cvarToString(&result, currentValue, numberFormat);
-        return result;
-    }
+        std::uint32_t bits = node->flagIndexMask;
+        node->flagIndexMask = 0;
 
-    bool setStringValue(std::string newValue) override
-    {
-        if (!isWritable())
+        for (int bit = 0; bits != 0; ++bit, bits >>= 1)
         {
-            return errorF("CVar '%s' is read-only!", name);
-        }
+            if (!(bits & 1))
+            {
+                continue;
+            }
 
-        if (cvarSetString(&currentValue, std::move(newValue), (isRangeChecked() ? &valueRange : nullptr)))
-        {
-            setModified();
-            return true;
+            NodeList & list = lists[bit];
+            T ** const end  = list.nodes + list.count;
+            T ** const pos  = std::find(list.nodes, end, node);
+            CFG_ASSERT(pos != end && "Node missing from the flag index!");
+
+            if (walkDepth > 0)
+            {
+                *pos = nullptr;
+                ++list.holes;
+            }
+            else
+            {
+                // Order of the lists is irrelevant, so just swap with the last.
+                *pos = list.nodes[--list.count];
+            }
         }
-        return false;
     }
 
-    bool setStringValueIgnoreRO(std::string newValue, bool writeRomCVars, bool writeInitCVars) override
+    void clear()
     {
-        // Optionally unchecked and without setting the modified flag.
-        if ((flags & CVar::Flags::ReadOnly) && !writeRomCVars)
+        CFG_ASSERT(walkDepth == 0);
+        for (NodeList & list : lists)
         {
-            return errorF("CVar '%s' is read-only!", name);
+            memFree(list.nodes);
+            list = NodeList{};
         }
-        if ((flags & CVar::Flags::InitOnly) && !writeInitCVars)
+    }
+
+    //
+    // Calls 'func(T *)' for each node having any of the flags,
+    // once per node, until it returns false. Returns the number
+    // of nodes visited. No specific iteration order is guaranteed.
+    // The function can change the flags of the nodes and remove
+    // them from the index.
+    //
+    template<typename Func>
+    int forEachWithFlags(const std::uint32_t flags, Func && func) const
+    {
+        int visited = 0;
+        bool stopped = false;
+        ++walkDepth;
+
+        for (int bit = 0; bit < FlagBits && !stopped; ++bit)
         {
-            return errorF("CVar '%s' is read-only!", name);
+            const std::uint32_t bitMask = 1u << bit;
+            if (!(flags & bitMask))
+            {
+                continue;
+            }
+
+            // Nodes also having a lower queried bit were already visited in that list.
+            const std::uint32_t visitedBits = flags & (bitMask - 1);
+            NodeList & list = lists[bit];
+
+            // Indexed loop, since the function can add nodes to the list.
+            for (int i = 0; i < list.count && !stopped; ++i)
+            {
+                T * node = list.nodes[i];
+                if (node == nullptr)
+                {
+                    continue; // Removed.
+                }
+
+                const std::uint32_t nodeFlags = node->getFlags();
+                if (!(nodeFlags & bitMask))
+                {
+                    node->flagIndexMask &= ~bitMask; // Stale entry.
+                    list.nodes[i] = nullptr;
+                    ++list.holes;
+                    continue;
+                }
+
+                if (!(nodeFlags & visitedBits))
+                {
+                    ++visited;
+                    stopped = !func(node);
+                }
+            }
         }
 
-        if (cvarSetString(&currentValue, std::move(newValue), (isRangeChecked() ? &valueRange : nullptr)))
+        if (--walkDepth == 0)
         {
-            return true;
+            for (NodeList & list : lists)
+            {
+                list.compact();
+            }
         }
-        return false;
+        return visited;
     }
 
-    int getAllowedValueStrings(std::string * outValueStrings, int maxValueStrings) const override
+private:
+
+    struct NodeList
     {
-        if (outValueStrings == nullptr || maxValueStrings <= 0)
+        T ** nodes   = nullptr;
+        int count    = 0; // Entries used in nodes[], including the holes.
+        int capacity = 0;
+        int holes    = 0;
+
+        void push(T * node)
         {
-            return -1;
+            if (count == capacity)
+            {
+                const int newCapacity = std::max(capacity * 2, 16);
+                T ** const newNodes = memAlloc<T *>(newCapacity, MemoryCategory::HashTables);
+                if (nodes != nullptr)
+                {
+                    std::memcpy(newNodes, nodes, count * sizeof(T *));
+                    memFree(nodes);
+                }
+                nodes    = newNodes;
+                capacity = newCapacity;
+            }
+            nodes[count++] = node;
         }
 
-        std::string tempStr;
-        const int count = std::min(maxValueStrings, valueRange.getCount());
-        for (int v = 0; v < count; ++v)
+        void compact()
         {
-            cvarToString(&tempStr, valueRange.getValue(v), numberFormat);
-            outValueStrings[v] = std::move(tempStr);
+            if (holes == 0)
+            {
+                return;
+            }
+            count = static_cast<int>(std::remove(nodes, nodes + count, nullptr) - nodes);
+            holes = 0;
         }
+    };
 
-        return valueRange.getCount();
-    }
+    // Updated by forEachWithFlags(), hence mutable.
+    mutable NodeList lists[FlagBits];
+    mutable int walkDepth = 0;
+};
 
-    int getAllowedValueCount() const override
-    {
-        return valueRange.getCount();
-    }
+// ================================================================================================
+//
+//                              CVars - Configuration Variables
+//
+// ================================================================================================
 
-    bool setDefaultValue() override
-    {
-        if (!isWritable())
-        {
-            return errorF("CVar '%s' is read-only!", name);
-        }
+// ========================================================
+// CVar helpers:
+// ========================================================
 
-        currentValue = defaultValue;
-        setModified();
-        return true;
+template<typename T>
+struct CVarNumberRange final
+{
+    T minValue = 0;
+    T maxValue = 0;
+
+    CVarNumberRange() = default;
+
+    CVarNumberRange(const T min, const T max) noexcept
+        : minValue(min)
+        , maxValue(max)
+    { }
+
+    int getCount() const noexcept
+    {
+        return 2;
     }
 
-    bool setDefaultValueIgnoreRO(bool writeRomCVars, bool writeInitCVars) override
+    T getValue(const int index) const
     {
-        // Optionally unchecked and without setting the modified flag.
-        if ((flags & CVar::Flags::ReadOnly) && !writeRomCVars)
-        {
-            return errorF("CVar '%s' is read-only!", name);
-        }
-        if ((flags & CVar::Flags::InitOnly) && !writeInitCVars)
-        {
-            return errorF("CVar '%s' is read-only!", name);
-        }
+        CFG_ASSERT(index >= 0 && index < getCount());
+        return (index == 0 ? minValue : maxValue);
+    }
 
-        currentValue = defaultValue;
-        return true;
+    void clearIndex(MemoryArena *) noexcept
+    { }
+
+    void clear(MemoryArena *) noexcept
+    {
+        minValue = 0;
+        maxValue = 0;
     }
+};
 
-    std::string getDefaultValueString() const override
+//
+// Sorted indexes of the allowed strings and enum constants, built at registration,
+// so lookups are binary searches instead of a string compare against every entry.
+// The index arrays hold positions into the original lists, which keep their order.
+//
+
+// Stable, so entries that compare equal stay in declaration order.
+template<typename Less>
+static void fillSortedIndex(int * const index, const int count, Less && less)
+{
+    for (int i = 0; i < count; ++i)
     {
-        std::string result;
-        cvarToString(&result, defaultValue, numberFormat);
-        return result;
+        index[i] = i;
     }
+    std::stable_sort(index, index + count, less);
+}
 
-    int valueCompletion(const char * partialVal, std::string * outMatches, int maxMatches) const override
+// Position of the first sorted entry not less than the key, given the std::strcmp-style 'compare(entry)'.
+template<typename Compare>
+static int lowerBoundSortedIndex(const int * const index, const int count, Compare && compare)
+{
+    const int * pos = std::lower_bound(index, index + count, 0,
+                                       [&compare](const int entry, int) { return compare(entry) < 0; });
+    return static_cast<int>(pos - index);
+}
+
+struct CVarAllowedStrings final
+{
+    // List of strings terminated by a null entry.
+    const char ** strings = nullptr;
+
+    // Positions into strings[] sorted by cvarCmpStrings(). Null if there are no strings.
+    const int * sortedIndex = nullptr;
+    int count = 0;
+
+    CVarAllowedStrings(const char ** allowedStrings, MemoryArena * arena)
     {
-        if (valueCompletionCallback != nullptr)
+        if (allowedStrings != nullptr)
         {
-            return valueCompletionCallback(partialVal, outMatches, maxMatches);
+            strings = cloneStringArray(allowedStrings, arena);
+            buildIndex(arena);
         }
-        else
+    }
+
+    // References the strings without copying, for CVars that don't own their strings.
+    // The index is still allocated from the arena, see clearIndex().
+    static CVarAllowedStrings fromStatic(const char ** allowedStrings, MemoryArena * arena)
+    {
+        CVarAllowedStrings list{ nullptr, nullptr };
+        if (allowedStrings != nullptr)
         {
-            return getAllowedValueStrings(outMatches, maxMatches);
+            list.strings = allowedStrings;
+            list.buildIndex(arena);
         }
+        return list;
     }
 
-    CVarValueCompletionCallback getValueCompletionCallback() const override
+    int getCount() const noexcept
     {
-        return valueCompletionCallback;
+        return count;
     }
 
-private:
+    std::string getValue(const int index) const
+    {
+        CFG_ASSERT(index >= 0 && index < getCount());
+        return strings[index];
+    }
 
-    ValueType                   currentValue;            // Current value. Only changeable if not ReadOnly.
-    const ValueType             defaultValue;            // The initial value set when created is the reset value.
-    ValueRange                  valueRange;              // Range of numeric values or allowed strings/enum names.
-    NumberFormat                numberFormat;            // Number formatting from int=>string conversion (decimal, binary, etc).
-    std::uint32_t               flags;                   // ORed CVar::Flags or zero.
-    const char *                name;                    // Heap-allocated name string. Never null and never empty.
-    const char *                description;             // Heap-allocated Description comment. Can be null if not provided.
-    CVarValueCompletionCallback valueCompletionCallback; // Optional callback for value auto-completion. May be null.
-};
+    // Position in strings[] of the allowed string equal to 'str', or -1 if not allowed.
+    int find(const char * const str, const int length) const;
 
-//
-// These are the supported CVar types:
-//
-using CVarInt    = CVarImpl< std::int64_t,  CVarNumberRange<std::int64_t>, CVar::Type::Int    >;
-using CVarBool   = CVarImpl< bool,          CVarNumberRange<bool>,         CVar::Type::Bool   >;
-using CVarFloat  = CVarImpl< double,        CVarNumberRange<double>,       CVar::Type::Float  >;
-using CVarString = CVarImpl< std::string,   CVarAllowedStrings,            CVar::Type::String >;
-using CVarEnum   = CVarImpl< CVarEnumConst, CVarEnumConstList,             CVar::Type::Enum   >;
+    // Writes the allowed strings starting with 'prefix', sorted. Returns the total number found.
+    int findWithPrefix(const char * prefix, std::string * outMatches, int maxMatches) const;
 
-// ========================================================
-// class CVarManagerImpl:
-// ========================================================
+    void clearIndex(MemoryArena * arena) noexcept
+    {
+        memFree(arena, const_cast<int *>(sortedIndex));
+        sortedIndex = nullptr;
+    }
 
-class CVarManagerImpl final
-    : public CVarManager
-{
-public:
+    void clear(MemoryArena * arena) noexcept
+    {
+        clearIndex(arena);
+        memFree(arena, strings);
+        strings = nullptr;
+        count   = 0;
+    }
 
-    // Not copyable.
-    CVarManagerImpl(const CVarManagerImpl &) = delete;
-    CVarManagerImpl & operator = (const CVarManagerImpl &) = delete;
+private:
 
-    explicit CVarManagerImpl(int hashTableSize);
-    ~CVarManagerImpl();
+    void buildIndex(MemoryArena * arena);
+};
 
-    CVar * findCVar(const char * name) const override;
-    int findCVarsWithPartialName(const char * partialName, CVar ** outMatches, int maxMatches) const override;
-    int findCVarsWithPartialName(const char * partialName, const char ** outMatches, int maxMatches) const override;
-    int findCVarsWithFlags(std::uint32_t flags, CVar ** outMatches, int maxMatches) const override;
+struct CVarEnumConstList final
+{
+    const char         ** names  = nullptr; // List of strings terminated by a null entry.
+    const std::int64_t *  values = nullptr; // Corresponding values for each name.
 
-    bool removeCVar(const char * name) override;
-    bool removeCVar(CVar * cvar) override;
-    void removeAllCVars() override;
+    // Positions into names[]/values[] sorted by name (std::strcmp) and by value. Null if there are no constants.
+    const int * sortedByName  = nullptr;
+    const int * sortedByValue = nullptr;
+    int count = 0;
 
-    int getRegisteredCVarsCount() const override;
-    bool isValidCVarName(const char * name) const override;
-    void enumerateAllCVars(CVarEnumerateCallback enumCallback, void * userContext) override;
+    CVarEnumConstList(const std::int64_t * enumConstants, const char ** constNames, MemoryArena * arena)
+    {
+        if (enumConstants != nullptr && constNames != nullptr)
+        {
+            names = cloneStringArray(constNames, arena);
 
-    CVar * registerCVarBool(const char * name, const char * description, std::uint32_t flags,
-                            bool initValue, CVarValueCompletionCallback completionCb = nullptr) override;
+            // Expect the same number of names and constant values.
+            int n = 0;
+            for (; constNames[n] != nullptr; ++n) { }
 
-    CVar * registerCVarInt(const char * name, const char * description, std::uint32_t flags,
-                           std::int64_t initValue, std::int64_t minValue, std::int64_t maxValue,
-                           CVarValueCompletionCallback completionCb = nullptr) override;
+            if (n > 0)
+            {
+                std::int64_t * newValues = memAlloc<std::int64_t>(arena, n, MemoryCategory::ValueLists);
+                std::memcpy(newValues, enumConstants, n * sizeof(std::int64_t));
+                values = newValues;
+            }
+            buildIndex(arena);
+        }
+    }
 
-    CVar * registerCVarFloat(const char * name, const char * description, std::uint32_t flags,
-                             double initValue, double minValue, double maxValue,
-                             CVarValueCompletionCallback completionCb = nullptr) override;
+    // References the names and constants without copying, for CVars that don't own their strings.
+    // The indexes are still allocated from the arena, see clearIndex().
+    static CVarEnumConstList fromStatic(const std::int64_t * enumConstants, const char ** constNames, MemoryArena * arena)
+    {
+        CVarEnumConstList list{ nullptr, nullptr, nullptr };
+        if (enumConstants != nullptr && constNames != nullptr)
+        {
+            list.names  = constNames;
+            list.values = enumConstants;
+            list.buildIndex(arena);
+        }
+        return list;
+    }
 
-    CVar * registerCVarString(const char * name, const char * description, std::uint32_t flags,
-                              const std::string & initValue, const char ** allowedStrings,
-                              CVarValueCompletionCallback completionCb = nullptr) override;
+    int getCount() const noexcept
+    {
+        return count;
+    }
 
-    CVar * registerCVarEnum(const char * name, const char * description, std::uint32_t flags,
-                            std::int64_t initValue, const std::int64_t * enumConstants, const char ** constNames,
-                            CVarValueCompletionCallback completionCb = nullptr) override;
+    std::string getValue(const int index) const
+    {
+        CFG_ASSERT(index >= 0 && index < getCount());
+        return names[index];
+    }
 
-    bool getCVarValueBool(const char * name) const override;
-    std::int64_t getCVarValueInt(const char * name) const override;
-    double getCVarValueFloat(const char * name) const override;
-    std::string getCVarValueString(const char * name) const override;
+    // Position in names[]/values[] of the constant, or -1 if not a member of the enum.
+    // Values declared more than once find the first declared name, like a linear search would.
+    int findName(const char * name) const;
+    int findValue(std::int64_t value) const;
 
-    CVar * setCVarValueBool(const char * name, bool value, std::uint32_t flags) override;
-    CVar * setCVarValueInt(const char * name, std::int64_t value, std::uint32_t flags) override;
-    CVar * setCVarValueFloat(const char * name, double value, std::uint32_t flags) override;
-    CVar * setCVarValueString(const char * name, const std::string & value, std::uint32_t flags) override;
+    // Writes the constant names starting with 'prefix', sorted. Returns the total number found.
+    int findWithPrefix(const char * prefix, std::string * outMatches, int maxMatches) const;
 
-    // For use in 'set' and 'reset' commands called on 'reloadConfig' or from the program command line.
-    bool internalSetStringValue(CVar * cvar, std::string value);
-    bool internalSetDefaultValue(CVar * cvar);
+    void clearIndex(MemoryArena * arena) noexcept
+    {
+        // Both indexes share one allocation.
+        memFree(arena, const_cast<int *>(sortedByName));
+        sortedByName  = nullptr;
+        sortedByValue = nullptr;
+    }
 
-    // This will only affect 'set' and 'reset' commands on vars flagged with ReadOnly or InitOnly.
-    void setAllowWritingReadOnlyVars(bool allow) noexcept;
+    void clear(MemoryArena * arena) noexcept
+    {
+        clearIndex(arena);
 
-    // This will only affect 'set' and 'reset' commands on vars flagged with InitOnly.
-    void setAllowWritingInitOnlyVars(bool allow) noexcept;
+        memFree(arena, names);
+        names = nullptr;
+
+        memFree(arena, values);
+        values = nullptr;
+        count  = 0;
+    }
 
 private:
 
-    template<typename T>
-    bool validateCVarRegistration(const char * name, std::uint32_t flags,
-                                  const T & initValue, T (CVar::*pGetVal)() const) const;
+    void buildIndex(MemoryArena * arena);
+};
 
-    template<typename T>
-    int findWithPartialNameHelper(const char * partialName, T * outMatches,
-                                  int maxMatches, T (*pGetVar)(CVar *)) const;
+struct CVarEnumConst final
+{
+    const char * name;  // Pointer into the CVarEnumConstList for the CVar.
+    std::int64_t value; // Integer value of the enum constant.
+};
 
-    //
-    // Hash function used to lookup CVar names in the HT.
-    // Can be case-sensitive or not.
-    //
-    #if CFG_CVAR_CASE_SENSITIVE_NAMES
-    using CVarNameHasher = StringHasher;
-    #else // !CFG_CVAR_CASE_SENSITIVE_NAMES
-    using CVarNameHasher = StringHasherNoCase;
-    #endif // CFG_CVAR_CASE_SENSITIVE_NAMES
+// Size of small stack-declared strings for things like number => string conversions.
+constexpr int CVarTempStrMaxSize = 128;
 
-    // All the registered CVars in a hash table for fast lookup by name.
-    LinkedHashTable<CVarImplBase, CVarNameHasher> registeredCVars;
-    bool allowWritingRomCVars;
-    bool allowWritingInitCVars;
-};
+// Floats are converted to strings with formatDouble(), which gives the shortest
+// string that parses back to the same value. Define this to a snprintf() format
+// specifier to use it instead, e.g.: "%.8g" for up-to eight digits of precision.
+// Note that snprintf() depends on the current locale for the decimal point.
+//#define CFG_FLOAT_PRINT_FMT "%.8g"
+
+// Portability macro:
+#ifndef CFG_I64_PRINT_FMT
+    #ifdef PRIi64
+        #define CFG_I64_PRINT_FMT "%" PRIi64
+    #else // PRIi64 not defined
+        #define CFG_I64_PRINT_FMT "%lli"
+    #endif // PRIi64
+#endif // CFG_I64_PRINT_FMT
 
 // ========================================================
-// CVarManagerImpl implementation:
+// String comparators with configurable case-sensitivity:
 // ========================================================
 
-CVarManager * CVarManager::createInstance(const int cvarHashTableSizeHint)
-{
-    auto cvarManager = memAlloc<CVarManagerImpl>(1);
-    return construct(cvarManager, cvarHashTableSizeHint);
-}
-
-void CVarManager::destroyInstance(CVarManager * cvarManager)
+static inline int cvarCmpStrings(const char * const a, const char * const b)
 {
-    destroy(cvarManager);
-    memFree(cvarManager);
+    #if CFG_CVAR_CASE_SENSITIVE_STRINGS
+    return std::strcmp(a, b);
+    #else // !CFG_CVAR_CASE_SENSITIVE_STRINGS
+    return compareStringsNoCase(a, b);
+    #endif // CFG_CVAR_CASE_SENSITIVE_STRINGS
 }
 
-CVarManagerImpl::CVarManagerImpl(const int hashTableSize)
-    : allowWritingRomCVars(false)
-    , allowWritingInitCVars(false)
+// Equality test of cvarCmpStrings() for a 'b' string that is not null terminated.
+static inline bool cvarStringEquals(const char * const a, const char * const b, const int bLength)
 {
-    if (hashTableSize > 0)
+    if (lengthOfString(a) != bLength)
     {
-        registeredCVars.allocate(hashTableSize);
+        return false;
     }
+    #if CFG_CVAR_CASE_SENSITIVE_STRINGS
+    return std::strncmp(a, b, bLength) == 0;
+    #else // !CFG_CVAR_CASE_SENSITIVE_STRINGS
+    return compareStringsNoCase(a, b, bLength) == 0;
+    #endif // CFG_CVAR_CASE_SENSITIVE_STRINGS
 }
 
-CVarManagerImpl::~CVarManagerImpl()
+// cvarCmpStrings() for a 'b' string that is not null terminated.
+static inline int cvarCmpStrings(const char * const a, const char * const b, const int bLength)
 {
-    auto cvar = registeredCVars.getFirst();
-    while (cvar != nullptr)
-    {
-        auto temp = cvar->getNext();
-        destroy(cvar);
-        memFree(cvar);
-        cvar = temp;
-    }
+    const int aLength = lengthOfString(a);
+    const int n = std::min(aLength, bLength);
+    #if CFG_CVAR_CASE_SENSITIVE_STRINGS
+    const int cmp = std::strncmp(a, b, n);
+    #else // !CFG_CVAR_CASE_SENSITIVE_STRINGS
+    const int cmp = compareStringsNoCase(a, b, n);
+    #endif // CFG_CVAR_CASE_SENSITIVE_STRINGS
+    return (cmp != 0) ? cmp : (aLength - bLength);
 }
 
-CVar * CVarManagerImpl::findCVar(const char * const name) const
+static inline int cvarCmpNames(const char * const a, const char * const b)
 {
-    if (name == nullptr || *name == '\0')
-    {
-        return nullptr;
-    }
-    return registeredCVars.findByKey(name);
+    #if CFG_CVAR_CASE_SENSITIVE_NAMES
+    return std::strcmp(a, b);
+    #else // !CFG_CVAR_CASE_SENSITIVE_NAMES
+    return compareStringsNoCase(a, b);
+    #endif // CFG_CVAR_CASE_SENSITIVE_NAMES
 }
 
-int CVarManagerImpl::findCVarsWithPartialName(const char * const partialName,
-                                              CVar ** outMatches, const int maxMatches) const
+static inline void cvarSortMatches(CVar ** outMatches, const int count)
 {
-    return findWithPartialNameHelper<CVar *>(partialName, outMatches, maxMatches,
-                                             [](CVar * cvar) { return cvar; });
+    std::sort(outMatches, outMatches + count,
+              [](const CVar * const a, const CVar * const b)
+              {
+                  return cvarCmpNames(a->getNameCString(), b->getNameCString()) < 0;
+              });
 }
 
-int CVarManagerImpl::findCVarsWithPartialName(const char * const partialName,
-                                              const char ** outMatches, const int maxMatches) const
+static inline void cvarSortMatches(const char ** outMatches, const int count)
 {
-    return findWithPartialNameHelper<const char *>(partialName, outMatches, maxMatches,
-                                                   [](CVar * cvar) { return cvar->getNameCString(); });
+    std::sort(outMatches, outMatches + count,
+              [](const char * const a, const char * const b)
+              {
+                  return cvarCmpNames(a, b) < 0;
+              });
 }
 
-int CVarManagerImpl::findCVarsWithFlags(const std::uint32_t flags,
-                                        CVar ** outMatches, const int maxMatches) const
+// ========================================================
+// CVarAllowedStrings/CVarEnumConstList lookups:
+// ========================================================
+
+void CVarAllowedStrings::buildIndex(MemoryArena * arena)
 {
-    if (flags == 0)
+    for (count = 0; strings[count] != nullptr; ++count) { }
+    if (count == 0)
     {
-        return 0;
-    }
-    else if (outMatches == nullptr || maxMatches <= 0)
-    {
-        return -1;
+        return;
     }
 
-    int matchesFound = 0;
-    for (auto cvar = registeredCVars.getFirst(); cvar; cvar = cvar->getNext())
-    {
-        if (cvar->getFlags() & flags)
-        {
-            if (matchesFound < maxMatches)
-            {
-                outMatches[matchesFound] = cvar;
-            }
-            ++matchesFound; // Keep incrementing even if outMatches[] is full,
-                            // so the caller can know the total num found.
-        }
-    }
+    int * index = memAlloc<int>(arena, count, MemoryCategory::ValueLists);
+    fillSortedIndex(index, count, [this](const int a, const int b) { return cvarCmpStrings(strings[a], strings[b]) < 0; });
+    sortedIndex = index;
+}
 
-    if (matchesFound > 0)
+int CVarAllowedStrings::find(const char * const str, const int length) const
+{
+    const int pos = lowerBoundSortedIndex(sortedIndex, count,
+                                          [this, str, length](const int entry) { return cvarCmpStrings(strings[entry], str, length); });
+
+    if (pos < count && cvarCmpStrings(strings[sortedIndex[pos]], str, length) == 0)
     {
-        // Output will be sorted alphabetically.
-        cvarSortMatches(outMatches, std::min(matchesFound, maxMatches));
+        return sortedIndex[pos];
     }
-    return matchesFound;
+    return -1;
 }
 
-template<typename T>
-int CVarManagerImpl::findWithPartialNameHelper(const char * const partialName, T * outMatches,
-                                               const int maxMatches, T (*pGetVar)(CVar *)) const
+int CVarAllowedStrings::findWithPrefix(const char * const prefix, std::string * outMatches, const int maxMatches) const
 {
-    if (partialName == nullptr || *partialName == '\0')
-    {
-        return 0;
-    }
-    else if (outMatches == nullptr || maxMatches <= 0)
-    {
-        return -1;
-    }
+    // The strings starting with the prefix are contiguous in the sorted order, right from the prefix itself.
+    const int prefixLen = lengthOfString(prefix);
+    int pos = lowerBoundSortedIndex(sortedIndex, count,
+                                    [this, prefix, prefixLen](const int entry) { return cvarCmpStrings(strings[entry], prefix, prefixLen); });
 
     int matchesFound = 0;
-
-    // Partial name searching unfortunately can't take advantage of the optimized
-    // constant time hash table lookup, so we have to fall back to a linear search.
-    for (auto cvar = registeredCVars.getFirst(); cvar; cvar = cvar->getNext())
+    for (; pos < count; ++pos)
     {
-        if (cvarNameStartsWith(cvar->getNameCString(), partialName))
+        const char * const str = strings[sortedIndex[pos]];
+        #if CFG_CVAR_CASE_SENSITIVE_STRINGS
+        if (std::strncmp(str, prefix, prefixLen) != 0)
+        #else // !CFG_CVAR_CASE_SENSITIVE_STRINGS
+        if (compareStringsNoCase(str, prefix, prefixLen) != 0)
+        #endif // CFG_CVAR_CASE_SENSITIVE_STRINGS
         {
-            if (matchesFound < maxMatches)
-            {
-                outMatches[matchesFound] = pGetVar(cvar);
-            }
-            ++matchesFound; // Keep incrementing even if outMatches[] is full,
-                            // so the caller can know the total num found.
+            break;
         }
-    }
 
-    if (matchesFound > 0)
-    {
-        // Output will be sorted alphabetically.
-        cvarSortMatches(outMatches, std::min(matchesFound, maxMatches));
+        if (matchesFound < maxMatches)
+        {
+            outMatches[matchesFound] = str;
+        }
+        ++matchesFound;
     }
     return matchesFound;
 }
 
-bool CVarManagerImpl::removeCVar(const char * const name)
+void CVarEnumConstList::buildIndex(MemoryArena * arena)
 {
-    if (!isValidCVarName(name))
-    {
-        return errorF("'%s' is not a valid CVar name. Nothing to remove.", name);
-    }
-
-    auto cvar = registeredCVars.unlinkByKey(name);
-    if (cvar == nullptr)
+    for (count = 0; names[count] != nullptr; ++count) { }
+    if (count == 0)
     {
-        return false; // No such variable.
+        return;
     }
 
-    destroy(cvar);
-    memFree(cvar);
-    return true;
+    int * index = memAlloc<int>(arena, count * 2, MemoryCategory::ValueLists);
+    fillSortedIndex(index, count, [this](const int a, const int b) { return std::strcmp(names[a], names[b]) < 0; });
+    fillSortedIndex(index + count, count, [this](const int a, const int b) { return values[a] < values[b]; });
+    sortedByName  = index;
+    sortedByValue = index + count;
 }
 
-bool CVarManagerImpl::removeCVar(CVar * cvar)
+int CVarEnumConstList::findName(const char * const name) const
 {
-    if (cvar == nullptr)
+    const int pos = lowerBoundSortedIndex(sortedByName, count,
+                                          [this, name](const int entry) { return std::strcmp(names[entry], name); });
+
+    if (pos < count && std::strcmp(names[sortedByName[pos]], name) == 0)
     {
-        return false;
+        return sortedByName[pos];
     }
-    return removeCVar(cvar->getNameCString());
+    return -1;
 }
 
-void CVarManagerImpl::removeAllCVars()
+int CVarEnumConstList::findValue(const std::int64_t value) const
 {
-    auto cvar = registeredCVars.getFirst();
-    while (cvar != nullptr)
+    const int pos = lowerBoundSortedIndex(sortedByValue, count,
+                                          [this, value](const int entry) { return (values[entry] < value) ? -1 : (values[entry] > value ? 1 : 0); });
+
+    if (pos < count && values[sortedByValue[pos]] == value)
     {
-        auto temp = cvar->getNext();
-        destroy(cvar);
-        memFree(cvar);
-        cvar = temp;
+        return sortedByValue[pos];
     }
-    registeredCVars.deallocate();
+    return -1;
 }
 
-int CVarManagerImpl::getRegisteredCVarsCount() const
+int CVarEnumConstList::findWithPrefix(const char * const prefix, std::string * outMatches, const int maxMatches) const
 {
-    return registeredCVars.getSize();
-}
+    // Same as CVarAllowedStrings::findWithPrefix(), but the names are always case-sensitive.
+    const int prefixLen = lengthOfString(prefix);
+    int pos = lowerBoundSortedIndex(sortedByName, count,
+                                    [this, prefix](const int entry) { return std::strcmp(names[entry], prefix); });
 
-bool CVarManagerImpl::isValidCVarName(const char * const name) const
-{
-    //
-    // CVar names somewhat follow the C++ variable
-    // naming rules, that is, cannot start with a number,
-    // cannot contain white spaces, cannot start with nor
-    // contain any special characters except the underscore.
-    //
-    // But we allow a CVar name composed by multiple words
-    // separated by a dot, such as "Obj.Prop", as long as the
-    // character following the dot complies to the above rules.
-    //
-    if (name == nullptr || *name == '\0')
+    int matchesFound = 0;
+    for (; pos < count; ++pos)
     {
-        return false;
+        const char * const name = names[sortedByName[pos]];
+        if (std::strncmp(name, prefix, prefixLen) != 0)
+        {
+            break;
+        }
+
+        if (matchesFound < maxMatches)
+        {
+            outMatches[matchesFound] = name;
+        }
+        ++matchesFound;
     }
+    return matchesFound;
+}
 
-    int i = 0;
-    int c = name[i++];
+// ========================================================
+// class CVarStringValue:
+// ========================================================
 
-    // Must start with a letter or an underscore:
-    if ((c < 'a' || c > 'z') && (c < 'A' || c > 'Z') && (c != '_'))
+//
+// Value of a string CVar. Strings shorter than CFG_CVAR_STRING_INLINE_SIZE
+// are stored inline and never touch the allocator. Longer ones go into a
+// heap buffer, which assign() reuses while it is big enough.
+//
+class CVarStringValue final
+{
+public:
+
+    CVarStringValue() noexcept
+        : heapChars(nullptr)
+        , heapCapacity(0)
+        , length(0)
+        , inlineChars() // Zero filled, so swap() never reads uninitialized chars.
+    { }
+
+    CVarStringValue(const char * const str, const int len)
+        : CVarStringValue()
     {
-        return false;
+        assign(str, len);
     }
 
-    while (name[i] != '\0')
+    // Implicit, so that std::string init values convert.
+    CVarStringValue(const std::string & str)
+        : CVarStringValue()
     {
-        c = name[i++];
-
-        // If not a number nor a lower or upper case letter...
-        if ((c < '0' || c > '9') && (c < 'a' || c > 'z') && (c < 'A' || c > 'Z'))
-        {
-            // If it is a dot or an underscore it's OK, otherwise invalid.
-            if (c != '.' && c != '_')
-            {
-                return false;
-            }
-
-            // As long as the next char is a letter or underscore
-            // and the string is not over after the dot...
-            if (c == '.' && name[i] == '\0')
-            {
-                return false;
-            }
+        assign(str.data(), static_cast<int>(str.size()));
+    }
 
-            // Dot must be followed by letter or underscore.
-            if (c == '.')
-            {
-                c = name[i++];
-                if ((c < 'a' || c > 'z') && (c < 'A' || c > 'Z') && c != '_')
-                {
-                    return false;
-                }
-            }
-            else // An '_'
-            {
-                // Underscore can be followed by letter,
-                // number, another underscore or a dot.
-                c = name[i++];
-                if ((c < '0' || c > '9') &&
-                    (c < 'a' || c > 'z') &&
-                    (c < 'A' || c > 'Z') &&
-                    c != '_' && c != '.')
-                {
-                    return false;
-                }
-            }
-        }
+    CVarStringValue(const CVarStringValue & other)
+        : CVarStringValue()
+    {
+        assign(other.c_str(), other.length);
     }
 
-    // A valid name if we get to the end of the string.
-    return true;
-}
+    CVarStringValue(CVarStringValue && other) noexcept
+        : CVarStringValue()
+    {
+        swap(other);
+    }
 
-void CVarManagerImpl::enumerateAllCVars(CVarEnumerateCallback enumCallback, void * userContext)
-{
-    CFG_ASSERT(enumCallback != nullptr);
-    for (auto cvar = registeredCVars.getFirst(); cvar; cvar = cvar->getNext())
+    CVarStringValue & operator = (const CVarStringValue & other)
     {
-        if (!enumCallback(cvar, userContext))
+        if (this != &other)
         {
-            return;
+            assign(other.c_str(), other.length);
         }
+        return *this;
     }
-}
 
-template<typename T>
-bool CVarManagerImpl::validateCVarRegistration(const char * const name, const std::uint32_t flags,
-                                               const T & initValue, T (CVar::*pGetVal)() const) const
-{
-    if (name == nullptr || *name == '\0')
+    CVarStringValue & operator = (CVarStringValue && other) noexcept
     {
-        return errorF("Null or empty string for CVar name!");
+        swap(other);
+        return *this;
     }
-    else if (!isValidCVarName(name))
+
+    ~CVarStringValue()
     {
-        return errorF("Invalid CVar name '%s'. Can't register it.", name);
+        memFree(heapChars);
     }
-    else if (const auto cvar = findCVar(name))
+
+    // 'str' doesn't have to be null terminated and may point into this string.
+    void assign(const char * const str, const int len)
     {
-        if (cvar->getFlags() != flags)
-        {
-            errorF("CVar '%s' already registered with different flags!", name);
-        }
-        else if ((cvar->*pGetVal)() != initValue)
+        CFG_ASSERT(str != nullptr && len >= 0);
+
+        if (len >= CFG_CVAR_STRING_INLINE_SIZE && len >= heapCapacity)
         {
-            errorF("CVar '%s' already registered with different value!", name);
+            // Copied before freeing the old buffer, in case the source is in it.
+            char * newChars = memAlloc<char>(len + 1, MemoryCategory::Strings);
+            std::memcpy(newChars, str, len);
+            memFree(heapChars);
+            heapChars    = newChars;
+            heapCapacity = len + 1;
         }
         else
         {
-            errorF("CVar '%s' already registered! Duplicate names are not allowed.", name);
+            std::memmove((len < CFG_CVAR_STRING_INLINE_SIZE ? inlineChars : heapChars), str, len);
         }
-        return false;
+
+        length = len;
+        (length < CFG_CVAR_STRING_INLINE_SIZE ? inlineChars : heapChars)[length] = '\0';
     }
-    else // Registration is a go.
+
+    void swap(CVarStringValue & other) noexcept
     {
-        return true;
+        std::swap(inlineChars,  other.inlineChars);
+        std::swap(heapChars,    other.heapChars);
+        std::swap(heapCapacity, other.heapCapacity);
+        std::swap(length,       other.length);
     }
-}
 
-CVar * CVarManagerImpl::registerCVarBool(const char * const name, const char * const description,
-                                         const std::uint32_t flags, const bool initValue,
-                                         CVarValueCompletionCallback completionCb)
-{
-    if (!validateCVarRegistration(name, flags, initValue, &CVar::getBoolValue))
+    const char * c_str() const noexcept
     {
-        return nullptr;
+        return (length < CFG_CVAR_STRING_INLINE_SIZE ? inlineChars : heapChars);
     }
 
-    auto newVar = memAlloc<CVarBool>(1);
-    construct(newVar, name, description, flags, initValue, CVarNumberRange<bool>(false, true), completionCb);
-    registeredCVars.linkWithKey(newVar, name);
-    return newVar;
-}
-
-CVar * CVarManagerImpl::registerCVarInt(const char * const name, const char * const description,
-                                        const std::uint32_t flags, const std::int64_t initValue,
-                                        const std::int64_t minValue, const std::int64_t maxValue,
-                                        CVarValueCompletionCallback completionCb)
-{
-    if (!validateCVarRegistration(name, flags, initValue, &CVar::getIntValue))
+    int size() const noexcept
     {
-        return nullptr;
+        return length;
     }
 
-    auto newVar = memAlloc<CVarInt>(1);
-    construct(newVar, name, description, flags, initValue, CVarNumberRange<std::int64_t>(minValue, maxValue), completionCb);
-    registeredCVars.linkWithKey(newVar, name);
-    return newVar;
-}
+    bool operator == (const CVarStringValue & other) const noexcept
+    {
+        return length == other.length && std::memcmp(c_str(), other.c_str(), length) == 0;
+    }
 
-CVar * CVarManagerImpl::registerCVarFloat(const char * const name, const char * const description,
-                                          const std::uint32_t flags, const double initValue,
-                                          const double minValue, const double maxValue,
-                                          CVarValueCompletionCallback completionCb)
-{
-    if (!validateCVarRegistration(name, flags, initValue, &CVar::getFloatValue))
+    bool operator != (const CVarStringValue & other) const noexcept
     {
-        return nullptr;
+        return !(*this == other);
     }
 
-    auto newVar = memAlloc<CVarFloat>(1);
-    construct(newVar, name, description, flags, initValue, CVarNumberRange<double>(minValue, maxValue), completionCb);
-    registeredCVars.linkWithKey(newVar, name);
-    return newVar;
-}
+private:
 
-CVar * CVarManagerImpl::registerCVarString(const char * const name, const char * const description,
-                                           const std::uint32_t flags, const std::string & initValue,
-                                           const char ** allowedStrings, CVarValueCompletionCallback completionCb)
+    char * heapChars;                              // Buffer for the long strings. Null until needed.
+    int    heapCapacity;                           // Size in chars of heapChars, including the terminator.
+    int    length;                                 // Length not counting the null terminator.
+    char   inlineChars[CFG_CVAR_STRING_INLINE_SIZE]; // Storage for the short strings.
+};
+
+// ========================================================
+// cvarToX() functions:
+// ========================================================
+
+//
+// int64_t:
+//
+
+static inline std::int64_t cvarToInt64(const std::int64_t val)
 {
-    if (!validateCVarRegistration(name, flags, initValue, &CVar::getStringValue))
-    {
-        return nullptr;
-    }
+    return val;
+}
 
-    auto newVar = memAlloc<CVarString>(1);
-    construct(newVar, name, description, flags, initValue, CVarAllowedStrings(allowedStrings), completionCb);
-    registeredCVars.linkWithKey(newVar, name);
-    return newVar;
+static inline std::int64_t cvarToInt64(const bool val)
+{
+    return static_cast<std::int64_t>(val);
 }
 
-CVar * CVarManagerImpl::registerCVarEnum(const char * const name, const char * const description,
-                                         const std::uint32_t flags, const std::int64_t initValue,
-                                         const std::int64_t * const enumConstants, const char ** constNames,
-                                         CVarValueCompletionCallback completionCb)
+static inline std::int64_t cvarToInt64(const double val)
 {
-    if (!validateCVarRegistration(name, flags, initValue, &CVar::getIntValue))
-    {
-        return nullptr;
-    }
+    return static_cast<std::int64_t>(val);
+}
 
-    CVarEnumConst enumValue = { "", initValue };
-    CVarEnumConstList enumConstList(enumConstants, constNames);
+static inline std::int64_t cvarToInt64(const CVarEnumConst & enumConst)
+{
+    return enumConst.value;
+}
 
-    // Find the name from provided values and const names:
-    if (enumConstList.names != nullptr && enumConstList.values != nullptr)
+static inline std::int64_t cvarToInt64(const char * const str, bool * outOkFlag = nullptr)
+{
+    std::int64_t num;
+    if (parseInt64(str, lengthOfString(str), &num) == 0)
     {
-        for (int c = 0; enumConstList.names[c] != nullptr; ++c)
-        {
-            if (enumConstList.values[c] == initValue)
-            {
-                enumValue.name = enumConstList.names[c];
-                break;
-            }
-        }
+        errorF("No available conversion from \"%s\" to integer number.", str);
+        if (outOkFlag != nullptr) { *outOkFlag = false; }
+        return 0;
     }
 
-    auto newVar = memAlloc<CVarEnum>(1);
-    construct(newVar, name, description, flags, enumValue, enumConstList, completionCb);
-    registeredCVars.linkWithKey(newVar, name);
-    return newVar;
+    if (outOkFlag != nullptr) { *outOkFlag = true; }
+    return num;
 }
 
-bool CVarManagerImpl::getCVarValueBool(const char * const name) const
+static inline std::int64_t cvarToInt64(const CVarStringValue & str)
 {
-    if (const auto cvar = findCVar(name))
-    {
-        return cvar->getBoolValue();
-    }
-    errorF("CVar '%s' not found.", name);
-    return false;
+    return cvarToInt64(str.c_str());
 }
 
-std::int64_t CVarManagerImpl::getCVarValueInt(const char * const name) const
+//
+// double:
+//
+
+static inline double cvarToDouble(const std::int64_t val)
 {
-    if (const auto cvar = findCVar(name))
-    {
-        return cvar->getIntValue();
-    }
-    errorF("CVar '%s' not found.", name);
-    return 0;
+    return static_cast<double>(val);
 }
 
-double CVarManagerImpl::getCVarValueFloat(const char * const name) const
+static inline double cvarToDouble(const bool val)
 {
-    if (const auto cvar = findCVar(name))
-    {
-        return cvar->getFloatValue();
-    }
-    errorF("CVar '%s' not found.", name);
-    return 0.0;
+    return static_cast<double>(val);
 }
 
-std::string CVarManagerImpl::getCVarValueString(const char * const name) const
+static inline double cvarToDouble(const double val)
 {
-    std::string str;
-    if (const auto cvar = findCVar(name))
-    {
-        str = cvar->getStringValue();
-        return str;
-    }
-    errorF("CVar '%s' not found.", name);
-    return str;
+    return val;
 }
 
-CVar * CVarManagerImpl::setCVarValueBool(const char * const name, const bool value, const std::uint32_t flags)
+static inline double cvarToDouble(const CVarEnumConst & enumConst)
 {
-    if (auto cvar = findCVar(name))
-    {
-        cvar->setBoolValue(value);
-        return cvar;
-    }
-    return registerCVarBool(name, "", flags, value);
+    return static_cast<double>(enumConst.value);
 }
 
-CVar * CVarManagerImpl::setCVarValueInt(const char * const name, const std::int64_t value, const std::uint32_t flags)
+static inline double cvarToDouble(const char * const str, bool * outOkFlag = nullptr)
 {
-    if (auto cvar = findCVar(name))
+    double num;
+    if (parseDouble(str, lengthOfString(str), &num) == 0)
     {
-        cvar->setIntValue(value);
-        return cvar;
+        errorF("No available conversion from \"%s\" to floating-point number.", str);
+        if (outOkFlag != nullptr) { *outOkFlag = false; }
+        return 0.0;
     }
-    return registerCVarInt(name, "", flags, value, INT64_MIN, INT64_MAX);
+
+    if (outOkFlag != nullptr) { *outOkFlag = true; }
+    return num;
 }
 
-CVar * CVarManagerImpl::setCVarValueFloat(const char * const name, const double value, const std::uint32_t flags)
+static inline double cvarToDouble(const CVarStringValue & str)
 {
-    if (auto cvar = findCVar(name))
-    {
-        cvar->setFloatValue(value);
-        return cvar;
-    }
-    return registerCVarFloat(name, "", flags, value, DBL_MIN, DBL_MAX);
+    return cvarToDouble(str.c_str());
 }
 
-CVar * CVarManagerImpl::setCVarValueString(const char * const name, const std::string & value, const std::uint32_t flags)
+//
+// char buffer:
+//
+// The value is formatted into a caller buffer, which is always null terminated,
+// truncating the output if needed. Returns the length of the whole value string,
+// so a return >= destSizeInChars means the output was truncated.
+//
+
+static inline int cvarToChars(char * const destBuf, const int destSizeInChars,
+                              const std::int64_t val, const CVar::NumberFormat numberFormat)
 {
-    if (auto cvar = findCVar(name))
+    int base = 0;
+    switch (numberFormat)
     {
-        cvar->setStringValue(value);
-        return cvar;
+    case CVar::NumberFormat::Binary      : { base = 2;  break; }
+    case CVar::NumberFormat::Octal       : { base = 8;  break; }
+    case CVar::NumberFormat::Decimal     : { base = 10; break; }
+    case CVar::NumberFormat::Hexadecimal : { base = 16; break; }
+    } // switch (numberFormat)
+
+    if (base == 10)
+    {
+        return formatInt64(val, destBuf, destSizeInChars);
     }
-    return registerCVarString(name, "", flags, value, nullptr);
+
+    char numStr[CVarTempStrMaxSize];
+    intToString(static_cast<std::uint64_t>(val), numStr, lengthOfArray(numStr), base, (val < 0));
+    return copyStringTruncated(destBuf, destSizeInChars, numStr, lengthOfString(numStr));
 }
 
-bool CVarManagerImpl::internalSetStringValue(CVar * cvar, std::string value)
+static inline int cvarToChars(char * const destBuf, const int destSizeInChars,
+                              const bool val, CVar::NumberFormat)
 {
-    CFG_ASSERT(cvar != nullptr);
+    // For printing, the first boolean string is always the one used.
+    const BoolCStr * const bStrings = getBoolStrings();
+    const char * const str = (val ? bStrings[0].trueStr : bStrings[0].falseStr);
+    return copyStringTruncated(destBuf, destSizeInChars, str, lengthOfString(str));
+}
 
-    if (!cvar->isWritable() && (allowWritingRomCVars || allowWritingInitCVars))
+static inline int cvarToChars(char * const destBuf, const int destSizeInChars,
+                              const double val, CVar::NumberFormat)
+{
+    #ifdef CFG_FLOAT_PRINT_FMT
+    char numStr[CVarTempStrMaxSize];
+    std::snprintf(numStr, lengthOfArray(numStr), CFG_FLOAT_PRINT_FMT, val);
+
+    const int length = trimTrailingZeros(numStr);
+    return copyStringTruncated(destBuf, destSizeInChars, numStr, length);
+    #else // !CFG_FLOAT_PRINT_FMT
+    return formatDouble(val, destBuf, destSizeInChars);
+    #endif // CFG_FLOAT_PRINT_FMT
+}
+
+static inline int cvarToChars(char * const destBuf, const int destSizeInChars,
+                              const CVarEnumConst & enumConst, const CVar::NumberFormat numberFormat)
+{
+    if (enumConst.name != nullptr && enumConst.name[0] != '\0')
     {
-        return static_cast<CVarImplBase *>(cvar)->setStringValueIgnoreRO(std::move(value),
-                                             allowWritingRomCVars, allowWritingInitCVars);
+        return copyStringTruncated(destBuf, destSizeInChars, enumConst.name, lengthOfString(enumConst.name));
     }
-    else
+    else // Reuse the int=>string conversion:
     {
-        return cvar->setStringValue(std::move(value));
+        return cvarToChars(destBuf, destSizeInChars, enumConst.value, numberFormat);
     }
 }
 
-bool CVarManagerImpl::internalSetDefaultValue(CVar * cvar)
+static inline int cvarToChars(char * const destBuf, const int destSizeInChars,
+                              const CVarStringValue & str, CVar::NumberFormat)
 {
-    CFG_ASSERT(cvar != nullptr);
+    return copyStringTruncated(destBuf, destSizeInChars, str.c_str(), str.size());
+}
 
-    if (!cvar->isWritable() && (allowWritingRomCVars || allowWritingInitCVars))
+//
+// std::string:
+//
+
+template<typename T>
+static inline void cvarToString(std::string * result, const T & val, const CVar::NumberFormat numberFormat)
+{
+    // Numbers and booleans always fit in a temp string.
+    char numStr[CVarTempStrMaxSize];
+    const int length = cvarToChars(numStr, lengthOfArray(numStr), val, numberFormat);
+    result->assign(numStr, length);
+}
+
+static inline void cvarToString(std::string * result, const CVarEnumConst & enumConst,
+                                const CVar::NumberFormat numberFormat)
+{
+    if (enumConst.name != nullptr && enumConst.name[0] != '\0')
     {
-        return static_cast<CVarImplBase *>(cvar)->setDefaultValueIgnoreRO(
-                             allowWritingRomCVars, allowWritingInitCVars);
+        *result = enumConst.name;
     }
-    else
+    else // Reuse the int=>string conversion:
     {
-        return cvar->setDefaultValue();
+        cvarToString(result, enumConst.value, numberFormat);
     }
 }
 
-void CVarManagerImpl::setAllowWritingReadOnlyVars(const bool allow) noexcept
+static inline void cvarToString(std::string * result, const CVarStringValue & str, CVar::NumberFormat)
 {
-    allowWritingRomCVars  = allow;
-    allowWritingInitCVars = allow;
-    // When ReadOnly CVars are set to writable, InitOnly vars
-    // inherit the setting. The opposite is not true.
+    result->assign(str.c_str(), str.size());
 }
 
-void CVarManagerImpl::setAllowWritingInitOnlyVars(const bool allow) noexcept
+static inline void cvarToString(std::string * result, std::string str, CVar::NumberFormat)
 {
-    allowWritingInitCVars = allow;
+    *result = std::move(str);
 }
 
 // ========================================================
-// Virtual destructors anchored to this file:
+// cvarSetX() functions:
 // ========================================================
 
-CVar::~CVar()
-{ }
-
-CVarImplBase::~CVarImplBase()
-{ }
-
-CVarManager::~CVarManager()
-{ }
-
-// ================================================================================================
 //
-//                                      Console Commands
+// int64_t:
 //
-// ================================================================================================
-
-// ========================================================
-// CommandArgs implementation:
-// ========================================================
-
-CommandArgs::CommandArgs()
-    : CommandArgs(nullptr)
-{ }
-
-CommandArgs::CommandArgs(const char * const cmdStr)
-    : argCount(0)
-    , nextTokenIndex(0)
-    , cmdName(nullptr)
-{
-    clearArray(argStrings);
-    clearArray(tokenizedArgStr);
-
-    if (cmdStr != nullptr)
-    {
-        parseArgString(cmdStr);
-    }
-}
 
-CommandArgs::CommandArgs(const int argc, const char * argv[])
-    : CommandArgs(nullptr)
+static inline bool cvarSetInt64(std::int64_t * outVal, const std::int64_t newVal,
+                                const CVarNumberRange<std::int64_t> * valueRange, CVar::NumberFormat)
 {
-    CFG_ASSERT(argc >= 1);
-    CFG_ASSERT(argv != nullptr);
-
-    // Command/prog name:
-    cmdName = appendToken(argv[0], lengthOfString(argv[0]));
-
-    for (int i = 1; i < argc; ++i)
+    if (valueRange != nullptr)
     {
-        const char * const argStr = appendToken(argv[i], lengthOfString(argv[i]));
-        if (!addArgString(argStr))
+        if (newVal < valueRange->minValue)
         {
-            break;
+            return errorF("Value " CFG_I64_PRINT_FMT " below minimum (" CFG_I64_PRINT_FMT ").",
+                          newVal, valueRange->minValue);
+        }
+        else if (newVal > valueRange->maxValue)
+        {
+            return errorF("Value " CFG_I64_PRINT_FMT " above maximum (" CFG_I64_PRINT_FMT ").",
+                          newVal, valueRange->maxValue);
         }
     }
+    *outVal = newVal;
+    return true;
 }
 
-CommandArgs::CommandArgs(const CommandArgs & other)
+static inline bool cvarSetInt64(bool * outVal, const std::int64_t newVal,
+                                const CVarNumberRange<bool> *, CVar::NumberFormat)
 {
-    *this = other;
+    // Range never checked for booleans.
+    // Anything above zero is true, else false.
+    *outVal = (newVal > 0);
+    return true;
 }
 
-CommandArgs & CommandArgs::operator = (const CommandArgs & other)
+static inline bool cvarSetInt64(double * outVal, const std::int64_t newVal,
+                                const CVarNumberRange<double> * valueRange, CVar::NumberFormat)
 {
-    if (this == &other)
+    if (valueRange != nullptr)
     {
-        return *this;
+        if (newVal < valueRange->minValue)
+        {
+            return errorF("Value " CFG_I64_PRINT_FMT " below minimum (%f).",
+                          newVal, valueRange->minValue);
+        }
+        else if (newVal > valueRange->maxValue)
+        {
+            return errorF("Value " CFG_I64_PRINT_FMT " above maximum (%f).",
+                          newVal, valueRange->maxValue);
+        }
     }
+    *outVal = static_cast<double>(newVal);
+    return true;
+}
 
-    // Reset the current:
-    argCount       = 0;
-    nextTokenIndex = 0;
-
-    clearArray(argStrings);
-    clearArray(tokenizedArgStr);
+static inline bool cvarSetInt64(CVarEnumConst * outVal, const std::int64_t newVal,
+                                const CVarEnumConstList * enumConstants, CVar::NumberFormat)
+{
+    if (enumConstants != nullptr && enumConstants->names != nullptr)
+    {
+        const int c = enumConstants->findValue(newVal);
+        if (c < 0)
+        {
+            return false; // Value not a member of this enum.
+        }
+        outVal->name  = enumConstants->names[c];
+        outVal->value = enumConstants->values[c];
+        return true;
+    }
+    else
+    {
+        outVal->name  = ""; // Can't figure out the constant name without a const list.
+        outVal->value = newVal;
+        return true;
+    }
+}
 
-    cmdName = appendToken(other.getCommandName(), lengthOfString(other.getCommandName()));
+static inline bool cvarSetInt64(CVarStringValue * outVal, const std::int64_t newVal,
+                                const CVarAllowedStrings * allowedStrings,
+                                const CVar::NumberFormat numberFormat)
+{
+    char tempStr[CVarTempStrMaxSize];
+    const int length = cvarToChars(tempStr, lengthOfArray(tempStr), newVal, numberFormat);
 
-    for (int i = 0; i < other.getArgCount(); ++i)
+    if (allowedStrings != nullptr && allowedStrings->strings != nullptr)
     {
-        const char * const argStr = appendToken(other.getArgAt(i),
-                               lengthOfString(other.getArgAt(i)));
-
-        // Don't bother checking since if all arguments fit in
-        // the source CommandArgs, they must fit in here too!
-        addArgString(argStr);
+        if (allowedStrings->find(tempStr, length) < 0)
+        {
+            return false;
+        }
+        outVal->assign(tempStr, length);
+        return true;
+    }
+    else
+    {
+        outVal->assign(tempStr, length);
+        return true;
     }
+}
 
-    return *this;
+//
+// double:
+//
+
+static inline bool cvarSetDouble(std::int64_t * outVal, const double newVal,
+                                 const CVarNumberRange<std::int64_t> * valueRange)
+{
+    if (valueRange != nullptr)
+    {
+        if (newVal < valueRange->minValue)
+        {
+            return errorF("Value %f below minimum (" CFG_I64_PRINT_FMT ").",
+                          newVal, valueRange->minValue);
+        }
+        else if (newVal > valueRange->maxValue)
+        {
+            return errorF("Value %f above maximum (" CFG_I64_PRINT_FMT ").",
+                          newVal, valueRange->maxValue);
+        }
+    }
+    *outVal = static_cast<std::int64_t>(newVal);
+    return true;
 }
 
-const char * CommandArgs::getCommandName() const noexcept
+static inline bool cvarSetDouble(bool * outVal, const double newVal,
+                                 const CVarNumberRange<bool> *)
 {
-    return cmdName;
+    *outVal = (newVal > 0.0);
+    return true;
 }
 
-int CommandArgs::getArgCount() const noexcept
+static inline bool cvarSetDouble(double * outVal, const double newVal,
+                                 const CVarNumberRange<double> * valueRange)
 {
-    return argCount;
+    if (valueRange != nullptr)
+    {
+        if (newVal < valueRange->minValue)
+        {
+            return errorF("Value %f below minimum (%f).", newVal, valueRange->minValue);
+        }
+        else if (newVal > valueRange->maxValue)
+        {
+            return errorF("Value %f above maximum (%f).", newVal, valueRange->maxValue);
+        }
+    }
+    *outVal = newVal;
+    return true;
 }
 
-bool CommandArgs::isEmpty() const noexcept
+static inline bool cvarSetDouble(CVarEnumConst * outVal, const double newVal,
+                                 const CVarEnumConstList * enumConstants)
 {
-    return argCount == 0;
+    // Enums can only be integers, so we can reuse this other function.
+    return cvarSetInt64(outVal, static_cast<std::int64_t>(newVal),
+                        enumConstants, CVar::NumberFormat::Decimal);
 }
 
-const char * CommandArgs::operator[](const int index) const
+static inline bool cvarSetDouble(CVarStringValue * outVal, const double newVal,
+                                 const CVarAllowedStrings * allowedStrings)
 {
-    return getArgAt(index);
+    char tempStr[CVarTempStrMaxSize];
+    const int length = cvarToChars(tempStr, lengthOfArray(tempStr), newVal, CVar::NumberFormat::Decimal);
+
+    if (allowedStrings != nullptr && allowedStrings->strings != nullptr)
+    {
+        if (allowedStrings->find(tempStr, length) < 0)
+        {
+            return false;
+        }
+        outVal->assign(tempStr, length);
+        return true;
+    }
+    else
+    {
+        outVal->assign(tempStr, length);
+        return true;
+    }
 }
 
-const char * CommandArgs::getArgAt(const int index) const
+//
+// std::string:
+//
+
+static inline bool cvarSetString(std::int64_t * outVal, const char * const newVal,
+                                 const CVarNumberRange<std::int64_t> * valueRange)
 {
-    CFG_ASSERT(index >= 0 && index < argCount);
-    CFG_ASSERT(argStrings[index] != nullptr);
-    return argStrings[index];
+    bool ok;
+    const auto temp = cvarToInt64(newVal, &ok);
+    if (!ok)
+    {
+        return false;
+    }
+    return cvarSetInt64(outVal, temp, valueRange, CVar::NumberFormat::Decimal);
 }
 
-const char * const * CommandArgs::begin() const noexcept
+static inline bool cvarSetString(bool * outVal, const char * const newVal,
+                                 const CVarNumberRange<bool> *)
 {
-    return argStrings;
+    const BoolCStr * const bStrings = getBoolStrings();
+    bool bFound = false;
+
+    for (int s = 0; bStrings[s].trueStr != nullptr; ++s)
+    {
+        if (cvarCmpStrings(bStrings[s].trueStr, newVal) == 0)
+        {
+            bFound  = true;
+            *outVal = true;
+            break;
+        }
+        if (cvarCmpStrings(bStrings[s].falseStr, newVal) == 0)
+        {
+            bFound  = true;
+            *outVal = false;
+            break;
+        }
+    }
+
+    return (bFound ? true : errorF("Can't set boolean CVar from string \"%s\".", newVal));
 }
 
-const char * const * CommandArgs::end() const noexcept
+static inline bool cvarSetString(double * outVal, const char * const newVal,
+                                 const CVarNumberRange<double> * valueRange)
 {
-    return argStrings + argCount;
+    bool ok;
+    const auto temp = cvarToDouble(newVal, &ok);
+    if (!ok)
+    {
+        return false;
+    }
+    return cvarSetDouble(outVal, temp, valueRange);
 }
 
-int CommandArgs::compare(const int argIndex, const char * const str) const
+static inline bool cvarSetString(CVarEnumConst * outVal, const char * const newVal,
+                                 const CVarEnumConstList * enumConstants)
 {
-    CFG_ASSERT(str != nullptr);
-    if (argIndex < 0 || argIndex >= argCount)
+    if (enumConstants != nullptr && enumConstants->names != nullptr)
     {
-        return -1;
+        const int c = enumConstants->findName(newVal);
+        if (c < 0)
+        {
+            return false; // Value not a member of this enum.
+        }
+        outVal->name  = enumConstants->names[c];
+        outVal->value = enumConstants->values[c];
+        return true;
+    }
+    else
+    {
+        // Assume the value is numeric:
+        std::int64_t temp;
+        if (cvarSetString(&temp, newVal, nullptr))
+        {
+            outVal->name  = "";
+            outVal->value = temp;
+            return true;
+        }
+        return false;
     }
-    return std::strcmp(getArgAt(argIndex), str);
 }
 
-void CommandArgs::parseArgString(const char * argStr)
+//
+// (chars, length):
+//
+// The value string doesn't have to be null terminated.
+//
+
+static inline bool cvarSetChars(std::int64_t * outVal, const char * const newVal, const int newLength,
+                                const CVarNumberRange<std::int64_t> * valueRange)
 {
-    CFG_ASSERT(argStr != nullptr);
+    std::int64_t temp;
+    if (parseInt64(newVal, newLength, &temp) == 0)
+    {
+        return errorF("No available conversion from \"%.*s\" to integer number.", newLength, newVal);
+    }
+    return cvarSetInt64(outVal, temp, valueRange, CVar::NumberFormat::Decimal);
+}
 
-    // First argument should be the unquoted command/program name.
-    // Command string might be preceded by whitespace.
+static inline bool cvarSetChars(double * outVal, const char * const newVal, const int newLength,
+                                const CVarNumberRange<double> * valueRange)
+{
+    double temp;
+    if (parseDouble(newVal, newLength, &temp) == 0)
+    {
+        return errorF("No available conversion from \"%.*s\" to floating-point number.", newLength, newVal);
+    }
+    return cvarSetDouble(outVal, temp, valueRange);
+}
 
-    int          argLen      = 0;
-    int          quoteCount  = 0;
-    bool         firstArg    = true;
-    bool         quoted      = false;
-    bool         singleQuote = false;
-    bool         done        = false;
-    const char * newArg      = nullptr;
-    const char * argStart    = nullptr;
+template<typename T, typename ValueRange>
+static inline bool cvarSetChars(T * outVal, const char * const newVal, const int newLength,
+                                const ValueRange * valueRange)
+{
+    // Numbers, booleans and enum names are parsed from a null terminated copy.
+    char tempStr[CVarTempStrMaxSize];
+    if (newLength < CVarTempStrMaxSize)
+    {
+        std::memcpy(tempStr, newVal, newLength);
+        tempStr[newLength] = '\0';
+        return cvarSetString(outVal, tempStr, valueRange);
+    }
+    return cvarSetString(outVal, std::string(newVal, newLength).c_str(), valueRange);
+}
 
-    for (; *argStr != '\0' && !done; ++argStr)
+static inline bool cvarSetChars(CVarStringValue * outVal, const char * const newVal, const int newLength,
+                                const CVarAllowedStrings * allowedStrings)
+{
+    if (allowedStrings != nullptr && allowedStrings->strings != nullptr)
     {
-        switch (*argStr)
+        if (allowedStrings->find(newVal, newLength) < 0)
         {
-        // Quotes:
-        //  Indicate that this arg won't end until
-        //  the next enclosing quote is found.
-        case '"' :
-            {
-                ++quoteCount;
-                quoted = quoteCount & 1;
-                if (argStart == nullptr)
-                {
-                    argStart = argStr;
-                }
-                break;
-            }
-        // Simple quotes are allowed to start an argument string
-        // and can also appear inside a double-quoted block.
-        case '\'' :
-            {
-                if (!quoted)
-                {
-                    ++quoteCount;
-                    quoted = quoteCount & 1;
-                    singleQuote = true;
-                }
-                else if (singleQuote)
-                {
-                    ++quoteCount;
-                    quoted = quoteCount & 1;
-                    singleQuote = false;
-                }
-
-                if (argStart == nullptr)
-                {
-                    argStart = argStr;
-                }
-                break;
-            }
-        // Whitespace:
-        //  Separate each individual argument of a command
-        //  line if we are not inside a quoted string.
-        case  ' ' :
-        case '\t' :
-        case '\n' :
-        case '\r' :
-            {
-                if (!quoted && argStart != nullptr)
-                {
-                    argLen = static_cast<int>(argStr - argStart);
-                    newArg = appendToken(argStart, argLen);
-                    argStart = nullptr;
-                    if (firstArg)
-                    {
-                        cmdName = newArg;
-                        firstArg = false;
-                    }
-                    else
-                    {
-                        if (!addArgString(newArg))
-                        {
-                            done = true; // Arg limit reached.
-                        }
-                    }
-                }
-                break;
-            }
-        // Start of a new argument or continuing an already started one.
-        default :
-            {
-                if (argStart == nullptr)
-                {
-                    argStart = argStr;
-                }
-                break;
-            }
-        } // switch (*argStr)
-    }
-
-    // End reached with an open quote?
-    // We don't trash the arguments completely in such case. Some parameters
-    // might still be valid. Failing will be up to the command handler.
-    if (quoted)
-    {
-        errorF("Attention! Command string ended with open quotation block!");
-        // Allow it to proceed.
-    }
-
-    // Last residual argument before the end of the string.
-    if (argStart != nullptr)
-    {
-        argLen = static_cast<int>(argStr - argStart);
-        newArg = appendToken(argStart, argLen);
-        if (firstArg)
-        {
-            cmdName = newArg;
-        }
-        else
-        {
-            addArgString(newArg);
+            return false;
         }
-    }
-}
-
-bool CommandArgs::addArgString(const char * const argStr)
-{
-    if (argStr == nullptr)
-    {
-        return errorF("Null token! CommandArgs::tokenizedArgStr[] depleted?");
-    }
-    else if (argCount == MaxCommandArguments)
-    {
-        return errorF("Too many arguments! Ignoring extraneous ones...");
+        outVal->assign(newVal, newLength);
+        return true;
     }
     else
     {
-        argStrings[argCount++] = argStr;
+        outVal->assign(newVal, newLength);
         return true;
     }
 }
 
-const char * CommandArgs::appendToken(const char * token, int tokenLen)
-{
-    if ((nextTokenIndex + tokenLen) >= MaxCommandArgStrLength)
-    {
-        errorF("Command argument string too long! Max is %i characters.", MaxCommandArgStrLength - 1);
-        return nullptr;
-    }
+// ========================================================
+// cvarValueCompletion() functions:
+// ========================================================
 
-    // If the token is enclosed in single or double quotes, ignore them.
-    // Note that this assumes the opening AND closing quotes are present!
-    char * outTokenPtr = &tokenizedArgStr[nextTokenIndex];
-    if (token[0] == '"' || token[0] == '\'')
+// Number ranges just list the min and max values, regardless of the partial value.
+template<typename T>
+static inline int cvarValueCompletion(const CVarNumberRange<T> & valueRange, const char *,
+                                      std::string * outMatches, const int maxMatches,
+                                      const CVar::NumberFormat numberFormat)
+{
+    const int count = std::min(maxMatches, valueRange.getCount());
+    for (int v = 0; v < count; ++v)
     {
-        ++token;
-        tokenLen -= 2;
+        cvarToString(&outMatches[v], valueRange.getValue(v), numberFormat);
     }
+    return valueRange.getCount();
+}
 
-    std::memcpy(outTokenPtr, token, tokenLen);
-    nextTokenIndex += (tokenLen + 1);
-    outTokenPtr[tokenLen] = '\0';
-
-    return outTokenPtr;
+// Allowed strings and enum constants are searched by prefix.
+template<typename ValueList>
+static inline int cvarValueCompletion(const ValueList & valueList, const char * const partialVal,
+                                      std::string * outMatches, const int maxMatches, CVar::NumberFormat)
+{
+    return valueList.findWithPrefix((partialVal != nullptr ? partialVal : ""), outMatches, maxMatches);
 }
 
 // ========================================================
-// class CommandImplBase:
+// cvarValuePtr() functions:
 // ========================================================
 
-#if CFG_PACK_STRUCTURES
-    #pragma pack(push, 1)
-#endif // CFG_PACK_STRUCTURES
+//
+// Address of the value a CVarRef reads. Enums
+// are referenced by their integer value.
+//
 
-class CommandImplBase
-    : public HashTableLink<CommandImplBase>
-    , public Command
+template<typename T>
+static inline const void * cvarValuePtr(const T & val)
 {
-public:
+    return &val;
+}
 
-    // Not copyable.
-    CommandImplBase(const CommandImplBase &) = delete;
-    CommandImplBase & operator = (const CommandImplBase &) = delete;
+static inline const void * cvarValuePtr(const CVarEnumConst & enumConst)
+{
+    return &enumConst.value;
+}
 
-    // Construct with common parameters. Description may be null or an empty string.
-    // Min and max args may be negative to disable CommandManager-side argument count
-    // validation. Flags are any user defined set of integer bit-flags, including zero.
-    CommandImplBase(const char * cmdName,
-                    const char * cmdDesc,
-                    std::uint32_t cmdFlags,
-                    int minCmdArgs,
-                    int maxCmdArgs);
+// ========================================================
+// class CVarValueHolder:
+// ========================================================
 
-    virtual ~CommandImplBase() = default;
-    virtual void onExecute(const CommandArgs & args);
-    virtual bool isAlias() const override;
-    virtual int argumentCompletion(const char  * partialArg,
-                                   std::string * outMatches,
-                                   int maxMatches) const override;
+//
+// Storage for the current value of a CVar. When CFG_THREAD_SAFE_CVARS
+// is enabled, values can be loaded from any thread while the owner
+// thread stores new ones. Otherwise this is just a plain value.
+//
+// getValuePtr() gives the address read by the typed CVarRefs.
+//
 
-    std::uint32_t getFlags() const override;
-    void setFlags(std::uint32_t newFlags) override;
+#if CFG_THREAD_SAFE_CVARS
 
-    const char * getNameCString() const override;
-    const char * getDescCString() const override;
+//
+// Int, bool and float values are plain atomics.
+//
+template<typename T>
+class CVarValueHolder final
+{
+public:
 
-    std::string getName() const override;
-    std::string getDesc() const override;
+    explicit CVarValueHolder(const T & initValue)
+        : value(initValue)
+    { }
 
-    int getMinArgs() const override;
-    int getMaxArgs() const override;
+    T load() const noexcept
+    {
+        return value.load(std::memory_order_acquire);
+    }
 
-private:
+    void store(const T & newValue) noexcept
+    {
+        value.store(newValue, std::memory_order_release);
+    }
 
-    // Opaque user defined bitflags. Can be changed after construction.
-    std::uint32_t flags;
+    const void * getValuePtr() const noexcept
+    {
+        return &value;
+    }
 
-    // We don't need the full range of an integer for the arg counts.
-    // A command will have at most half a dozen args, in the rare case.
-    const std::int8_t minArgs;
-    const std::int8_t maxArgs;
+private:
 
-    // A name must always be provided. Description may be an empty string.
-    char name[MaxCommandNameLength];
-    char desc[MaxCommandDescLength];
+    std::atomic<T> value;
 };
 
-#if CFG_PACK_STRUCTURES
-    #pragma pack(pop)
-#endif // CFG_PACK_STRUCTURES
+//
+// Enum constants are a {name, value} pair that must be read together,
+// so they get a sequence lock. The integer value is still an atomic of
+// its own, which allows the CVarRefs to read it with a single load.
+//
+template<>
+class CVarValueHolder<CVarEnumConst> final
+{
+public:
 
-// ========================================================
-// CommandImplBase implementation:
-// ========================================================
+    explicit CVarValueHolder(const CVarEnumConst & initValue)
+        : sequence(0)
+        , name(initValue.name)
+        , value(initValue.value)
+    { }
 
-CommandImplBase::CommandImplBase(const char * const cmdName,
-                                 const char * const cmdDesc,
-                                 const std::uint32_t cmdFlags,
-                                 const int minCmdArgs,
-                                 const int maxCmdArgs)
-    : flags(cmdFlags)
-    , minArgs(static_cast<std::int8_t>(minCmdArgs))
-    , maxArgs(static_cast<std::int8_t>(maxCmdArgs))
-{
-    CFG_ASSERT(minCmdArgs <= MaxCommandArguments);
-    CFG_ASSERT(maxCmdArgs <= MaxCommandArguments);
+    CVarEnumConst load() const noexcept
+    {
+        CVarEnumConst result;
+        std::uint32_t seqBefore, seqAfter;
+        do {
+            seqBefore    = sequence.load(std::memory_order_acquire);
+            result.name  = name.load(std::memory_order_relaxed);
+            result.value = value.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seqAfter     = sequence.load(std::memory_order_relaxed);
+        } while ((seqBefore & 1) || seqBefore != seqAfter);
+        return result;
+    }
 
-    CFG_ASSERT(cmdName != nullptr && *cmdName != '\0');
-    CFG_ASSERT(lengthOfString(cmdName) < MaxCommandNameLength);
+    void store(const CVarEnumConst & newValue) noexcept
+    {
+        // An odd sequence number marks a write in progress.
+        std::uint32_t seq = sequence.load(std::memory_order_relaxed);
+        while ((seq & 1) || !sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire))
+        {
+            seq = sequence.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
 
-    clearArray(name);
-    clearArray(desc);
-    copyString(name, lengthOfArray(name), cmdName);
+        name.store(newValue.name,   std::memory_order_relaxed);
+        value.store(newValue.value, std::memory_order_relaxed);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
 
-    // Description comment is optional.
-    if (cmdDesc != nullptr && *cmdDesc != '\0')
+    const void * getValuePtr() const noexcept
     {
-        CFG_ASSERT(lengthOfString(cmdDesc) < MaxCommandDescLength);
-        copyString(desc, lengthOfArray(desc), cmdDesc);
+        return &value;
     }
-}
 
-void CommandImplBase::onExecute(const CommandArgs & /* args */)
-{
-    // Default no-op command handler.
-}
+private:
 
-bool CommandImplBase::isAlias() const
-{
-    return false;
-}
+    std::atomic<std::uint32_t> sequence;
+    std::atomic<const char *>  name;
+    std::atomic<std::int64_t>  value;
+};
 
-int CommandImplBase::argumentCompletion(const char  * /* partialArg */,
-                                        std::string * /* outMatches */,
-                                        int /* maxMatches */) const
+//
+// Strings can't be read atomically, so each string CVar has a
+// writer-preferring reader/writer spin lock. Readers only hold it
+// while copying the string. The new string is built and the old one
+// freed outside of the lock, so writers hold it for a swap only.
+//
+template<>
+class CVarValueHolder<CVarStringValue> final
 {
-    // Default no-op completion handler.
-    return 0;
-}
+public:
 
-std::uint32_t CommandImplBase::getFlags() const
-{
-    return flags;
-}
+    explicit CVarValueHolder(const CVarStringValue & initValue)
+        : lockState(0)
+        , value(initValue)
+    { }
 
-void CommandImplBase::setFlags(const std::uint32_t newFlags)
-{
-    flags = newFlags;
-}
+    CVarStringValue load() const
+    {
+        lockShared();
+        CVarStringValue result{ value };
+        unlockShared();
+        return result;
+    }
 
-const char * CommandImplBase::getNameCString() const
-{
-    return name;
-}
+    void store(CVarStringValue newValue)
+    {
+        lockExclusive();
+        value.swap(newValue);
+        unlockExclusive();
+    } // Old value freed here.
 
-const char * CommandImplBase::getDescCString() const
-{
-    return desc;
-}
+    int copyChars(char * const destBuf, const int destSizeInChars) const
+    {
+        lockShared();
+        const int length = cvarToChars(destBuf, destSizeInChars, value, CVar::NumberFormat::Decimal);
+        unlockShared();
+        return length;
+    }
 
-std::string CommandImplBase::getName() const
-{
-    return name;
-}
+    // Unlocked access. Only safe on the thread that stores the values.
+    const CVarStringValue & view() const noexcept
+    {
+        return value;
+    }
 
-std::string CommandImplBase::getDesc() const
-{
-    return desc;
-}
+    const void * getValuePtr() const noexcept
+    {
+        return this;
+    }
 
-int CommandImplBase::getMinArgs() const
-{
-    return minArgs;
-}
+private:
 
-int CommandImplBase::getMaxArgs() const
-{
-    return maxArgs;
-}
+    static constexpr std::uint32_t WriterBit = 0x80000000;
 
-// ========================================================
-// class CommandImplCallbacks:
-// ========================================================
+    void lockShared() const noexcept
+    {
+        for (;;)
+        {
+            std::uint32_t state = lockState.load(std::memory_order_relaxed);
+            if (!(state & WriterBit) &&
+                lockState.compare_exchange_weak(state, state + 1, std::memory_order_acquire))
+            {
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
 
-//
-// Wraps a pair of C-style function pointers (callbacks) into a
-// CommandImpl that we can insert in the commands hash table.
-//
-class CommandImplCallbacks final
-    : public CommandImplBase
+    void unlockShared() const noexcept
+    {
+        lockState.fetch_sub(1, std::memory_order_release);
+    }
+
+    void lockExclusive() noexcept
+    {
+        // Claim the writer bit first, so new readers back off, then wait for current readers to leave.
+        while (lockState.fetch_or(WriterBit, std::memory_order_acquire) & WriterBit)
+        {
+            std::this_thread::yield();
+        }
+        while (lockState.load(std::memory_order_acquire) != WriterBit)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void unlockExclusive() noexcept
+    {
+        lockState.store(0, std::memory_order_release);
+    }
+
+    mutable std::atomic<std::uint32_t> lockState; // Writer bit + count of active readers.
+    CVarStringValue value;
+};
+
+// CVar flags can also be queried from other threads.
+using CVarFlagsStorage = std::atomic<std::uint32_t>;
+
+#else // !CFG_THREAD_SAFE_CVARS
+
+template<typename T>
+class CVarValueHolder final
 {
 public:
 
-    CommandImplCallbacks(const char * cmdName,
-                         const char * cmdDesc,
-                         std::uint32_t cmdFlags,
-                         int minCmdArgs,
-                         int maxCmdArgs,
-                         CommandHandlerCallback execCb,
-                         CommandArgCompletionCallback argCompleteCb,
-                         void * userCtx);
+    explicit CVarValueHolder(const T & initValue)
+        : value(initValue)
+    { }
 
-    void onExecute(const CommandArgs & args) override;
-    int argumentCompletion(const char  * partialArg,
-                           std::string * outMatches,
-                           int maxMatches) const override;
+    const T & load() const noexcept
+    {
+        return value;
+    }
+
+    const T & view() const noexcept
+    {
+        return value;
+    }
+
+    void store(T newValue)
+    {
+        value = std::move(newValue);
+    }
+
+    const void * getValuePtr() const noexcept
+    {
+        return cvarValueHolderPtr(value);
+    }
 
 private:
 
-    CommandHandlerCallback       execCallback;
-    CommandArgCompletionCallback argCompletionCallback;
-    void *                       userContext;
+    // Strings are read back via the holder, so CVarRef<std::string>
+    // doesn't depend on which holder variant is in use.
+    const void * cvarValueHolderPtr(const CVarStringValue &) const noexcept { return this; }
+    template<typename U> static const void * cvarValueHolderPtr(const U & val) noexcept { return cvarValuePtr(val); }
+
+    T value;
 };
 
-CommandImplCallbacks::CommandImplCallbacks(const char * const cmdName,
-                                           const char * const cmdDesc,
-                                           const std::uint32_t cmdFlags,
-                                           const int minCmdArgs,
-                                           const int maxCmdArgs,
-                                           CommandHandlerCallback execCb,
-                                           CommandArgCompletionCallback argCompleteCb,
-                                           void * userCtx)
-    : CommandImplBase(cmdName, cmdDesc, cmdFlags, minCmdArgs, maxCmdArgs)
-    , execCallback(execCb)
-    , argCompletionCallback(argCompleteCb)
-    , userContext(userCtx)
+using CVarFlagsStorage = std::uint32_t;
+
+#endif // CFG_THREAD_SAFE_CVARS
+
+//
+// Value to chars without going through std::string.
+// With CFG_THREAD_SAFE_CVARS strings are copied under the lock.
+//
+template<typename T>
+static inline int cvarValueToChars(char * const destBuf, const int destSizeInChars,
+                                   const CVarValueHolder<T> & holder, const CVar::NumberFormat numberFormat)
 {
+    return cvarToChars(destBuf, destSizeInChars, holder.load(), numberFormat);
 }
 
-void CommandImplCallbacks::onExecute(const CommandArgs & args)
+#if CFG_THREAD_SAFE_CVARS
+static inline int cvarValueToChars(char * const destBuf, const int destSizeInChars,
+                                   const CVarValueHolder<CVarStringValue> & holder, CVar::NumberFormat)
 {
-    if (execCallback != nullptr)
-    {
-        execCallback(args, userContext);
-    }
+    return holder.copyChars(destBuf, destSizeInChars);
 }
+#endif // CFG_THREAD_SAFE_CVARS
 
-int CommandImplCallbacks::argumentCompletion(const char  * const partialArg,
-                                             std::string * outMatches,
-                                             const int maxMatches) const
+//
+// Only string values can be viewed in place.
+//
+template<typename T>
+static inline bool cvarValueView(const CVarValueHolder<T> &, const char ** outStr, int * outLength)
 {
-    if (argCompletionCallback != nullptr)
-    {
-        return argCompletionCallback(partialArg, outMatches, maxMatches, userContext);
-    }
-    return 0;
+    *outStr    = "";
+    *outLength = 0;
+    return false;
+}
+
+static inline bool cvarValueView(const CVarValueHolder<CVarStringValue> & holder, const char ** outStr, int * outLength)
+{
+    const CVarStringValue & value = holder.view();
+    *outStr    = value.c_str();
+    *outLength = value.size();
+    return true;
 }
 
 // ========================================================
-// class CommandImplDelegates:
+// class CVarValueChars:
 // ========================================================
 
 //
-// Wraps a pair of std::functions (delegates) into a
-// CommandImpl that we can insert in the commands hash table.
+// Current or default value string of a CVar formatted into a stack
+// buffer, so printing or comparing the value doesn't need a temporary
+// std::string. Only values too long for the buffer allocate.
 //
-class CommandImplDelegates final
-    : public CommandImplBase
+class CVarValueChars final
 {
 public:
 
-    CommandImplDelegates(const char * cmdName,
-                         const char * cmdDesc,
-                         std::uint32_t cmdFlags,
-                         int minCmdArgs,
-                         int maxCmdArgs,
-                         CommandHandlerDelegate execDl,
-                         CommandArgCompletionDelegate argComplDl);
+    CVarValueChars(const CVar & cvar, const bool defaultValue = false)
+    {
+        length  = (defaultValue ? cvar.getDefaultValueString(stackChars, lengthOfArray(stackChars))
+                                : cvar.getStringValue(stackChars, lengthOfArray(stackChars)));
+        useLong = (length >= lengthOfArray(stackChars));
+        if (useLong)
+        {
+            longStr = (defaultValue ? cvar.getDefaultValueString() : cvar.getStringValue());
+            length  = static_cast<int>(longStr.size());
+        }
+    }
 
-    void onExecute(const CommandArgs & args) override;
-    int argumentCompletion(const char * partialArg, std::string * outMatches, int maxMatches) const override;
+    const char * c_str() const noexcept { return (useLong ? longStr.c_str() : stackChars); }
+    int size() const noexcept { return length; }
+
+    bool operator == (const CVarValueChars & other) const noexcept
+    {
+        return length == other.length && std::memcmp(c_str(), other.c_str(), length) == 0;
+    }
+
+    bool operator != (const CVarValueChars & other) const noexcept
+    {
+        return !(*this == other);
+    }
 
 private:
 
-    CommandHandlerDelegate       execDelegate;
-    CommandArgCompletionDelegate argCompletionDelegate;
+    char        stackChars[CVarTempStrMaxSize];
+    std::string longStr;
+    int         length;
+    bool        useLong;
 };
 
-CommandImplDelegates::CommandImplDelegates(const char * const cmdName,
-                                           const char * const cmdDesc,
-                                           const std::uint32_t cmdFlags,
-                                           const int minCmdArgs,
-                                           const int maxCmdArgs,
-                                           CommandHandlerDelegate execDl,
-                                           CommandArgCompletionDelegate argCompleteDl)
-    : CommandImplBase(cmdName, cmdDesc, cmdFlags, minCmdArgs, maxCmdArgs)
-    , execDelegate(std::move(execDl))
-    , argCompletionDelegate(std::move(argCompleteDl))
-{
-}
-
-void CommandImplDelegates::onExecute(const CommandArgs & args)
-{
-    if (execDelegate != nullptr)
-    {
-        execDelegate(args);
-    }
-}
+// ========================================================
+// struct CVarRawValue:
+// ========================================================
 
-int CommandImplDelegates::argumentCompletion(const char  * const partialArg,
-                                             std::string * outMatches,
-                                             const int maxMatches) const
+// A CVar value as stored in binary config snapshots.
+// Only the field(s) matching the type tag are used.
+struct CVarRawValue final
 {
-    if (argCompletionDelegate != nullptr)
-    {
-        return argCompletionDelegate(partialArg, outMatches, maxMatches);
-    }
-    return 0;
-}
+    CVar::Type    type;
+    std::int64_t  intValue;     // Int, Bool and Enum.
+    double        floatValue;   // Float.
+    const char *  stringData;   // String. Not null terminated.
+    std::uint32_t stringLength; // String.
+};
 
 // ========================================================
-// class CommandImplMemberFuncs:
+// class CVarImplBase:
 // ========================================================
 
-//
-// Wraps a pair of class methods plus a pointer to the
-// owning object (the "this pointer") allowing a standard
-// C++ class registering a member method as a command handler.
-//
-class CommandImplMemberFuncs final
-    : public CommandImplBase
+class CVarManagerImpl;
+
+class CVarImplBase
+    : public HashTableLink<CVarImplBase>
+    , public CVar
 {
 public:
+    // This empty class serves as glue for the HashTableLink
+    // and CVar, so that CVarManagerImpl can declare a
+    // hash table of CVarImplBases. This is necessary
+    // because CVarImpl is a template, and we want to
+    // store generic pointers in the manger instead.
+    virtual ~CVarImplBase();
 
-    CommandImplMemberFuncs(const char * cmdName,
-                           const char * cmdDesc,
-                           std::uint32_t cmdFlags,
-                           int minCmdArgs,
-                           int maxCmdArgs,
-                           CommandHandlerMemFunc execMf,
-                           CommandHandlerMemFunc argCompleteMf);
+    // Sets the string value regardless of ReadOnly or InitOnly if the proper
+    // flags are passed. This is used internally to set CVars from config files
+    // and startup command line. It will also prevent setting the modified flag
+    // again after setting the value.
+    virtual bool setStringValueIgnoreRO(std::string newValue, bool writeRomCVars, bool writeInitCVars) = 0;
+    virtual bool setDefaultValueIgnoreRO(bool writeRomCVars, bool writeInitCVars) = 0;
 
-    void onExecute(const CommandArgs & args) override;
-    int argumentCompletion(const char * partialArg, std::string * outMatches, int maxMatches) const override;
+    // Same as setStringValueIgnoreRO(), but assigns the typed value from a config snapshot directly.
+    // The raw value type must match the CVar type.
+    virtual bool setRawValueIgnoreRO(const CVarRawValue & newValue, bool writeRomCVars, bool writeInitCVars) = 0;
+
+    // Formats a 'set' command for config file writing.
+    char * toCfgString(char * outBuffer, int bufferSize) const;
+
+    // Address of the stored value read by the typed CVarRefs.
+    virtual const void * getValuePtr() const = 0;
+
+    // Links/unlinks a CVarRef to this var. All references
+    // still linked are reset when the CVar is destroyed.
+    void linkRef(CVarRefBase * ref);
+    void unlinkRef(CVarRefBase * ref);
+
+protected:
+
+    // Change listener hooks for the CVarImpl value setters.
+    // The comparison of old and new values is skipped if nobody is listening.
+    bool hasChangeListeners() const noexcept;
+    void notifyValueChanged();
+
+    // Flag index hook for the CVarImpl flag setters. Only calls
+    // the manager if the var gained flags not yet indexed.
+    void updateFlagIndex(const std::uint32_t newFlags)
+    {
+        if ((newFlags & ~flagIndexMask) != 0)
+        {
+            addToFlagIndex();
+        }
+    }
 
 private:
 
-    CommandHandlerMemFunc execMemFunc;
-    CommandHandlerMemFunc argCompletionMemFunc;
+    friend class CVarManagerImpl;
+    friend class FlagIndex<CVarImplBase>;
+
+    void addToFlagIndex();
+
+    // Head of the list of CVarRefs bound to this var. Kept in the base,
+    // since the CVarRef is not aware of the concrete CVarImpl type.
+    CVarRefBase * refListHead = nullptr;
+
+    // Manager that registered this var and dispatches the change notifications.
+    CVarManagerImpl * owner = nullptr;
+
+    // Number of listeners added for this var only (see CVarManager::addChangeListener()).
+    int changeListenerCount = 0;
+
+    // Set while the var is in the manager's queue of Batched notifications.
+    bool changePending = false;
+
+    // Set while the var is in the manager's list of vars to encode again in the next CVarSnapshot.
+    bool snapshotDirty = false;
+
+    // Flag bits of the manager's FlagIndex lists this var is in.
+    std::uint32_t flagIndexMask = 0;
 };
 
-CommandImplMemberFuncs::CommandImplMemberFuncs(const char * const cmdName,
-                                               const char * const cmdDesc,
-                                               const std::uint32_t cmdFlags,
-                                               const int minCmdArgs,
-                                               const int maxCmdArgs,
-                                               CommandHandlerMemFunc execMf,
-                                               CommandHandlerMemFunc argCompleteMf)
-    : CommandImplBase(cmdName, cmdDesc, cmdFlags, minCmdArgs, maxCmdArgs)
-    , execMemFunc(execMf)
-    , argCompletionMemFunc(argCompleteMf)
+void CVarImplBase::linkRef(CVarRefBase * ref)
 {
-}
+    CFG_ASSERT(ref != nullptr);
+    CFG_ASSERT(ref->cvar == nullptr); // Must be unbound first.
 
-void CommandImplMemberFuncs::onExecute(const CommandArgs & args)
-{
-    if (execMemFunc != nullptr)
+    ref->valuePtr = getValuePtr();
+    ref->cvar     = this;
+    ref->prevRef  = nullptr;
+    ref->nextRef  = refListHead;
+
+    if (refListHead != nullptr)
     {
-        execMemFunc.invoke<void>(args);
+        refListHead->prevRef = ref;
     }
+    refListHead = ref;
 }
 
-int CommandImplMemberFuncs::argumentCompletion(const char  * const partialArg,
-                                               std::string * outMatches,
-                                               const int maxMatches) const
+void CVarImplBase::unlinkRef(CVarRefBase * ref)
 {
-    if (argCompletionMemFunc != nullptr)
+    CFG_ASSERT(ref != nullptr);
+    CFG_ASSERT(ref->cvar == this);
+
+    if (ref->prevRef != nullptr)
     {
-        return argCompletionMemFunc.invoke<int>(partialArg, outMatches, maxMatches);
+        ref->prevRef->nextRef = ref->nextRef;
     }
-    return 0;
+    else
+    {
+        refListHead = ref->nextRef;
+    }
+
+    if (ref->nextRef != nullptr)
+    {
+        ref->nextRef->prevRef = ref->prevRef;
+    }
+
+    ref->valuePtr = nullptr;
+    ref->cvar     = nullptr;
+    ref->prevRef  = nullptr;
+    ref->nextRef  = nullptr;
 }
 
-// ========================================================
-// class CommandImplAlias:
-// ========================================================
+char * CVarImplBase::toCfgString(char * outBuffer, const int bufferSize) const
+{
+    CFG_ASSERT(outBuffer != nullptr);
 
-//
-// Helper used to define command aliases using the same
-// CommandImpl interface. It just stores a copy of the
-// aliased command string. onExecute() pushes this string
-// into the CommandManager buffer.
-//
-class CommandImplAlias final
-    : public CommandImplBase
-{
-public:
-
-    CommandImplAlias(const char * cmdName,
-                     const char * cmdDesc,
-                     const char * cmdStr,
-                     CommandExecMode cmdExec,
-                     CommandManager * cmdMgr);
-
-    ~CommandImplAlias();
-    void onExecute(const CommandArgs & args) override;
-    bool isAlias() const override;
-    char * toCfgString(char * outBuffer, int bufferSize) const;
+    std::string varFlagsString;
+    const std::uint32_t flags = getFlags();
 
-private:
+    // Only the ones that will be created dynamically need the flags.
+    // The ones defined in the C++ code already have their flags set.
+    if (flags & Flags::UserDefined)
+    {
+        if (flags & Flags::Persistent) { varFlagsString += "-persistent "; }
+        if (flags & Flags::Volatile)   { varFlagsString += "-volatile ";   }
+        if (flags & Flags::ReadOnly)   { varFlagsString += "-readonly ";   }
+        if (flags & Flags::InitOnly)   { varFlagsString += "-initonly ";   }
+        if (flags & Flags::Modified)   { varFlagsString += "-modified ";   }
+    }
 
-    const CommandExecMode execMode;
-    CommandManager *      manager;
-    char *                targetCommand;
-};
+    const CVar::Type     varType        = getType();
+    const CVarValueChars varValueString{ *this };
 
-CommandImplAlias::CommandImplAlias(const char * const cmdName,
-                                   const char * const cmdDesc,
-                                   const char * const cmdStr,
-                                   const CommandExecMode cmdExec,
-                                   CommandManager * cmdMgr)
-    : CommandImplBase(cmdName, cmdDesc, 0, 0, 0)
-    , execMode(cmdExec)
-    , manager(cmdMgr)
-    , targetCommand(cloneString(cmdStr))
-{
-    CFG_ASSERT(cmdMgr != nullptr);
+    // set  cvar  value  optional-flags
+    if (!varFlagsString.empty())
+    {
+        if (varType == CVar::Type::String || varType == CVar::Type::Enum)
+        {
+            std::snprintf(outBuffer, bufferSize,
+                          "set %s \"%s\" %s",
+                          getNameCString(), varValueString.c_str(), varFlagsString.c_str());
+        }
+        else // No need to quote the value string.
+        {
+            std::snprintf(outBuffer, bufferSize,
+                          "set %s %s %s",
+                          getNameCString(), varValueString.c_str(), varFlagsString.c_str());
+        }
+    }
+    else
+    {
+        if (varType == CVar::Type::String || varType == CVar::Type::Enum)
+        {
+            std::snprintf(outBuffer, bufferSize,
+                          "set %s \"%s\"",
+                          getNameCString(), varValueString.c_str());
+        }
+        else // No need to quote the value string.
+        {
+            std::snprintf(outBuffer, bufferSize,
+                          "set %s %s",
+                          getNameCString(), varValueString.c_str());
+        }
+    }
+    return outBuffer;
 }
 
-CommandImplAlias::~CommandImplAlias()
-{
-    memFree(targetCommand);
-}
+// ========================================================
+// CVar value comparison for the change notifications:
+// ========================================================
 
-void CommandImplAlias::onExecute(const CommandArgs & /* args */)
+template<typename T>
+static inline bool cvarValueEquals(const T & a, const T & b)
 {
-    manager->execute(execMode, targetCommand);
+    return a == b;
 }
 
-bool CommandImplAlias::isAlias() const
+static inline bool cvarValueEquals(const CVarEnumConst & a, const CVarEnumConst & b)
 {
-    return true;
+    return a.value == b.value && a.name == b.name;
 }
 
-char * CommandImplAlias::toCfgString(char * outBuffer, const int bufferSize) const
+// ========================================================
+// class CVarImpl:
+// ========================================================
+
+template
+<
+    typename ValueType,
+    typename ValueRange,
+    CVar::Type TypeTag
+>
+class CVarImpl final
+    : public CVarImplBase
 {
-    CFG_ASSERT(outBuffer != nullptr);
+public:
 
-    const char * description = getDescCString();
-    const char * modeFlag;
+    // Not copyable.
+    CVarImpl(const CVarImpl &) = delete;
+    CVarImpl & operator = (const CVarImpl &) = delete;
 
-    if (execMode == CommandExecMode::Insert)
+    CVarImpl(const char * const varName, const char * const varDesc,
+             const std::uint32_t varFlags, const ValueType & initValue,
+             const ValueRange & range, const CVarValueCompletionCallback completionCb,
+             MemoryArena * const arena, const bool staticStrings = false)
+        : currentValue(initValue)
+        , defaultValue(initValue)
+        , valueRange(range)
+        , numberFormat(NumberFormat::Decimal)
+        , flags(varFlags)
+        , name(nullptr)
+        , description(nullptr)
+        , valueCompletionCallback(completionCb)
+        , memArena(arena)
+        , ownsStrings(!staticStrings)
     {
-        modeFlag = "-insert";
+        // Must have a name string,
+        CFG_ASSERT(varName != nullptr && *varName != '\0');
+        name = (ownsStrings ? cloneString(varName, memArena) : varName);
+
+        // Description comment is optional.
+        if (varDesc != nullptr && *varDesc != '\0')
+        {
+            description = (ownsStrings ? cloneString(varDesc, memArena) : varDesc);
+        }
+
+        // This would make no sense.
+        if ((varFlags & CVar::Flags::Persistent) && (varFlags & CVar::Flags::Volatile))
+        {
+            errorF("%s: 'Persistent' and 'Volatile' flags are mutually exclusive!", varName);
+        }
     }
-    else if (execMode == CommandExecMode::Immediate)
+
+    ~CVarImpl()
     {
-        modeFlag = "-immediate";
+        // Static strings and value ranges only referenced (see CVarManager::registerCVars()).
+        if (ownsStrings)
+        {
+            memFree(memArena, name);
+            memFree(memArena, description);
+            valueRange.clear(memArena);
+        }
+        else
+        {
+            valueRange.clearIndex(memArena);
+        }
     }
-    else // CommandExecMode::Append
+
+    std::string getName() const override
     {
-        modeFlag = "-append";
+        return getNameCString();
     }
 
-    // alias  name  "cmd-string"  mode-flag  "optional-description"
-    if (*description != '\0')
+    std::string getDesc() const override
     {
-        std::snprintf(outBuffer, bufferSize,
-                      "alias %s \"%s\" %s \"%s\"",
-                      getNameCString(), targetCommand, modeFlag, description);
+        return getDescCString();
     }
-    else
+
+    const char * getNameCString() const override
     {
-        std::snprintf(outBuffer, bufferSize,
-                      "alias %s \"%s\" %s",
-                      getNameCString(), targetCommand, modeFlag);
+        // Name is never null.
+        CFG_ASSERT(name != nullptr);
+        return name;
     }
-    return outBuffer;
-}
 
-// ========================================================
-// Command name string comparisons and sorting:
-// ========================================================
+    const char * getDescCString() const override
+    {
+        // Description can be null, returning an empty string for that case.
+        return (description != nullptr ? description : "");
+    }
 
-static inline int cmdCmpNames(const char * const a, const char * const b, const std::uint32_t count = ~0u)
-{
-    #if CFG_COMMAND_CASE_SENSITIVE_NAMES
-    return std::strncmp(a, b, count);
-    #else // !CFG_COMMAND_CASE_SENSITIVE_NAMES
-    return compareStringsNoCase(a, b, count);
-    #endif // CFG_COMMAND_CASE_SENSITIVE_NAMES
-}
+    std::string getTypeString() const override
+    {
+        return getTypeCString();
+    }
 
-static inline bool cmdNameStartsWith(const char * const name, const char * const prefix)
-{
-    CFG_ASSERT(name   != nullptr);
-    CFG_ASSERT(prefix != nullptr);
+    const char * getTypeCString() const override
+    {
+        static const char * const typeStrings[]
+        {
+            "int",
+            "bool",
+            "float",
+            "string",
+            "enum"
+        };
 
-    const int nameLen   = lengthOfString(name);
-    const int prefixLen = lengthOfString(prefix);
+        const auto index = static_cast<int>(TypeTag);
+        CFG_ASSERT(index < lengthOfArray(typeStrings));
+        return typeStrings[index];
+    }
 
-    if (nameLen < prefixLen)
+    Type getType() const override
     {
-        return false;
+        return TypeTag;
     }
-    else if (nameLen == 0 || prefixLen == 0)
+
+    NumberFormat getNumberFormat() const override
     {
-        return false;
+        return numberFormat;
     }
-    else
+
+    void setNumberFormat(NumberFormat format) override
     {
-        return cmdCmpNames(name, prefix, prefixLen) == 0;
+        numberFormat = format;
     }
-}
-
-static inline void cmdSortMatches(Command ** outMatches, const int count)
-{
-    std::sort(outMatches, outMatches + count,
-              [](const Command * const a, const Command * const b)
-              {
-                  return cmdCmpNames(a->getNameCString(), b->getNameCString()) < 0;
-              });
-}
-
-static inline void cmdSortMatches(const char ** outMatches, const int count)
-{
-    std::sort(outMatches, outMatches + count,
-              [](const char * const a, const char * const b)
-              {
-                  return cmdCmpNames(a, b) < 0;
-              });
-}
 
-// ========================================================
-// class CommandManagerImpl:
-// ========================================================
+    std::uint32_t getFlags() const override
+    {
+        return flags;
+    }
 
-class CommandManagerImpl final
-    : public CommandManager
-{
-public:
+    void setFlags(std::uint32_t newFlags) override
+    {
+        flags = newFlags;
+        updateFlagIndex(newFlags);
+    }
 
-    // Not copyable.
-    CommandManagerImpl(const CommandManagerImpl &) = delete;
-    CommandManagerImpl & operator = (const CommandManagerImpl &) = delete;
+    std::string getFlagsString() const override
+    {
+        std::string str;
 
-    CommandManagerImpl(int hashTableSize, CVarManager * cvarMgr);
-    ~CommandManagerImpl();
+        if (flags & Flags::Modified)    { str += "M "; }
+        if (flags & Flags::Persistent)  { str += "P "; }
+        if (flags & Flags::Volatile)    { str += "V "; }
+        if (flags & Flags::ReadOnly)    { str += "R "; }
+        if (flags & Flags::InitOnly)    { str += "I "; }
+        if (flags & Flags::RangeCheck)  { str += "C "; }
+        if (flags & Flags::UserDefined) { str += "U "; }
 
-    Command * findCommand(const char * name) const override;
-    int findCommandsWithPartialName(const char * partialName, Command ** outMatches, int maxMatches) const override;
-    int findCommandsWithPartialName(const char * partialName, const char ** outMatches, int maxMatches) const override;
-    int findCommandsWithFlags(std::uint32_t flags, Command ** outMatches, int maxMatches) const override;
-
-    bool removeCommand(const char * name) override;
-    bool removeCommand(Command * cmd) override;
-    bool removeCommandAlias(const char * aliasName) override;
-    void removeAllCommands() override;
-    void removeAllCommandAliases() override;
-
-    int getRegisteredCommandsCount() const override;
-    int getCommandAliasCount() const override;
-    bool isValidCommandName(const char * name) const override;
-    void enumerateAllCommands(CommandEnumerateCallback enumCallback, void * userContext) override;
-
-    void disableCommandsWithFlags(std::uint32_t flags) override;
-    void enableAllCommands() override;
-
-    CVarManager * getCVarManager() const override;
-    void setCVarManager(CVarManager * cvarMgr) override;
-
-    bool registerCommand(const char * name,
-                         CommandHandlerCallback handler,
-                         CommandArgCompletionCallback completionHandler = nullptr,
-                         void * userContext       = nullptr,
-                         const char * description = "",
-                         std::uint32_t flags      =  0,
-                         int minArgs              = -1,
-                         int maxArgs              = -1) override;
-
-    bool registerCommand(const char * name,
-                         CommandHandlerDelegate handler,
-                         CommandArgCompletionDelegate completionHandler = nullptr,
-                         const char * description = "",
-                         std::uint32_t flags      =  0,
-                         int minArgs              = -1,
-                         int maxArgs              = -1) override;
-
-    bool registerCommand(const char * name,
-                         CommandHandlerMemFunc handler,
-                         CommandHandlerMemFunc completionHandler = nullptr,
-                         const char * description = "",
-                         std::uint32_t flags      =  0,
-                         int minArgs              = -1,
-                         int maxArgs              = -1) override;
-
-    bool createCommandAlias(const char * aliasName,
-                            const char * aliasedCmdStr,
-                            CommandExecMode execMode,
-                            const char * description = "") override;
-
-    void execNow(const char * str)    override;
-    void execInsert(const char * str) override;
-    void execAppend(const char * str) override;
-    void execute(CommandExecMode execMode, const char * str) override;
-    int  execBufferedCommands(std::uint32_t maxCommandsToExec = ExecAll) override;
-    bool execConfigFile(const char * filename, SimpleCommandTerminal * term) override;
-    void execStartupCommandLine(int argc, const char * argv[]) override;
-    bool hasBufferedCommands() const override;
-
-private:
-
-    template<typename T>
-    int findWithPartialNameHelper(const char * partialName, T * outMatches,
-                                  int maxMatches, T (*pGetCmd)(Command *)) const;
-
-    void execTokenized(const CommandArgs & cmdArgs);
-    bool registerCmdPreValidate(const char * cmdName) const;
-
-    bool extractNextCommand(const char ** outStr, char * destBuf,
-                            int destSizeInChars, bool * outOverflowed) const;
-
-    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
-    bool expandCVar(const char ** outStr, int * outCharsCopied, char * destBuf,
-                    int destSizeInChars, int recursionDepth) const;
-    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
-
-    //
-    // Hash function used to lookup command names in the HT.
-    // Can be case-sensitive or not.
-    //
-    #if CFG_COMMAND_CASE_SENSITIVE_NAMES
-    using CommandNameHasher = StringHasher;
-    #else // !CFG_COMMAND_CASE_SENSITIVE_NAMES
-    using CommandNameHasher = StringHasherNoCase;
-    #endif // CFG_COMMAND_CASE_SENSITIVE_NAMES
-
-    // All the registered commands in a hash table for fast lookup by name.
-    LinkedHashTable<CommandImplBase, CommandNameHasher> registeredCommands;
-
-    // Optional pointer to a CVarManager to provided CVar name expansion and command-style CVar updating.
-    CVarManagerImpl * cvarManager;
-
-    // Commands matching this set of flags will not be allowed to execute.
-    // Zero allows execution of all commands. 'DisableAll' prevents all commands from executing.
-    std::uint32_t disabledCmdFlags;
-
-    // Number of registered CommandImplAlias.
-    int cmdAliasCount;
-
-    // Chars used so far in the cmdBuffer. Up to CommandBufferSize-1,
-    // since the max size must also accommodate a null terminator at the end.
-    int cmdBufferUsed;
-
-    // Buffered commands. Huge string with individual
-    // command+args blocks separated by a semicolon (;).
-    char cmdBuffer[CommandBufferSize];
-};
-
-// ========================================================
-// CommandManagerImpl implementation:
-// ========================================================
-
-CommandManager * CommandManager::createInstance(const int cmdHashTableSizeHint, CVarManager * cvarMgr)
-{
-    auto cmdManager = memAlloc<CommandManagerImpl>(1);
-    return construct(cmdManager, cmdHashTableSizeHint, cvarMgr);
-}
+        if (str.empty())
+        {
+            str = "0";
+        }
+        else if (str.back() == ' ')
+        {
+            str.pop_back();
+        }
 
-void CommandManager::destroyInstance(CommandManager * cmdManager)
-{
-    destroy(cmdManager);
-    memFree(cmdManager);
-}
+        return str;
+    }
 
-CommandManagerImpl::CommandManagerImpl(const int hashTableSize, CVarManager * cvarMgr)
-    : cvarManager(static_cast<CVarManagerImpl *>(cvarMgr))
-    , disabledCmdFlags(0)
-    , cmdAliasCount(0)
-    , cmdBufferUsed(0)
-{
-    if (hashTableSize > 0)
+    void setModified() override
     {
-        registeredCommands.allocate(hashTableSize);
+        flags |= Flags::Modified;
+        updateFlagIndex(Flags::Modified);
     }
-    clearArray(cmdBuffer);
-}
 
-CommandManagerImpl::~CommandManagerImpl()
-{
-    auto cmd = registeredCommands.getFirst();
-    while (cmd != nullptr)
+    void clearModified() override
     {
-        auto temp = cmd->getNext();
-        destroy(cmd);
-        memFree(cmd);
-        cmd = temp;
+        flags &= ~Flags::Modified;
     }
-}
 
-Command * CommandManagerImpl::findCommand(const char * const name) const
-{
-    if (name == nullptr || *name == '\0')
+    bool isWritable() const override
     {
-        return nullptr;
+        return !(flags & (Flags::ReadOnly | Flags::InitOnly));
     }
-    return registeredCommands.findByKey(name);
-}
 
-int CommandManagerImpl::findCommandsWithPartialName(const char * const partialName,
-                                                    Command ** outMatches, const int maxMatches) const
-{
-    return findWithPartialNameHelper<Command *>(partialName, outMatches, maxMatches,
-                                                [](Command * cmd) { return cmd; });
-}
-
-int CommandManagerImpl::findCommandsWithPartialName(const char * const partialName,
-                                                    const char ** outMatches, const int maxMatches) const
-{
-    return findWithPartialNameHelper<const char *>(partialName, outMatches, maxMatches,
-                                                   [](Command * cmd) { return cmd->getNameCString(); });
-}
+    bool isModified() const override
+    {
+        return !!(flags & Flags::Modified);
+    }
 
-int CommandManagerImpl::findCommandsWithFlags(const std::uint32_t flags,
-                                              Command ** outMatches, const int maxMatches) const
-{
-    if (flags == 0)
+    bool isPersistent() const override
     {
-        return 0;
+        return !!(flags & Flags::Persistent);
     }
-    else if (outMatches == nullptr || maxMatches <= 0)
+
+    bool isRangeChecked() const override
     {
-        return -1;
+        return !!(flags & Flags::RangeCheck);
     }
 
-    int matchesFound = 0;
+    int compareNames(const CVar & other) const override
+    {
+        return cvarCmpNames(getNameCString(), other.getNameCString());
+    }
 
-    // Partial name searching unfortunately can't take advantage of the optimized
-    // constant time hash table lookup, so we have to fall back to a linear search.
-    for (auto cmd = registeredCommands.getFirst(); cmd; cmd = cmd->getNext())
+    bool compareEqual(const CVar & other) const override
     {
-        if (cmd->getFlags() & flags)
+        if (getType() != other.getType())
         {
-            if (matchesFound < maxMatches)
-            {
-                outMatches[matchesFound] = cmd;
-            }
-            ++matchesFound; // Keep incrementing even if outMatches[] is full,
-                            // so the caller can know the total num found.
+            return false;
+        }
+        else if (getFlags() != other.getFlags())
+        {
+            return false;
+        }
+        else if (compareNames(other) != 0)
+        {
+            return false;
+        }
+        else if (CVarValueChars(*this) != CVarValueChars(other))
+        {
+            return false;
+        }
+        else if (CVarValueChars(*this, true) != CVarValueChars(other, true))
+        {
+            return false;
+        }
+        else if (getNumberFormat() != other.getNumberFormat())
+        {
+            return false;
+        }
+        else
+        {
+            // Description not compared. It's just metadata for displaying.
+            // ValueRange also not currently compared. Should it be?
+            return true;
         }
     }
 
-    if (matchesFound > 0)
+    std::int64_t getIntValue() const override
     {
-        // Output will be sorted alphabetically.
-        cmdSortMatches(outMatches, std::min(matchesFound, maxMatches));
+        return cvarToInt64(currentValue.load());
     }
-    return matchesFound;
-}
 
-template<typename T>
-int CommandManagerImpl::findWithPartialNameHelper(const char * const partialName, T * outMatches,
-                                                  const int maxMatches, T (*pGetCmd)(Command *)) const
-{
-    if (partialName == nullptr || *partialName == '\0')
+    bool setIntValue(std::int64_t newValue) override
     {
-        return 0;
+        if (!isWritable())
+        {
+            return errorF("CVar '%s' is read-only!", name);
+        }
+
+        ValueType temp = ValueType();
+        if (cvarSetInt64(&temp, newValue, (isRangeChecked() ? &valueRange : nullptr), numberFormat))
+        {
+            storeValue(std::move(temp));
+            setModified();
+            return true;
+        }
+        return false;
     }
-    else if (outMatches == nullptr || maxMatches <= 0)
+
+    bool getBoolValue() const override
     {
-        return -1;
+        return !!cvarToInt64(currentValue.load());
     }
 
-    int matchesFound = 0;
-
-    // Partial name searching unfortunately can't take advantage of the optimized
-    // constant time hash table lookup, so we have to fall back to a linear search.
-    for (auto cmd = registeredCommands.getFirst(); cmd; cmd = cmd->getNext())
+    bool setBoolValue(bool newValue) override
     {
-        if (cmdNameStartsWith(cmd->getNameCString(), partialName))
+        if (!isWritable())
         {
-            if (matchesFound < maxMatches)
-            {
-                outMatches[matchesFound] = pGetCmd(cmd);
-            }
-            ++matchesFound; // Keep incrementing even if outMatches[] is full,
-                            // so the caller can know the total num found.
+            return errorF("CVar '%s' is read-only!", name);
+        }
+
+        ValueType temp = ValueType();
+        if (cvarSetInt64(&temp, newValue, (isRangeChecked() ? &valueRange : nullptr), numberFormat))
+        {
+            storeValue(std::move(temp));
+            setModified();
+            return true;
         }
+        return false;
     }
 
-    if (matchesFound > 0)
+    double getFloatValue() const override
     {
-        // Output will be sorted alphabetically.
-        cmdSortMatches(outMatches, std::min(matchesFound, maxMatches));
+        return cvarToDouble(currentValue.load());
     }
-    return matchesFound;
-}
 
-bool CommandManagerImpl::removeCommand(const char * const name)
-{
-    if (!isValidCommandName(name))
+    bool setFloatValue(double newValue) override
     {
-        return errorF("'%s' is not a valid command name! Nothing to remove.", name);
-    }
+        if (!isWritable())
+        {
+            return errorF("CVar '%s' is read-only!", name);
+        }
 
-    auto cmd = registeredCommands.unlinkByKey(name);
-    if (cmd == nullptr)
-    {
-        return false; // No such command/alias.
+        ValueType temp = ValueType();
+        if (cvarSetDouble(&temp, newValue, (isRangeChecked() ? &valueRange : nullptr)))
+        {
+            storeValue(std::move(temp));
+            setModified();
+            return true;
+        }
+        return false;
     }
 
-    destroy(cmd);
-    memFree(cmd);
-    return true;
-}
-
-bool CommandManagerImpl::removeCommand(Command * cmd)
-{
-    if (cmd == nullptr)
+    std::string getStringValue() const override
     {
-        return false;
+        std::string result;
+        cvarToString(&result, currentValue.load(), numberFormat);
+        return result;
     }
-    return removeCommand(cmd->getNameCString());
-}
 
-bool CommandManagerImpl::removeCommandAlias(const char * const aliasName)
-{
-    if (!isValidCommandName(aliasName))
+    bool setStringValue(std::string newValue) override
     {
-        return false;
+        return setStringValue(newValue.c_str(), static_cast<int>(newValue.size()));
     }
 
-    const auto cmd = registeredCommands.findByKey(aliasName);
-    if (cmd == nullptr || !cmd->isAlias())
+    int getStringValue(char * destBuf, int destSizeInChars) const override
     {
-        return false;
+        return cvarValueToChars(destBuf, destSizeInChars, currentValue, numberFormat);
     }
 
-    if (!removeCommand(aliasName))
+    bool setStringValue(const char * newValue, int length) override
     {
+        CFG_ASSERT(newValue != nullptr && length >= 0);
+        if (!isWritable())
+        {
+            return errorF("CVar '%s' is read-only!", name);
+        }
+
+        ValueType temp = ValueType();
+        if (cvarSetChars(&temp, newValue, length, (isRangeChecked() ? &valueRange : nullptr)))
+        {
+            storeValue(std::move(temp));
+            setModified();
+            return true;
+        }
         return false;
     }
 
-    --cmdAliasCount;
-    return true;
-}
-
-void CommandManagerImpl::removeAllCommands()
-{
-    auto cmd = registeredCommands.getFirst();
-    while (cmd != nullptr)
+    bool getStringValueView(const char ** outStr, int * outLength) const override
     {
-        auto temp = cmd->getNext();
-        destroy(cmd);
-        memFree(cmd);
-        cmd = temp;
+        CFG_ASSERT(outStr != nullptr && outLength != nullptr);
+        return cvarValueView(currentValue, outStr, outLength);
     }
-    registeredCommands.deallocate();
-}
-
-void CommandManagerImpl::removeAllCommandAliases()
-{
-    std::vector<CommandImplBase *> aliases;
 
-    for (auto cmd = registeredCommands.getFirst(); cmd; cmd = cmd->getNext())
+    bool setStringValueIgnoreRO(std::string newValue, bool writeRomCVars, bool writeInitCVars) override
     {
-        if (cmd->isAlias())
+        // Optionally unchecked and without setting the modified flag.
+        if ((flags & CVar::Flags::ReadOnly) && !writeRomCVars)
         {
-            aliases.push_back(cmd);
+            return errorF("CVar '%s' is read-only!", name);
+        }
+        if ((flags & CVar::Flags::InitOnly) && !writeInitCVars)
+        {
+            return errorF("CVar '%s' is read-only!", name);
         }
-    }
 
-    for (auto alias : aliases)
-    {
-        removeCommand(alias);
+        ValueType temp = ValueType();
+        if (cvarSetChars(&temp, newValue.c_str(), static_cast<int>(newValue.size()),
+                         (isRangeChecked() ? &valueRange : nullptr)))
+        {
+            storeValue(std::move(temp));
+            return true;
+        }
+        return false;
     }
 
-    cmdAliasCount = 0;
-}
-
-int CommandManagerImpl::getRegisteredCommandsCount() const
-{
-    return registeredCommands.getSize();
-}
+    bool setRawValueIgnoreRO(const CVarRawValue & newValue, bool writeRomCVars, bool writeInitCVars) override
+    {
+        CFG_ASSERT(newValue.type == TypeTag);
 
-int CommandManagerImpl::getCommandAliasCount() const
-{
-    return cmdAliasCount;
-}
+        // Optionally unchecked and without setting the modified flag.
+        if ((flags & CVar::Flags::ReadOnly) && !writeRomCVars)
+        {
+            return errorF("CVar '%s' is read-only!", name);
+        }
+        if ((flags & CVar::Flags::InitOnly) && !writeInitCVars)
+        {
+            return errorF("CVar '%s' is read-only!", name);
+        }
 
-bool CommandManagerImpl::isValidCommandName(const char * const name) const
-{
-    //
-    // Command names follow the C++ variable naming rules,
-    // that is, cannot start with a number, cannot contain
-    // white spaces, cannot start with nor contain any special
-    // characters or punctuation, except for the underscore.
-    //
-    if (name == nullptr || *name == '\0')
-    {
-        return false;
-    }
+        bool succeeded;
+        ValueType temp = ValueType();
+        const ValueRange * range = (isRangeChecked() ? &valueRange : nullptr);
 
-    int i = 0;
-    int c = name[i++];
+        switch (newValue.type)
+        {
+        case CVar::Type::Float :
+            succeeded = cvarSetDouble(&temp, newValue.floatValue, range);
+            break;
+        case CVar::Type::String :
+            succeeded = cvarSetChars(&temp, newValue.stringData, static_cast<int>(newValue.stringLength), range);
+            break;
+        case CVar::Type::Enum :
+            // Always try the constants list first to get the name back.
+            succeeded = cvarSetInt64(&temp, newValue.intValue, &valueRange, numberFormat) ||
+                        (range == nullptr && cvarSetInt64(&temp, newValue.intValue, nullptr, numberFormat));
+            break;
+        default : // Int & Bool
+            succeeded = cvarSetInt64(&temp, newValue.intValue, range, numberFormat);
+            break;
+        } // switch (newValue.type)
 
-    // Must start with a letter or an underscore:
-    if ((c < 'a' || c > 'z') && (c < 'A' || c > 'Z') && (c != '_'))
-    {
-        return false;
+        if (succeeded)
+        {
+            storeValue(std::move(temp));
+        }
+        return succeeded;
     }
 
-    while (name[i] != '\0')
+    int getAllowedValueStrings(std::string * outValueStrings, int maxValueStrings) const override
     {
-        c = name[i++];
+        if (outValueStrings == nullptr || maxValueStrings <= 0)
+        {
+            return -1;
+        }
 
-        // If not a number, lower or upper case letter
-        // and not an underscore it's not a valid command name.
-        if ((c < '0' || c > '9') &&
-            (c < 'a' || c > 'z') &&
-            (c < 'A' || c > 'Z') &&
-            (c != '_'))
+        std::string tempStr;
+        const int count = std::min(maxValueStrings, valueRange.getCount());
+        for (int v = 0; v < count; ++v)
         {
-            return false;
+            cvarToString(&tempStr, valueRange.getValue(v), numberFormat);
+            outValueStrings[v] = std::move(tempStr);
         }
+
+        return valueRange.getCount();
     }
 
-    // Lastly, must comply to our fixed max name length.
-    if (i >= MaxCommandNameLength)
+    int getAllowedValueCount() const override
     {
-        return false;
+        return valueRange.getCount();
     }
-    return true;
-}
 
-void CommandManagerImpl::enumerateAllCommands(CommandEnumerateCallback enumCallback, void * userContext)
-{
-    CFG_ASSERT(enumCallback != nullptr);
-    for (auto cmd = registeredCommands.getFirst(); cmd; cmd = cmd->getNext())
+    bool setDefaultValue() override
     {
-        if (!enumCallback(cmd, userContext))
+        if (!isWritable())
         {
-            return;
+            return errorF("CVar '%s' is read-only!", name);
         }
-    }
-}
-
-void CommandManagerImpl::disableCommandsWithFlags(const std::uint32_t flags)
-{
-    disabledCmdFlags = flags;
-}
 
-void CommandManagerImpl::enableAllCommands()
-{
-    disabledCmdFlags = 0;
-}
+        storeValue(defaultValue);
+        setModified();
+        return true;
+    }
 
-CVarManager * CommandManagerImpl::getCVarManager() const
-{
-    return cvarManager;
-}
+    bool setDefaultValueIgnoreRO(bool writeRomCVars, bool writeInitCVars) override
+    {
+        // Optionally unchecked and without setting the modified flag.
+        if ((flags & CVar::Flags::ReadOnly) && !writeRomCVars)
+        {
+            return errorF("CVar '%s' is read-only!", name);
+        }
+        if ((flags & CVar::Flags::InitOnly) && !writeInitCVars)
+        {
+            return errorF("CVar '%s' is read-only!", name);
+        }
 
-void CommandManagerImpl::setCVarManager(CVarManager * cvarMgr)
-{
-    cvarManager = static_cast<CVarManagerImpl *>(cvarMgr);
-}
+        storeValue(defaultValue);
+        return true;
+    }
 
-bool CommandManagerImpl::registerCmdPreValidate(const char * const cmdName) const
-{
-    if (!isValidCommandName(cmdName))
+    std::string getDefaultValueString() const override
     {
-        return errorF("Bad command name '%s'! Can't register it.", cmdName);
+        std::string result;
+        cvarToString(&result, defaultValue, numberFormat);
+        return result;
     }
-    if (findCommand(cmdName)) // No duplicates allowed.
+
+    int getDefaultValueString(char * destBuf, int destSizeInChars) const override
     {
-        return errorF("Command '%s' already registered! Duplicate commands are not allowed.", cmdName);
+        return cvarToChars(destBuf, destSizeInChars, defaultValue, numberFormat);
     }
-    if ((cvarManager != nullptr) && cvarManager->findCVar(cmdName)) // Avoid Cmd/CVar name ambiguities.
+
+    int valueCompletion(const char * partialVal, std::string * outMatches, int maxMatches) const override
     {
-        return errorF("A CVar named '%s' already exists. Cannot declare a new command with this name!", cmdName);
+        if (valueCompletionCallback != nullptr)
+        {
+            return valueCompletionCallback(partialVal, outMatches, maxMatches);
+        }
+        else if (outMatches == nullptr || maxMatches <= 0)
+        {
+            return -1;
+        }
+        else
+        {
+            return cvarValueCompletion(valueRange, partialVal, outMatches, maxMatches, numberFormat);
+        }
     }
-    return true;
-}
 
-bool CommandManagerImpl::registerCommand(const char * const name,
-                                         CommandHandlerCallback handler,
-                                         CommandArgCompletionCallback completionHandler,
-                                         void * userContext,
-                                         const char * const description,
-                                         const std::uint32_t flags,
-                                         const int minArgs,
-                                         const int maxArgs)
-{
-    if (handler == nullptr)
+    CVarValueCompletionCallback getValueCompletionCallback() const override
     {
-        return errorF("No command handler provided!");
+        return valueCompletionCallback;
     }
-    if (!registerCmdPreValidate(name))
+
+    const void * getValuePtr() const override
     {
-        return false;
+        return currentValue.getValuePtr();
     }
 
-    auto newCmd = memAlloc<CommandImplCallbacks>(1);
-    construct(newCmd, name, description, flags, minArgs, maxArgs, handler, completionHandler, userContext);
+private:
 
-    registeredCommands.linkWithKey(newCmd, name);
-    return true;
-}
+    // All value changes go through here to reach the change listeners.
+    void storeValue(ValueType newValue)
+    {
+        const bool changed = hasChangeListeners() && !cvarValueEquals(currentValue.load(), newValue);
+        currentValue.store(std::move(newValue));
+        if (changed)
+        {
+            notifyValueChanged();
+        }
+    }
 
-bool CommandManagerImpl::registerCommand(const char * const name,
-                                         CommandHandlerDelegate handler,
-                                         CommandArgCompletionDelegate completionHandler,
-                                         const char * const description,
-                                         const std::uint32_t flags,
-                                         const int minArgs,
-                                         const int maxArgs)
-{
-    if (handler == nullptr)
-    {
-        return errorF("No command handler provided!");
-    }
-    if (!registerCmdPreValidate(name))
-    {
-        return false;
-    }
+    CVarValueHolder<ValueType>  currentValue;            // Current value. Only changeable if not ReadOnly.
+    const ValueType             defaultValue;            // The initial value set when created is the reset value.
+    ValueRange                  valueRange;              // Range of numeric values or allowed strings/enum names.
+    NumberFormat                numberFormat;            // Number formatting from int=>string conversion (decimal, binary, etc).
+    CVarFlagsStorage            flags;                   // ORed CVar::Flags or zero.
+    const char *                name;                    // Heap-allocated name string. Never null and never empty.
+    const char *                description;             // Heap-allocated Description comment. Can be null if not provided.
+    CVarValueCompletionCallback valueCompletionCallback; // Optional callback for value auto-completion. May be null.
+    MemoryArena *               memArena;                // Arena of the manager the strings came from. Null if not using one.
+    const bool                  ownsStrings;             // False if name, description and valueRange reference static data.
+};
 
-    auto newCmd = memAlloc<CommandImplDelegates>(1);
-    construct(newCmd, name, description, flags, minArgs, maxArgs,
-              std::move(handler), std::move(completionHandler));
+//
+// These are the supported CVar types:
+//
+using CVarInt    = CVarImpl< std::int64_t,    CVarNumberRange<std::int64_t>, CVar::Type::Int    >;
+using CVarBool   = CVarImpl< bool,            CVarNumberRange<bool>,         CVar::Type::Bool   >;
+using CVarFloat  = CVarImpl< double,          CVarNumberRange<double>,       CVar::Type::Float  >;
+using CVarString = CVarImpl< CVarStringValue, CVarAllowedStrings,            CVar::Type::String >;
+using CVarEnum   = CVarImpl< CVarEnumConst,   CVarEnumConstList,             CVar::Type::Enum   >;
 
-    registeredCommands.linkWithKey(newCmd, name);
-    return true;
-}
+// ========================================================
+// struct CVarSnapshotEntry:
+// ========================================================
 
-bool CommandManagerImpl::registerCommand(const char * const name,
-                                         CommandHandlerMemFunc handler,
-                                         CommandHandlerMemFunc completionHandler,
-                                         const char * const description,
-                                         const std::uint32_t flags,
-                                         const int minArgs,
-                                         const int maxArgs)
-{
-    if (handler == nullptr)
-    {
-        return errorF("No command handler provided!");
-    }
-    if (!registerCmdPreValidate(name))
-    {
-        return false;
-    }
+class CVarSnapshotImpl;
 
-    auto newCmd = memAlloc<CommandImplMemberFuncs>(1);
-    construct(newCmd, name, description, flags, minArgs, maxArgs, handler, completionHandler);
+// The values of one CVar in a CVarSnapshotImpl, converted to every type
+// when the snapshot is built. Strings are offsets into the snapshot chars.
+struct CVarSnapshotEntry final
+{
+    std::uint32_t nameHash;    // Same hash of the CVarManagerImpl table.
+    std::uint32_t nameOffset;
+    std::uint32_t valueOffset;
+    bool          boolValue;
+    std::int64_t  intValue;
+    double        floatValue;
+};
 
-    registeredCommands.linkWithKey(newCmd, name);
-    return true;
-}
+// ========================================================
+// class CVarManagerImpl:
+// ========================================================
 
-bool CommandManagerImpl::createCommandAlias(const char * const aliasName,
-                                            const char * const aliasedCmdStr,
-                                            const CommandExecMode execMode,
-                                            const char * const description)
+class CVarManagerImpl final
+    : public CVarManager
 {
-    if (aliasedCmdStr == nullptr || *aliasedCmdStr == '\0')
-    {
-        return errorF("Can't create a command alias for an empty/null string!");
-    }
-    if (!isValidCommandName(aliasName))
-    {
-        return errorF("'%s' is not a valid alias or command name!", aliasName);
-    }
-    if (findCommand(aliasName))
-    {
-        return errorF("A command or alias named '%s' already exists!", aliasName);
-    }
-    if ((cvarManager != nullptr) && cvarManager->findCVar(aliasName))
-    {
-        return errorF("A CVar named '%s' already exists. Cannot declare a new command alias with this name!", aliasName);
-    }
+public:
+
+    // Not copyable.
+    CVarManagerImpl(const CVarManagerImpl &) = delete;
+    CVarManagerImpl & operator = (const CVarManagerImpl &) = delete;
 
-    auto newCmd = memAlloc<CommandImplAlias>(1);
-    construct(newCmd, aliasName, description, aliasedCmdStr, execMode, this);
+    CVarManagerImpl(int hashTableSize, bool useMemoryArena);
+    ~CVarManagerImpl();
 
-    registeredCommands.linkWithKey(newCmd, aliasName);
-    ++cmdAliasCount;
+    CVar * findCVar(const char * name) const override;
+    CVar * findCVar(const HashedName & name) const override;
+    int findCVarsWithPartialName(const char * partialName, CVar ** outMatches, int maxMatches) const override;
+    int findCVarsWithPartialName(const char * partialName, const char ** outMatches, int maxMatches) const override;
+    int findCVarsWithFlags(std::uint32_t flags, CVar ** outMatches, int maxMatches) const override;
 
-    return true;
-}
+    bool removeCVar(const char * name) override;
+    bool removeCVar(CVar * cvar) override;
+    void removeAllCVars() override;
 
-void CommandManagerImpl::execNow(const char * str)
-{
-    CFG_ASSERT(str != nullptr);
-    if (*str == '\0')
+    int getRegisteredCVarsCount() const override;
+    bool isValidCVarName(const char * name) const override;
+    void enumerateAllCVars(CVarEnumerateCallback enumCallback, void * userContext) override;
+    int enumerateCVarsWithFlags(std::uint32_t flags, CVarEnumerateCallback enumCallback, void * userContext) override;
+
+    CVar * registerCVarBool(const char * name, const char * description, std::uint32_t flags,
+                            bool initValue, CVarValueCompletionCallback completionCb = nullptr) override;
+
+    CVar * registerCVarInt(const char * name, const char * description, std::uint32_t flags,
+                           std::int64_t initValue, std::int64_t minValue, std::int64_t maxValue,
+                           CVarValueCompletionCallback completionCb = nullptr) override;
+
+    CVar * registerCVarFloat(const char * name, const char * description, std::uint32_t flags,
+                             double initValue, double minValue, double maxValue,
+                             CVarValueCompletionCallback completionCb = nullptr) override;
+
+    CVar * registerCVarString(const char * name, const char * description, std::uint32_t flags,
+                              const std::string & initValue, const char ** allowedStrings,
+                              CVarValueCompletionCallback completionCb = nullptr) override;
+
+    CVar * registerCVarEnum(const char * name, const char * description, std::uint32_t flags,
+                            std::int64_t initValue, const std::int64_t * enumConstants, const char ** constNames,
+                            CVarValueCompletionCallback completionCb = nullptr) override;
+
+    int registerCVars(const CVarDesc * descs, int count, CVar ** outCVars = nullptr) override;
+
+    bool getCVarValueBool(const char * name) const override;
+    std::int64_t getCVarValueInt(const char * name) const override;
+    double getCVarValueFloat(const char * name) const override;
+    std::string getCVarValueString(const char * name) const override;
+    bool getCVarValueBool(const HashedName & name) const override;
+    std::int64_t getCVarValueInt(const HashedName & name) const override;
+    double getCVarValueFloat(const HashedName & name) const override;
+    std::string getCVarValueString(const HashedName & name) const override;
+
+    CVar * setCVarValueBool(const char * name, bool value, std::uint32_t flags) override;
+    CVar * setCVarValueInt(const char * name, std::int64_t value, std::uint32_t flags) override;
+    CVar * setCVarValueFloat(const char * name, double value, std::uint32_t flags) override;
+    CVar * setCVarValueString(const char * name, const std::string & value, std::uint32_t flags) override;
+
+    int addChangeListener(CVar * cvar, CVarChangeCallback callback,
+                          void * userContext, CVarChangeDelivery delivery) override;
+    int addChangeListenerForFlags(std::uint32_t flags, CVarChangeCallback callback,
+                                  void * userContext, CVarChangeDelivery delivery) override;
+    int addChangeListenerForPrefix(const char * namePrefix, CVarChangeCallback callback,
+                                   void * userContext, CVarChangeDelivery delivery) override;
+    bool removeChangeListener(int listenerId) override;
+    int deliverChangeNotifications() override;
+    int getPendingChangeNotificationsCount() const override;
+
+    void setCVarSnapshotsEnabled(bool enable) override;
+    bool isCVarSnapshotsEnabled() const override;
+    bool publishCVarSnapshot() override;
+    CVarSnapshotRef acquireCVarSnapshot() const override;
+
+    // Called by CVarImplBase::notifyValueChanged().
+    void onCVarValueChanged(CVarImplBase * cvar);
+
+    // The published CVar snapshots also need to know about any value change.
+    bool hasGlobalChangeListeners() const noexcept { return globalChangeListeners > 0 || snapshotsEnabled; }
+
+    // For use in 'set' and 'reset' commands called on 'reloadConfig' or from the program command line.
+    bool internalSetStringValue(CVar * cvar, std::string value);
+    bool internalSetDefaultValue(CVar * cvar);
+    bool internalSetRawValue(CVar * cvar, const CVarRawValue & value);
+
+    // Binary config snapshots. See CommandManager::saveConfigSnapshot().
+    std::uint32_t getSnapshotSchemaChecksum() const;
+    std::uint32_t writeSnapshotCVars(std::string * outData) const;
+    bool readSnapshotCVars(const char ** inOutData, const char * dataEnd, std::uint32_t count);
+
+    // This will only affect 'set' and 'reset' commands on vars flagged with ReadOnly or InitOnly.
+    void setAllowWritingReadOnlyVars(bool allow) noexcept;
+
+    // This will only affect 'set' and 'reset' commands on vars flagged with InitOnly.
+    void setAllowWritingInitOnlyVars(bool allow) noexcept;
+
+    // Incremented every time a CVar is removed, so cached CVar pointers know to be resolved again.
+    std::uint32_t getRemovalGeneration() const noexcept { return cvarRemovalGeneration; }
+
+private:
+
+    friend class CVarSnapshotImpl;
+    friend class CVarImplBase;
+
+    template<typename T>
+    bool validateCVarRegistration(const char * name, std::uint32_t flags,
+                                  const T & initValue, T (CVar::*pGetVal)() const) const;
+
+    template<typename T>
+    int findWithPartialNameHelper(const char * partialName, T * outMatches,
+                                  int maxMatches, T (*pGetVar)(CVar *)) const;
+
+    // Internal bookkeeping arrays, accounted with the CVars in the memory stats.
+    template<typename T>
+    using CVarArray = MemVector<T, MemoryCategory::CVars>;
+    using NameString = MemString<MemoryCategory::Strings>;
+
+    // A listener matches a single var, the vars with some
+    // flags or the vars with a name prefix, in this order.
+    struct CVarChangeListener
+    {
+        int                id;          // Zero once removed. Removed entries are compacted when not dispatching.
+        CVarImplBase *     cvar;        // For addChangeListener(). Null for the others.
+        std::uint32_t      flags;       // For addChangeListenerForFlags(). Zero for the others.
+        NameString         namePrefix;  // For addChangeListenerForPrefix(). Empty for the others.
+        CVarChangeCallback callback;
+        void *             userContext;
+        CVarChangeDelivery delivery;
+    };
+
+    CVar * linkNewCVar(CVarImplBase * newVar, const char * name);
+    CVar * linkNewCVar(CVarImplBase * newVar, const char * name, std::uint32_t hashKey);
+    CVar * registerCVarFromDesc(const CVarDesc & desc);
+    static CVarEnumConst findEnumConst(const CVarEnumConstList & enumConstList, std::int64_t value);
+    void forgetChangeListeners(CVarImplBase * cvar);
+    void compactChangeListeners();
+    int addChangeListenerHelper(CVarChangeListener listener);
+    bool listenerMatches(const CVarChangeListener & listener, const CVarImplBase * cvar) const;
+    void markSnapshotDirty(CVarImplBase * cvar);
+    void forgetSnapshotVar(CVarImplBase * cvar);
+    void clearSnapshotDirtyVars();
+    void encodeSnapshotEntry(const CVarImplBase * cvar, CVarSnapshotEntry * outEntry);
+    CVarSnapshotImpl * buildCVarSnapshot();
+    void retireCurrentCVarSnapshot(CVarSnapshotImpl * newSnapshot);
+    void reclaimCVarSnapshots();
+    std::atomic<const CVarSnapshotImpl *> & claimSnapshotHazard(const CVarSnapshotImpl * snapshot) const;
+    bool isSnapshotHazard(const CVarSnapshotImpl * snapshot) const;
+
+    //
+    // Hash function used to lookup CVar names in the HT.
+    // Can be case-sensitive or not.
+    //
+    #if CFG_CVAR_CASE_SENSITIVE_NAMES
+    using CVarNameHasher  = StringHasher;
+    using CVarNameCompare = StringKeyCompare;
+    #else // !CFG_CVAR_CASE_SENSITIVE_NAMES
+    using CVarNameHasher  = StringHasherNoCase;
+    using CVarNameCompare = StringKeyCompareNoCase;
+    #endif // CFG_CVAR_CASE_SENSITIVE_NAMES
+
+    // The HashedName hash matching the CVarNameHasher.
+    static std::uint32_t hashOfName(const HashedName & name) noexcept
     {
-        return;
+        #if CFG_CVAR_CASE_SENSITIVE_NAMES
+        return name.hash;
+        #else // !CFG_CVAR_CASE_SENSITIVE_NAMES
+        return name.hashNoCase;
+        #endif // CFG_CVAR_CASE_SENSITIVE_NAMES
     }
 
-    // Input string might consist of multiple commands.
-    // Split it up and handle each command separately.
-    bool overflowed;
-    char tempBuffer[MaxCommandArgStrLength];
-    while (extractNextCommand(&str, tempBuffer, lengthOfArray(tempBuffer), &overflowed))
-    {
-        if (overflowed)
-        {
-            // Malformed command line that won't fit in our buffers.
-            // Discard the rest of the string.
-            errorF("Discarding rest of command line due to malformed string...");
-            break;
-        }
+    // All the registered CVars in a hash table for fast lookup by name.
+    LinkedHashTable<CVarImplBase, CVarNameHasher, CVarNameCompare> registeredCVars;
 
-        // Tokenize the command string, separating command name and splitting the args, then we can run it.
-        CommandArgs cmdArgs(tempBuffer);
-        execTokenized(cmdArgs);
-    }
-}
+    // The same CVars by flag bit, for findCVarsWithFlags() and enumerateCVarsWithFlags().
+    FlagIndex<CVarImplBase> cvarFlagIndex;
+    bool allowWritingRomCVars;
+    bool allowWritingInitCVars;
 
-void CommandManagerImpl::execInsert(const char * const str)
+    // Storage for the CVars and their strings if created with 'useMemoryArena'.
+    // memArena points to cvarArena in that case, or is null otherwise.
+    MemoryArena   cvarArena;
+    MemoryArena * memArena;
+
+    // Change notifications. See CVarManager::addChangeListener().
+    CVarArray<CVarChangeListener>   changeListeners;
+    CVarArray<CVarImplBase *>       pendingChanges;         // Vars waiting for deliverChangeNotifications().
+    int                             nextChangeListenerId;   // Ids are never reused.
+    int                             globalChangeListeners;  // Flag and prefix listeners, which can match any var.
+    int                             changeDispatchDepth;    // Listeners are only erased when not dispatching.
+    bool                            hasRemovedListeners;    // Some entries have id = 0 and need compacting.
+    bool                            deliveringChanges;      // Inside deliverChangeNotifications().
+
+    // See getRemovalGeneration().
+    std::uint32_t cvarRemovalGeneration;
+
+    // Versioned CVar snapshots. See CVarManager::publishCVarSnapshot().
+    // A reader publishes the version it loaded from currentSnapshot in a free
+    // hazard slot until it has taken its reference, so a version retired in
+    // the meantime is not freed under it. See acquireCVarSnapshot().
+    static constexpr int SnapshotHazardSlots = 64;
+    std::atomic<CVarSnapshotImpl *>               currentSnapshot;
+    mutable std::atomic<const CVarSnapshotImpl *> snapshotHazards[SnapshotHazardSlots];
+    mutable std::atomic<std::uint32_t>            nextSnapshotHazard;  // Where the next reader starts looking for a free slot.
+    CVarArray<CVarSnapshotImpl *>                 retiredSnapshots;    // Replaced versions, freed once unreferenced.
+    CVarArray<CVarImplBase *>                     snapshotDirtyVars;   // Vars registered or changed since the current version.
+    CVarArray<int>                                snapshotDroppedVars; // Entries of the current version for removed vars.
+    CVarArray<CVarSnapshotEntry>                  snapshotEntries;     // Scratch buffers of buildCVarSnapshot(),
+    CVarArray<char>                               snapshotChars;       // kept to reuse their memory.
+    std::uint64_t                                 snapshotVersion;     // Version of the last snapshot built.
+    bool                                          snapshotsEnabled;
+    bool                                          snapshotDirty;       // Vars changed since the last snapshot.
+    bool                                          snapshotRebuildAll;  // All vars removed. Can't reuse the current version.
+};
+
+// ========================================================
+// class CVarSnapshotImpl:
+// ========================================================
+
+//
+// One published version of the CVar values. The object is followed by its
+// entries and the name/value strings in a single allocation made by
+// CVarManagerImpl::buildCVarSnapshot(). Entries are sorted by name hash,
+// so lookups are a binary search.
+//
+// The next version starts from a copy of these chars, so the entries of
+// unchanged vars are copied as they are. The strings of the vars changed
+// or removed since are left in as garbage, until they make up half of
+// the chars and the next version is built from scratch.
+//
+class CVarSnapshotImpl final
+    : public CVarSnapshot
 {
-    CFG_ASSERT(str != nullptr);
-    if (*str == '\0')
-    {
-        return;
-    }
+public:
 
-    const int strLen = lengthOfString(str) + 1;
+    CVarSnapshotImpl(const std::uint64_t snapshotVersion, const CVarSnapshotEntry * snapshotEntries,
+                     const int snapshotEntryCount, const char * snapshotChars,
+                     const std::uint32_t snapshotCharCount, const std::uint32_t snapshotGarbageChars)
+        : refCount(0)
+        , version(snapshotVersion)
+        , entries(snapshotEntries)
+        , entryCount(snapshotEntryCount)
+        , chars(snapshotChars)
+        , charCount(snapshotCharCount)
+        , garbageChars(snapshotGarbageChars)
+    { }
 
-    // Check for buffer overflow:
-    if ((cmdBufferUsed + strLen) >= CommandBufferSize)
-    {
-        errorF("Buffer overflow! Command buffer depleted in CommandManager::execInsert()!");
-        return;
-    }
+    std::uint64_t getVersion() const override { return version; }
+    int getCVarCount() const override { return entryCount; }
+
+    bool hasCVar(const char * name) const override;
+    bool hasCVar(const HashedName & name) const override;
+
+    bool getBool(const char * name, bool defaultValue) const override;
+    std::int64_t getInt(const char * name, std::int64_t defaultValue) const override;
+    double getFloat(const char * name, double defaultValue) const override;
+    const char * getString(const char * name, const char * defaultValue) const override;
+
+    bool getBool(const HashedName & name, bool defaultValue) const override;
+    std::int64_t getInt(const HashedName & name, std::int64_t defaultValue) const override;
+    double getFloat(const HashedName & name, double defaultValue) const override;
+    const char * getString(const HashedName & name, const char * defaultValue) const override;
 
-    // Move the existing command text so we can prepend the new command:
-    for (int i = cmdBufferUsed - 1; i >= 0; --i)
+    void release() const override
     {
-        cmdBuffer[i + strLen] = cmdBuffer[i];
+        refCount.fetch_sub(1, std::memory_order_release);
     }
 
-    // Copy the new text in:
-    std::memcpy(cmdBuffer, str, strLen - 1);
+    // Readers holding this version. Only the manager frees it, once retired and zero.
+    mutable std::atomic<std::int32_t> refCount;
 
-    // Separate the command strings:
-    cmdBuffer[strLen - 1] = CommandTextSeparator;
-    cmdBufferUsed += strLen;
+private:
 
-    // Ensure always null terminated.
-    cmdBuffer[cmdBufferUsed] = '\0';
-}
+    friend class CVarManagerImpl;
 
-void CommandManagerImpl::execAppend(const char * const str)
+    const CVarSnapshotEntry * findEntry(const char * name) const;
+    const CVarSnapshotEntry * findEntry(const char * name, std::uint32_t nameHash) const;
+
+    const std::uint64_t             version;
+    const CVarSnapshotEntry * const entries;
+    const int                       entryCount;
+    const char * const              chars;        // Null terminated names and value strings of the entries.
+    const std::uint32_t             charCount;    // Size of chars[], not counting the final '\0'.
+    const std::uint32_t             garbageChars; // Strings in chars[] no longer used by any entry.
+};
+
+const CVarSnapshotEntry * CVarSnapshotImpl::findEntry(const char * const name) const
 {
-    CFG_ASSERT(str != nullptr);
-    if (*str == '\0')
+    if (name == nullptr || *name == '\0')
     {
-        return;
+        return nullptr;
     }
+    return findEntry(name, CVarManagerImpl::CVarNameHasher{}(name));
+}
 
-    const int strLen = lengthOfString(str) + 1;
+const CVarSnapshotEntry * CVarSnapshotImpl::findEntry(const char * const name, const std::uint32_t nameHash) const
+{
+    const CVarSnapshotEntry * const last = entries + entryCount;
+    const CVarSnapshotEntry * entry = std::lower_bound(entries, last, nameHash,
+            [](const CVarSnapshotEntry & e, const std::uint32_t h) { return e.nameHash < h; });
 
-    // Check for buffer overflow:
-    if ((cmdBufferUsed + strLen) >= CommandBufferSize)
+    for (; entry != last && entry->nameHash == nameHash; ++entry)
     {
-        errorF("Buffer overflow! Command buffer depleted in CommandManager::execAppend()!");
-        return;
+        if (CVarManagerImpl::CVarNameCompare{}(chars + entry->nameOffset, name) == 0)
+        {
+            return entry;
+        }
     }
+    return nullptr;
+}
 
-    // Copy the user command:
-    std::memcpy(cmdBuffer + cmdBufferUsed, str, strLen - 1);
-    cmdBufferUsed += strLen;
+bool CVarSnapshotImpl::hasCVar(const char * const name) const
+{
+    return findEntry(name) != nullptr;
+}
 
-    // Separate the command strings and null terminate the buffer:
-    cmdBuffer[cmdBufferUsed - 1] = CommandTextSeparator;
-    cmdBuffer[cmdBufferUsed] = '\0';
+bool CVarSnapshotImpl::hasCVar(const HashedName & name) const
+{
+    return findEntry(name.name, CVarManagerImpl::hashOfName(name)) != nullptr;
 }
 
-void CommandManagerImpl::execute(const CommandExecMode execMode, const char * const str)
+bool CVarSnapshotImpl::getBool(const char * const name, const bool defaultValue) const
 {
-    switch (execMode)
-    {
-    case CommandExecMode::Immediate :
-        execNow(str);
-        break;
-    case CommandExecMode::Insert :
-        execInsert(str);
-        break;
-    case CommandExecMode::Append :
-        execAppend(str);
-        break;
-    default :
-        errorF("Invalid CommandExecMode enum value!");
-    } // switch (execMode)
+    const CVarSnapshotEntry * entry = findEntry(name);
+    return (entry != nullptr) ? entry->boolValue : defaultValue;
 }
 
-bool CommandManagerImpl::execConfigFile(const char * const filename, SimpleCommandTerminal * term)
+std::int64_t CVarSnapshotImpl::getInt(const char * const name, const std::int64_t defaultValue) const
 {
-    FileIOCallbacks * io = getFileIOCallbacks();
+    const CVarSnapshotEntry * entry = findEntry(name);
+    return (entry != nullptr) ? entry->intValue : defaultValue;
+}
 
-    FileHandle fileIn;
-    if (!io->open(&fileIn, filename, FileOpenMode::Read))
-    {
-        return false;
-    }
+double CVarSnapshotImpl::getFloat(const char * const name, const double defaultValue) const
+{
+    const CVarSnapshotEntry * entry = findEntry(name);
+    return (entry != nullptr) ? entry->floatValue : defaultValue;
+}
 
-    int  lineNum = 0;
-    char line[MaxCommandArgStrLength];
+const char * CVarSnapshotImpl::getString(const char * const name, const char * const defaultValue) const
+{
+    const CVarSnapshotEntry * entry = findEntry(name);
+    return (entry != nullptr) ? (chars + entry->valueOffset) : defaultValue;
+}
 
-    // Scan the file line-by-line:
-    while (!io->isAtEOF(fileIn) && io->readLine(fileIn, line, lengthOfArray(line)))
-    {
-        ++lineNum;
+bool CVarSnapshotImpl::getBool(const HashedName & name, const bool defaultValue) const
+{
+    const CVarSnapshotEntry * entry = findEntry(name.name, CVarManagerImpl::hashOfName(name));
+    return (entry != nullptr) ? entry->boolValue : defaultValue;
+}
 
-        // Skip blank lines and comments ('#')
-        if (line[0] == '\0' || line[0] == '\n' || line[0] == '#')
-        {
-            continue;
-        }
-        // Allow C++-style single-line comments inside config files.
-        else if (line[0] == '/' && line[1] == '/')
-        {
-            continue;
-        }
+std::int64_t CVarSnapshotImpl::getInt(const HashedName & name, const std::int64_t defaultValue) const
+{
+    const CVarSnapshotEntry * entry = findEntry(name.name, CVarManagerImpl::hashOfName(name));
+    return (entry != nullptr) ? entry->intValue : defaultValue;
+}
 
-        if (term != nullptr)
-        {
-            // Echo current line to console, adding source file and line number:
-            const int lastChar = lengthOfString(line) - 1;
-            if (line[lastChar] == '\n')
-            {
-                line[lastChar] = '\0'; // Get rid of the extra '\n'. We add one by default.
-            }
-            term->printF("%s(%i): %s\n", filename, lineNum, line);
-        }
+double CVarSnapshotImpl::getFloat(const HashedName & name, const double defaultValue) const
+{
+    const CVarSnapshotEntry * entry = findEntry(name.name, CVarManagerImpl::hashOfName(name));
+    return (entry != nullptr) ? entry->floatValue : defaultValue;
+}
 
-        // Execute immediately:
-        execNow(line);
-    }
+const char * CVarSnapshotImpl::getString(const HashedName & name, const char * const defaultValue) const
+{
+    const CVarSnapshotEntry * entry = findEntry(name.name, CVarManagerImpl::hashOfName(name));
+    return (entry != nullptr) ? (chars + entry->valueOffset) : defaultValue;
+}
 
-    io->close(fileIn);
-    return true;
+// ========================================================
+// CVarManagerImpl implementation:
+// ========================================================
+
+CVarManager * CVarManager::createInstance(const int cvarHashTableSizeHint, const bool useMemoryArena)
+{
+    auto cvarManager = memAlloc<CVarManagerImpl>(1);
+    return construct(cvarManager, cvarHashTableSizeHint, useMemoryArena);
 }
 
-void CommandManagerImpl::execStartupCommandLine(const int argc, const char * argv[])
+void CVarManager::destroyInstance(CVarManager * cvarManager)
 {
-    char   cmdline[MaxCommandArgStrLength] = {'\0'};
-    char * ptr     = cmdline;
-    int    length  = 0;
-    bool   setCmd  = false;
+    destroy(cvarManager);
+    memFree(cvarManager);
+}
 
-    if (cvarManager != nullptr)
+CVarManagerImpl::CVarManagerImpl(const int hashTableSize, const bool useMemoryArena)
+    : allowWritingRomCVars(false)
+    , allowWritingInitCVars(false)
+    , memArena(useMemoryArena ? &cvarArena : nullptr)
+    , nextChangeListenerId(1)
+    , globalChangeListeners(0)
+    , changeDispatchDepth(0)
+    , hasRemovedListeners(false)
+    , deliveringChanges(false)
+    , cvarRemovalGeneration(0)
+    , currentSnapshot(nullptr)
+    , nextSnapshotHazard(0)
+    , snapshotVersion(0)
+    , snapshotsEnabled(false)
+    , snapshotDirty(false)
+    , snapshotRebuildAll(false)
+{
+    for (auto & hazard : snapshotHazards)
+    {
+        hazard.store(nullptr, std::memory_order_relaxed);
+    }
+    if (hashTableSize > 0)
     {
-        cvarManager->setAllowWritingInitOnlyVars(true);
+        registeredCVars.allocate(hashTableSize);
     }
+}
 
-    // argv[0] assumed to be the program name.
-    for (int i = 1; i < argc; ++i)
+CVarManagerImpl::~CVarManagerImpl()
+{
+    // Readers must have released their snapshots by now.
+    retireCurrentCVarSnapshot(nullptr);
+    for (CVarSnapshotImpl * snapshot : retiredSnapshots)
     {
-        const char * arg = argv[i];
-        if (*arg == '+')
-        {
-            if (length > 0)
-            {
-                if (setCmd)
-                {
-                    execNow(cmdline);
-                }
-                else
-                {
-                    execAppend(cmdline);
-                }
-            }
-
-            ++arg;
-            ptr = cmdline;
-            length = 0;
-
-            // 'set/reset' commands shall not be buffered when running the cmdline.
-            setCmd = (cmdCmpNames(arg, "set") == 0) || (cmdCmpNames(arg, "reset") == 0);
-        }
-
-        if ((lengthOfArray(cmdline) - length - 1) <= 0)
-        {
-            break;
-        }
-
-        const int written = copyString(ptr, lengthOfArray(cmdline) - length, arg);
-        ptr[written    ] = ' ';
-        ptr[written + 1] = '\0';
-
-        length += written + 1;
-        ptr    += written + 1;
+        CFG_ASSERT(snapshot->refCount.load() == 0);
+        destroy(snapshot);
+        memFree(snapshot);
     }
 
-    if (length > 0)
+    auto cvar = registeredCVars.getFirst();
+    while (cvar != nullptr)
     {
-        if (setCmd)
-        {
-            execNow(cmdline);
-        }
-        else
-        {
-            execAppend(cmdline);
-        }
+        auto temp = cvar->getNext();
+        destroy(cvar);
+        memFree(memArena, cvar);
+        cvar = temp;
     }
+}
 
-    if (cvarManager != nullptr)
+CVar * CVarManagerImpl::findCVar(const char * const name) const
+{
+    if (name == nullptr || *name == '\0')
     {
-        cvarManager->setAllowWritingInitOnlyVars(false);
+        return nullptr;
     }
+    return registeredCVars.findByKey(name);
 }
 
-int CommandManagerImpl::execBufferedCommands(const std::uint32_t maxCommandsToExec)
+CVar * CVarManagerImpl::findCVar(const HashedName & name) const
 {
-    if (cmdBufferUsed == 0 || maxCommandsToExec == 0)
+    if (name.name == nullptr || *name.name == '\0')
     {
-        return 0;
+        return nullptr;
     }
+    return registeredCVars.findByKey(name.name, hashOfName(name));
+}
 
-    int commandsExecuted = 0;
-    const char * cmdBufferPtr = cmdBuffer;
+int CVarManagerImpl::findCVarsWithPartialName(const char * const partialName,
+                                              CVar ** outMatches, const int maxMatches) const
+{
+    return findWithPartialNameHelper<CVar *>(partialName, outMatches, maxMatches,
+                                             [](CVar * cvar) { return cvar; });
+}
 
-    bool overflowed;
-    char tempBuffer[MaxCommandArgStrLength];
+int CVarManagerImpl::findCVarsWithPartialName(const char * const partialName,
+                                              const char ** outMatches, const int maxMatches) const
+{
+    return findWithPartialNameHelper<const char *>(partialName, outMatches, maxMatches,
+                                                   [](CVar * cvar) { return cvar->getNameCString(); });
+}
 
-    while (extractNextCommand(&cmdBufferPtr, tempBuffer, lengthOfArray(tempBuffer), &overflowed))
+int CVarManagerImpl::findCVarsWithFlags(const std::uint32_t flags,
+                                        CVar ** outMatches, const int maxMatches) const
+{
+    if (flags == 0)
     {
-        if (overflowed)
-        {
-            // Malformed command line that won't fit in our buffers.
-            // Discard the rest of the command buffer and bail out.
-            cmdBufferUsed = 0;
-            cmdBuffer[0]  = '\0';
-            errorF("Discarding rest of command buffer due to malformed command string...");
-            break;
-        }
-
-        //
-        // It is necessary to shift the buffer and remove every
-        // executed command to ensure execInsert/execAppend will
-        // work properly if called from within a command handler.
-        // Doing this rather suboptimal memory shuffling allows
-        // the user to define commands that push other buffered
-        // commands, so the net gain pays it off.
-        //
-        const int charsConsumed = static_cast<int>(cmdBufferPtr - cmdBuffer);
-        cmdBufferUsed -= charsConsumed;
-        std::memmove(cmdBuffer, cmdBufferPtr, cmdBufferUsed);
-
-        cmdBuffer[cmdBufferUsed] = '\0';
-        cmdBufferPtr = cmdBuffer;
-
-        // Call the handler:
-        CommandArgs cmdArgs(tempBuffer);
-        execTokenized(cmdArgs);
-        ++commandsExecuted;
-
-        // If we have already executed a ludicrous number of commands,
-        // chances are there's a reentrant command in the buffer that
-        // is adding itself again and again. This should catch it.
-        if (commandsExecuted == MaxReentrantCommands)
-        {
-            cmdBufferUsed = 0;
-            cmdBuffer[0]  = '\0';
-            errorF("%i commands executed in sequence! Possible reentrant loop...", commandsExecuted);
-            break;
-        }
-
-        // Reached our limit for this frame?
-        if ((maxCommandsToExec != ExecAll) &&
-            (static_cast<std::uint32_t>(commandsExecuted) == maxCommandsToExec))
-        {
-            break;
-        }
+        return 0;
     }
-
-    // If we're at the end, make sure any trailing command separators and whitespace are discarded.
-    if (*cmdBufferPtr == '\0')
+    else if (outMatches == nullptr || maxMatches <= 0)
     {
-        cmdBufferUsed = 0;
-        cmdBuffer[0]  = '\0';
+        return -1;
     }
 
-    return commandsExecuted;
-}
+    int matchesFound = 0;
+    cvarFlagIndex.forEachWithFlags(flags,
+            [outMatches, maxMatches, &matchesFound](CVarImplBase * cvar)
+            {
+                if (matchesFound < maxMatches)
+                {
+                    outMatches[matchesFound] = cvar;
+                }
+                ++matchesFound; // Keep incrementing even if outMatches[] is full,
+                                // so the caller can know the total num found.
+                return true;
+            });
 
-bool CommandManagerImpl::hasBufferedCommands() const
-{
-    return cmdBufferUsed > 0;
+    if (matchesFound > 0)
+    {
+        // Output will be sorted alphabetically.
+        cvarSortMatches(outMatches, std::min(matchesFound, maxMatches));
+    }
+    return matchesFound;
 }
 
-void CommandManagerImpl::execTokenized(const CommandArgs & cmdArgs)
+template<typename T>
+int CVarManagerImpl::findWithPartialNameHelper(const char * const partialName, T * outMatches,
+                                               const int maxMatches, T (*pGetVar)(CVar *)) const
 {
-    // Validate the name length:
-    const char * const cmdName = cmdArgs.getCommandName();
-    if (lengthOfString(cmdName) >= MaxCommandNameLength)
+    if (partialName == nullptr || *partialName == '\0')
     {
-        errorF("Command name too long! Max command name length is %i characters.", MaxCommandNameLength);
-        return;
+        return 0;
     }
-
-    // Find the command:
-    auto cmd = registeredCommands.findByKey(cmdName);
-    if (cmd == nullptr)
+    else if (outMatches == nullptr || maxMatches <= 0)
     {
-        errorF("%s: Command not found.", cmdName);
-        return;
+        return -1;
     }
 
-    // Check if this command is currently allowed to execute:
-    if (disabledCmdFlags != 0)
-    {
-        if (disabledCmdFlags == DisableAll)
-        {
-            errorF("Command execution is globally disabled!");
-            return;
-        }
-        if (cmd->getFlags() & disabledCmdFlags)
-        {
-            errorF("%s: Command is disabled!", cmdName);
-            return;
-        }
-    }
+    // The sorted name index gives us the matches already in alphabetical order.
+    return registeredCVars.findByPrefix(partialName, maxMatches,
+                                        [outMatches, pGetVar](CVarImplBase * cvar, const int index)
+                                        {
+                                            outMatches[index] = pGetVar(cvar);
+                                        });
+}
 
-    // Optional min/max arguments validation, if they are not negative (zero args is OK):
-    if (cmd->getMinArgs() >= 0)
+bool CVarManagerImpl::removeCVar(const char * const name)
+{
+    if (!isValidCVarName(name))
     {
-        if (cmdArgs.getArgCount() < cmd->getMinArgs())
-        {
-            errorF("%s: Not enough arguments! Expected at least %i.", cmdName, cmd->getMinArgs());
-            return;
-        }
+        return errorF("'%s' is not a valid CVar name. Nothing to remove.", name);
     }
 
-    if (cmd->getMaxArgs() >= 0)
+    auto cvar = registeredCVars.unlinkByKey(name);
+    if (cvar == nullptr)
     {
-        if (cmdArgs.getArgCount() > cmd->getMaxArgs())
-        {
-            errorF("%s: Too many arguments provided! Expected up to %i.", cmdName, cmd->getMaxArgs());
-            return;
-        }
+        return false; // No such variable.
     }
 
-    // Arguments pre-validated, call command handler:
-    cmd->onExecute(cmdArgs);
+    forgetChangeListeners(cvar);
+    forgetSnapshotVar(cvar);
+    cvarFlagIndex.remove(cvar);
+    destroy(cvar);
+    memFree(memArena, cvar);
+    ++cvarRemovalGeneration;
+    return true;
 }
 
-bool CommandManagerImpl::extractNextCommand(const char ** outStr, char * destBuf, const int destSizeInChars, bool * outOverflowed) const
+bool CVarManagerImpl::removeCVar(CVar * cvar)
 {
-    const char * str = *outStr;
-    *outOverflowed   = false;
-
-    // First, sanitize leading command separators and whitespace
-    // that might have been left over from a previous pass.
-    for (; *str != '\0'; ++str)
+    if (cvar == nullptr)
     {
-        const int chr = *str;
-        if (!isWhitespace(chr) && chr != CommandTextSeparator)
-        {
-            break;
-        }
+        return false;
     }
+    return removeCVar(cvar->getNameCString());
+}
 
-    /*
-     * This simple parsing loop allows for commands mostly compatible
-     * with Unix Shell implementations. A couple examples:
-     *
-     * cmd_1 "hello world" \
-     *       "goodbye galaxy"
-     *
-     * ^ The backslash allows a multi-line command/arg-list.
-     *
-     * Multiple commands can also be placed on the same line if separated
-     * by a CommandTextSeparator (by default a ';'), example:
-     *
-     * cmd_1 hello; cmd_2 goodbye; cmd_3 "commands made easy"
-     *
-     * Quotes will keep whitespace-separated strings together as a single argument,
-     * ignoring occurrences of command separators inside the quoted blocks.
-     */
-
-    int  charsCopied = 0;
-    int  quoteCount  = 0;
-    bool quoted      = false;
-    bool singleQuote = false;
-    bool backslash   = false;
-    bool done        = false;
+void CVarManagerImpl::removeAllCVars()
+{
+    clearSnapshotDirtyVars();
+    snapshotDirty = true;
+    snapshotRebuildAll = true;
 
-    for (; !done && *str != '\0' && charsCopied < destSizeInChars; ++str)
+    auto cvar = registeredCVars.getFirst();
+    while (cvar != nullptr)
     {
-        const int chr = *str;
-        if (chr == '\r')
-        {
-            // Silently ignore Windows Carriage Returns.
-            // We only care about newlines.
-            continue;
-        }
-        else if (chr == '\\')
-        {
-            // A backslash allows a multi-line command.
-            backslash = true;
-            continue;
-        }
-        else if (chr == '\n')
-        {
-            // Ignore the newline if preceded by a backslash or between quotes.
-            done = !backslash && !quoted;
-            backslash = false;
-        }
-        else if (chr == '"')
-        {
-            // Remember if we are inside a quoted block.
-            // We have to ignore CommandTextSeparators inside them.
-            ++quoteCount;
-            quoted = quoteCount & 1;
-        }
-        else if (chr == '\'')
-        {
-            // Single quotes can start a quoted block or appear inside a double-quotes block.
-            if (!quoted)
-            {
-                ++quoteCount;
-                quoted = quoteCount & 1;
-                singleQuote = true;
-            }
-            else if (singleQuote)
-            {
-                ++quoteCount;
-                quoted = quoteCount & 1;
-                singleQuote = false;
-            }
-        }
-        else if (chr == CommandTextSeparator)
-        {
-            // Default command separator breaks a command
-            // string if not inside a quoted block.
-            done = !quoted;
-        }
-        #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
-        else if (chr == '$' && *(str + 1) == '(')
-        {
-            if (!expandCVar(&str, &charsCopied, destBuf, destSizeInChars, 1))
-            {
-                // Skip the rest of the broken command.
-                for (; *str != '\0' && *str != '\n' && *str != CommandTextSeparator; ++str) { }
-                *outOverflowed = true; // This makes the command string be discarded.
-                done = true;
-            }
-            continue;
-        }
-        #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
-
-        if (backslash && !(chr == ' ' || chr == '\t'))
-        {
-            // This prevents errors from lost backslashes in the middle of a string,
-            // which are probably leftovers from collapsing a line. Just ignore it.
-            backslash = false;
-        }
-
-        if (!done)
-        {
-            destBuf[charsCopied++] = static_cast<char>(chr);
-        }
+        auto temp = cvar->getNext();
+        forgetChangeListeners(cvar);
+        destroy(cvar);
+        memFree(memArena, cvar);
+        cvar = temp;
     }
+    registeredCVars.deallocate();
+    cvarFlagIndex.clear();
+    ++cvarRemovalGeneration;
 
-    if (charsCopied == destSizeInChars)
+    // Every CVar is gone, so the blocks can be released wholesale.
+    if (memArena != nullptr)
     {
-        --charsCopied; // Truncated.
-        *outOverflowed = true;
-        errorF("Command string too long! Can't parse all arguments from it...");
+        memArena->releaseAll();
     }
+}
 
-    destBuf[charsCopied] = '\0';
-    *outStr = str;
-
-    return charsCopied > 0;
+int CVarManagerImpl::getRegisteredCVarsCount() const
+{
+    return registeredCVars.getSize();
 }
 
-#if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
-bool CommandManagerImpl::expandCVar(const char ** outStr, int * outCharsCopied, char * destBuf,
-                                    const int destSizeInChars, const int recursionDepth) const
+bool CVarManagerImpl::isValidCVarName(const char * const name) const
 {
-    if (cvarManager == nullptr)
+    //
+    // CVar names somewhat follow the C++ variable
+    // naming rules, that is, cannot start with a number,
+    // cannot contain white spaces, cannot start with nor
+    // contain any special characters except the underscore.
+    //
+    // But we allow a CVar name composed by multiple words
+    // separated by a dot, such as "Obj.Prop", as long as the
+    // character following the dot complies to the above rules.
+    //
+    if (name == nullptr || *name == '\0')
     {
-        return errorF("No CVarManager set. Unable to perform CVar argument expansion.");
+        return false;
     }
 
-    // Max recursion depth for reentrant CVar expansions.
-    // If the maximum is reached, the whole substitution will fail.
-    constexpr int MaxRecursionDepth = 15;
-
-    const char * str   = *outStr;
-    int  parenthesis   = 0;
-    int  varNameLength = 0;
-    char varName[MaxCommandArgStrLength];
+    int i = 0;
+    int c = name[i++];
 
-    // Function should be entered while pointing to the '$'
-    CFG_ASSERT(*str == '$');
+    // Must start with a letter or an underscore:
+    if ((c < 'a' || c > 'z') && (c < 'A' || c > 'Z') && (c != '_'))
+    {
+        return false;
+    }
 
-    for (++str; *str != '\0' && *str != '\n' && *str != CommandTextSeparator; ++str)
+    while (name[i] != '\0')
     {
-        if (*str == '(')
-        {
-            ++parenthesis;
-        }
-        else if (*str == ')')
-        {
-            --parenthesis;
-            break;
-        }
-        else if (*str == '$' && *(str + 1) == '(') // Reentrant expansion
+        c = name[i++];
+
+        // If not a number nor a lower or upper case letter...
+        if ((c < '0' || c > '9') && (c < 'a' || c > 'z') && (c < 'A' || c > 'Z'))
         {
-            if (recursionDepth == MaxRecursionDepth)
+            // If it is a dot or an underscore it's OK, otherwise invalid.
+            if (c != '.' && c != '_')
             {
-                return errorF("Too many reentrant CVar argument expansions!");
+                return false;
             }
-            if (!expandCVar(&str, &varNameLength, varName, MaxCommandArgStrLength, recursionDepth + 1))
+
+            // As long as the next char is a letter or underscore
+            // and the string is not over after the dot...
+            if (c == '.' && name[i] == '\0')
             {
                 return false;
             }
-        }
-        else // Part of the var name
-        {
-            if (!isWhitespace(*str))
+
+            // Dot must be followed by letter or underscore.
+            if (c == '.')
             {
-                if (varNameLength == MaxCommandArgStrLength)
+                c = name[i++];
+                if ((c < 'a' || c > 'z') && (c < 'A' || c > 'Z') && c != '_')
                 {
-                    return errorF("Buffer overflow in CVar name expansion!");
+                    return false;
+                }
+            }
+            else // An '_'
+            {
+                // Underscore can be followed by letter,
+                // number, another underscore or a dot.
+                c = name[i++];
+                if ((c < '0' || c > '9') &&
+                    (c < 'a' || c > 'z') &&
+                    (c < 'A' || c > 'Z') &&
+                    c != '_' && c != '.')
+                {
+                    return false;
                 }
-                varName[varNameLength++] = *str;
             }
         }
     }
 
-    if (parenthesis != 0)
-    {
-        return errorF("Unbalanced opening or closing parenthesis in CVar argument expansion!");
-    }
-    if (varNameLength == 0)
-    {
-        return errorF("Missing CVar name in argument expansion!");
-    }
+    // A valid name if we get to the end of the string.
+    return true;
+}
 
-    varName[varNameLength] = '\0';
-    if (!cvarManager->isValidCVarName(varName))
+void CVarManagerImpl::enumerateAllCVars(CVarEnumerateCallback enumCallback, void * userContext)
+{
+    CFG_ASSERT(enumCallback != nullptr);
+    for (auto cvar = registeredCVars.getFirst(); cvar; cvar = cvar->getNext())
     {
-        return errorF("Invalid CVar name '%s' in argument expansion!", varName);
+        if (!enumCallback(cvar, userContext))
+        {
+            return;
+        }
     }
+}
 
-    const CVar * const cvar = cvarManager->findCVar(varName);
-    if (cvar == nullptr)
+int CVarManagerImpl::enumerateCVarsWithFlags(const std::uint32_t flags, CVarEnumerateCallback enumCallback, void * userContext)
+{
+    CFG_ASSERT(enumCallback != nullptr);
+    if (flags == 0)
     {
-        return errorF("Trying to expand undefined CVar '$(%s)'.", varName);
+        return 0;
     }
-
-    const int bufferOffset     = *outCharsCopied;
-    const std::string varValue = cvar->getStringValue();
-
-    *outCharsCopied += copyString(destBuf + bufferOffset, destSizeInChars - bufferOffset, varValue.c_str());
-    *outStr = str;
-
-    return true;
+    return cvarFlagIndex.forEachWithFlags(flags,
+            [enumCallback, userContext](CVarImplBase * cvar) { return enumCallback(cvar, userContext); });
 }
-#endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
 
-// ========================================================
-// Virtual destructors anchored to this file:
-// ========================================================
-
-Command::~Command()
-{ }
-
-CommandManager::~CommandManager()
-{ }
-
-CommandHandlerMemFunc::BaseCallableHolder::~BaseCallableHolder()
-{ }
-
-// ================================================================================================
-//
-//                                 Interactive Terminal/Console
-//
-// ================================================================================================
-
-// ========================================================
-// color::canColorPrint():
-// ========================================================
-
-namespace color
-{
-
-bool canColorPrint() noexcept
+template<typename T>
+bool CVarManagerImpl::validateCVarRegistration(const char * const name, const std::uint32_t flags,
+                                               const T & initValue, T (CVar::*pGetVal)() const) const
 {
-    #ifdef CFG_USE_ANSI_COLOR_CODES
-        #if (CFG_USE_ANSI_COLOR_CODES == 0)
-        // Define to zero to disable.
+    if (name == nullptr || *name == '\0')
+    {
+        return errorF("Null or empty string for CVar name!");
+    }
+    else if (!isValidCVarName(name))
+    {
+        return errorF("Invalid CVar name '%s'. Can't register it.", name);
+    }
+    else if (const auto cvar = findCVar(name))
+    {
+        if (cvar->getFlags() != flags)
+        {
+            errorF("CVar '%s' already registered with different flags!", name);
+        }
+        else if ((cvar->*pGetVal)() != initValue)
+        {
+            errorF("CVar '%s' already registered with different value!", name);
+        }
+        else
+        {
+            errorF("CVar '%s' already registered! Duplicate names are not allowed.", name);
+        }
         return false;
-        #elif (CFG_USE_ANSI_COLOR_CODES == 1)
-        // Define to 1 to check for redirection.
-        // This can be cached, since it is unlikely that the standard
-        // streams will be redirected while the program is still running.
-        static bool notRedirected = CFG_ISATTY(CFG_STDOUT_FILENO) && CFG_ISATTY(CFG_STDERR_FILENO);
-        return notRedirected;
-        #else
-        // Define to anything else to always enable.
+    }
+    else // Registration is a go.
+    {
         return true;
-        #endif // CFG_USE_ANSI_COLOR_CODES
-    #else // not defined -> always disable.
-    return false;
-    #endif // CFG_USE_ANSI_COLOR_CODES
+    }
 }
 
-} // namespace color {}
-
-// ========================================================
-// SpecialKeys::toString():
-// ========================================================
-
-std::string SpecialKeys::toString(const int key)
+CVar * CVarManagerImpl::registerCVarBool(const char * const name, const char * const description,
+                                         const std::uint32_t flags, const bool initValue,
+                                         CVarValueCompletionCallback completionCb)
 {
-    std::string str;
-    switch (key)
+    if (!validateCVarRegistration(name, flags, initValue, &CVar::getBoolValue))
     {
-    case Return     : { str = "Return";     break; }
-    case Tab        : { str = "Tab";        break; }
-    case Backspace  : { str = "Backspace";  break; }
-    case Delete     : { str = "Delete";     break; }
-    case UpArrow    : { str = "UpArrow";    break; }
-    case DownArrow  : { str = "DownArrow";  break; }
-    case RightArrow : { str = "RightArrow"; break; }
-    case LeftArrow  : { str = "LeftArrow";  break; }
-    case Escape     : { str = "Escape";     break; }
-    case Control    : { str = "Control";    break; }
-    default         : { str.push_back(static_cast<char>(key)); break; }
-    } // switch (key)
-    return str;
-}
-
-// ========================================================
-// BuiltInCmd handlers:
-// ========================================================
-
-static void cmdExit(SimpleCommandTerminal & term)      { term.setExit();             }
-static void cmdClear(SimpleCommandTerminal & term)     { term.clear();               }
-static void cmdHistView(SimpleCommandTerminal & term)  { term.printCommandHistory(); }
-static void cmdHistClear(SimpleCommandTerminal & term) { term.clearCommandHistory(); }
-static void cmdHistSave(SimpleCommandTerminal & term)  { term.saveCommandHistory();  }
-static void cmdHistLoad(SimpleCommandTerminal & term)  { term.loadCommandHistory();  }
-
-// ========================================================
-// List of built-in commands:
-// ========================================================
-
-const SimpleCommandTerminal::BuiltInCmd SimpleCommandTerminal::builtInCmds[]
-{
-    { &cmdExit,      "exit",      "Exits the interactive terminal mode." },
-    { &cmdClear,     "clear",     "Clears the terminal screen."          },
-    { &cmdHistView,  "histView",  "Prints the current command history."  },
-    { &cmdHistClear, "histClear", "Erases the current command history."  },
-    { &cmdHistSave,  "histSave",  "Saves the current command history to \"" CFG_COMMAND_HIST_FILE "\"." },
-    { &cmdHistLoad,  "histLoad",  "Load previous command history from \""   CFG_COMMAND_HIST_FILE "\"." }
-};
-
-// ========================================================
-// SimpleCommandTerminal implementation:
-// ========================================================
+        return nullptr;
+    }
 
-SimpleCommandTerminal::SimpleCommandTerminal(CommandManager * cmdMgr,
-                                             CVarManager    * cvarMgr,
-                                             const char     * newlineMark)
-    : lineBufferUsed(0)
-    , lineBufferInsertionPos(0)
-    , currCmdInHistory(0)
-    , indexCmdHistory(0)
-    , lineHasMarker(false)
-    , exitFlag(false)
-    , listAllCmdsOnTab(false)
-    , firstAutoCompletionTry(true)
-    , oldLineBufferUsed(0)
-    , nextDisplayedCompletionMatch(0)
-    , partialStrLength(0)
-    , completionMatchCount(0)
-    , cmdManager(cmdMgr)
-    , cvarManager(cvarMgr)
-    , cmdExecMode(CommandExecMode::Append)
-    , newlineMarkerStr(newlineMark)
-{
-    clearArray(completionMatches);
-    clearArray(lineBuffer);
+    auto newVar = memAlloc<CVarBool>(memArena, 1, MemoryCategory::CVars);
+    construct(newVar, name, description, flags, initValue, CVarNumberRange<bool>(false, true), completionCb, memArena);
+    return linkNewCVar(newVar, name);
 }
 
-SimpleCommandTerminal::~SimpleCommandTerminal()
+CVar * CVarManagerImpl::registerCVarInt(const char * const name, const char * const description,
+                                        const std::uint32_t flags, const std::int64_t initValue,
+                                        const std::int64_t minValue, const std::int64_t maxValue,
+                                        CVarValueCompletionCallback completionCb)
 {
-    // No cleanup needed.
-    // Here to anchor the vtable to this file.
-}
+    if (!validateCVarRegistration(name, flags, initValue, &CVar::getIntValue))
+    {
+        return nullptr;
+    }
 
-CommandManager * SimpleCommandTerminal::getCommandManager() const noexcept
-{
-    return cmdManager;
+    auto newVar = memAlloc<CVarInt>(memArena, 1, MemoryCategory::CVars);
+    construct(newVar, name, description, flags, initValue, CVarNumberRange<std::int64_t>(minValue, maxValue), completionCb, memArena);
+    return linkNewCVar(newVar, name);
 }
 
-CommandExecMode SimpleCommandTerminal::getCommandExecMode() const noexcept
+CVar * CVarManagerImpl::registerCVarFloat(const char * const name, const char * const description,
+                                          const std::uint32_t flags, const double initValue,
+                                          const double minValue, const double maxValue,
+                                          CVarValueCompletionCallback completionCb)
 {
-    return cmdExecMode;
-}
+    if (!validateCVarRegistration(name, flags, initValue, &CVar::getFloatValue))
+    {
+        return nullptr;
+    }
 
-CVarManager * SimpleCommandTerminal::getCVarManager() const noexcept
-{
-    return cvarManager;
+    auto newVar = memAlloc<CVarFloat>(memArena, 1, MemoryCategory::CVars);
+    construct(newVar, name, description, flags, initValue, CVarNumberRange<double>(minValue, maxValue), completionCb, memArena);
+    return linkNewCVar(newVar, name);
 }
 
-void SimpleCommandTerminal::setCommandManager(CommandManager * cmdMgr) noexcept
+CVar * CVarManagerImpl::registerCVarString(const char * const name, const char * const description,
+                                           const std::uint32_t flags, const std::string & initValue,
+                                           const char ** allowedStrings, CVarValueCompletionCallback completionCb)
 {
-    cmdManager = cmdMgr;
-}
+    if (!validateCVarRegistration(name, flags, initValue, &CVar::getStringValue))
+    {
+        return nullptr;
+    }
 
-void SimpleCommandTerminal::setCommandExecMode(const CommandExecMode newMode) noexcept
-{
-    cmdExecMode = newMode;
+    auto newVar = memAlloc<CVarString>(memArena, 1, MemoryCategory::CVars);
+    construct(newVar, name, description, flags, initValue, CVarAllowedStrings(allowedStrings, memArena), completionCb, memArena);
+    return linkNewCVar(newVar, name);
 }
 
-void SimpleCommandTerminal::setCVarManager(CVarManager * cvarMgr) noexcept
+CVar * CVarManagerImpl::registerCVarEnum(const char * const name, const char * const description,
+                                         const std::uint32_t flags, const std::int64_t initValue,
+                                         const std::int64_t * const enumConstants, const char ** constNames,
+                                         CVarValueCompletionCallback completionCb)
 {
-    cvarManager = cvarMgr;
-}
+    if (!validateCVarRegistration(name, flags, initValue, &CVar::getIntValue))
+    {
+        return nullptr;
+    }
 
-void SimpleCommandTerminal::setTextColor(const char * const ansiColorCode) noexcept
-{
-    print(ansiColorCode);
-}
+    CVarEnumConstList enumConstList(enumConstants, constNames, memArena);
+    const CVarEnumConst enumValue = findEnumConst(enumConstList, initValue);
 
-void SimpleCommandTerminal::restoreTextColor() noexcept
-{
-    print(color::restore());
+    auto newVar = memAlloc<CVarEnum>(memArena, 1, MemoryCategory::CVars);
+    construct(newVar, name, description, flags, enumValue, enumConstList, completionCb, memArena);
+    return linkNewCVar(newVar, name);
 }
 
-void SimpleCommandTerminal::printF(const char * const fmt, ...)
+CVarEnumConst CVarManagerImpl::findEnumConst(const CVarEnumConstList & enumConstList, const std::int64_t value)
 {
-    CFG_ASSERT(fmt != nullptr);
-
-    va_list vaList;
-    char tempStr[LineBufferMaxSize];
-
-    va_start(vaList, fmt);
-    const int result = std::vsnprintf(tempStr, lengthOfArray(tempStr), fmt, vaList);
-    va_end(vaList);
+    CVarEnumConst enumValue = { "", value };
 
-    if (result > 0)
+    // Find the name from provided values and const names:
+    if (enumConstList.names != nullptr && enumConstList.values != nullptr)
     {
-        print(tempStr);
+        const int c = enumConstList.findValue(value);
+        if (c >= 0)
+        {
+            enumValue.name = enumConstList.names[c];
+        }
     }
+    return enumValue;
 }
 
-void SimpleCommandTerminal::clear()
+int CVarManagerImpl::registerCVars(const CVarDesc * const descs, const int count, CVar ** outCVars)
 {
-    // If a child class overrides clear(), this should still
-    // be called at the end to insert a new line marker in
-    // the just cleared terminal buffer.
-
-    print(newlineMarkerStr.c_str());
-
-    lineBufferUsed               = 0;
-    lineBufferInsertionPos       = 0;
-    lineHasMarker                = true;
-    listAllCmdsOnTab             = false;
-    firstAutoCompletionTry       = true;
-    oldLineBufferUsed            = 0;
-    nextDisplayedCompletionMatch = 0;
-    partialStrLength             = 0;
-    completionMatchCount         = 0;
+    if (descs == nullptr || count <= 0)
+    {
+        return 0;
+    }
 
-    clearArray(completionMatches);
-    clearArray(lineBuffer);
+    // Sized once for the whole batch.
+    registeredCVars.reserve(registeredCVars.getSize() + count);
 
-    for (auto & s : argStringMatches)
+    int registered = 0;
+    for (int i = 0; i < count; ++i)
     {
-        s.clear();
+        CVar * newVar = registerCVarFromDesc(descs[i]);
+        if (newVar != nullptr)
+        {
+            ++registered;
+        }
+        if (outCVars != nullptr)
+        {
+            outCVars[i] = newVar;
+        }
     }
+    return registered;
 }
 
-void SimpleCommandTerminal::update()
+CVar * CVarManagerImpl::registerCVarFromDesc(const CVarDesc & desc)
 {
-    // Might not have the newline marker yet if the CommandManager was still processing commands.
-    if (!lineHasMarker && !exitFlag)
+    const char * const  name    = desc.name.name;
+    const std::uint32_t hashKey = hashOfName(desc.name);
+
+    if (!isValidCVarName(name))
     {
-        print(newlineMarkerStr.c_str());
-        lineHasMarker = true;
+        errorF("Invalid CVar name '%s'. Can't register it.", name);
+        return nullptr;
+    }
+    if (registeredCVars.findByKey(name, hashKey) != nullptr)
+    {
+        errorF("CVar '%s' already registered! Duplicate names are not allowed.", name);
+        return nullptr;
     }
-}
 
-bool SimpleCommandTerminal::exit() const
-{
-    return exitFlag;
-}
+    // Strings are referenced, not cloned.
+    const bool staticStrings = true;
+    CVarImplBase * newVar;
 
-void SimpleCommandTerminal::cancelExit()
-{
-    exitFlag = false;
+    switch (desc.type)
+    {
+    case CVar::Type::Bool :
+        {
+            auto var = memAlloc<CVarBool>(memArena, 1, MemoryCategory::CVars);
+            newVar = construct(var, name, desc.description, desc.flags, desc.intValue != 0,
+                               CVarNumberRange<bool>(false, true), desc.completionCb, memArena, staticStrings);
+            break;
+        }
+    case CVar::Type::Int :
+        {
+            auto var = memAlloc<CVarInt>(memArena, 1, MemoryCategory::CVars);
+            newVar = construct(var, name, desc.description, desc.flags, desc.intValue,
+                               CVarNumberRange<std::int64_t>(desc.intMin, desc.intMax), desc.completionCb, memArena, staticStrings);
+            break;
+        }
+    case CVar::Type::Float :
+        {
+            auto var = memAlloc<CVarFloat>(memArena, 1, MemoryCategory::CVars);
+            newVar = construct(var, name, desc.description, desc.flags, desc.floatValue,
+                               CVarNumberRange<double>(desc.floatMin, desc.floatMax), desc.completionCb, memArena, staticStrings);
+            break;
+        }
+    case CVar::Type::String :
+        {
+            auto var = memAlloc<CVarString>(memArena, 1, MemoryCategory::CVars);
+            const char * const initValue = (desc.stringValue != nullptr ? desc.stringValue : "");
+            newVar = construct(var, name, desc.description, desc.flags, CVarStringValue(initValue, lengthOfString(initValue)),
+                               CVarAllowedStrings::fromStatic(desc.strings, memArena), desc.completionCb, memArena, staticStrings);
+            break;
+        }
+    case CVar::Type::Enum :
+        {
+            const CVarEnumConstList enumConstList = CVarEnumConstList::fromStatic(desc.enumConstants, desc.strings, memArena);
+            auto var = memAlloc<CVarEnum>(memArena, 1, MemoryCategory::CVars);
+            newVar = construct(var, name, desc.description, desc.flags, findEnumConst(enumConstList, desc.intValue),
+                               enumConstList, desc.completionCb, memArena, staticStrings);
+            break;
+        }
+    default :
+        errorF("Invalid CVar type for '%s'!", name);
+        return nullptr;
+    } // switch (desc.type)
+
+    return linkNewCVar(newVar, name, hashKey);
 }
 
-void SimpleCommandTerminal::setExit()
+bool CVarManagerImpl::getCVarValueBool(const char * const name) const
 {
-    exitFlag = true;
-    onExit();
+    if (const auto cvar = findCVar(name))
+    {
+        return cvar->getBoolValue();
+    }
+    errorF("CVar '%s' not found.", name);
+    return false;
 }
 
-void SimpleCommandTerminal::onExit()
+std::int64_t CVarManagerImpl::getCVarValueInt(const char * const name) const
 {
-    // A no-op by default.
+    if (const auto cvar = findCVar(name))
+    {
+        return cvar->getIntValue();
+    }
+    errorF("CVar '%s' not found.", name);
+    return 0;
 }
 
-void SimpleCommandTerminal::onSetClipboardString(const char * /* str */)
+double CVarManagerImpl::getCVarValueFloat(const char * const name) const
 {
-    // A no-op by default.
+    if (const auto cvar = findCVar(name))
+    {
+        return cvar->getFloatValue();
+    }
+    errorF("CVar '%s' not found.", name);
+    return 0.0;
 }
 
-const char * SimpleCommandTerminal::onGetClipboardString()
+std::string CVarManagerImpl::getCVarValueString(const char * const name) const
 {
-    return nullptr; // A no-op by default.
+    std::string str;
+    if (const auto cvar = findCVar(name))
+    {
+        str = cvar->getStringValue();
+        return str;
+    }
+    errorF("CVar '%s' not found.", name);
+    return str;
 }
 
-bool SimpleCommandTerminal::handleKeyInput(const int key, const char chr)
+bool CVarManagerImpl::getCVarValueBool(const HashedName & name) const
 {
-    // Reset some [TAB] auto-completion states:
-    if (key != SpecialKeys::Tab)
+    if (const auto cvar = findCVar(name))
     {
-        listAllCmdsOnTab             = false;
-        firstAutoCompletionTry       = true;
-        nextDisplayedCompletionMatch = 0;
-        oldLineBufferUsed            = 0;
+        return cvar->getBoolValue();
     }
+    errorF("CVar '%s' not found.", name.name);
+    return false;
+}
 
-    switch (key)
+std::int64_t CVarManagerImpl::getCVarValueInt(const HashedName & name) const
+{
+    if (const auto cvar = findCVar(name))
     {
-    case SpecialKeys::Return     : return finishCommand();
-    case SpecialKeys::Tab        : return tabCompletion();
-    case SpecialKeys::Backspace  : return popChar();
-    case SpecialKeys::Delete     : return delChar();
-    case SpecialKeys::UpArrow    : return nextCmdFromHistory();
-    case SpecialKeys::DownArrow  : return prevCmdFromHistory();
-    case SpecialKeys::RightArrow : return navigateTextRight();
-    case SpecialKeys::LeftArrow  : return navigateTextLeft();
-    case SpecialKeys::Escape     : return discardInput();
-    case SpecialKeys::Control    : return handleCtrlKey(chr);
-    default                      : return insertChar(chr);
-    } // switch (key)
+        return cvar->getIntValue();
+    }
+    errorF("CVar '%s' not found.", name.name);
+    return 0;
 }
 
-int SimpleCommandTerminal::getCommandHistorySize() const noexcept
+double CVarManagerImpl::getCVarValueFloat(const HashedName & name) const
 {
-    return indexCmdHistory;
+    if (const auto cvar = findCVar(name))
+    {
+        return cvar->getFloatValue();
+    }
+    errorF("CVar '%s' not found.", name.name);
+    return 0.0;
 }
 
-const char * SimpleCommandTerminal::getCommandFromHistory(const int index) const
+std::string CVarManagerImpl::getCVarValueString(const HashedName & name) const
 {
-    CFG_ASSERT(index >= 0 && index < getCommandHistorySize());
-    return cmdHistory[index].c_str();
+    std::string str;
+    if (const auto cvar = findCVar(name))
+    {
+        str = cvar->getStringValue();
+        return str;
+    }
+    errorF("CVar '%s' not found.", name.name);
+    return str;
 }
 
-void SimpleCommandTerminal::clearCommandHistory()
+CVar * CVarManagerImpl::setCVarValueBool(const char * const name, const bool value, const std::uint32_t flags)
 {
-    for (int i = 0; i < CmdHistoryMaxSize; ++i)
+    if (auto cvar = findCVar(name))
     {
-        cmdHistory[i].clear();
+        cvar->setBoolValue(value);
+        return cvar;
     }
-
-    currCmdInHistory = 0;
-    indexCmdHistory  = 0;
+    return registerCVarBool(name, "", flags, value);
 }
 
-void SimpleCommandTerminal::printCommandHistory()
+CVar * CVarManagerImpl::setCVarValueInt(const char * const name, const std::int64_t value, const std::uint32_t flags)
 {
-    printLn("----- Command History -----");
-
-    const int histSize = getCommandHistorySize();
-    for (int i = 0; i < histSize; ++i)
+    if (auto cvar = findCVar(name))
     {
-        printF("[%02i]: %s\n", i, getCommandFromHistory(i));
+        cvar->setIntValue(value);
+        return cvar;
     }
+    return registerCVarInt(name, "", flags, value, INT64_MIN, INT64_MAX);
 }
 
-bool SimpleCommandTerminal::saveCommandHistory()
+CVar * CVarManagerImpl::setCVarValueFloat(const char * const name, const double value, const std::uint32_t flags)
 {
-    FileIOCallbacks * io = getFileIOCallbacks();
-
-    FileHandle fileOut;
-    if (!io->open(&fileOut, CFG_COMMAND_HIST_FILE, FileOpenMode::Write))
+    if (auto cvar = findCVar(name))
     {
-        return false;
+        cvar->setFloatValue(value);
+        return cvar;
     }
+    return registerCVarFloat(name, "", flags, value, DBL_MIN, DBL_MAX);
+}
 
-    const int histSize = getCommandHistorySize();
-    for (int i = 0; i < histSize; ++i)
+CVar * CVarManagerImpl::setCVarValueString(const char * const name, const std::string & value, const std::uint32_t flags)
+{
+    if (auto cvar = findCVar(name))
     {
-        io->writeFormat(fileOut, "%s\n", getCommandFromHistory(i));
+        cvar->setStringValue(value);
+        return cvar;
     }
+    return registerCVarString(name, "", flags, value, nullptr);
+}
 
-    printF("Command history saved to \"%s\".\n", CFG_COMMAND_HIST_FILE);
-    io->close(fileOut);
-    return true;
+CVar * CVarManagerImpl::linkNewCVar(CVarImplBase * newVar, const char * const name)
+{
+    return linkNewCVar(newVar, name, CVarNameHasher{}(name));
 }
 
-bool SimpleCommandTerminal::loadCommandHistory()
+// With the hash of the name computed in advance, e.g. by a CVarDesc.
+CVar * CVarManagerImpl::linkNewCVar(CVarImplBase * newVar, const char * const name, const std::uint32_t hashKey)
 {
-    FileIOCallbacks * io = getFileIOCallbacks();
+    newVar->owner = this;
+    registeredCVars.linkWithKey(newVar, name, hashKey);
+    cvarFlagIndex.update(newVar);
+    markSnapshotDirty(newVar);
+    return newVar;
+}
 
-    FileHandle fileIn;
-    if (!io->open(&fileIn, CFG_COMMAND_HIST_FILE, FileOpenMode::Read))
+int CVarManagerImpl::addChangeListener(CVar * cvar, const CVarChangeCallback callback,
+                                       void * userContext, const CVarChangeDelivery delivery)
+{
+    if (cvar == nullptr || static_cast<CVarImplBase *>(cvar)->owner != this)
     {
-        return false;
+        errorF("Can't add a change listener for a CVar not registered with this manager!");
+        return 0;
     }
+    return addChangeListenerHelper({ 0, static_cast<CVarImplBase *>(cvar), 0, NameString(), callback, userContext, delivery });
+}
 
-    clearCommandHistory(); // Current history is lost, if any.
-
-    // Copy the new history:
-    char line[LineBufferMaxSize];
-    while (io->readLine(fileIn, line, lengthOfArray(line)))
+int CVarManagerImpl::addChangeListenerForFlags(const std::uint32_t flags, const CVarChangeCallback callback,
+                                               void * userContext, const CVarChangeDelivery delivery)
+{
+    if (flags == 0)
     {
-        addCmdToHistory(rightTrimString(line)); // RTrim to get rid of the newline.
+        errorF("Can't add a change listener for empty CVar flags!");
+        return 0;
     }
-
-    printF("Command history restored from \"%s\".\n", CFG_COMMAND_HIST_FILE);
-    io->close(fileIn);
-    return true;
+    return addChangeListenerHelper({ 0, nullptr, flags, NameString(), callback, userContext, delivery });
 }
 
-int SimpleCommandTerminal::getBuiltInCommandsCount() const noexcept
+int CVarManagerImpl::addChangeListenerForPrefix(const char * const namePrefix, const CVarChangeCallback callback,
+                                                void * userContext, const CVarChangeDelivery delivery)
 {
-    return lengthOfArray(builtInCmds);
+    if (namePrefix == nullptr || *namePrefix == '\0')
+    {
+        errorF("Can't add a change listener for an empty CVar name prefix!");
+        return 0;
+    }
+    return addChangeListenerHelper({ 0, nullptr, 0, NameString(namePrefix), callback, userContext, delivery });
 }
 
-const SimpleCommandTerminal::BuiltInCmd * SimpleCommandTerminal::getBuiltInCommand(const int index) const
+int CVarManagerImpl::addChangeListenerHelper(CVarChangeListener listener)
 {
-    CFG_ASSERT(index >= 0 && index < getBuiltInCommandsCount());
-    return &builtInCmds[index];
+    if (listener.callback == nullptr)
+    {
+        errorF("Null CVar change callback!");
+        return 0;
+    }
+
+    listener.id = nextChangeListenerId++;
+    if (listener.cvar != nullptr)
+    {
+        ++listener.cvar->changeListenerCount;
+    }
+    else
+    {
+        ++globalChangeListeners;
+    }
+
+    changeListeners.push_back(std::move(listener));
+    return changeListeners.back().id;
 }
 
-const SimpleCommandTerminal::BuiltInCmd * SimpleCommandTerminal::getBuiltInCommand(const char * const name) const
+bool CVarManagerImpl::removeChangeListener(const int listenerId)
 {
-    if (name == nullptr || *name == '\0')
+    if (listenerId <= 0)
     {
-        return nullptr;
+        return false;
     }
 
-    const int builtInCount = getBuiltInCommandsCount();
-    for (int i = 0; i < builtInCount; ++i)
+    for (CVarChangeListener & listener : changeListeners)
     {
-        if (cmdCmpNames(name, builtInCmds[i].name) == 0)
+        if (listener.id != listenerId)
         {
-            return &builtInCmds[i];
+            continue;
         }
-    }
 
-    return nullptr;
+        if (listener.cvar != nullptr)
+        {
+            --listener.cvar->changeListenerCount;
+        }
+        else
+        {
+            --globalChangeListeners;
+        }
+
+        // Erased later if a dispatch loop is running.
+        listener.id = 0;
+        hasRemovedListeners = true;
+        if (changeDispatchDepth == 0)
+        {
+            compactChangeListeners();
+        }
+        return true;
+    }
+    return false; // No such listener.
 }
 
-void SimpleCommandTerminal::setLineBuffer(const char * str)
+void CVarManagerImpl::forgetChangeListeners(CVarImplBase * cvar)
 {
-    if (str == nullptr)
+    if (cvar->changeListenerCount > 0)
     {
-        return;
+        for (CVarChangeListener & listener : changeListeners)
+        {
+            if (listener.id != 0 && listener.cvar == cvar)
+            {
+                listener.id   = 0;
+                listener.cvar = nullptr;
+            }
+        }
+        cvar->changeListenerCount = 0;
+        hasRemovedListeners = true;
+        if (changeDispatchDepth == 0)
+        {
+            compactChangeListeners();
+        }
     }
 
-    clearVisibleEditLine();
-    if (*str != '\0')
+    if (deliveringChanges)
     {
-        print(str);
-        lineBufferUsed = copyString(lineBuffer, lengthOfArray(lineBuffer), str);
-        lineBufferInsertionPos = lineBufferUsed;
+        // The batch being delivered skips the null entries.
+        std::replace(pendingChanges.begin(), pendingChanges.end(), cvar, static_cast<CVarImplBase *>(nullptr));
     }
-    else
+    else if (cvar->changePending)
     {
-        clearLineInputBuffer();
+        pendingChanges.erase(std::find(pendingChanges.begin(), pendingChanges.end(), cvar));
     }
 }
 
-const char * SimpleCommandTerminal::getLineBuffer() const
+void CVarManagerImpl::compactChangeListeners()
 {
-    return lineBuffer;
+    changeListeners.erase(std::remove_if(changeListeners.begin(), changeListeners.end(),
+                                         [](const CVarChangeListener & listener) { return listener.id == 0; }),
+                          changeListeners.end());
+    hasRemovedListeners = false;
 }
 
-bool SimpleCommandTerminal::isLineBufferEmpty() const
+bool CVarManagerImpl::listenerMatches(const CVarChangeListener & listener, const CVarImplBase * cvar) const
 {
-    return lineBufferUsed == 0;
+    if (listener.id == 0)
+    {
+        return false;
+    }
+    if (listener.cvar != nullptr)
+    {
+        return listener.cvar == cvar;
+    }
+    if (listener.flags != 0)
+    {
+        return (cvar->getFlags() & listener.flags) != 0;
+    }
+    return CVarNameCompare{}(cvar->getNameCString(), listener.namePrefix.c_str(),
+                             static_cast<std::uint32_t>(listener.namePrefix.size())) == 0;
 }
 
-void SimpleCommandTerminal::newLineNoMarker()
+void CVarManagerImpl::onCVarValueChanged(CVarImplBase * cvar)
 {
-    print("\n");
-    lineHasMarker = false;
-}
-
-void SimpleCommandTerminal::newLineWithMarker()
-{
-    printF("\n%s", newlineMarkerStr.c_str());
-    lineHasMarker = true;
-}
+    markSnapshotDirty(cvar);
+    ++changeDispatchDepth;
 
-void SimpleCommandTerminal::clearVisibleEditLine()
-{
-    // Fill the line with blanks to clear it out.
-    char blankLine[LineBufferMaxSize];
-    const int charsToFill = std::min(static_cast<int>(lineBufferUsed + newlineMarkerStr.length()), lengthOfArray(blankLine));
+    // Indexed loop, since the callbacks can add listeners.
+    bool queued = cvar->changePending;
+    for (std::size_t i = 0; i < changeListeners.size(); ++i)
+    {
+        if (!listenerMatches(changeListeners[i], cvar))
+        {
+            continue;
+        }
 
-    std::memset(blankLine, ' ', charsToFill);
-    blankLine[charsToFill] = '\0';
+        if (changeListeners[i].delivery == CVarChangeDelivery::Immediate)
+        {
+            changeListeners[i].callback(cvar, changeListeners[i].userContext);
+        }
+        else if (!queued)
+        {
+            pendingChanges.push_back(cvar);
+            cvar->changePending = true;
+            queued = true;
+        }
+    }
 
-    printF("\r%s\r%s", blankLine, newlineMarkerStr.c_str());
-    lineHasMarker = true;
+    if (--changeDispatchDepth == 0 && hasRemovedListeners)
+    {
+        compactChangeListeners();
+    }
 }
 
-void SimpleCommandTerminal::clearLineInputBuffer()
+int CVarManagerImpl::deliverChangeNotifications()
 {
-    lineBufferUsed         = 0;
-    lineBufferInsertionPos = 0;
-    lineBuffer[0]          = '\0';
-}
+    if (deliveringChanges)
+    {
+        return 0; // Called from inside a listener.
+    }
 
-bool SimpleCommandTerminal::finishCommand()
-{
-    // Break this line but don't put the new line marker yet,
-    // let the command be processed first.
-    newLineNoMarker();
+    deliveringChanges = true;
+    ++changeDispatchDepth;
 
-    // Add to the history and run the command:
-    if (!isLineBufferEmpty())
+    // Vars changed by the callbacks are appended past the current batch.
+    int delivered = 0;
+    const std::size_t batchSize = pendingChanges.size();
+    for (std::size_t p = 0; p < batchSize; ++p)
     {
-        // But ignore blank lines/empty command.
-        if (*lineBuffer != '\0' && *lineBuffer != '\n' && *lineBuffer != '\r')
+        CVarImplBase * cvar = pendingChanges[p];
+        if (cvar == nullptr)
         {
-            addCmdToHistory(lineBuffer);
-            execCmdLine(lineBuffer);
+            continue; // Removed after it changed.
         }
-        clearLineInputBuffer();
+
+        // Cleared first, so a change made by a callback is queued again.
+        cvar->changePending = false;
+        for (std::size_t i = 0; i < changeListeners.size() && pendingChanges[p] != nullptr; ++i)
+        {
+            if (changeListeners[i].delivery == CVarChangeDelivery::Batched && listenerMatches(changeListeners[i], cvar))
+            {
+                changeListeners[i].callback(cvar, changeListeners[i].userContext);
+            }
+        }
+        ++delivered;
     }
 
-    bool canAddMarker;
-    if (cmdManager == nullptr)
+    pendingChanges.erase(pendingChanges.begin(), pendingChanges.begin() + batchSize);
+    deliveringChanges = false;
+
+    if (--changeDispatchDepth == 0 && hasRemovedListeners)
     {
-        canAddMarker = true;
+        compactChangeListeners();
     }
-    else if (cmdManager->hasBufferedCommands())
+    return delivered;
+}
+
+int CVarManagerImpl::getPendingChangeNotificationsCount() const
+{
+    return static_cast<int>(pendingChanges.size());
+}
+
+void CVarManagerImpl::setCVarSnapshotsEnabled(const bool enable)
+{
+    if (enable == snapshotsEnabled)
     {
-        canAddMarker = false;
+        return;
+    }
+
+    snapshotsEnabled = enable;
+    if (enable)
+    {
+        snapshotDirty = true;
+        publishCVarSnapshot();
     }
     else
     {
-        canAddMarker = true;
+        retireCurrentCVarSnapshot(nullptr);
+        reclaimCVarSnapshots();
+        clearSnapshotDirtyVars();
     }
+}
 
-    if (canAddMarker && !lineHasMarker && !exitFlag)
+bool CVarManagerImpl::isCVarSnapshotsEnabled() const
+{
+    return snapshotsEnabled;
+}
+
+bool CVarManagerImpl::publishCVarSnapshot()
+{
+    bool published = false;
+    if (snapshotsEnabled && snapshotDirty)
     {
-        print(newlineMarkerStr.c_str());
-        lineHasMarker = true;
+        snapshotDirty = false;
+        retireCurrentCVarSnapshot(buildCVarSnapshot());
+        published = true;
     }
 
-    return true; // Input [RETURN] was handled.
+    reclaimCVarSnapshots();
+    return published;
 }
 
-void SimpleCommandTerminal::execCmdLine(const char * cmd)
+CVarSnapshotRef CVarManagerImpl::acquireCVarSnapshot() const
 {
-    char cmdName[LineBufferMaxSize];
-    const char * cmdPtr = cmd;
+    for (;;)
+    {
+        CVarSnapshotImpl * snapshot = currentSnapshot.load();
+        if (snapshot == nullptr)
+        {
+            return CVarSnapshotRef(nullptr);
+        }
 
-    // Skip leading whitespace:
-    for (; *cmdPtr != '\0' && isWhitespace(*cmdPtr); ++cmdPtr) { }
-    const char * firstNonWhite = cmdPtr;
+        // Once in a hazard slot the version is not freed, even if retired. If it was
+        // already retired before that, the manager can free it anytime, so try again.
+        std::atomic<const CVarSnapshotImpl *> & hazard = claimSnapshotHazard(snapshot);
+        const bool stillCurrent = (currentSnapshot.load() == snapshot);
+        if (stillCurrent)
+        {
+            snapshot->refCount.fetch_add(1);
+        }
+        hazard.store(nullptr);
 
-    // Copy until the first whitespace to get the command name:
-    char * p = cmdName;
-    for (; *cmdPtr != '\0' && !isWhitespace(*cmdPtr); ++p, ++cmdPtr)
-    {
-        *p = *cmdPtr;
+        if (stillCurrent)
+        {
+            return CVarSnapshotRef(snapshot);
+        }
     }
-    *p = '\0';
+}
 
-    if (*cmdName == '\0')
+std::atomic<const CVarSnapshotImpl *> & CVarManagerImpl::claimSnapshotHazard(const CVarSnapshotImpl * const snapshot) const
+{
+    // Readers start looking at different slots, so they seldom compete for one.
+    // A slot is only held for a few instructions, so a free one turns up quickly.
+    for (std::uint32_t index = nextSnapshotHazard.fetch_add(1, std::memory_order_relaxed); ; ++index)
     {
-        return; // Just whitespace.
+        std::atomic<const CVarSnapshotImpl *> & hazard = snapshotHazards[index % SnapshotHazardSlots];
+        const CVarSnapshotImpl * expected = nullptr;
+        if (hazard.load(std::memory_order_relaxed) == nullptr && hazard.compare_exchange_strong(expected, snapshot))
+        {
+            return hazard;
+        }
     }
+}
 
-    //
-    // Check if not setting a CVar with the shortcut notation:
-    // "varName value"
-    //
-    // Or if printing the variable value by referencing it.
-    //
-    if (cvarManager != nullptr)
+bool CVarManagerImpl::isSnapshotHazard(const CVarSnapshotImpl * const snapshot) const
+{
+    for (const std::atomic<const CVarSnapshotImpl *> & hazard : snapshotHazards)
     {
-        if (CVar * cvar = cvarManager->findCVar(cmdName))
+        if (hazard.load() == snapshot)
         {
-            CommandArgs cmdArgs(cmd);
-            if (cmdArgs.getArgCount() < 1)
-            {
-                printF("%s is: \"%s\"  |  default: \"%s\"\n",
-                       cvar->getNameCString(),
-                       cvar->getStringValue().c_str(),
-                       cvar->getDefaultValueString().c_str());
-            }
-            else
-            {
-                if (cmdArgs.getArgCount() > 1)
-                {
-                    setTextColor(color::yellow());
-                    printLn("CVar update takes one argument. Ignoring extraneous ones...");
-                    restoreTextColor();
-                }
-                if (!cvar->setStringValue(cmdArgs[0]))
-                {
-                    setTextColor(color::yellow());
-                    printF("Cannot set %s to \"%s\"!\n", cmdName, cmdArgs[0]);
-                    restoreTextColor();
-                }
-            }
-            return;
+            return true;
         }
     }
+    return false;
+}
 
-    //
-    // Check the built-in commands second:
-    //
-    if (const BuiltInCmd * const builtIn = getBuiltInCommand(cmdName))
-    {
-        builtIn->handler(*this);
-        return;
-    }
+void CVarManagerImpl::markSnapshotDirty(CVarImplBase * const cvar)
+{
+    snapshotDirty = true;
 
-    //
-    // Try the user-defined commands last:
-    //
-    if ((cmdManager != nullptr) && cmdManager->findCommand(cmdName))
+    // Only tracked while snapshots are enabled. The first version encodes all the vars.
+    if (snapshotsEnabled && !cvar->snapshotDirty)
     {
-        cmdManager->execute(cmdExecMode, firstNonWhite);
-        return;
+        cvar->snapshotDirty = true;
+        snapshotDirtyVars.push_back(cvar);
     }
-
-    printF("%s: Command not found.\n", cmdName);
 }
 
-void SimpleCommandTerminal::addCmdToHistory(const char * cmd)
+void CVarManagerImpl::forgetSnapshotVar(CVarImplBase * const cvar)
 {
-    if (indexCmdHistory < CmdHistoryMaxSize) // Insert at front:
+    snapshotDirty = true;
+
+    if (cvar->snapshotDirty)
     {
-        cmdHistory[indexCmdHistory++] = cmd;
+        snapshotDirtyVars.erase(std::find(snapshotDirtyVars.begin(), snapshotDirtyVars.end(), cvar));
+        cvar->snapshotDirty = false;
     }
-    else // Full, remove oldest:
-    {
-        CFG_ASSERT(indexCmdHistory == CmdHistoryMaxSize);
 
-        // Pop tail and shift everyone:
-        for (int i = 0; i < indexCmdHistory - 1; ++i)
+    // The entry of the current version is left out of the next one.
+    // The var is already unlinked here, so its hash key is gone.
+    const CVarSnapshotImpl * const current = currentSnapshot.load(std::memory_order_relaxed);
+    if (current != nullptr && !snapshotRebuildAll)
+    {
+        if (const CVarSnapshotEntry * entry = current->findEntry(cvar->getNameCString()))
         {
-            cmdHistory[i] = cmdHistory[i + 1];
+            snapshotDroppedVars.push_back(static_cast<int>(entry - current->entries));
         }
-
-        // Insert new at front:
-        cmdHistory[indexCmdHistory - 1] = cmd;
     }
+}
 
-    currCmdInHistory = indexCmdHistory - 1;
+void CVarManagerImpl::clearSnapshotDirtyVars()
+{
+    for (CVarImplBase * cvar : snapshotDirtyVars)
+    {
+        cvar->snapshotDirty = false;
+    }
+    snapshotDirtyVars.clear();
+    snapshotDroppedVars.clear();
 }
 
-bool SimpleCommandTerminal::nextCmdFromHistory()
+void CVarManagerImpl::encodeSnapshotEntry(const CVarImplBase * const cvar, CVarSnapshotEntry * const outEntry)
 {
-    CFG_ASSERT(currCmdInHistory >= 0 && currCmdInHistory < lengthOfArray(cmdHistory));
-    const char * cmd = cmdHistory[currCmdInHistory].c_str();
+    const CVarValueChars valueChars{ *cvar };
+    const char * const name = cvar->getNameCString();
 
-    if (currCmdInHistory > 0)
+    CVarSnapshotEntry & entry = (*outEntry);
+    entry.nameHash   = cvar->getHashKey();
+    entry.nameOffset = static_cast<std::uint32_t>(snapshotChars.size());
+    snapshotChars.insert(snapshotChars.end(), name, name + lengthOfString(name) + 1);
+    entry.valueOffset = static_cast<std::uint32_t>(snapshotChars.size());
+    snapshotChars.insert(snapshotChars.end(), valueChars.c_str(), valueChars.c_str() + valueChars.size() + 1);
+
+    if (cvar->getType() == CVar::Type::String)
     {
-        --currCmdInHistory;
-        if (std::strcmp(cmd, lineBuffer) == 0 && currCmdInHistory >= 0)
+        // The CVar getters log an error for strings that are not numbers,
+        // which is not wanted here. Bool strings are also accepted.
+        if (parseInt64(valueChars.c_str(), valueChars.size(), &entry.intValue) == 0)
         {
-            cmd = cmdHistory[currCmdInHistory].c_str();
+            entry.intValue = 0;
+        }
+        if (parseDouble(valueChars.c_str(), valueChars.size(), &entry.floatValue) == 0)
+        {
+            entry.floatValue = 0.0;
+        }
+        entry.boolValue = (entry.intValue != 0);
+        for (const BoolCStr * bStrings = getBoolStrings(); bStrings->trueStr != nullptr; ++bStrings)
+        {
+            if (cvarCmpStrings(bStrings->trueStr, valueChars.c_str()) == 0)
+            {
+                entry.boolValue = true;
+                break;
+            }
         }
     }
-
-    setLineBuffer(cmd);
-    return true;
+    else
+    {
+        entry.boolValue  = cvar->getBoolValue();
+        entry.intValue   = cvar->getIntValue();
+        entry.floatValue = cvar->getFloatValue();
+    }
 }
 
-bool SimpleCommandTerminal::prevCmdFromHistory()
+CVarSnapshotImpl * CVarManagerImpl::buildCVarSnapshot()
 {
-    const char * cmd;
-    if (currCmdInHistory < (indexCmdHistory - 1))
+    // Updated from the current version if it doesn't have too much garbage already.
+    const CVarSnapshotImpl * const base = currentSnapshot.load(std::memory_order_relaxed);
+    const bool updateBase = (base != nullptr && !snapshotRebuildAll && base->garbageChars <= base->charCount / 2);
+
+    snapshotEntries.clear();
+    snapshotChars.clear();
+    std::uint32_t garbageChars = 0;
+
+    if (updateBase)
     {
-        ++currCmdInHistory;
-        CFG_ASSERT(currCmdInHistory >= 0 && currCmdInHistory < lengthOfArray(cmdHistory));
-        cmd = cmdHistory[currCmdInHistory].c_str();
+        // The unchanged entries are copied as they are, so their strings keep their offsets.
+        snapshotChars.assign(base->chars, base->chars + base->charCount);
+        garbageChars = base->garbageChars;
 
-        // Need this check if going up and down on the same two commands.
-        if (std::strcmp(cmd, lineBuffer) == 0 && currCmdInHistory < indexCmdHistory)
+        // Only the new and changed vars are encoded again.
+        for (const CVarImplBase * cvar : snapshotDirtyVars)
         {
-            ++currCmdInHistory;
-            cmd = cmdHistory[currCmdInHistory].c_str();
+            if (const CVarSnapshotEntry * oldEntry = base->findEntry(cvar->getNameCString(), cvar->getHashKey()))
+            {
+                snapshotDroppedVars.push_back(static_cast<int>(oldEntry - base->entries));
+            }
+            snapshotEntries.emplace_back();
+            encodeSnapshotEntry(cvar, &snapshotEntries.back());
+        }
+
+        // A var can be removed and registered again, so its old entry could be in the list twice.
+        std::sort(snapshotDroppedVars.begin(), snapshotDroppedVars.end());
+        snapshotDroppedVars.erase(std::unique(snapshotDroppedVars.begin(), snapshotDroppedVars.end()), snapshotDroppedVars.end());
+        for (const int dropped : snapshotDroppedVars)
+        {
+            const char * const name  = base->chars + base->entries[dropped].nameOffset;
+            const char * const value = base->chars + base->entries[dropped].valueOffset;
+            garbageChars += static_cast<std::uint32_t>(lengthOfString(name) + lengthOfString(value) + 2);
         }
     }
     else
     {
-        cmd = "";
+        snapshotDroppedVars.clear();
+        for (auto cvar = registeredCVars.getFirst(); cvar; cvar = cvar->getNext())
+        {
+            snapshotEntries.emplace_back();
+            encodeSnapshotEntry(cvar, &snapshotEntries.back());
+        }
     }
 
-    setLineBuffer(cmd);
-    return true;
-}
+    std::sort(snapshotEntries.begin(), snapshotEntries.end(),
+              [](const CVarSnapshotEntry & a, const CVarSnapshotEntry & b) { return a.nameHash < b.nameHash; });
 
-bool SimpleCommandTerminal::navigateTextLeft()
-{
-    if (lineBufferInsertionPos <= 0)
+    const int baseCount  = (updateBase ? base->entryCount : 0);
+    const int newCount   = static_cast<int>(snapshotEntries.size());
+    const int entryCount = baseCount - static_cast<int>(snapshotDroppedVars.size()) + newCount;
+
+    static_assert(sizeof(CVarSnapshotImpl) % alignof(CVarSnapshotEntry) == 0, "Misaligned snapshot entries!");
+    const std::size_t entryBytes = entryCount * sizeof(CVarSnapshotEntry);
+    auto block = memAlloc<std::uint8_t>(sizeof(CVarSnapshotImpl) + entryBytes + snapshotChars.size() + 1, MemoryCategory::CVars);
+
+    auto entries = reinterpret_cast<CVarSnapshotEntry *>(block + sizeof(CVarSnapshotImpl));
+    auto chars   = reinterpret_cast<char *>(block + sizeof(CVarSnapshotImpl) + entryBytes);
+
+    // Merge of the kept base entries and the new ones, both sorted by hash.
+    CVarSnapshotEntry * outEntry = entries;
+    int b = 0, n = 0;
+    std::size_t d = 0;
+    while (b < baseCount || n < newCount)
     {
-        return true; // Return whether the input was handled or not.
-                     // In this case, always true.
+        if (b < baseCount && d < snapshotDroppedVars.size() && snapshotDroppedVars[d] == b)
+        {
+            ++b;
+            ++d;
+        }
+        else if (n == newCount || (b < baseCount && base->entries[b].nameHash <= snapshotEntries[n].nameHash))
+        {
+            *outEntry++ = base->entries[b++];
+        }
+        else
+        {
+            *outEntry++ = snapshotEntries[n++];
+        }
     }
+    CFG_ASSERT(outEntry == entries + entryCount);
 
-    lineBufferInsertionPos--;
-    redrawInputLine();
-    return true;
-}
-
-bool SimpleCommandTerminal::navigateTextRight()
-{
-    if (lineBufferInsertionPos >= lineBufferUsed)
+    if (!snapshotChars.empty())
     {
-        return true; // Same as above.
+        std::memcpy(chars, snapshotChars.data(), snapshotChars.size());
     }
+    chars[snapshotChars.size()] = '\0';
 
-    lineBufferInsertionPos++;
-    redrawInputLine();
-    return true;
+    clearSnapshotDirtyVars();
+    snapshotRebuildAll = false;
+
+    auto snapshot = reinterpret_cast<CVarSnapshotImpl *>(block);
+    return construct(snapshot, ++snapshotVersion, entries, entryCount, chars,
+                     static_cast<std::uint32_t>(snapshotChars.size()), garbageChars);
 }
 
-void SimpleCommandTerminal::redrawInputLine()
+void CVarManagerImpl::retireCurrentCVarSnapshot(CVarSnapshotImpl * newSnapshot)
 {
-    // Workaround to position the cursor without
-    // a gotoxy()-like function: redraw the whole line.
-    printF("\r%s%.*s", newlineMarkerStr.c_str(), lineBufferInsertionPos, lineBuffer);
+    CVarSnapshotImpl * oldSnapshot = currentSnapshot.exchange(newSnapshot);
+    if (oldSnapshot != nullptr)
+    {
+        retiredSnapshots.push_back(oldSnapshot);
+    }
 }
 
-bool SimpleCommandTerminal::handleCtrlKey(const char chr)
+void CVarManagerImpl::reclaimCVarSnapshots()
 {
-    switch (chr)
-    {
-    // Copy input line to clipboard: PC=CTRL+c, Mac=CMD+c
-    case 'c' :
-        onSetClipboardString(lineBuffer);
-        return true;
-
-    // Paste from clipboard: PC=CTRL+v, Mac=CMD+v
-    case 'v' :
-        for (const char * str = onGetClipboardString();
-             str != nullptr && *str != '\0'; ++str)
-        {
-            // Using this loop to allow inserting at the current cursor pos.
-            insertChar(*str);
-        }
-        return true;
-
-    // [CTRL] + l clears the screen
-    case 'l' :
-        clear();
-        return true;
-
-    // Unix-style command history: [CTRL] + n = previous command
-    case 'n' :
-        return prevCmdFromHistory();
+    //
+    // A reader that loaded one of the retired versions in acquireCVarSnapshot()
+    // either still has it in a hazard slot, or has already taken its reference
+    // before clearing the slot, so the slots are checked before the count.
+    // New readers only get the current version.
+    //
+    auto firstHeld = std::remove_if(retiredSnapshots.begin(), retiredSnapshots.end(),
+            [this](CVarSnapshotImpl * snapshot)
+            {
+                if (isSnapshotHazard(snapshot) || snapshot->refCount.load(std::memory_order_acquire) != 0)
+                {
+                    return false;
+                }
+                destroy(snapshot);
+                memFree(snapshot);
+                return true;
+            });
+    retiredSnapshots.erase(firstHeld, retiredSnapshots.end());
+}
 
-    // Unix-style command history: [CTRL] + p = next command
-    case 'p' :
-        return nextCmdFromHistory();
+bool CVarManagerImpl::internalSetStringValue(CVar * cvar, std::string value)
+{
+    CFG_ASSERT(cvar != nullptr);
 
-    default :
-        return false;
-    } // switch (chr)
+    if (!cvar->isWritable() && (allowWritingRomCVars || allowWritingInitCVars))
+    {
+        return static_cast<CVarImplBase *>(cvar)->setStringValueIgnoreRO(std::move(value),
+                                             allowWritingRomCVars, allowWritingInitCVars);
+    }
+    else
+    {
+        return cvar->setStringValue(std::move(value));
+    }
 }
 
-bool SimpleCommandTerminal::hasFullNameInLineBuffer() const
+bool CVarManagerImpl::internalSetDefaultValue(CVar * cvar)
 {
-    bool foundNonWhiteChar = false;
-    for (int i = 0; i < lineBufferUsed; ++i)
+    CFG_ASSERT(cvar != nullptr);
+
+    if (!cvar->isWritable() && (allowWritingRomCVars || allowWritingInitCVars))
     {
-        if (lineBuffer[i] != ' ')
-        {
-            foundNonWhiteChar = true;
-        }
-        else
-        {
-            if (!foundNonWhiteChar)
-            {
-                continue;
-            }
-            return true;
-        }
+        return static_cast<CVarImplBase *>(cvar)->setDefaultValueIgnoreRO(
+                             allowWritingRomCVars, allowWritingInitCVars);
+    }
+    else
+    {
+        return cvar->setDefaultValue();
     }
-    return false;
 }
 
-void SimpleCommandTerminal::listAllCommands()
+bool CVarManagerImpl::internalSetRawValue(CVar * cvar, const CVarRawValue & value)
 {
-    if (cmdManager == nullptr)
+    CFG_ASSERT(cvar != nullptr);
+
+    // Follows internalSetStringValue(): Writable vars get the modified flag, the others don't.
+    if (!static_cast<CVarImplBase *>(cvar)->setRawValueIgnoreRO(value, allowWritingRomCVars, allowWritingInitCVars))
     {
-        return;
+        return false;
     }
-
-    if (!listAllCmdsOnTab)
+    if (cvar->isWritable())
     {
-        printF("\rPress [%s] again to list commands...\n",
-               SpecialKeys::toString(SpecialKeys::Tab).c_str());
-        listAllCmdsOnTab = true;
-        return;
+        cvar->setModified();
     }
+    return true;
+}
 
-    //
-    // List all available commands (or up to MaxCompletionMatches):
-    //
+void CVarManagerImpl::setAllowWritingReadOnlyVars(const bool allow) noexcept
+{
+    allowWritingRomCVars  = allow;
+    allowWritingInitCVars = allow;
+    // When ReadOnly CVars are set to writable, InitOnly vars
+    // inherit the setting. The opposite is not true.
+}
 
-    struct CmdList
-    {
-        int count = 0;
-        const Command * cmds[MaxCompletionMatches]{};
-    };
-    CmdList cmdList{};
+void CVarManagerImpl::setAllowWritingInitOnlyVars(const bool allow) noexcept
+{
+    allowWritingInitCVars = allow;
+}
 
-    cmdManager->enumerateAllCommands(
-            [](Command * cmd, void * userContext)
-            {
-                auto list = static_cast<CmdList *>(userContext);
-                if (list->count == SimpleCommandTerminal::MaxCompletionMatches)
-                {
-                    return false; // Stop the enumeration.
-                }
-                list->cmds[list->count++] = cmd;
-                return true;
-            },
-            &cmdList);
+// ========================================================
+// Binary config snapshots:
+// ========================================================
 
-    std::sort(cmdList.cmds, cmdList.cmds + cmdList.count,
-              [](const Command * const a, const Command * const b)
-              {
-                  return cmdCmpNames(a->getNameCString(), b->getNameCString()) < 0;
-              });
+//
+// File layout. Everything is in native byte order; a snapshot
+// from a machine with different endianness fails the magic check.
+//
+//   ConfigSnapshotHeader
+//   CVar records (cvarCount):
+//     u32 nameHash, u8 type, u8 recordFlags
+//     [u32 cvarFlags]           if SnapshotUserDefined
+//     [u16 nameLength + chars]  if SnapshotHasName
+//     i64 | f64 | u32 length + chars (the value)
+//   Alias records (aliasCount):
+//     u8 execMode, then name, target command and description
+//     strings, each as u32 length + chars
+//
+struct ConfigSnapshotHeader final
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t cvarCount;
+    std::uint32_t aliasCount;
+    std::uint32_t schemaChecksum;
+};
 
-    int cmdsWrittenInALine = 0;
-    const int builtInCount = getBuiltInCommandsCount();
+constexpr std::uint32_t ConfigSnapshotMagic   = 0x53474643; // "CFGS"
+constexpr std::uint32_t ConfigSnapshotVersion = 1;
 
-    // List the build-ins first in alternate color:
-    setTextColor(color::cyan());
-    for (int c = 0; c < builtInCount; ++c)
+constexpr std::uint8_t SnapshotHasName     = 1 << 0; // Name follows the hash. Needed for user vars and hash collisions.
+constexpr std::uint8_t SnapshotUserDefined = 1 << 1; // Var is created on load if it doesn't exist.
+
+template<typename T>
+static inline void snapshotPut(std::string * out, const T & value)
+{
+    out->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+static inline bool snapshotGet(const char ** inOutData, const char * const dataEnd, T * outValue)
+{
+    if (static_cast<std::size_t>(dataEnd - *inOutData) < sizeof(T))
     {
-        const BuiltInCmd * const cmd = getBuiltInCommand(c);
-        printF("%-*s", MaxCommandNameLength, cmd->name);
+        return false;
+    }
+    std::memcpy(outValue, *inOutData, sizeof(T));
+    (*inOutData) += sizeof(T);
+    return true;
+}
 
-        if (++cmdsWrittenInALine >= MaxCmdMatchesPerLine && c != (builtInCount - 1))
+// Vars defined in the C++ code. They must all be present in a snapshot.
+static inline bool isSnapshotSchemaVar(const CVar * const cvar)
+{
+    return cvar->isPersistent() && !(cvar->getFlags() & CVar::Flags::UserDefined);
+}
+
+std::uint32_t CVarManagerImpl::getSnapshotSchemaChecksum() const
+{
+    // A sum of the mixed name hash and type of each var, so
+    // the result doesn't depend on the registration order.
+    std::uint32_t checksum = 0;
+    std::uint32_t count    = 0;
+
+    for (auto var = registeredCVars.getFirst(); var != nullptr; var = var->getNext())
+    {
+        if (isSnapshotSchemaVar(var))
         {
-            cmdsWrittenInALine = 0;
-            print("\n");
+            std::uint32_t h = CVarNameHasher{}(var->getNameCString());
+            h ^= (static_cast<std::uint32_t>(var->getType()) + 1) * 0x9E3779B9u;
+            h *= 0x85EBCA6Bu;
+            h ^= (h >> 13);
+            checksum += h;
+            ++count;
         }
     }
+    return checksum ^ (count * 0xC2B2AE35u);
+}
 
-    // Now the rest in normal color:
-    restoreTextColor();
-    for (int c = 0; c < cmdList.count; ++c)
+std::uint32_t CVarManagerImpl::writeSnapshotCVars(std::string * outData) const
+{
+    // Hashes shared by more than one var need the full name to be told apart.
+    std::vector<std::uint32_t> hashes;
+    std::vector<std::uint32_t> collisions;
+    for (auto var = registeredCVars.getFirst(); var != nullptr; var = var->getNext())
     {
-        const Command * const cmd = cmdList.cmds[c];
-        printF("%-*s", MaxCommandNameLength, cmd->getNameCString());
-
-        if (++cmdsWrittenInALine >= MaxCmdMatchesPerLine && c != (cmdList.count - 1))
+        if (isSnapshotSchemaVar(var))
         {
-            cmdsWrittenInALine = 0;
-            print("\n");
+            hashes.push_back(CVarNameHasher{}(var->getNameCString()));
         }
     }
-
-    const int totalCmds = cmdManager->getRegisteredCommandsCount();
-    if (cmdList.count < totalCmds)
+    std::sort(hashes.begin(), hashes.end());
+    for (std::size_t i = 1; i < hashes.size(); ++i)
     {
-        setTextColor(color::cyan());
-        printF("\n+%i commands...", (totalCmds - cmdList.count));
-        restoreTextColor();
+        if (hashes[i] == hashes[i - 1])
+        {
+            collisions.push_back(hashes[i]);
+        }
     }
 
-    newLineWithMarker();
-    listAllCmdsOnTab = false;
-}
-
-void SimpleCommandTerminal::listMatches(const char * const partialStr, const char ** matches, const int matchesFound,
-                                        const int maxMatches, const int maxPerLine, const int spacing, const bool coloredMatch)
-{
-    int writtenInALine   = 0;
-    const int partialLen = lengthOfString(partialStr);
-
-    for (int i = 0; i < matchesFound; ++i)
+    std::uint32_t count = 0;
+    for (auto var = registeredCVars.getFirst(); var != nullptr; var = var->getNext())
     {
-        if (i != maxMatches)
+        if (!var->isPersistent())
         {
-            CFG_ASSERT(matches[i] != nullptr);
+            continue;
+        }
 
-            if (coloredMatch)
-            {
-                setTextColor(color::cyan());
-                printF("%.*s", partialLen, matches[i]);
-                restoreTextColor();
-            }
-            else
-            {
-                printF("%.*s", partialLen, matches[i]);
-            }
+        const std::uint32_t nameHash = CVarNameHasher{}(var->getNameCString());
+        const bool userDefined = !!(var->getFlags() & CVar::Flags::UserDefined);
+        const bool hasName     = userDefined || std::binary_search(collisions.begin(), collisions.end(), nameHash);
 
-            if (maxPerLine > 1)
-            {
-                printF("%-*s", spacing - partialLen, matches[i] + partialLen); // A bunch per line, column align.
-            }
-            else
-            {
-                printF("%s", matches[i] + partialLen); // One per line.
-            }
+        std::uint8_t recordFlags = 0;
+        if (hasName)     { recordFlags |= SnapshotHasName;     }
+        if (userDefined) { recordFlags |= SnapshotUserDefined; }
+
+        snapshotPut(outData, nameHash);
+        snapshotPut(outData, static_cast<std::uint8_t>(var->getType()));
+        snapshotPut(outData, recordFlags);
+
+        if (userDefined)
+        {
+            // Modified is cleared by saveConfig, so it isn't saved.
+            snapshotPut(outData, static_cast<std::uint32_t>(var->getFlags() & ~CVar::Flags::Modified));
         }
-        else
+        if (hasName)
         {
-            setTextColor(color::cyan());
-            printF("+%i matches...", (matchesFound - maxMatches));
-            restoreTextColor();
-            break;
+            const char * const varName = var->getNameCString();
+            snapshotPut(outData, static_cast<std::uint16_t>(lengthOfString(varName)));
+            outData->append(varName);
         }
 
-        if (++writtenInALine >= maxPerLine)
+        switch (var->getType())
         {
-            if ((matchesFound - i) > 1)
+        case CVar::Type::Float :
+            snapshotPut(outData, var->getFloatValue());
+            break;
+        case CVar::Type::String :
             {
-                print("\n");
+                const char * value = nullptr;
+                int valueLength    = 0;
+                var->getStringValueView(&value, &valueLength);
+                snapshotPut(outData, static_cast<std::uint32_t>(valueLength));
+                outData->append(value, valueLength);
+                break;
             }
-            writtenInALine = 0;
-        }
+        default : // Int, Bool & Enum
+            snapshotPut(outData, var->getIntValue());
+            break;
+        } // switch (var->getType())
+
+        ++count;
     }
+    return count;
 }
 
-bool SimpleCommandTerminal::displayCompletionMatches(const char * const partialString, const int maxPerLine,
-                                                     const bool whitespaceAfter1Match, const bool allowCyclingValues,
-                                                     const FindMatchesCallback & findMatchesCb)
+bool CVarManagerImpl::readSnapshotCVars(const char ** inOutData, const char * const dataEnd, const std::uint32_t count)
 {
-    if (firstAutoCompletionTry) // Fist [TAB], list possible matches and save them for subsequent cycling:
+    // Lookup by name hash. The schema checksum was already validated,
+    // so every record hash matches one of these sans the collisions.
+    using HashedVar = std::pair<std::uint32_t, CVarImplBase *>;
+    std::vector<HashedVar> schemaVars;
+    for (auto var = registeredCVars.getFirst(); var != nullptr; var = var->getNext())
     {
-        int matchesFound = 0;
-        findMatchesCb(*this, partialString, completionMatches, &matchesFound, MaxCompletionMatches);
-
-        if (matchesFound <= 0)
+        if (isSnapshotSchemaVar(var))
         {
-            return false; // No matches for auto-completion.
+            schemaVars.emplace_back(CVarNameHasher{}(var->getNameCString()), var);
         }
+    }
+    std::sort(schemaVars.begin(), schemaVars.end(),
+              [](const HashedVar & a, const HashedVar & b)
+              {
+                  return a.first < b.first;
+              });
 
-        if (matchesFound == 1) // Exactly one:
-        {
-            const int partialLen    = lengthOfString(partialString);
-            const char * completion = completionMatches[0] + partialLen;
+    const char * data = *inOutData;
+    std::string  varName;
+    bool         allSet = true;
 
-            lineBufferUsed += copyString(lineBuffer + lineBufferUsed, lengthOfArray(lineBuffer) - lineBufferUsed, completion);
+    // Nothing else is read past a truncated record.
+    *inOutData = dataEnd;
 
-            if (whitespaceAfter1Match)
+    for (std::uint32_t r = 0; r < count; ++r)
+    {
+        std::uint32_t nameHash    = 0;
+        std::uint8_t  typeTag     = 0;
+        std::uint8_t  recordFlags = 0;
+        std::uint32_t varFlags    = 0;
+        std::uint16_t nameLength  = 0;
+
+        if (!snapshotGet(&data, dataEnd, &nameHash) ||
+            !snapshotGet(&data, dataEnd, &typeTag)  ||
+            !snapshotGet(&data, dataEnd, &recordFlags))
+        {
+            return errorF("Config snapshot is truncated!");
+        }
+        if ((recordFlags & SnapshotUserDefined) && !snapshotGet(&data, dataEnd, &varFlags))
+        {
+            return errorF("Config snapshot is truncated!");
+        }
+        if (recordFlags & SnapshotHasName)
+        {
+            if (!snapshotGet(&data, dataEnd, &nameLength) ||
+                static_cast<std::size_t>(dataEnd - data) < nameLength)
             {
-                lineBuffer[lineBufferUsed++] = ' ';
-                lineBuffer[lineBufferUsed]   = '\0';
-                printF("%s ", completion);
+                return errorF("Config snapshot is truncated!");
             }
-            else
+            varName.assign(data, nameLength);
+            data += nameLength;
+        }
+
+        CVarRawValue value{};
+        value.type = static_cast<CVar::Type>(typeTag);
+        switch (value.type)
+        {
+        case CVar::Type::Float :
+            if (!snapshotGet(&data, dataEnd, &value.floatValue))
             {
-                printF("%s", completion);
+                return errorF("Config snapshot is truncated!");
+            }
+            break;
+        case CVar::Type::String :
+            if (!snapshotGet(&data, dataEnd, &value.stringLength) ||
+                static_cast<std::size_t>(dataEnd - data) < value.stringLength)
+            {
+                return errorF("Config snapshot is truncated!");
+            }
+            value.stringData = data;
+            data += value.stringLength;
+            break;
+        case CVar::Type::Int  :
+        case CVar::Type::Bool :
+        case CVar::Type::Enum :
+            if (!snapshotGet(&data, dataEnd, &value.intValue))
+            {
+                return errorF("Config snapshot is truncated!");
             }
+            break;
+        default :
+            return errorF("Bad CVar type tag in config snapshot!");
+        } // switch (value.type)
 
-            lineBufferInsertionPos = lineBufferUsed;
+        CVar * cvar = nullptr;
+        if (recordFlags & SnapshotHasName)
+        {
+            cvar = findCVar(varName.c_str());
         }
-        else // There is more than one match, print a list:
+        else
         {
-            const int maxMatches = MaxCompletionMatches;
-
-            newLineNoMarker();
-            listMatches(partialString, completionMatches, matchesFound, maxMatches,
-                        maxPerLine, MaxCommandNameLength, allowCyclingValues);
-            newLineWithMarker();
-            print(lineBuffer);
-
-            if (allowCyclingValues)
+            const auto iter = std::lower_bound(schemaVars.begin(), schemaVars.end(), nameHash,
+                                               [](const HashedVar & a, const std::uint32_t h)
+                                               {
+                                                   return a.first < h;
+                                               });
+            if (iter != schemaVars.end() && iter->first == nameHash)
             {
-                // Save for [TAB] cycling:
-                firstAutoCompletionTry = false;
-                completionMatchCount   = std::min(matchesFound, maxMatches);
-                partialStrLength       = lengthOfString(partialString);
-                oldLineBufferUsed      = lineBufferUsed;
+                cvar = iter->second;
             }
         }
 
-        return true;
-    }
-    else // Cycling a list of possible matches after the first [TAB]:
-    {
-        const int partialLen  = std::min(partialStrLength, LineBufferMaxSize - 1);
-        const char * matchStr = completionMatches[nextDisplayedCompletionMatch];
+        if (cvar == nullptr)
+        {
+            if (!(recordFlags & SnapshotUserDefined))
+            {
+                allSet = errorF("CVar with name hash 0x%08X from config snapshot not found!", nameHash);
+                continue;
+            }
 
-        clearVisibleEditLine();
-        if ((oldLineBufferUsed - partialLen) > 0)
+            // Create the user var, same as a 'set' with flags would.
+            switch (value.type)
+            {
+            case CVar::Type::Int :
+                setCVarValueInt(varName.c_str(), value.intValue, varFlags);
+                break;
+            case CVar::Type::Bool :
+                setCVarValueBool(varName.c_str(), !!value.intValue, varFlags);
+                break;
+            case CVar::Type::Float :
+                setCVarValueFloat(varName.c_str(), value.floatValue, varFlags);
+                break;
+            case CVar::Type::String :
+                setCVarValueString(varName.c_str(), std::string(value.stringData, value.stringLength), varFlags);
+                break;
+            default :
+                allSet = errorF("Can't create enum CVar '%s' from config snapshot!", varName.c_str());
+                break;
+            } // switch (value.type)
+            continue;
+        }
+
+        if (cvar->getType() != value.type)
         {
-            printF("%.*s", oldLineBufferUsed - partialLen, lineBuffer);
+            allSet = errorF("CVar '%s' type doesn't match the config snapshot!", cvar->getNameCString());
+            continue;
+        }
+        if (!internalSetRawValue(cvar, value))
+        {
+            allSet = false;
         }
+    }
 
-        // Partial name in normal color:
-        printF("%.*s", partialLen, matchStr);
+    *inOutData = data;
+    return allSet;
+}
 
-        // Auto-completed guess in alternate color:
-        setTextColor(color::cyan());
-        print(matchStr + partialLen);
-        restoreTextColor();
+// ========================================================
+// Virtual destructors anchored to this file:
+// ========================================================
 
-        lineBufferUsed  = oldLineBufferUsed;
-        lineBufferUsed += copyString(lineBuffer + lineBufferUsed, lengthOfArray(lineBuffer) - lineBufferUsed, matchStr + partialLen);
-        lineBufferInsertionPos = lineBufferUsed;
+CVar::~CVar()
+{ }
 
-        // Cycle in case the user hits TAB again.
-        nextDisplayedCompletionMatch = (nextDisplayedCompletionMatch + 1) % completionMatchCount;
-        return true;
+CVarImplBase::~CVarImplBase()
+{
+    // Null any references still pointing to us.
+    while (refListHead != nullptr)
+    {
+        unlinkRef(refListHead);
     }
 }
 
-// warning C4706: assignment within conditional expression
-// Granted, to logic in the following function is a bit dodgy,
-// should review that in the future...
-#ifdef _MSC_VER
-    #pragma warning(push)
-    #pragma warning(disable: 4706)
-#endif // _MSC_VER
+bool CVarImplBase::hasChangeListeners() const noexcept
+{
+    return changeListenerCount > 0 || (owner != nullptr && owner->hasGlobalChangeListeners());
+}
 
-bool SimpleCommandTerminal::tabCompletion()
+void CVarImplBase::notifyValueChanged()
 {
-    if (lineBufferInsertionPos != lineBufferUsed)
+    if (owner != nullptr)
     {
-        // Auto-completion not attempted if the cursor is not at the end of input line.
-        return true;
+        owner->onCVarValueChanged(this);
     }
+}
 
-    if (isLineBufferEmpty())
+void CVarImplBase::addToFlagIndex()
+{
+    // Not indexed until linked to the manager, which indexes the initial flags.
+    if (owner != nullptr)
     {
-        listAllCommands(); // Only after 2 consecutive TABs.
-        return true;
+        owner->cvarFlagIndex.update(this);
     }
+}
 
-    // A Command or CVar name is already completed, now we'll do argument auto-completion:
-    if (hasFullNameInLineBuffer())
-    {
-        // Check for "$(var)" CVar substitution/expansion and try to complete the var name:
-        if (const char * cvarExpansionPtr = std::strrchr(lineBuffer, '$'))
-        {
-            if (cvarManager != nullptr && *(++cvarExpansionPtr) == '(')
-            {
-                if (!std::strrchr(++cvarExpansionPtr, ')')) // If the "$(..." not closed yet, try completing:
-                {
-                    auto findMatchesCallback = [](SimpleCommandTerminal & term, const char * const partialName,
-                                                  const char ** outMatches, int * outMatchesFound, const int maxMatches)
-                    {
-                        auto cvarMgr = term.getCVarManager();
-                        *outMatchesFound = cvarMgr->findCVarsWithPartialName(partialName, outMatches, maxMatches);
-                    };
-
-                    const char * const partialCVarName = cvarExpansionPtr;
-                    displayCompletionMatches(partialCVarName, MaxCVarMatchesPerLine, false, true, findMatchesCallback);
-                    return true;
-                }
-            }
-        }
-
-        // Command argument or CVar value auto-completion:
-        char cmdName[LineBufferMaxSize];
-        const char * cmdPtr = lineBuffer;
+CVarManager::~CVarManager()
+{ }
 
-        // Skip leading whitespace:
-        for (; *cmdPtr != '\0' && isWhitespace(*cmdPtr); ++cmdPtr) { }
+CVarSnapshot::~CVarSnapshot()
+{ }
 
-        // Copy until the first whitespace to get the command name:
-        char * p = cmdName;
-        for (; *cmdPtr != '\0' && !isWhitespace(*cmdPtr); ++p, ++cmdPtr)
-        {
-            *p = *cmdPtr;
-        }
-        *p = '\0';
+// ========================================================
+// CVarSnapshotRef implementation:
+// ========================================================
 
-        int  argCount = 0;
-        bool quotes   = false;
-        bool gotWhite = false;
+void CVarSnapshotRef::reset()
+{
+    if (snapshot != nullptr)
+    {
+        snapshot->release();
+        snapshot = nullptr;
+    }
+}
 
-        // Last partial argument is the completion target.
-        // Quoted strings keep whitespace.
-        const char * lastWsPtr = cmdPtr;
-        for (; *cmdPtr != '\0'; ++cmdPtr)
-        {
-            if (!quotes && isWhitespace(*cmdPtr))
-            {
-                lastWsPtr = cmdPtr; // Save the last whitespace.
-                gotWhite  = true;
-            }
-            else if (*cmdPtr == '"' || *cmdPtr == '\'')
-            {
-                quotes = !quotes;
-            }
-            else // Not whitespace, not quotes:
-            {
-                if (gotWhite)
-                {
-                    gotWhite = false;
-                    ++argCount;
-                }
-            }
-        }
+// ========================================================
+// CVarRef implementation:
+// ========================================================
 
-        // Get to the start of the partial argument:
-        for (; *lastWsPtr != '\0' && isWhitespace(*lastWsPtr); ++lastWsPtr) { }
-        const char * const partialArgStr = lastWsPtr;
+CVarRefBase::~CVarRefBase()
+{
+    reset();
+}
 
-        //
-        // See if we are completing the value of a CVar or arguments of a command:
-        //
-        const CVar    * cvar = nullptr;
-        const Command * cmd  = nullptr;
+void CVarRefBase::reset()
+{
+    if (cvar != nullptr)
+    {
+        static_cast<CVarImplBase *>(cvar)->unlinkRef(this);
+    }
+}
 
-        if ((cvarManager != nullptr) && (cvar = cvarManager->findCVar(cmdName)))
-        {
-            std::string * varValueStrings = argStringMatches;
-            auto findMatchesCallback = [cvar, varValueStrings](SimpleCommandTerminal &, const char * const partialArg,
-                                                               const char ** outMatches, int * outMatchesFound, const int maxMatches)
-            {
-                CFG_ASSERT(maxMatches <= MaxCompletionMatches);
-                const int matchesFound = cvar->valueCompletion(partialArg, varValueStrings, maxMatches);
+void CVarRefBase::bind(CVar * const target, const CVar::Type typeTag, const CVar::Type altTypeTag)
+{
+    reset();
+    if (target == nullptr)
+    {
+        return;
+    }
 
-                const int count = std::min(matchesFound, maxMatches);
-                for (int m = 0; m < count; ++m)
-                {
-                    outMatches[m] = varValueStrings[m].c_str();
-                }
-                *outMatchesFound = matchesFound;
-            };
+    const CVar::Type varType = target->getType();
+    if (varType != typeTag && varType != altTypeTag)
+    {
+        errorF("Can't bind CVarRef to CVar '%s': type mismatch (%s).",
+               target->getNameCString(), target->getTypeCString());
+        return;
+    }
 
-            const bool allowCyclingValues = (*partialArgStr == '\0' || cvar->getValueCompletionCallback() != nullptr);
-            displayCompletionMatches(partialArgStr, MaxArgMatchesPerLine, false, allowCyclingValues, findMatchesCallback);
-        }
-        else if ((cmdManager != nullptr) && (cmd = cmdManager->findCommand(cmdName)))
-        {
-            std::string * argCompletionStrings = argStringMatches;
-            auto findMatchesCallback = [cmd, argCompletionStrings](SimpleCommandTerminal &, const char * const partialArg,
-                                                                   const char ** outMatches, int * outMatchesFound, const int maxMatches)
-            {
-                CFG_ASSERT(maxMatches <= MaxCompletionMatches);
-                const int matchesFound = cmd->argumentCompletion(partialArg, argCompletionStrings, maxMatches);
+    static_cast<CVarImplBase *>(target)->linkRef(this);
+}
 
-                const int count = std::min(matchesFound, maxMatches);
-                for (int m = 0; m < count; ++m)
-                {
-                    outMatches[m] = argCompletionStrings[m].c_str();
-                }
-                *outMatchesFound = matchesFound;
-            };
-            displayCompletionMatches(partialArgStr, MaxArgMatchesPerLine, true, true, findMatchesCallback);
-        }
-        // else no match found.
+void CVarRefBase::copyFrom(const CVarRefBase & other)
+{
+    if (&other == this || other.cvar == cvar)
+    {
+        return;
     }
-    else // Not a full name typed yet, try Cmd/CVar name completion:
+
+    reset();
+    if (other.cvar != nullptr)
     {
-        // Skip leading whitespace:
-        const char * partialCmdName = lineBuffer;
-        for (; *partialCmdName != '\0' && isWhitespace(*partialCmdName); ++partialCmdName) { }
+        static_cast<CVarImplBase *>(other.cvar)->linkRef(this);
+    }
+}
 
-        // Turns out it was an empty string.
-        if (*partialCmdName == '\0')
-        {
-            return true;
-        }
+std::string CVarRef<std::string>::get() const
+{
+    CFG_ASSERT(valuePtr != nullptr);
+    const auto & value = static_cast<const CVarValueHolder<CVarStringValue> *>(valuePtr)->load();
+    return std::string(value.c_str(), value.size());
+}
 
-        //
-        // Try the console built-ins first:
-        //
-        bool matchFound;
-        {
-            auto findMatchesCallback = [](SimpleCommandTerminal & term, const char * const partialName,
-                                          const char ** outMatches, int * outMatchesFound, const int maxMatches)
-            {
-                int matchesFound = 0;
-                const int partialLen = lengthOfString(partialName);
-                for (int i = 0; i < term.getBuiltInCommandsCount(); ++i)
-                {
-                    if (cmdCmpNames(partialName, term.getBuiltInCommand(i)->name, partialLen) == 0)
-                    {
-                        if (matchesFound < maxMatches)
-                        {
-                            outMatches[matchesFound] = term.getBuiltInCommand(i)->name;
-                        }
-                        ++matchesFound;
-                    }
-                }
-                *outMatchesFound = matchesFound;
-            };
-            matchFound = displayCompletionMatches(partialCmdName, MaxCmdMatchesPerLine, true, true, findMatchesCallback);
-        }
+// ================================================================================================
+//
+//                                      Console Commands
+//
+// ================================================================================================
 
-        //
-        // CVar names second, to check for setting the var value:
-        //
-        if (!matchFound && cvarManager != nullptr)
-        {
-            auto findMatchesCallback = [](SimpleCommandTerminal & term, const char * const partialName,
-                                          const char ** outMatches, int * outMatchesFound, const int maxMatches)
-            {
-                auto cvarMgr = term.getCVarManager();
-                *outMatchesFound = cvarMgr->findCVarsWithPartialName(partialName, outMatches, maxMatches);
-            };
-            matchFound = displayCompletionMatches(partialCmdName, MaxCVarMatchesPerLine, true, true, findMatchesCallback);
-        }
+// ========================================================
+// CommandArgs implementation:
+// ========================================================
 
-        //
-        // Lastly the user-defined commands:
-        //
-        if (!matchFound && cmdManager != nullptr)
+CommandArgs::CommandArgs()
+    : CommandArgs(nullptr)
+{ }
+
+CommandArgs::CommandArgs(const char * const cmdStr)
+    : argCount(0)
+    , nextTokenIndex(0)
+    , cmdName(nullptr)
+    , inPlaceTokens(false)
+{
+    // argStrings[] and tokenizedArgStr[] are only ever read up to
+    // argCount/nextTokenIndex, so there's no need to clear them here.
+    if (cmdStr != nullptr)
+    {
+        parseArgString(cmdStr, /* inPlace = */ false);
+    }
+}
+
+CommandArgs::CommandArgs(const int argc, const char * argv[])
+    : CommandArgs(nullptr)
+{
+    CFG_ASSERT(argc >= 1);
+    CFG_ASSERT(argv != nullptr);
+
+    // Command/prog name:
+    int nameLen = lengthOfString(argv[0]);
+    cmdName = makeToken(argv[0], &nameLen, /* inPlace = */ false);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        int argLen = lengthOfString(argv[i]);
+        const char * const argStr = makeToken(argv[i], &argLen, /* inPlace = */ false);
+        if (!addArgString(argStr, argLen))
         {
-            auto findMatchesCallback = [](SimpleCommandTerminal & term, const char * const partialName,
-                                          const char ** outMatches, int * outMatchesFound, const int maxMatches)
-            {
-                auto cmdMgr = term.getCommandManager();
-                *outMatchesFound = cmdMgr->findCommandsWithPartialName(partialName, outMatches, maxMatches);
-            };
-            displayCompletionMatches(partialCmdName, MaxCmdMatchesPerLine, true, true, findMatchesCallback);
+            break;
         }
     }
+}
 
-    return true;
+CommandArgs::CommandArgs(const CommandArgs & other)
+    : CommandArgs(nullptr)
+{
+    *this = other;
 }
 
-#ifdef _MSC_VER
-    #pragma warning(pop)
-#endif // _MSC_VER
+CommandArgs & CommandArgs::operator = (const CommandArgs & other)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
 
-bool SimpleCommandTerminal::discardInput()
+    reset();
+
+    if (other.cmdName != nullptr)
+    {
+        cmdName = appendToken(other.cmdName, lengthOfString(other.cmdName));
+    }
+
+    for (int i = 0; i < other.argCount; ++i)
+    {
+        const char * const argStr = appendToken(other.argStrings[i], other.argLengths[i]);
+
+        // Don't bother checking since if all arguments fit in
+        // the source CommandArgs, they must fit in here too!
+        addArgString(argStr, other.argLengths[i]);
+    }
+
+    return *this;
+}
+
+CommandArgs::CommandArgs(CommandArgs && other) noexcept
+    : CommandArgs(nullptr)
 {
-    currCmdInHistory = indexCmdHistory - 1; // Reset command history traversal marker.
-    setLineBuffer("");
-    return true;
+    copyTokensFrom(other);
 }
 
-bool SimpleCommandTerminal::popChar()
+CommandArgs & CommandArgs::operator = (CommandArgs && other) noexcept
 {
-    if (isLineBufferEmpty() || lineBufferInsertionPos <= 0)
+    if (this != &other)
     {
-        return true; // Input is always handled by this call, so return true.
+        reset();
+        copyTokensFrom(other);
     }
+    return *this;
+}
 
-    clearVisibleEditLine();
+void CommandArgs::tokenizeInPlace(char * const cmdStr)
+{
+    CFG_ASSERT(cmdStr != nullptr);
 
-    if (lineBufferInsertionPos == lineBufferUsed) // Erasing last character only:
-    {
-        lineBufferUsed--;
-        lineBufferInsertionPos--;
+    reset();
+    inPlaceTokens = true;
+    parseArgString(cmdStr, /* inPlace = */ true);
+}
 
-        lineBuffer[lineBufferUsed] = '\0';
-        print(lineBuffer);
+void CommandArgs::setTokens(const char * const name, const char * const * const args,
+                            const std::uint16_t * const lengths, const int count)
+{
+    CFG_ASSERT(count >= 0 && count <= MaxCommandArguments);
+
+    // Strings are owned by the caller, same as with tokenizeInPlace().
+    reset();
+    inPlaceTokens = true;
+    cmdName       = name;
+    argCount      = count;
+    std::memcpy(argStrings, args, count * sizeof(argStrings[0]));
+    std::memcpy(argLengths, lengths, count * sizeof(argLengths[0]));
+}
+
+void CommandArgs::reset() noexcept
+{
+    argCount       = 0;
+    nextTokenIndex = 0;
+    cmdName        = nullptr;
+    inPlaceTokens  = false;
+}
+
+void CommandArgs::copyTokensFrom(const CommandArgs & other)
+{
+    argCount       = other.argCount;
+    nextTokenIndex = other.nextTokenIndex;
+    inPlaceTokens  = other.inPlaceTokens;
+
+    std::memcpy(argLengths, other.argLengths, argCount * sizeof(argLengths[0]));
+
+    if (inPlaceTokens)
+    {
+        // Strings live in an external buffer. Just share the pointers.
+        cmdName = other.cmdName;
+        std::memcpy(argStrings, other.argStrings, argCount * sizeof(argStrings[0]));
+        return;
     }
-    else // Erasing at arbitrary position:
+
+    // Copy only the used part of the token buffer and rebase the pointers into ours.
+    std::memcpy(tokenizedArgStr, other.tokenizedArgStr, nextTokenIndex);
+    cmdName = (other.cmdName != nullptr) ? tokenizedArgStr + (other.cmdName - other.tokenizedArgStr) : nullptr;
+    for (int i = 0; i < argCount; ++i)
     {
-        lineBufferUsed--;
-        lineBufferInsertionPos--;
+        argStrings[i] = tokenizedArgStr + (other.argStrings[i] - other.tokenizedArgStr);
+    }
+}
 
-        int i;
-        for (i = lineBufferInsertionPos; i != lineBufferUsed; ++i)
-        {
-            lineBuffer[i] = lineBuffer[i + 1];
-        }
-        lineBuffer[i] = '\0';
+const char * CommandArgs::getCommandName() const noexcept
+{
+    return cmdName;
+}
 
-        // Reposition the cursor:
-        print(lineBuffer);
-        redrawInputLine();
+int CommandArgs::getArgCount() const noexcept
+{
+    return argCount;
+}
+
+bool CommandArgs::isEmpty() const noexcept
+{
+    return argCount == 0;
+}
+
+const char * CommandArgs::operator[](const int index) const
+{
+    return getArgAt(index);
+}
+
+const char * CommandArgs::getArgAt(const int index) const
+{
+    CFG_ASSERT(index >= 0 && index < argCount);
+    CFG_ASSERT(argStrings[index] != nullptr);
+    return argStrings[index];
+}
+
+int CommandArgs::getArgLength(const int index) const
+{
+    CFG_ASSERT(index >= 0 && index < argCount);
+    return argLengths[index];
+}
+
+const char * const * CommandArgs::begin() const noexcept
+{
+    return argStrings;
+}
+
+const char * const * CommandArgs::end() const noexcept
+{
+    return argStrings + argCount;
+}
+
+int CommandArgs::compare(const int argIndex, const char * const str) const
+{
+    CFG_ASSERT(str != nullptr);
+    if (argIndex < 0 || argIndex >= argCount)
+    {
+        return -1;
     }
+    return std::strcmp(getArgAt(argIndex), str);
+}
 
-    return true;
+void CommandArgs::parseArgString(const char * argStr, const bool inPlace)
+{
+    CFG_ASSERT(argStr != nullptr);
+
+    // First argument should be the unquoted command/program name.
+    // Command string might be preceded by whitespace.
+
+    int          argLen      = 0;
+    int          quoteCount  = 0;
+    bool         firstArg    = true;
+    bool         quoted      = false;
+    bool         singleQuote = false;
+    bool         done        = false;
+    const char * newArg      = nullptr;
+    const char * argStart    = nullptr;
+
+    for (; *argStr != '\0' && !done; ++argStr)
+    {
+        switch (*argStr)
+        {
+        // Quotes:
+        //  Indicate that this arg won't end until
+        //  the next enclosing quote is found.
+        case '"' :
+            {
+                ++quoteCount;
+                quoted = quoteCount & 1;
+                if (argStart == nullptr)
+                {
+                    argStart = argStr;
+                }
+                break;
+            }
+        // Simple quotes are allowed to start an argument string
+        // and can also appear inside a double-quoted block.
+        case '\'' :
+            {
+                if (!quoted)
+                {
+                    ++quoteCount;
+                    quoted = quoteCount & 1;
+                    singleQuote = true;
+                }
+                else if (singleQuote)
+                {
+                    ++quoteCount;
+                    quoted = quoteCount & 1;
+                    singleQuote = false;
+                }
+
+                if (argStart == nullptr)
+                {
+                    argStart = argStr;
+                }
+                break;
+            }
+        // Whitespace:
+        //  Separate each individual argument of a command
+        //  line if we are not inside a quoted string.
+        case  ' ' :
+        case '\t' :
+        case '\n' :
+        case '\r' :
+            {
+                if (!quoted && argStart != nullptr)
+                {
+                    argLen = static_cast<int>(argStr - argStart);
+                    newArg = makeToken(argStart, &argLen, inPlace);
+                    argStart = nullptr;
+                    if (firstArg)
+                    {
+                        cmdName = newArg;
+                        firstArg = false;
+                    }
+                    else
+                    {
+                        if (!addArgString(newArg, argLen))
+                        {
+                            done = true; // Arg limit reached.
+                        }
+                    }
+                }
+                break;
+            }
+        // Start of a new argument or continuing an already started one.
+        default :
+            {
+                if (argStart == nullptr)
+                {
+                    argStart = argStr;
+                }
+                break;
+            }
+        } // switch (*argStr)
+    }
+
+    // End reached with an open quote?
+    // We don't trash the arguments completely in such case. Some parameters
+    // might still be valid. Failing will be up to the command handler.
+    if (quoted)
+    {
+        errorF("Attention! Command string ended with open quotation block!");
+        // Allow it to proceed.
+    }
+
+    // Last residual argument before the end of the string.
+    if (argStart != nullptr)
+    {
+        argLen = static_cast<int>(argStr - argStart);
+        newArg = makeToken(argStart, &argLen, inPlace);
+        if (firstArg)
+        {
+            cmdName = newArg;
+        }
+        else
+        {
+            addArgString(newArg, argLen);
+        }
+    }
+}
+
+bool CommandArgs::addArgString(const char * const argStr, const int argLen)
+{
+    if (argStr == nullptr)
+    {
+        return errorF("Null token! CommandArgs::tokenizedArgStr[] depleted?");
+    }
+    else if (argCount == MaxCommandArguments)
+    {
+        return errorF("Too many arguments! Ignoring extraneous ones...");
+    }
+    else
+    {
+        argLengths[argCount]   = static_cast<std::uint16_t>(argLen);
+        argStrings[argCount++] = argStr;
+        return true;
+    }
+}
+
+const char * CommandArgs::appendToken(const char * token, int tokenLen)
+{
+    if ((nextTokenIndex + tokenLen) >= MaxCommandArgStrLength)
+    {
+        errorF("Command argument string too long! Max is %i characters.", MaxCommandArgStrLength - 1);
+        return nullptr;
+    }
+
+    char * outTokenPtr = &tokenizedArgStr[nextTokenIndex];
+    std::memcpy(outTokenPtr, token, tokenLen);
+    nextTokenIndex += (tokenLen + 1);
+    outTokenPtr[tokenLen] = '\0';
+
+    return outTokenPtr;
+}
+
+const char * CommandArgs::makeToken(const char * token, int * tokenLen, const bool inPlace)
+{
+    // If the token is enclosed in single or double quotes, ignore them.
+    // Note that this assumes the opening AND closing quotes are present!
+    if ((token[0] == '"' || token[0] == '\'') && *tokenLen >= 2)
+    {
+        ++token;
+        *tokenLen -= 2;
+    }
+
+    if (!inPlace)
+    {
+        return appendToken(token, *tokenLen);
+    }
+
+    // The closing quote or the whitespace after the token becomes its null terminator.
+    char * outTokenPtr = const_cast<char *>(token);
+    outTokenPtr[*tokenLen] = '\0';
+    return outTokenPtr;
+}
+
+// ========================================================
+// class CommandImplBase:
+// ========================================================
+
+#if CFG_PACK_STRUCTURES
+    #pragma pack(push, 1)
+#endif // CFG_PACK_STRUCTURES
+
+class CommandImplBase
+    : public HashTableLink<CommandImplBase>
+    , public Command
+{
+public:
+
+    // Not copyable.
+    CommandImplBase(const CommandImplBase &) = delete;
+    CommandImplBase & operator = (const CommandImplBase &) = delete;
+
+    // Construct with common parameters. Description may be null or an empty string.
+    // Min and max args may be negative to disable CommandManager-side argument count
+    // validation. Flags are any user defined set of integer bit-flags, including zero.
+    CommandImplBase(const char * cmdName,
+                    const char * cmdDesc,
+                    std::uint32_t cmdFlags,
+                    int minCmdArgs,
+                    int maxCmdArgs);
+
+    virtual ~CommandImplBase();
+    virtual void onExecute(const CommandArgs & args);
+    virtual bool isAlias() const override;
+    virtual int argumentCompletion(const char  * partialArg,
+                                   std::string * outMatches,
+                                   int maxMatches) const override;
+
+    std::uint32_t getFlags() const override;
+    void setFlags(std::uint32_t newFlags) override;
+
+    const char * getNameCString() const override;
+    const char * getDescCString() const override;
+
+    std::string getName() const override;
+    std::string getDesc() const override;
+
+    int getMinArgs() const override;
+    int getMaxArgs() const override;
+
+    std::uint32_t getCostHintMicros() const override;
+    void setCostHintMicros(std::uint32_t microseconds) override;
+
+    // Handler stats. Allocated on the first profiled run, null before that.
+    const CommandProfile * getProfile() const noexcept { return profile; }
+    void addProfiledRun(std::uint64_t nanoseconds);
+    void clearProfile();
+
+protected:
+
+    void setInlineHandler(const CommandHandlerInline * handler) noexcept { inlineHandler = handler; }
+
+private:
+
+    friend class CommandManagerImpl;
+    friend class FlagIndex<CommandImplBase>;
+
+    // Opaque user defined bitflags. Can be changed after construction.
+    std::uint32_t flags;
+
+    // Flag bits of the FlagIndex lists this command is in.
+    std::uint32_t flagIndexMask;
+
+    // Index of the manager that registered the command. Null until registered.
+    FlagIndex<CommandImplBase> * flagIndex;
+
+    // Set by commands with an inline handler, which is then called
+    // directly by execResolved() instead of going through onExecute().
+    const CommandHandlerInline * inlineHandler;
+
+    // Expected run time in microseconds, zero if unknown.
+    std::uint32_t costHint;
+
+    // See CommandManager::setProfilingEnabled().
+    CommandProfile * profile;
+
+    // We don't need the full range of an integer for the arg counts.
+    // A command will have at most half a dozen args, in the rare case.
+    const std::int8_t minArgs;
+    const std::int8_t maxArgs;
+
+    // A name must always be provided. Description may be an empty string.
+    char name[MaxCommandNameLength];
+    char desc[MaxCommandDescLength];
+};
+
+#if CFG_PACK_STRUCTURES
+    #pragma pack(pop)
+#endif // CFG_PACK_STRUCTURES
+
+// ========================================================
+// CommandImplBase implementation:
+// ========================================================
+
+CommandImplBase::CommandImplBase(const char * const cmdName,
+                                 const char * const cmdDesc,
+                                 const std::uint32_t cmdFlags,
+                                 const int minCmdArgs,
+                                 const int maxCmdArgs)
+    : flags(cmdFlags)
+    , flagIndexMask(0)
+    , flagIndex(nullptr)
+    , inlineHandler(nullptr)
+    , costHint(0)
+    , profile(nullptr)
+    , minArgs(static_cast<std::int8_t>(minCmdArgs))
+    , maxArgs(static_cast<std::int8_t>(maxCmdArgs))
+{
+    CFG_ASSERT(minCmdArgs <= MaxCommandArguments);
+    CFG_ASSERT(maxCmdArgs <= MaxCommandArguments);
+
+    CFG_ASSERT(cmdName != nullptr && *cmdName != '\0');
+    CFG_ASSERT(lengthOfString(cmdName) < MaxCommandNameLength);
+
+    clearArray(name);
+    clearArray(desc);
+    copyString(name, lengthOfArray(name), cmdName);
+
+    // Description comment is optional.
+    if (cmdDesc != nullptr && *cmdDesc != '\0')
+    {
+        CFG_ASSERT(lengthOfString(cmdDesc) < MaxCommandDescLength);
+        copyString(desc, lengthOfArray(desc), cmdDesc);
+    }
+}
+
+CommandImplBase::~CommandImplBase()
+{
+    clearProfile();
+}
+
+void CommandImplBase::onExecute(const CommandArgs & /* args */)
+{
+    // Default no-op command handler.
+}
+
+bool CommandImplBase::isAlias() const
+{
+    return false;
+}
+
+int CommandImplBase::argumentCompletion(const char  * /* partialArg */,
+                                        std::string * /* outMatches */,
+                                        int /* maxMatches */) const
+{
+    // Default no-op completion handler.
+    return 0;
+}
+
+std::uint32_t CommandImplBase::getFlags() const
+{
+    return flags;
+}
+
+void CommandImplBase::setFlags(const std::uint32_t newFlags)
+{
+    flags = newFlags;
+    if (flagIndex != nullptr)
+    {
+        flagIndex->update(this);
+    }
+}
+
+const char * CommandImplBase::getNameCString() const
+{
+    return name;
+}
+
+const char * CommandImplBase::getDescCString() const
+{
+    return desc;
+}
+
+std::string CommandImplBase::getName() const
+{
+    return name;
+}
+
+std::string CommandImplBase::getDesc() const
+{
+    return desc;
+}
+
+int CommandImplBase::getMinArgs() const
+{
+    return minArgs;
+}
+
+int CommandImplBase::getMaxArgs() const
+{
+    return maxArgs;
+}
+
+std::uint32_t CommandImplBase::getCostHintMicros() const
+{
+    return costHint;
+}
+
+void CommandImplBase::setCostHintMicros(const std::uint32_t microseconds)
+{
+    costHint = microseconds;
+}
+
+void CommandImplBase::addProfiledRun(const std::uint64_t nanoseconds)
+{
+    if (profile == nullptr)
+    {
+        profile = memAlloc<CommandProfile>(1, MemoryCategory::Commands);
+        std::memset(profile, 0, sizeof(CommandProfile));
+        profile->command = this;
+        profile->minTime = UINT64_MAX;
+    }
+
+    profile->callCount += 1;
+    profile->totalTime += nanoseconds;
+    profile->minTime    = std::min(profile->minTime, nanoseconds);
+    profile->maxTime    = std::max(profile->maxTime, nanoseconds);
+
+    // Log2 buckets of microseconds.
+    int bucket = 0;
+    for (std::uint64_t micros = nanoseconds / 1000; micros != 0 && bucket < CommandProfileHistogramSize - 1; micros >>= 1)
+    {
+        ++bucket;
+    }
+    profile->histogram[bucket] += 1;
+}
+
+void CommandImplBase::clearProfile()
+{
+    memFree(profile);
+    profile = nullptr;
+}
+
+// ========================================================
+// class CommandImplCallbacks:
+// ========================================================
+
+//
+// Wraps a pair of C-style function pointers (callbacks) into a
+// CommandImpl that we can insert in the commands hash table.
+//
+class CommandImplCallbacks final
+    : public CommandImplBase
+{
+public:
+
+    CommandImplCallbacks(const char * cmdName,
+                         const char * cmdDesc,
+                         std::uint32_t cmdFlags,
+                         int minCmdArgs,
+                         int maxCmdArgs,
+                         CommandHandlerCallback execCb,
+                         CommandArgCompletionCallback argCompleteCb,
+                         void * userCtx);
+
+    void onExecute(const CommandArgs & args) override;
+    int argumentCompletion(const char  * partialArg,
+                           std::string * outMatches,
+                           int maxMatches) const override;
+
+private:
+
+    CommandHandlerCallback       execCallback;
+    CommandArgCompletionCallback argCompletionCallback;
+    void *                       userContext;
+};
+
+CommandImplCallbacks::CommandImplCallbacks(const char * const cmdName,
+                                           const char * const cmdDesc,
+                                           const std::uint32_t cmdFlags,
+                                           const int minCmdArgs,
+                                           const int maxCmdArgs,
+                                           CommandHandlerCallback execCb,
+                                           CommandArgCompletionCallback argCompleteCb,
+                                           void * userCtx)
+    : CommandImplBase(cmdName, cmdDesc, cmdFlags, minCmdArgs, maxCmdArgs)
+    , execCallback(execCb)
+    , argCompletionCallback(argCompleteCb)
+    , userContext(userCtx)
+{
+}
+
+void CommandImplCallbacks::onExecute(const CommandArgs & args)
+{
+    if (execCallback != nullptr)
+    {
+        execCallback(args, userContext);
+    }
+}
+
+int CommandImplCallbacks::argumentCompletion(const char  * const partialArg,
+                                             std::string * outMatches,
+                                             const int maxMatches) const
+{
+    if (argCompletionCallback != nullptr)
+    {
+        return argCompletionCallback(partialArg, outMatches, maxMatches, userContext);
+    }
+    return 0;
+}
+
+// ========================================================
+// class CommandImplDelegates:
+// ========================================================
+
+//
+// Wraps a pair of std::functions (delegates) into a
+// CommandImpl that we can insert in the commands hash table.
+//
+class CommandImplDelegates final
+    : public CommandImplBase
+{
+public:
+
+    CommandImplDelegates(const char * cmdName,
+                         const char * cmdDesc,
+                         std::uint32_t cmdFlags,
+                         int minCmdArgs,
+                         int maxCmdArgs,
+                         CommandHandlerDelegate execDl,
+                         CommandArgCompletionDelegate argComplDl);
+
+    void onExecute(const CommandArgs & args) override;
+    int argumentCompletion(const char * partialArg, std::string * outMatches, int maxMatches) const override;
+
+private:
+
+    CommandHandlerDelegate       execDelegate;
+    CommandArgCompletionDelegate argCompletionDelegate;
+};
+
+CommandImplDelegates::CommandImplDelegates(const char * const cmdName,
+                                           const char * const cmdDesc,
+                                           const std::uint32_t cmdFlags,
+                                           const int minCmdArgs,
+                                           const int maxCmdArgs,
+                                           CommandHandlerDelegate execDl,
+                                           CommandArgCompletionDelegate argCompleteDl)
+    : CommandImplBase(cmdName, cmdDesc, cmdFlags, minCmdArgs, maxCmdArgs)
+    , execDelegate(std::move(execDl))
+    , argCompletionDelegate(std::move(argCompleteDl))
+{
+}
+
+void CommandImplDelegates::onExecute(const CommandArgs & args)
+{
+    if (execDelegate != nullptr)
+    {
+        execDelegate(args);
+    }
+}
+
+int CommandImplDelegates::argumentCompletion(const char  * const partialArg,
+                                             std::string * outMatches,
+                                             const int maxMatches) const
+{
+    if (argCompletionDelegate != nullptr)
+    {
+        return argCompletionDelegate(partialArg, outMatches, maxMatches);
+    }
+    return 0;
+}
+
+// ========================================================
+// class CommandImplMemberFuncs:
+// ========================================================
+
+//
+// Wraps a pair of class methods plus a pointer to the
+// owning object (the "this pointer") allowing a standard
+// C++ class registering a member method as a command handler.
+//
+class CommandImplMemberFuncs final
+    : public CommandImplBase
+{
+public:
+
+    CommandImplMemberFuncs(const char * cmdName,
+                           const char * cmdDesc,
+                           std::uint32_t cmdFlags,
+                           int minCmdArgs,
+                           int maxCmdArgs,
+                           CommandHandlerMemFunc execMf,
+                           CommandHandlerMemFunc argCompleteMf);
+
+    void onExecute(const CommandArgs & args) override;
+    int argumentCompletion(const char * partialArg, std::string * outMatches, int maxMatches) const override;
+
+private:
+
+    CommandHandlerMemFunc execMemFunc;
+    CommandHandlerMemFunc argCompletionMemFunc;
+};
+
+CommandImplMemberFuncs::CommandImplMemberFuncs(const char * const cmdName,
+                                               const char * const cmdDesc,
+                                               const std::uint32_t cmdFlags,
+                                               const int minCmdArgs,
+                                               const int maxCmdArgs,
+                                               CommandHandlerMemFunc execMf,
+                                               CommandHandlerMemFunc argCompleteMf)
+    : CommandImplBase(cmdName, cmdDesc, cmdFlags, minCmdArgs, maxCmdArgs)
+    , execMemFunc(execMf)
+    , argCompletionMemFunc(argCompleteMf)
+{
+}
+
+void CommandImplMemberFuncs::onExecute(const CommandArgs & args)
+{
+    if (execMemFunc != nullptr)
+    {
+        execMemFunc.invoke<void>(args);
+    }
+}
+
+int CommandImplMemberFuncs::argumentCompletion(const char  * const partialArg,
+                                               std::string * outMatches,
+                                               const int maxMatches) const
+{
+    if (argCompletionMemFunc != nullptr)
+    {
+        return argCompletionMemFunc.invoke<int>(partialArg, outMatches, maxMatches);
+    }
+    return 0;
+}
+
+// ========================================================
+// class CommandImplInline:
+// ========================================================
+
+//
+// Holds a pair of InlineDelegates. The callables live inside
+// the command itself, so registration allocates nothing besides
+// the command from the manager's arena.
+//
+class CommandImplInline final
+    : public CommandImplBase
+{
+public:
+
+    CommandImplInline(const char * cmdName,
+                      const char * cmdDesc,
+                      std::uint32_t cmdFlags,
+                      int minCmdArgs,
+                      int maxCmdArgs,
+                      CommandHandlerInline execIn,
+                      CommandArgCompletionInline argComplIn);
+
+    void onExecute(const CommandArgs & args) override;
+    int argumentCompletion(const char * partialArg, std::string * outMatches, int maxMatches) const override;
+
+private:
+
+    CommandHandlerInline       execInline;
+    CommandArgCompletionInline argCompletionInline;
+};
+
+CommandImplInline::CommandImplInline(const char * const cmdName,
+                                     const char * const cmdDesc,
+                                     const std::uint32_t cmdFlags,
+                                     const int minCmdArgs,
+                                     const int maxCmdArgs,
+                                     CommandHandlerInline execIn,
+                                     CommandArgCompletionInline argComplIn)
+    : CommandImplBase(cmdName, cmdDesc, cmdFlags, minCmdArgs, maxCmdArgs)
+    , execInline(execIn)
+    , argCompletionInline(argComplIn)
+{
+    CFG_ASSERT(execInline != nullptr);
+    setInlineHandler(&execInline);
+}
+
+void CommandImplInline::onExecute(const CommandArgs & args)
+{
+    execInline(args);
+}
+
+int CommandImplInline::argumentCompletion(const char  * const partialArg,
+                                          std::string * outMatches,
+                                          const int maxMatches) const
+{
+    if (argCompletionInline != nullptr)
+    {
+        return argCompletionInline(partialArg, outMatches, maxMatches);
+    }
+    return 0;
+}
+
+#if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+// ========================================================
+// class CommandTemplate:
+// ========================================================
+
+//
+// An alias string with $(var) expansions, split ahead of time
+// into the text of each command minus the expansions, plus the
+// positions where the CVar values go. Running the alias then just
+// copies the text and the current values, without scanning the
+// string and looking up the names again. Commands that can't be
+// precompiled, like reentrant $(a$(b)) expansions, keep their
+// source text and are expanded as usual when they run.
+// See CommandManagerImpl::compileCommandTemplate().
+//
+class CommandTemplate final
+{
+public:
+
+    // One command of the alias string.
+    struct Command
+    {
+        int sourceText;   // Offset in chars[] of the command as written.
+        int literalText;  // Offset in chars[] of the command with the $(var)s removed, or -1 if not precompiled.
+        int literalLength;
+        int firstVarRef;  // Index in varRefs[] of the first expansion of this command.
+        int varRefCount;
+    };
+
+    // One $(var) expansion.
+    struct VarRef
+    {
+        int          insertPos; // Position in the command literal text where the value goes.
+        int          varName;   // Offset in chars[] of the CVar name.
+        const CVar * cvar;      // Resolved on first use. Null if not resolved yet or not found.
+    };
+
+    template<typename T>
+    using Array = MemVector<T, MemoryCategory::Commands>;
+
+    Array<Command> commands;
+    Array<VarRef>  varRefs;
+    Array<char>    chars; // All the strings, null separated. The whole alias string comes first.
+
+    // CVars and CVarManagerImpl::getRemovalGeneration() when the VarRef::cvar pointers were last resolved.
+    const CVarManagerImpl * resolvedManager = nullptr;
+    std::uint32_t resolvedGeneration = 0;
+
+    // One reference is held by the alias and one by each of its commands waiting in the
+    // command buffer, so removing the alias from a command handler is fine.
+    int refCount = 1;
+
+    int addString(const char * const str, const int length)
+    {
+        const int offset = static_cast<int>(chars.size());
+        chars.insert(chars.end(), str, str + length);
+        chars.push_back('\0');
+        return offset;
+    }
+
+    const char * getString(const int offset) const noexcept
+    {
+        return chars.data() + offset;
+    }
+
+    // Parses the $(var) at *outStr, which must point to the '$'. Returns false if the
+    // expansion can't be precompiled. Leaves *outStr pointing to the closing parenthesis.
+    bool addVarRef(const char ** const outStr, const int insertPos)
+    {
+        const char * str   = *outStr;
+        int  parenthesis   = 0;
+        int  varNameLength = 0;
+        char varName[MaxCommandArgStrLength];
+
+        CFG_ASSERT(*str == '$');
+
+        // Same rules of CommandManagerImpl::expandCVar().
+        for (++str; *str != '\0' && *str != '\n' && *str != CommandTextSeparator; ++str)
+        {
+            if (*str == '(')
+            {
+                ++parenthesis;
+            }
+            else if (*str == ')')
+            {
+                --parenthesis;
+                break;
+            }
+            else if (*str == '$' && *(str + 1) == '(')
+            {
+                return false; // Reentrant expansion.
+            }
+            else if (!isWhitespace(*str))
+            {
+                if (varNameLength == MaxCommandArgStrLength - 1)
+                {
+                    return false;
+                }
+                varName[varNameLength++] = *str;
+            }
+        }
+
+        if (parenthesis != 0 || varNameLength == 0)
+        {
+            return false;
+        }
+
+        VarRef ref;
+        ref.insertPos = insertPos;
+        ref.varName   = addString(varName, varNameLength);
+        ref.cvar      = nullptr;
+        varRefs.push_back(ref);
+
+        *outStr = str;
+        return true;
+    }
+};
+
+inline void releaseCommandTemplate(CommandTemplate * const cmdTemplate)
+{
+    if (cmdTemplate != nullptr && --cmdTemplate->refCount == 0)
+    {
+        destroy(cmdTemplate);
+        memFree(cmdTemplate);
+    }
+}
+#endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+// ========================================================
+// class CommandImplAlias:
+// ========================================================
+
+class CommandManagerImpl;
+class CommandTemplate;
+
+//
+// Helper used to define command aliases using the same
+// CommandImpl interface. It just stores a copy of the
+// aliased command string. onExecute() pushes this string
+// into the CommandManager buffer. Strings with $(var)
+// expansions also get a precompiled CommandTemplate.
+//
+class CommandImplAlias final
+    : public CommandImplBase
+{
+public:
+
+    CommandImplAlias(const char * cmdName,
+                     const char * cmdDesc,
+                     const char * cmdStr,
+                     CommandExecMode cmdExec,
+                     CommandManagerImpl * cmdMgr,
+                     CommandTemplate * cmdTmpl,
+                     MemoryArena * arena);
+
+    ~CommandImplAlias();
+    void onExecute(const CommandArgs & args) override;
+    bool isAlias() const override;
+    char * toCfgString(char * outBuffer, int bufferSize) const;
+
+    const char * getTargetCommand() const noexcept { return targetCommand; }
+    CommandExecMode getExecMode() const noexcept { return execMode; }
+
+private:
+
+    const CommandExecMode execMode;
+    CommandManagerImpl *  manager;
+    CommandTemplate *     cmdTemplate; // Null if not using $(var) expansions.
+    MemoryArena *         memArena;
+    char *                targetCommand;
+};
+
+CommandImplAlias::CommandImplAlias(const char * const cmdName,
+                                   const char * const cmdDesc,
+                                   const char * const cmdStr,
+                                   const CommandExecMode cmdExec,
+                                   CommandManagerImpl * cmdMgr,
+                                   CommandTemplate * cmdTmpl,
+                                   MemoryArena * arena)
+    : CommandImplBase(cmdName, cmdDesc, 0, 0, 0)
+    , execMode(cmdExec)
+    , manager(cmdMgr)
+    , cmdTemplate(cmdTmpl)
+    , memArena(arena)
+    , targetCommand(cloneString(cmdStr, arena))
+{
+    CFG_ASSERT(cmdMgr != nullptr);
+}
+
+CommandImplAlias::~CommandImplAlias()
+{
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    releaseCommandTemplate(cmdTemplate);
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    memFree(memArena, targetCommand);
+}
+
+bool CommandImplAlias::isAlias() const
+{
+    return true;
+}
+
+char * CommandImplAlias::toCfgString(char * outBuffer, const int bufferSize) const
+{
+    CFG_ASSERT(outBuffer != nullptr);
+
+    const char * description = getDescCString();
+    const char * modeFlag;
+
+    if (execMode == CommandExecMode::Insert)
+    {
+        modeFlag = "-insert";
+    }
+    else if (execMode == CommandExecMode::Immediate)
+    {
+        modeFlag = "-immediate";
+    }
+    else // CommandExecMode::Append
+    {
+        modeFlag = "-append";
+    }
+
+    // alias  name  "cmd-string"  mode-flag  "optional-description"
+    if (*description != '\0')
+    {
+        std::snprintf(outBuffer, bufferSize,
+                      "alias %s \"%s\" %s \"%s\"",
+                      getNameCString(), targetCommand, modeFlag, description);
+    }
+    else
+    {
+        std::snprintf(outBuffer, bufferSize,
+                      "alias %s \"%s\" %s",
+                      getNameCString(), targetCommand, modeFlag);
+    }
+    return outBuffer;
+}
+
+// ========================================================
+// Command name string comparisons and sorting:
+// ========================================================
+
+static inline int cmdCmpNames(const char * const a, const char * const b, const std::uint32_t count = ~0u)
+{
+    #if CFG_COMMAND_CASE_SENSITIVE_NAMES
+    return std::strncmp(a, b, count);
+    #else // !CFG_COMMAND_CASE_SENSITIVE_NAMES
+    return compareStringsNoCase(a, b, count);
+    #endif // CFG_COMMAND_CASE_SENSITIVE_NAMES
+}
+
+static inline void cmdSortMatches(Command ** outMatches, const int count)
+{
+    std::sort(outMatches, outMatches + count,
+              [](const Command * const a, const Command * const b)
+              {
+                  return cmdCmpNames(a->getNameCString(), b->getNameCString()) < 0;
+              });
+}
+
+static inline void cmdSortMatches(const char ** outMatches, const int count)
+{
+    std::sort(outMatches, outMatches + count,
+              [](const char * const a, const char * const b)
+              {
+                  return cmdCmpNames(a, b) < 0;
+              });
+}
+
+// ========================================================
+// Command text splitting for the command buffer:
+// ========================================================
+
+// Skips command separators and whitespace in between commands.
+static const char * cmdSkipSeparators(const char * str)
+{
+    for (; *str != '\0'; ++str)
+    {
+        if (!isWhitespace(*str) && *str != CommandTextSeparator)
+        {
+            break;
+        }
+    }
+    return str;
+}
+
+// Finds where the command starting at 'str' ends, using the same rules of
+// CommandManagerImpl::extractNextCommand(), but without copying or expanding
+// anything. Returns a pointer just past the terminating separator/newline.
+static const char * cmdFindEndOfCommand(const char * str)
+{
+    int  quoteCount  = 0;
+    bool quoted      = false;
+    bool singleQuote = false;
+    bool backslash   = false;
+
+    while (*str != '\0')
+    {
+        const int chr = *str++;
+        if (chr == '\r')
+        {
+            continue;
+        }
+        else if (chr == '\\')
+        {
+            backslash = true;
+            continue;
+        }
+        else if (chr == '\n')
+        {
+            if (!backslash && !quoted)
+            {
+                break;
+            }
+            backslash = false;
+        }
+        else if (chr == '"')
+        {
+            ++quoteCount;
+            quoted = quoteCount & 1;
+        }
+        else if (chr == '\'')
+        {
+            if (!quoted)
+            {
+                ++quoteCount;
+                quoted = quoteCount & 1;
+                singleQuote = true;
+            }
+            else if (singleQuote)
+            {
+                ++quoteCount;
+                quoted = quoteCount & 1;
+                singleQuote = false;
+            }
+        }
+        else if (chr == CommandTextSeparator)
+        {
+            if (!quoted)
+            {
+                break;
+            }
+        }
+        #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        else if (chr == '$' && *str == '(')
+        {
+            // Separators inside a $(var) are part of the expansion. See expandCVar().
+            int parenthesis = 0;
+            for (; *str != '\0' && *str != '\n' && *str != CommandTextSeparator; ++str)
+            {
+                if (*str == '(')
+                {
+                    ++parenthesis;
+                }
+                else if (*str == ')' && --parenthesis == 0)
+                {
+                    ++str;
+                    break;
+                }
+            }
+            continue;
+        }
+        #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+        if (backslash && !(chr == ' ' || chr == '\t'))
+        {
+            backslash = false;
+        }
+    }
+    return str;
+}
+
+// ========================================================
+// class CompiledConfig:
+// ========================================================
+
+//
+// A configuration file split and tokenized ahead of time.
+// See CommandManager::compileConfigFile().
+//
+class CompiledConfig final
+{
+public:
+
+    // One command from the file, or one line that must be executed as text.
+    struct Op
+    {
+        CommandImplBase * cmd; // Resolved on first run. Null if not resolved yet or not found.
+        int lineNum;           // Line of the command in the source file.
+        int echoText;          // Offset in chars[] of the line to echo, or -1 if not the first command of the line.
+        int deferredText;      // Offset in chars[] of a line with $(var) expansions to run with execNow(), or -1.
+        int firstToken;        // Index in tokens[]/tokenLengths[] of the command name. Args follow it.
+        int argCount;          // Number of args after the command name.
+    };
+
+    template<typename T>
+    using Array = MemVector<T, MemoryCategory::CommandBuffer>;
+
+    MemString<MemoryCategory::CommandBuffer> filename;
+    Array<Op>            ops;
+    Array<char>          chars;        // All the strings, null separated.
+    Array<int>           tokenOffsets; // Offsets in chars[] of each token.
+    Array<const char *>  tokens;       // Pointers into chars[], only filled once the whole file is read.
+    Array<std::uint16_t> tokenLengths; // Length of each token, not counting the '\0'.
+
+    // CommandManagerImpl::cmdRemovalGeneration when the Op::cmd pointers were last resolved.
+    std::uint32_t resolvedGeneration = 0;
+
+    // Number of execCompiledConfig() calls currently running this program.
+    // A program discarded while in use is only freed when the last run ends.
+    int  activeRuns = 0;
+    bool discarded  = false;
+
+    int addString(const char * const str, const int length)
+    {
+        const int offset = static_cast<int>(chars.size());
+        chars.insert(chars.end(), str, str + length);
+        chars.push_back('\0');
+        return offset;
+    }
+
+    void addToken(const char * const str, const int length)
+    {
+        tokenOffsets.push_back(addString(str, length));
+        tokenLengths.push_back(static_cast<std::uint16_t>(length));
+    }
+
+    void finalize()
+    {
+        tokens.resize(tokenOffsets.size());
+        for (std::size_t i = 0; i < tokenOffsets.size(); ++i)
+        {
+            tokens[i] = chars.data() + tokenOffsets[i];
+        }
+        tokenOffsets.clear();
+        tokenOffsets.shrink_to_fit();
+    }
+};
+
+// ========================================================
+// class CommandSubmitQueue:
+// ========================================================
+
+//
+// Bounded lock-free queue of command strings with many producer
+// threads and a single consumer, for CommandManager::submitCommandText().
+// Records are packed in a ring of bytes: a producer reserves space for its
+// string by bumping the write position with a CAS, copies the text in and then
+// marks the record header as ready. The consumer pops ready records in order,
+// stopping at the first one still being written. Records that would wrap around
+// the end of the ring are preceded by a padding record filling the tail.
+//
+class CommandSubmitQueue final
+{
+public:
+
+    // Not copyable.
+    CommandSubmitQueue(const CommandSubmitQueue &) = delete;
+    CommandSubmitQueue & operator = (const CommandSubmitQueue &) = delete;
+
+    CommandSubmitQueue()
+        : ring(memAlloc<char>(Capacity, MemoryCategory::CommandBuffer))
+        , writePos(0)
+        , readPos(0)
+        , rejectedCount(0)
+    {
+        // Zero headers are records not ready yet.
+        std::memset(ring, 0, Capacity);
+    }
+
+    ~CommandSubmitQueue()
+    {
+        memFree(ring);
+    }
+
+    // Any thread. Returns false if there's no room for the string.
+    bool push(const char * const str, const int length)
+    {
+        const std::uint32_t recordSize = alignRecordSize(HeaderSize + length + 1);
+
+        // A record and the padding before it always fit if under half the ring.
+        if (recordSize > (Capacity / 2))
+        {
+            rejectedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        std::uint32_t pos = writePos.load(std::memory_order_relaxed);
+        std::uint32_t padding;
+        for (;;)
+        {
+            const std::uint32_t tailSize = Capacity - (pos & (Capacity - 1));
+            padding = (recordSize > tailSize) ? tailSize : 0;
+
+            if ((pos + padding + recordSize - readPos.load(std::memory_order_acquire)) > Capacity)
+            {
+                rejectedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (writePos.compare_exchange_weak(pos, pos + padding + recordSize, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        if (padding != 0)
+        {
+            headerAt(pos)->store(padding | RecordReady | RecordPadding, std::memory_order_release);
+            pos += padding;
+        }
+
+        char * const text = ring + (pos & (Capacity - 1)) + HeaderSize;
+        std::memcpy(text, str, length);
+        text[length] = '\0';
+
+        headerAt(pos)->store(recordSize | RecordReady, std::memory_order_release);
+        return true;
+    }
+
+    // Owning thread only. Calls 'func' with each null terminated string, in push order.
+    template<typename Func>
+    int popAll(Func && func)
+    {
+        int popped = 0;
+        std::uint32_t pos = readPos.load(std::memory_order_relaxed);
+        const std::uint32_t end = writePos.load(std::memory_order_acquire);
+
+        while (pos != end)
+        {
+            std::atomic<std::uint32_t> * const header = headerAt(pos);
+            const std::uint32_t value = header->load(std::memory_order_acquire);
+            if ((value & RecordReady) == 0)
+            {
+                break; // Still being written. Stays for the next call.
+            }
+
+            char * const record = ring + (pos & (Capacity - 1));
+            const std::uint32_t recordSize = value & ~RecordFlagsMask;
+            if ((value & RecordPadding) == 0)
+            {
+                func(record + HeaderSize);
+                ++popped;
+            }
+
+            // Producers expect the space they reserve to be zeroed.
+            header->store(0, std::memory_order_relaxed);
+            std::memset(record + HeaderSize, 0, recordSize - HeaderSize);
+
+            pos += recordSize;
+            readPos.store(pos, std::memory_order_release);
+        }
+        return popped;
+    }
+
+    bool isEmpty() const noexcept
+    {
+        return readPos.load(std::memory_order_relaxed) == writePos.load(std::memory_order_acquire);
+    }
+
+    // Number of rejected pushes since the last call.
+    std::uint32_t takeRejectedCount() noexcept
+    {
+        return rejectedCount.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+
+    static constexpr std::uint32_t Capacity        = CFG_COMMAND_SUBMIT_QUEUE_SIZE;
+    static constexpr std::uint32_t HeaderSize      = 8; // Keeps the headers aligned.
+    static constexpr std::uint32_t RecordReady     = 1;
+    static constexpr std::uint32_t RecordPadding   = 2;
+    static constexpr std::uint32_t RecordFlagsMask = HeaderSize - 1;
+
+    static_assert((Capacity & (Capacity - 1)) == 0 && Capacity >= 256, "CFG_COMMAND_SUBMIT_QUEUE_SIZE must be a power of two!");
+    static_assert(sizeof(std::atomic<std::uint32_t>) <= HeaderSize, "Unexpected size of std::atomic!");
+
+    static std::uint32_t alignRecordSize(const int size) noexcept
+    {
+        return (static_cast<std::uint32_t>(size) + (HeaderSize - 1)) & ~(HeaderSize - 1);
+    }
+
+    std::atomic<std::uint32_t> * headerAt(const std::uint32_t pos) const noexcept
+    {
+        return reinterpret_cast<std::atomic<std::uint32_t> *>(ring + (pos & (Capacity - 1)));
+    }
+
+    char * const               ring;
+    std::atomic<std::uint32_t> writePos;      // Shared by the producers. Positions wrap around freely.
+    std::atomic<std::uint32_t> readPos;       // Only written by the consumer.
+    std::atomic<std::uint32_t> rejectedCount; // Reported on the owning thread by execBufferedCommands().
+};
+
+// ========================================================
+// class CommandManagerImpl:
+// ========================================================
+
+class CommandManagerImpl final
+    : public CommandManager
+{
+public:
+
+    // Not copyable.
+    CommandManagerImpl(const CommandManagerImpl &) = delete;
+    CommandManagerImpl & operator = (const CommandManagerImpl &) = delete;
+
+    CommandManagerImpl(int hashTableSize, CVarManager * cvarMgr, bool useMemoryArena);
+    ~CommandManagerImpl();
+
+    Command * findCommand(const char * name) const override;
+    Command * findCommand(const HashedName & name) const override;
+    int findCommandsWithPartialName(const char * partialName, Command ** outMatches, int maxMatches) const override;
+    int findCommandsWithPartialName(const char * partialName, const char ** outMatches, int maxMatches) const override;
+    int findCommandsWithFlags(std::uint32_t flags, Command ** outMatches, int maxMatches) const override;
+
+    bool removeCommand(const char * name) override;
+    bool removeCommand(Command * cmd) override;
+    bool removeCommandAlias(const char * aliasName) override;
+    void removeAllCommands() override;
+    void removeAllCommandAliases() override;
+
+    int getRegisteredCommandsCount() const override;
+    int getCommandAliasCount() const override;
+    bool isValidCommandName(const char * name) const override;
+    void enumerateAllCommands(CommandEnumerateCallback enumCallback, void * userContext) override;
+    int enumerateCommandsWithFlags(std::uint32_t flags, CommandEnumerateCallback enumCallback, void * userContext) override;
+
+    void disableCommandsWithFlags(std::uint32_t flags) override;
+    void enableAllCommands() override;
+
+    CVarManager * getCVarManager() const override;
+    void setCVarManager(CVarManager * cvarMgr) override;
+
+    bool registerCommand(const char * name,
+                         CommandHandlerCallback handler,
+                         CommandArgCompletionCallback completionHandler = nullptr,
+                         void * userContext       = nullptr,
+                         const char * description = "",
+                         std::uint32_t flags      =  0,
+                         int minArgs              = -1,
+                         int maxArgs              = -1,
+                         std::uint32_t costHintMicros = 0) override;
+
+    bool registerCommand(const char * name,
+                         CommandHandlerDelegate handler,
+                         CommandArgCompletionDelegate completionHandler = nullptr,
+                         const char * description = "",
+                         std::uint32_t flags      =  0,
+                         int minArgs              = -1,
+                         int maxArgs              = -1,
+                         std::uint32_t costHintMicros = 0) override;
+
+    bool registerCommand(const char * name,
+                         CommandHandlerMemFunc handler,
+                         CommandHandlerMemFunc completionHandler = nullptr,
+                         const char * description = "",
+                         std::uint32_t flags      =  0,
+                         int minArgs              = -1,
+                         int maxArgs              = -1,
+                         std::uint32_t costHintMicros = 0) override;
+
+    bool registerInlineCommand(const char * name,
+                               CommandHandlerInline handler,
+                               CommandArgCompletionInline completionHandler = nullptr,
+                               const char * description = "",
+                               std::uint32_t flags      =  0,
+                               int minArgs              = -1,
+                               int maxArgs              = -1,
+                               std::uint32_t costHintMicros = 0) override;
+
+    bool createCommandAlias(const char * aliasName,
+                            const char * aliasedCmdStr,
+                            CommandExecMode execMode,
+                            const char * description = "") override;
+
+    void execNow(const char * str)    override;
+    void execInsert(const char * str) override;
+    void execAppend(const char * str) override;
+    void execute(CommandExecMode execMode, const char * str) override;
+    bool submitCommandText(const char * str) override;
+    int  execBufferedCommands(std::uint32_t maxCommandsToExec = ExecAll) override;
+    int  execBufferedCommandsForTime(std::uint32_t budgetMicroseconds,
+                                     std::uint32_t * outMicrosecondsUsed = nullptr,
+                                     int * outCommandsLeft = nullptr) override;
+    bool execConfigFile(const char * filename, SimpleCommandTerminal * term) override;
+    bool compileConfigFile(const char * filename) override;
+    bool execCompiledConfig(const char * filename, SimpleCommandTerminal * term) override;
+    void discardCompiledConfig(const char * filename) override;
+    int execConfigFiles(const char * const * filenames, int fileCount,
+                        SimpleCommandTerminal * term, int maxWorkerThreads = 0) override;
+    bool saveConfigSnapshot(const char * filename) override;
+    bool loadConfigSnapshot(const char * filename) override;
+    bool appendConfigJournal(const char * filename, int * outJournalEntries) override;
+    bool resetConfigJournal(const char * filename) override;
+    void execStartupCommandLine(int argc, const char * argv[]) override;
+    bool hasBufferedCommands() const override;
+    int getBufferedCommandsCount() const override;
+    void setCommandBufferSize(int maxSizeInChars) override;
+    int getCommandBufferSize() const override;
+
+    void setProfilingEnabled(bool enable) override;
+    bool isProfilingEnabled() const override;
+    void resetProfilingStats() override;
+    int getCommandProfiles(CommandProfile * outProfiles, int maxProfiles) const override;
+    CommandExecProfile getExecProfile() const override;
+
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    // Runs a precompiled alias string. See CommandImplAlias::onExecute().
+    void execCommandTemplate(CommandExecMode execMode, CommandTemplate * cmdTemplate);
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+private:
+
+    template<typename T>
+    int findWithPartialNameHelper(const char * partialName, T * outMatches,
+                                  int maxMatches, T (*pGetCmd)(Command *)) const;
+
+    void execTokenized(const CommandArgs & cmdArgs);
+    void execResolved(CommandImplBase * cmd, const CommandArgs & cmdArgs);
+    CommandImplBase * findCommandToExec(const char * cmdName, std::uint64_t * outLookupTime = nullptr) const;
+    void linkNewCommand(CommandImplBase * newCmd, const char * name);
+    bool registerCmdPreValidate(const char * cmdName) const;
+
+    bool extractNextCommand(const char ** outStr, char * destBuf, int destSizeInChars,
+                            bool * outOverflowed, CommandTemplate * outTemplate = nullptr) const;
+
+    // Loads the files of an execConfigFiles() call.
+    struct ConfigFilesLoader;
+
+    bool parseConfigFile(const char * filename, CompiledConfig * program) const;
+    void runCompiledConfig(CompiledConfig * program, SimpleCommandTerminal * term);
+    CompiledConfig * findCompiledConfig(const char * filename) const;
+    void releaseCompiledConfig(CompiledConfig * program);
+
+    bool pushCommandText(const char * str, bool atFront, const char * callerName,
+                         CommandTemplate * cmdTemplate = nullptr);
+    void reserveCommandText(int charsNeeded);
+    void reserveCommandQueue(int recordsNeeded);
+    void clearCommandQueue();
+    void drainSubmitQueue();
+
+    // Clock for execBufferedCommandsForTime(). Null 'deadline' runs with no time budget.
+    using ExecClock = std::chrono::steady_clock;
+    int execBufferedCommandsHelper(std::uint32_t maxCommandsToExec, const ExecClock::time_point * deadline);
+
+    // Publishes the CVar snapshot of the CVarManager, unless inside a command batch,
+    // which publishes it at the end. See CVarManager::publishCVarSnapshot().
+    void publishCVarSnapshot();
+
+    // Profiling timestamps in nanoseconds. They are zero while profiling is
+    // disabled, so the stats are left untouched by profileAddTime().
+    static std::uint64_t profileNow() noexcept
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          ExecClock::now().time_since_epoch()).count());
+    }
+    std::uint64_t profileTimestamp() const noexcept
+    {
+        return profilingEnabled ? profileNow() : 0;
+    }
+    static void profileAddTime(std::uint64_t * const counter, const std::uint64_t startTime) noexcept
+    {
+        if (startTime != 0)
+        {
+            *counter += profileNow() - startTime;
+        }
+    }
+
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    bool expandCVar(const char ** outStr, int * outCharsCopied, char * destBuf,
+                    int destSizeInChars, int recursionDepth) const;
+
+    CommandTemplate * compileCommandTemplate(const char * str) const;
+    bool resolveTemplateVarRef(CommandTemplate * cmdTemplate, CommandTemplate::VarRef * ref) const;
+    bool expandTemplateCommand(CommandTemplate * cmdTemplate, int commandIndex, char * destBuf,
+                               int destSizeInChars, bool * outOverflowed) const;
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+    //
+    // Hash function used to lookup command names in the HT.
+    // Can be case-sensitive or not.
+    //
+    #if CFG_COMMAND_CASE_SENSITIVE_NAMES
+    using CommandNameHasher  = StringHasher;
+    using CommandNameCompare = StringKeyCompare;
+    #else // !CFG_COMMAND_CASE_SENSITIVE_NAMES
+    using CommandNameHasher  = StringHasherNoCase;
+    using CommandNameCompare = StringKeyCompareNoCase;
+    #endif // CFG_COMMAND_CASE_SENSITIVE_NAMES
+
+    // The HashedName hash matching the CommandNameHasher.
+    static std::uint32_t hashOfName(const HashedName & name) noexcept
+    {
+        #if CFG_COMMAND_CASE_SENSITIVE_NAMES
+        return name.hash;
+        #else // !CFG_COMMAND_CASE_SENSITIVE_NAMES
+        return name.hashNoCase;
+        #endif // CFG_COMMAND_CASE_SENSITIVE_NAMES
+    }
+
+    // All the registered commands in a hash table for fast lookup by name.
+    LinkedHashTable<CommandImplBase, CommandNameHasher, CommandNameCompare> registeredCommands;
+
+    // The same commands by flag bit, for findCommandsWithFlags() and enumerateCommandsWithFlags().
+    FlagIndex<CommandImplBase> cmdFlagIndex;
+
+    // Storage for the Commands and alias strings if created with 'useMemoryArena'.
+    // memArena points to cmdArena in that case, or is null otherwise.
+    MemoryArena   cmdArena;
+    MemoryArena * memArena;
+
+    // Optional pointer to a CVarManager to provided CVar name expansion and command-style CVar updating.
+    CVarManagerImpl * cvarManager;
+
+    // Commands matching this set of flags will not be allowed to execute.
+    // Zero allows execution of all commands. 'DisableAll' prevents all commands from executing.
+    std::uint32_t disabledCmdFlags;
+
+    // Number of registered CommandImplAlias.
+    int cmdAliasCount;
+
+    // One buffered command. The text is null terminated and
+    // lives in cmdText, 'length' including the terminator.
+    struct CommandTextRecord
+    {
+        int offset;
+        int length;
+        #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        CommandTemplate * cmdTemplate; // Set if the command came from a precompiled alias. Holds a reference.
+        int templateCommand;           // Index in CommandTemplate::commands.
+        #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    };
+
+    // Buffered commands, in execution order. A ring of records so
+    // popping from the front and execInsert() are both O(1) per command.
+    // Capacity is always a power of two.
+    CommandTextRecord * cmdQueue;
+    int cmdQueueCapacity;
+    int cmdQueueHead;
+    int cmdQueueCount;
+
+    // Text storage for the buffered commands. New text always goes at the end;
+    // space of executed commands is reclaimed when the queue empties or when
+    // the live text gets repacked into a bigger buffer.
+    char * cmdText;
+    int cmdTextCapacity;
+    int cmdTextUsed; // Chars used at the end of cmdText, including dead text.
+    int cmdTextLive; // Chars of commands still in the queue.
+
+    // Limit on cmdTextLive. Defaults to CommandBufferSize.
+    int cmdBufferMaxSize;
+
+    // Text from submitCommandText(), moved to the command buffer by execBufferedCommands().
+    CommandSubmitQueue submitQueue;
+
+    // Incremented every time a command is removed, so compiled configs know to resolve their Command pointers again.
+    std::uint32_t cmdRemovalGeneration;
+
+    // Cache of compileConfigFile() programs. Usually just a handful, so a linear search by filename is fine.
+    MemVector<CompiledConfig *, MemoryCategory::CommandBuffer> compiledConfigs;
+
+    // See setProfilingEnabled(). Per command stats are kept by the CommandImplBase.
+    bool profilingEnabled;
+    mutable CommandExecProfile execProfile;
+
+    // Nesting of execBufferedCommands() calls. The CVar snapshot is published by the outermost.
+    int execBatchDepth;
+
+    // Entry count of the last journal written by appendConfigJournal(), so it is only
+    // read back once. Null filename if no journal is tracked. See resetConfigJournal().
+    char * journalFilename;
+    int journalEntries;
+};
+
+// ========================================================
+// CommandManagerImpl implementation:
+// ========================================================
+
+CommandManager * CommandManager::createInstance(const int cmdHashTableSizeHint, CVarManager * cvarMgr,
+                                               const bool useMemoryArena)
+{
+    auto cmdManager = memAlloc<CommandManagerImpl>(1);
+    return construct(cmdManager, cmdHashTableSizeHint, cvarMgr, useMemoryArena);
+}
+
+void CommandManager::destroyInstance(CommandManager * cmdManager)
+{
+    destroy(cmdManager);
+    memFree(cmdManager);
+}
+
+CommandManagerImpl::CommandManagerImpl(const int hashTableSize, CVarManager * cvarMgr, const bool useMemoryArena)
+    : memArena(useMemoryArena ? &cmdArena : nullptr)
+    , cvarManager(static_cast<CVarManagerImpl *>(cvarMgr))
+    , disabledCmdFlags(0)
+    , cmdAliasCount(0)
+    , cmdQueue(nullptr)
+    , cmdQueueCapacity(0)
+    , cmdQueueHead(0)
+    , cmdQueueCount(0)
+    , cmdText(nullptr)
+    , cmdTextCapacity(0)
+    , cmdTextUsed(0)
+    , cmdTextLive(0)
+    , cmdBufferMaxSize(CommandBufferSize)
+    , cmdRemovalGeneration(0)
+    , profilingEnabled(false)
+    , execProfile()
+    , execBatchDepth(0)
+    , journalFilename(nullptr)
+    , journalEntries(0)
+{
+    if (hashTableSize > 0)
+    {
+        registeredCommands.allocate(hashTableSize);
+    }
+}
+
+CommandManagerImpl::~CommandManagerImpl()
+{
+    clearCommandQueue();
+    memFree(cmdQueue);
+    memFree(cmdText);
+    discardCompiledConfig(nullptr);
+    memFree(journalFilename);
+
+    auto cmd = registeredCommands.getFirst();
+    while (cmd != nullptr)
+    {
+        auto temp = cmd->getNext();
+        destroy(cmd);
+        memFree(memArena, cmd);
+        cmd = temp;
+    }
+}
+
+Command * CommandManagerImpl::findCommand(const char * const name) const
+{
+    if (name == nullptr || *name == '\0')
+    {
+        return nullptr;
+    }
+    return registeredCommands.findByKey(name);
+}
+
+Command * CommandManagerImpl::findCommand(const HashedName & name) const
+{
+    if (name.name == nullptr || *name.name == '\0')
+    {
+        return nullptr;
+    }
+    return registeredCommands.findByKey(name.name, hashOfName(name));
+}
+
+int CommandManagerImpl::findCommandsWithPartialName(const char * const partialName,
+                                                    Command ** outMatches, const int maxMatches) const
+{
+    return findWithPartialNameHelper<Command *>(partialName, outMatches, maxMatches,
+                                                [](Command * cmd) { return cmd; });
+}
+
+int CommandManagerImpl::findCommandsWithPartialName(const char * const partialName,
+                                                    const char ** outMatches, const int maxMatches) const
+{
+    return findWithPartialNameHelper<const char *>(partialName, outMatches, maxMatches,
+                                                   [](Command * cmd) { return cmd->getNameCString(); });
+}
+
+int CommandManagerImpl::findCommandsWithFlags(const std::uint32_t flags,
+                                              Command ** outMatches, const int maxMatches) const
+{
+    if (flags == 0)
+    {
+        return 0;
+    }
+    else if (outMatches == nullptr || maxMatches <= 0)
+    {
+        return -1;
+    }
+
+    int matchesFound = 0;
+    cmdFlagIndex.forEachWithFlags(flags,
+            [outMatches, maxMatches, &matchesFound](CommandImplBase * cmd)
+            {
+                if (matchesFound < maxMatches)
+                {
+                    outMatches[matchesFound] = cmd;
+                }
+                ++matchesFound; // Keep incrementing even if outMatches[] is full,
+                                // so the caller can know the total num found.
+                return true;
+            });
+
+    if (matchesFound > 0)
+    {
+        // Output will be sorted alphabetically.
+        cmdSortMatches(outMatches, std::min(matchesFound, maxMatches));
+    }
+    return matchesFound;
+}
+
+template<typename T>
+int CommandManagerImpl::findWithPartialNameHelper(const char * const partialName, T * outMatches,
+                                                  const int maxMatches, T (*pGetCmd)(Command *)) const
+{
+    if (partialName == nullptr || *partialName == '\0')
+    {
+        return 0;
+    }
+    else if (outMatches == nullptr || maxMatches <= 0)
+    {
+        return -1;
+    }
+
+    // The sorted name index gives us the matches already in alphabetical order.
+    return registeredCommands.findByPrefix(partialName, maxMatches,
+                                           [outMatches, pGetCmd](CommandImplBase * cmd, const int index)
+                                           {
+                                               outMatches[index] = pGetCmd(cmd);
+                                           });
+}
+
+bool CommandManagerImpl::removeCommand(const char * const name)
+{
+    if (!isValidCommandName(name))
+    {
+        return errorF("'%s' is not a valid command name! Nothing to remove.", name);
+    }
+
+    auto cmd = registeredCommands.unlinkByKey(name);
+    if (cmd == nullptr)
+    {
+        return false; // No such command/alias.
+    }
+
+    cmdFlagIndex.remove(cmd);
+    destroy(cmd);
+    memFree(memArena, cmd);
+    ++cmdRemovalGeneration;
+    return true;
+}
+
+bool CommandManagerImpl::removeCommand(Command * cmd)
+{
+    if (cmd == nullptr)
+    {
+        return false;
+    }
+    return removeCommand(cmd->getNameCString());
+}
+
+bool CommandManagerImpl::removeCommandAlias(const char * const aliasName)
+{
+    if (!isValidCommandName(aliasName))
+    {
+        return false;
+    }
+
+    const auto cmd = registeredCommands.findByKey(aliasName);
+    if (cmd == nullptr || !cmd->isAlias())
+    {
+        return false;
+    }
+
+    if (!removeCommand(aliasName))
+    {
+        return false;
+    }
+
+    --cmdAliasCount;
+    return true;
+}
+
+void CommandManagerImpl::removeAllCommands()
+{
+    auto cmd = registeredCommands.getFirst();
+    while (cmd != nullptr)
+    {
+        auto temp = cmd->getNext();
+        destroy(cmd);
+        memFree(memArena, cmd);
+        cmd = temp;
+    }
+    registeredCommands.deallocate();
+    cmdFlagIndex.clear();
+    ++cmdRemovalGeneration;
+
+    // Every command is gone, so the blocks can be released wholesale.
+    if (memArena != nullptr)
+    {
+        memArena->releaseAll();
+    }
+}
+
+void CommandManagerImpl::removeAllCommandAliases()
+{
+    std::vector<CommandImplBase *> aliases;
+
+    for (auto cmd = registeredCommands.getFirst(); cmd; cmd = cmd->getNext())
+    {
+        if (cmd->isAlias())
+        {
+            aliases.push_back(cmd);
+        }
+    }
+
+    for (auto alias : aliases)
+    {
+        removeCommand(alias);
+    }
+
+    cmdAliasCount = 0;
+}
+
+int CommandManagerImpl::getRegisteredCommandsCount() const
+{
+    return registeredCommands.getSize();
+}
+
+int CommandManagerImpl::getCommandAliasCount() const
+{
+    return cmdAliasCount;
+}
+
+bool CommandManagerImpl::isValidCommandName(const char * const name) const
+{
+    //
+    // Command names follow the C++ variable naming rules,
+    // that is, cannot start with a number, cannot contain
+    // white spaces, cannot start with nor contain any special
+    // characters or punctuation, except for the underscore.
+    //
+    if (name == nullptr || *name == '\0')
+    {
+        return false;
+    }
+
+    int i = 0;
+    int c = name[i++];
+
+    // Must start with a letter or an underscore:
+    if ((c < 'a' || c > 'z') && (c < 'A' || c > 'Z') && (c != '_'))
+    {
+        return false;
+    }
+
+    while (name[i] != '\0')
+    {
+        c = name[i++];
+
+        // If not a number, lower or upper case letter
+        // and not an underscore it's not a valid command name.
+        if ((c < '0' || c > '9') &&
+            (c < 'a' || c > 'z') &&
+            (c < 'A' || c > 'Z') &&
+            (c != '_'))
+        {
+            return false;
+        }
+    }
+
+    // Lastly, must comply to our fixed max name length.
+    if (i >= MaxCommandNameLength)
+    {
+        return false;
+    }
+    return true;
+}
+
+void CommandManagerImpl::enumerateAllCommands(CommandEnumerateCallback enumCallback, void * userContext)
+{
+    CFG_ASSERT(enumCallback != nullptr);
+    for (auto cmd = registeredCommands.getFirst(); cmd; cmd = cmd->getNext())
+    {
+        if (!enumCallback(cmd, userContext))
+        {
+            return;
+        }
+    }
+}
+
+int CommandManagerImpl::enumerateCommandsWithFlags(const std::uint32_t flags, CommandEnumerateCallback enumCallback, void * userContext)
+{
+    CFG_ASSERT(enumCallback != nullptr);
+    if (flags == 0)
+    {
+        return 0;
+    }
+    return cmdFlagIndex.forEachWithFlags(flags,
+            [enumCallback, userContext](CommandImplBase * cmd) { return enumCallback(cmd, userContext); });
+}
+
+void CommandManagerImpl::disableCommandsWithFlags(const std::uint32_t flags)
+{
+    disabledCmdFlags = flags;
+}
+
+void CommandManagerImpl::enableAllCommands()
+{
+    disabledCmdFlags = 0;
+}
+
+CVarManager * CommandManagerImpl::getCVarManager() const
+{
+    return cvarManager;
+}
+
+void CommandManagerImpl::setCVarManager(CVarManager * cvarMgr)
+{
+    cvarManager = static_cast<CVarManagerImpl *>(cvarMgr);
+}
+
+void CommandManagerImpl::linkNewCommand(CommandImplBase * newCmd, const char * const name)
+{
+    newCmd->flagIndex = &cmdFlagIndex;
+    registeredCommands.linkWithKey(newCmd, name);
+    cmdFlagIndex.update(newCmd);
+}
+
+bool CommandManagerImpl::registerCmdPreValidate(const char * const cmdName) const
+{
+    if (!isValidCommandName(cmdName))
+    {
+        return errorF("Bad command name '%s'! Can't register it.", cmdName);
+    }
+    if (findCommand(cmdName)) // No duplicates allowed.
+    {
+        return errorF("Command '%s' already registered! Duplicate commands are not allowed.", cmdName);
+    }
+    if ((cvarManager != nullptr) && cvarManager->findCVar(cmdName)) // Avoid Cmd/CVar name ambiguities.
+    {
+        return errorF("A CVar named '%s' already exists. Cannot declare a new command with this name!", cmdName);
+    }
+    return true;
+}
+
+bool CommandManagerImpl::registerCommand(const char * const name,
+                                         CommandHandlerCallback handler,
+                                         CommandArgCompletionCallback completionHandler,
+                                         void * userContext,
+                                         const char * const description,
+                                         const std::uint32_t flags,
+                                         const int minArgs,
+                                         const int maxArgs,
+                                         const std::uint32_t costHintMicros)
+{
+    if (handler == nullptr)
+    {
+        return errorF("No command handler provided!");
+    }
+    if (!registerCmdPreValidate(name))
+    {
+        return false;
+    }
+
+    auto newCmd = memAlloc<CommandImplCallbacks>(memArena, 1, MemoryCategory::Commands);
+    construct(newCmd, name, description, flags, minArgs, maxArgs, handler, completionHandler, userContext);
+    newCmd->setCostHintMicros(costHintMicros);
+
+    linkNewCommand(newCmd, name);
+    return true;
+}
+
+bool CommandManagerImpl::registerCommand(const char * const name,
+                                         CommandHandlerDelegate handler,
+                                         CommandArgCompletionDelegate completionHandler,
+                                         const char * const description,
+                                         const std::uint32_t flags,
+                                         const int minArgs,
+                                         const int maxArgs,
+                                         const std::uint32_t costHintMicros)
+{
+    if (handler == nullptr)
+    {
+        return errorF("No command handler provided!");
+    }
+    if (!registerCmdPreValidate(name))
+    {
+        return false;
+    }
+
+    auto newCmd = memAlloc<CommandImplDelegates>(memArena, 1, MemoryCategory::Commands);
+    construct(newCmd, name, description, flags, minArgs, maxArgs,
+              std::move(handler), std::move(completionHandler));
+    newCmd->setCostHintMicros(costHintMicros);
+
+    linkNewCommand(newCmd, name);
+    return true;
+}
+
+bool CommandManagerImpl::registerCommand(const char * const name,
+                                         CommandHandlerMemFunc handler,
+                                         CommandHandlerMemFunc completionHandler,
+                                         const char * const description,
+                                         const std::uint32_t flags,
+                                         const int minArgs,
+                                         const int maxArgs,
+                                         const std::uint32_t costHintMicros)
+{
+    if (handler == nullptr)
+    {
+        return errorF("No command handler provided!");
+    }
+    if (!registerCmdPreValidate(name))
+    {
+        return false;
+    }
+
+    auto newCmd = memAlloc<CommandImplMemberFuncs>(memArena, 1, MemoryCategory::Commands);
+    construct(newCmd, name, description, flags, minArgs, maxArgs, handler, completionHandler);
+    newCmd->setCostHintMicros(costHintMicros);
+
+    linkNewCommand(newCmd, name);
+    return true;
+}
+
+bool CommandManagerImpl::registerInlineCommand(const char * const name,
+                                               CommandHandlerInline handler,
+                                               CommandArgCompletionInline completionHandler,
+                                               const char * const description,
+                                               const std::uint32_t flags,
+                                               const int minArgs,
+                                               const int maxArgs,
+                                               const std::uint32_t costHintMicros)
+{
+    if (handler == nullptr)
+    {
+        return errorF("No command handler provided!");
+    }
+    if (!registerCmdPreValidate(name))
+    {
+        return false;
+    }
+
+    auto newCmd = memAlloc<CommandImplInline>(memArena, 1, MemoryCategory::Commands);
+    construct(newCmd, name, description, flags, minArgs, maxArgs, handler, completionHandler);
+    newCmd->setCostHintMicros(costHintMicros);
+
+    linkNewCommand(newCmd, name);
+    return true;
+}
+
+bool CommandManagerImpl::createCommandAlias(const char * const aliasName,
+                                            const char * const aliasedCmdStr,
+                                            const CommandExecMode execMode,
+                                            const char * const description)
+{
+    if (aliasedCmdStr == nullptr || *aliasedCmdStr == '\0')
+    {
+        return errorF("Can't create a command alias for an empty/null string!");
+    }
+    if (!isValidCommandName(aliasName))
+    {
+        return errorF("'%s' is not a valid alias or command name!", aliasName);
+    }
+    if (findCommand(aliasName))
+    {
+        return errorF("A command or alias named '%s' already exists!", aliasName);
+    }
+    if ((cvarManager != nullptr) && cvarManager->findCVar(aliasName))
+    {
+        return errorF("A CVar named '%s' already exists. Cannot declare a new command alias with this name!", aliasName);
+    }
+
+    CommandTemplate * cmdTemplate = nullptr;
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    if (std::strstr(aliasedCmdStr, "$(") != nullptr)
+    {
+        cmdTemplate = compileCommandTemplate(aliasedCmdStr);
+    }
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+    auto newCmd = memAlloc<CommandImplAlias>(memArena, 1, MemoryCategory::Commands);
+    construct(newCmd, aliasName, description, aliasedCmdStr, execMode, this, cmdTemplate, memArena);
+
+    linkNewCommand(newCmd, aliasName);
+    ++cmdAliasCount;
+
+    return true;
+}
+
+void CommandImplAlias::onExecute(const CommandArgs & /* args */)
+{
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    if (cmdTemplate != nullptr)
+    {
+        manager->execCommandTemplate(execMode, cmdTemplate);
+        return;
+    }
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    manager->execute(execMode, targetCommand);
+}
+
+void CommandManagerImpl::execNow(const char * str)
+{
+    CFG_ASSERT(str != nullptr);
+    if (*str == '\0')
+    {
+        return;
+    }
+
+    // Input string might consist of multiple commands.
+    // Split it up and handle each command separately.
+    bool overflowed;
+    char tempBuffer[MaxCommandArgStrLength];
+    for (;;)
+    {
+        const std::uint64_t parseStart = profileTimestamp();
+        const bool gotCommand = extractNextCommand(&str, tempBuffer, lengthOfArray(tempBuffer), &overflowed);
+        profileAddTime(&execProfile.parseTime, parseStart);
+
+        if (!gotCommand)
+        {
+            break;
+        }
+        if (overflowed)
+        {
+            // Malformed command line that won't fit in our buffers.
+            // Discard the rest of the string.
+            errorF("Discarding rest of command line due to malformed string...");
+            break;
+        }
+
+        // Tokenize the command string, separating command name and splitting the args, then we can run it.
+        // The temp buffer is ours, so tokenize it in-place to avoid copying the args a second time.
+        CommandArgs cmdArgs;
+        const std::uint64_t tokenizeStart = profileTimestamp();
+        cmdArgs.tokenizeInPlace(tempBuffer);
+        profileAddTime(&execProfile.tokenizeTime, tokenizeStart);
+        execTokenized(cmdArgs);
+    }
+}
+
+void CommandManagerImpl::execInsert(const char * const str)
+{
+    CFG_ASSERT(str != nullptr);
+    if (*str == '\0')
+    {
+        return;
+    }
+    pushCommandText(str, /* atFront = */ true, "execInsert");
+}
+
+void CommandManagerImpl::execAppend(const char * const str)
+{
+    CFG_ASSERT(str != nullptr);
+    if (*str == '\0')
+    {
+        return;
+    }
+    pushCommandText(str, /* atFront = */ false, "execAppend");
+}
+
+void CommandManagerImpl::execute(const CommandExecMode execMode, const char * const str)
+{
+    switch (execMode)
+    {
+    case CommandExecMode::Immediate :
+        execNow(str);
+        break;
+    case CommandExecMode::Insert :
+        execInsert(str);
+        break;
+    case CommandExecMode::Append :
+        execAppend(str);
+        break;
+    default :
+        errorF("Invalid CommandExecMode enum value!");
+    } // switch (execMode)
+}
+
+bool CommandManagerImpl::execConfigFile(const char * const filename, SimpleCommandTerminal * term)
+{
+    FileIOCallbacks * io = getFileIOCallbacks();
+
+    FileHandle fileIn;
+    if (!io->open(&fileIn, filename, FileOpenMode::Read))
+    {
+        return false;
+    }
+
+    int  lineNum = 0;
+    char line[MaxCommandArgStrLength];
+    FileLineReader lineReader(io, fileIn);
+
+    // Scan the file line-by-line:
+    while (lineReader.readLine(line, lengthOfArray(line)))
+    {
+        ++lineNum;
+
+        // Skip blank lines and comments ('#')
+        if (line[0] == '\0' || line[0] == '\n' || line[0] == '#')
+        {
+            continue;
+        }
+        // Allow C++-style single-line comments inside config files.
+        else if (line[0] == '/' && line[1] == '/')
+        {
+            continue;
+        }
+
+        if (term != nullptr)
+        {
+            // Echo current line to console, adding source file and line number:
+            const int lastChar = lengthOfString(line) - 1;
+            if (line[lastChar] == '\n')
+            {
+                line[lastChar] = '\0'; // Get rid of the extra '\n'. We add one by default.
+            }
+            term->printF("%s(%i): %s\n", filename, lineNum, line);
+        }
+
+        // Execute immediately:
+        execNow(line);
+    }
+
+    lineReader.release();
+    io->close(fileIn);
+    publishCVarSnapshot();
+    return true;
+}
+
+bool CommandManagerImpl::compileConfigFile(const char * const filename)
+{
+    CFG_ASSERT(filename != nullptr);
+
+    auto program = memAlloc<CompiledConfig>(1, MemoryCategory::CommandBuffer);
+    construct(program);
+
+    if (!parseConfigFile(filename, program))
+    {
+        destroy(program);
+        memFree(program);
+        return false;
+    }
+
+    // Replaces any existing program for the same file.
+    if (CompiledConfig * oldProgram = findCompiledConfig(filename))
+    {
+        releaseCompiledConfig(oldProgram);
+    }
+
+    program->resolvedGeneration = cmdRemovalGeneration;
+    compiledConfigs.push_back(program);
+    return true;
+}
+
+bool CommandManagerImpl::execCompiledConfig(const char * const filename, SimpleCommandTerminal * term)
+{
+    CFG_ASSERT(filename != nullptr);
+
+    CompiledConfig * program = findCompiledConfig(filename);
+    if (program == nullptr)
+    {
+        if (!compileConfigFile(filename))
+        {
+            return false;
+        }
+        program = compiledConfigs.back();
+    }
+
+    ++program->activeRuns;
+    runCompiledConfig(program, term);
+
+    if (--program->activeRuns == 0 && program->discarded)
+    {
+        destroy(program);
+        memFree(program);
+    }
+
+    publishCVarSnapshot();
+    return true;
+}
+
+void CommandManagerImpl::runCompiledConfig(CompiledConfig * const program, SimpleCommandTerminal * term)
+{
+    CommandArgs cmdArgs;
+    for (CompiledConfig::Op & op : program->ops)
+    {
+        // Checked for every command, since a handler might also remove commands.
+        if (program->resolvedGeneration != cmdRemovalGeneration)
+        {
+            for (CompiledConfig::Op & other : program->ops)
+            {
+                other.cmd = nullptr;
+            }
+            program->resolvedGeneration = cmdRemovalGeneration;
+        }
+
+        if (term != nullptr && op.echoText >= 0)
+        {
+            // Echo current line to console, adding source file and line number:
+            term->printF("%s(%i): %s\n", program->filename.c_str(), op.lineNum, &program->chars[op.echoText]);
+        }
+
+        if (op.deferredText >= 0)
+        {
+            execNow(&program->chars[op.deferredText]);
+            continue;
+        }
+
+        const char * const * tokens = &program->tokens[op.firstToken];
+        if (op.cmd == nullptr)
+        {
+            op.cmd = findCommandToExec(tokens[0]);
+            if (op.cmd == nullptr)
+            {
+                continue;
+            }
+        }
+
+        cmdArgs.setTokens(tokens[0], tokens + 1, program->tokenLengths.data() + op.firstToken + 1, op.argCount);
+        execResolved(op.cmd, cmdArgs);
+    }
+}
+
+//
+// Shared by the threads of an execConfigFiles() call. Files are claimed
+// in list order by whichever thread is free, the calling thread included,
+// so loading never waits on a file that nobody has started.
+//
+struct CommandManagerImpl::ConfigFilesLoader final
+{
+    enum Status : int { Pending, Loaded, Failed };
+
+    const CommandManagerImpl * cmdManager;
+    const char * const *       filenames;
+    CompiledConfig *           programs;
+    std::atomic<int> *         status;
+    std::atomic<int>           nextFile;
+    int                        fileCount;
+
+    #if CFG_PARALLEL_CONFIG_LOADING
+    std::mutex                 mutex;
+    std::condition_variable    fileDone;
+    #endif // CFG_PARALLEL_CONFIG_LOADING
+
+    // Loads the next unclaimed file. False if all were claimed.
+    bool loadNext();
+
+    // Called on the calling thread. Returns once the file is Loaded or Failed.
+    bool waitFor(int index);
+};
+
+bool CommandManagerImpl::ConfigFilesLoader::loadNext()
+{
+    const int index = nextFile.fetch_add(1, std::memory_order_relaxed);
+    if (index >= fileCount)
+    {
+        return false;
+    }
+
+    const bool loaded = cmdManager->parseConfigFile(filenames[index], &programs[index]);
+
+    #if CFG_PARALLEL_CONFIG_LOADING
+    std::lock_guard<std::mutex> lock{ mutex };
+    #endif // CFG_PARALLEL_CONFIG_LOADING
+
+    status[index].store(loaded ? Loaded : Failed, std::memory_order_release);
+
+    #if CFG_PARALLEL_CONFIG_LOADING
+    fileDone.notify_all();
+    #endif // CFG_PARALLEL_CONFIG_LOADING
+
+    return true;
+}
+
+bool CommandManagerImpl::ConfigFilesLoader::waitFor(const int index)
+{
+    // Help with the loading while the file is not ready.
+    while (status[index].load(std::memory_order_acquire) == Pending)
+    {
+        if (!loadNext())
+        {
+            #if CFG_PARALLEL_CONFIG_LOADING
+            // Everything claimed, so a worker has it.
+            std::unique_lock<std::mutex> lock{ mutex };
+            fileDone.wait(lock, [this, index]() {
+                return status[index].load(std::memory_order_acquire) != Pending;
+            });
+            #endif // CFG_PARALLEL_CONFIG_LOADING
+        }
+    }
+    return status[index].load(std::memory_order_acquire) == Loaded;
+}
+
+int CommandManagerImpl::execConfigFiles(const char * const * const filenames, const int fileCount,
+                                        SimpleCommandTerminal * term, const int maxWorkerThreads)
+{
+    CFG_ASSERT(filenames != nullptr);
+    if (fileCount <= 0)
+    {
+        return 0;
+    }
+
+    // The workers fill these in, allocating as they parse (see MemoryAllocCallbacks).
+    auto programs = memAlloc<CompiledConfig>(fileCount, MemoryCategory::CommandBuffer);
+    auto status   = memAlloc<std::atomic<int>>(fileCount, MemoryCategory::CommandBuffer);
+    for (int i = 0; i < fileCount; ++i)
+    {
+        construct(&programs[i]);
+        construct(&status[i], static_cast<int>(ConfigFilesLoader::Pending));
+    }
+
+    ConfigFilesLoader loader;
+    loader.cmdManager = this;
+    loader.filenames  = filenames;
+    loader.programs   = programs;
+    loader.status     = status;
+    loader.fileCount  = fileCount;
+    loader.nextFile.store(0, std::memory_order_relaxed);
+
+    #if CFG_PARALLEL_CONFIG_LOADING
+    // The calling thread also loads files, so one less worker than the hardware threads.
+    int workerCount = (maxWorkerThreads > 0) ? maxWorkerThreads :
+                      static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    workerCount = std::max(0, std::min(workerCount, fileCount - 1));
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i)
+    {
+        workers.emplace_back([&loader]() {
+            while (loader.loadNext()) { }
+        });
+    }
+    #else // !CFG_PARALLEL_CONFIG_LOADING
+    (void)maxWorkerThreads;
+    #endif // CFG_PARALLEL_CONFIG_LOADING
+
+    // Commands only ever run here, in list order, so later files still override earlier ones.
+    int filesLoaded = 0;
+    for (int i = 0; i < fileCount; ++i)
+    {
+        if (loader.waitFor(i))
+        {
+            programs[i].resolvedGeneration = cmdRemovalGeneration;
+            runCompiledConfig(&programs[i], term);
+            ++filesLoaded;
+        }
+
+        // Free as we go. Workers never touch a file once it is done.
+        destroy(&programs[i]);
+    }
+
+    #if CFG_PARALLEL_CONFIG_LOADING
+    for (std::thread & worker : workers)
+    {
+        worker.join();
+    }
+    #endif // CFG_PARALLEL_CONFIG_LOADING
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        destroy(&status[i]);
+    }
+    memFree(status);
+    memFree(programs);
+
+    publishCVarSnapshot();
+    return filesLoaded;
+}
+
+void CommandManagerImpl::discardCompiledConfig(const char * const filename)
+{
+    if (filename == nullptr)
+    {
+        while (!compiledConfigs.empty())
+        {
+            releaseCompiledConfig(compiledConfigs.back());
+        }
+    }
+    else if (CompiledConfig * program = findCompiledConfig(filename))
+    {
+        releaseCompiledConfig(program);
+    }
+}
+
+CompiledConfig * CommandManagerImpl::findCompiledConfig(const char * const filename) const
+{
+    for (CompiledConfig * program : compiledConfigs)
+    {
+        if (program->filename == filename)
+        {
+            return program;
+        }
+    }
+    return nullptr;
+}
+
+void CommandManagerImpl::releaseCompiledConfig(CompiledConfig * const program)
+{
+    compiledConfigs.erase(std::find(compiledConfigs.begin(), compiledConfigs.end(), program));
+
+    // If still running, the last execCompiledConfig() frees it.
+    if (program->activeRuns > 0)
+    {
+        program->discarded = true;
+        return;
+    }
+
+    destroy(program);
+    memFree(program);
+}
+
+bool CommandManagerImpl::parseConfigFile(const char * const filename, CompiledConfig * const program) const
+{
+    FileIOCallbacks * io = getFileIOCallbacks();
+
+    FileHandle fileIn;
+    if (!io->open(&fileIn, filename, FileOpenMode::Read))
+    {
+        return false;
+    }
+
+    program->filename = filename;
+
+    bool overflowed;
+    int  lineNum = 0;
+    char line[MaxCommandArgStrLength];
+    char tempBuffer[MaxCommandArgStrLength];
+    FileLineReader lineReader(io, fileIn);
+
+    // Same line-by-line rules of execConfigFile():
+    while (lineReader.readLine(line, lengthOfArray(line)))
+    {
+        ++lineNum;
+
+        // Skip blank lines and comments ('#' or '//')
+        if (line[0] == '\0' || line[0] == '\n' || line[0] == '#' || (line[0] == '/' && line[1] == '/'))
+        {
+            continue;
+        }
+
+        int lineLength = lengthOfString(line);
+        if (line[lineLength - 1] == '\n')
+        {
+            line[--lineLength] = '\0';
+        }
+
+        int echoText = program->addString(line, lineLength);
+
+        #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        // Expansions depend on the CVar values at the time the line runs.
+        if (std::strstr(line, "$(") != nullptr)
+        {
+            CompiledConfig::Op op{};
+            op.lineNum      = lineNum;
+            op.echoText     = echoText;
+            op.deferredText = echoText;
+            program->ops.push_back(op);
+            continue;
+        }
+        #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+        const char * str = line;
+        while (extractNextCommand(&str, tempBuffer, lengthOfArray(tempBuffer), &overflowed))
+        {
+            if (overflowed)
+            {
+                errorF("%s(%i): Discarding rest of command line due to malformed string...", filename, lineNum);
+                break;
+            }
+
+            CommandArgs cmdArgs;
+            cmdArgs.tokenizeInPlace(tempBuffer);
+            if (cmdArgs.getCommandName() == nullptr)
+            {
+                continue;
+            }
+
+            CompiledConfig::Op op{};
+            op.lineNum      = lineNum;
+            op.echoText     = echoText;
+            op.deferredText = -1;
+            op.firstToken   = static_cast<int>(program->tokenLengths.size());
+            op.argCount     = cmdArgs.getArgCount();
+            program->ops.push_back(op);
+
+            program->addToken(cmdArgs.getCommandName(), lengthOfString(cmdArgs.getCommandName()));
+            for (int i = 0; i < cmdArgs.getArgCount(); ++i)
+            {
+                program->addToken(cmdArgs[i], cmdArgs.getArgLength(i));
+            }
+
+            // Only echoed once per line.
+            echoText = -1;
+        }
+    }
+
+    lineReader.release();
+    io->close(fileIn);
+    program->finalize();
+    return true;
+}
+
+bool CommandManagerImpl::saveConfigSnapshot(const char * const filename)
+{
+    CFG_ASSERT(filename != nullptr);
+    if (cvarManager == nullptr)
+    {
+        return errorF("No CVarManager set. Unable to write config snapshot.");
+    }
+
+    ConfigSnapshotHeader header{};
+    header.magic          = ConfigSnapshotMagic;
+    header.version        = ConfigSnapshotVersion;
+    header.schemaChecksum = cvarManager->getSnapshotSchemaChecksum();
+
+    std::string data;
+    header.cvarCount = cvarManager->writeSnapshotCVars(&data);
+
+    for (auto cmd = registeredCommands.getFirst(); cmd != nullptr; cmd = cmd->getNext())
+    {
+        if (cmd->isAlias())
+        {
+            const auto alias = static_cast<const CommandImplAlias *>(cmd);
+            snapshotPut(&data, static_cast<std::uint8_t>(alias->getExecMode()));
+            for (const char * str : { alias->getNameCString(), alias->getTargetCommand(), alias->getDescCString() })
+            {
+                snapshotPut(&data, static_cast<std::uint32_t>(lengthOfString(str)));
+                data.append(str);
+            }
+            ++header.aliasCount;
+        }
+    }
+
+    FileIOCallbacks * io = getFileIOCallbacks();
+
+    FileHandle fileOut;
+    if (!io->open(&fileOut, filename, FileOpenMode::WriteBinary))
+    {
+        return false;
+    }
+
+    const bool written = io->writeBytes(fileOut, &header, sizeof(header)) &&
+                         io->writeBytes(fileOut, data.data(), data.size());
+    io->close(fileOut);
+
+    if (!written)
+    {
+        return errorF("Failed to write config snapshot \"%s\".", filename);
+    }
+    return true;
+}
+
+bool CommandManagerImpl::loadConfigSnapshot(const char * const filename)
+{
+    CFG_ASSERT(filename != nullptr);
+    if (cvarManager == nullptr)
+    {
+        return errorF("No CVarManager set. Unable to load config snapshot.");
+    }
+
+    FileIOCallbacks * io = getFileIOCallbacks();
+
+    FileHandle fileIn;
+    if (!io->open(&fileIn, filename, FileOpenMode::ReadBinary))
+    {
+        return false;
+    }
+
+    const char * fileData = nullptr;
+    std::size_t  fileSize = 0;
+    if (!io->mapFile(fileIn, &fileData, &fileSize))
+    {
+        io->close(fileIn);
+        return errorF("Unable to map config snapshot \"%s\".", filename);
+    }
+
+    const char * data          = fileData;
+    const char * const dataEnd = fileData + fileSize;
+
+    ConfigSnapshotHeader header{};
+    bool succeeded = snapshotGet(&data, dataEnd, &header);
+
+    if (!succeeded || header.magic != ConfigSnapshotMagic || header.version != ConfigSnapshotVersion)
+    {
+        succeeded = errorF("\"%s\" is not a compatible config snapshot.", filename);
+    }
+    else if (header.schemaChecksum != cvarManager->getSnapshotSchemaChecksum())
+    {
+        succeeded = errorF("Config snapshot \"%s\" doesn't match the registered CVars.", filename);
+    }
+    else
+    {
+        succeeded = cvarManager->readSnapshotCVars(&data, dataEnd, header.cvarCount);
+
+        std::string aliasStrings[3]; // name, target command, description
+        for (std::uint32_t a = 0; a < header.aliasCount; ++a)
+        {
+            std::uint8_t execMode = 0;
+            bool truncated = !snapshotGet(&data, dataEnd, &execMode);
+            for (std::string & str : aliasStrings)
+            {
+                std::uint32_t length = 0;
+                if (truncated || !snapshotGet(&data, dataEnd, &length) ||
+                    static_cast<std::size_t>(dataEnd - data) < length)
+                {
+                    truncated = true;
+                    break;
+                }
+                str.assign(data, length);
+                data += length;
+            }
+            if (truncated)
+            {
+                succeeded = errorF("Config snapshot is truncated!");
+                break;
+            }
+
+            // The snapshot replaces an existing alias with the same name.
+            removeCommandAlias(aliasStrings[0].c_str());
+            if (!createCommandAlias(aliasStrings[0].c_str(), aliasStrings[1].c_str(),
+                                    static_cast<CommandExecMode>(execMode), aliasStrings[2].c_str()))
+            {
+                succeeded = false;
+            }
+        }
+    }
+
+    io->unmapFile(fileIn, fileData);
+    io->close(fileIn);
+    publishCVarSnapshot();
+    return succeeded;
+}
+
+bool CommandManagerImpl::appendConfigJournal(const char * const filename, int * outJournalEntries)
+{
+    CFG_ASSERT(filename != nullptr);
+    if (cvarManager == nullptr)
+    {
+        return errorF("No CVarManager set. Unable to write config journal.");
+    }
+
+    FileIOCallbacks * io = getFileIOCallbacks();
+
+    FileHandle fileOut;
+    if (!io->open(&fileOut, filename, FileOpenMode::Append))
+    {
+        return false;
+    }
+
+    struct JournalWriter
+    {
+        FileIOCallbacks * io;
+        FileHandle        file;
+        int               entries;
+        bool              succeeded;
+    } writer{ io, fileOut, 0, true };
+
+    cvarManager->enumerateCVarsWithFlags(CVar::Flags::Modified,
+            [](CVar * cvar, void * userContext)
+            {
+                auto w = static_cast<JournalWriter *>(userContext);
+                if (cvar->isPersistent())
+                {
+                    auto var = static_cast<const CVarImplBase *>(cvar);
+
+                    char tempStr[MaxCommandArgStrLength];
+                    if (w->io->writeFormat(w->file, "%s\n", var->toCfgString(tempStr, MaxCommandArgStrLength)))
+                    {
+                        ++w->entries;
+                    }
+                    else
+                    {
+                        w->succeeded = false;
+                    }
+                }
+
+                // Same as a full save, the value is now in the persistent storage.
+                cvar->clearModified();
+                return true;
+            },
+            &writer);
+
+    io->close(fileOut);
+
+    if (!writer.succeeded)
+    {
+        // Unknown how much made it to the file, so count it again next time.
+        memFree(journalFilename);
+        journalFilename = nullptr;
+        return errorF("Failed to write config journal \"%s\".", filename);
+    }
+
+    //
+    // A journal not tracked yet is counted once, from what is in
+    // the file. From then on the appended entries are just added.
+    //
+    if (journalFilename != nullptr && std::strcmp(journalFilename, filename) == 0)
+    {
+        journalEntries += writer.entries;
+    }
+    else
+    {
+        FileHandle fileIn;
+        if (!io->open(&fileIn, filename, FileOpenMode::Read))
+        {
+            return false;
+        }
+
+        int entries = 0;
+        char lineBuffer[MaxCommandArgStrLength];
+        FileLineReader reader{ io, fileIn };
+        while (reader.readLine(lineBuffer, sizeof(lineBuffer)))
+        {
+            const int length = lengthOfString(lineBuffer);
+            if (length > 0 && lineBuffer[length - 1] == '\n')
+            {
+                ++entries;
+            }
+        }
+        reader.release();
+        io->close(fileIn);
+
+        memFree(journalFilename);
+        journalFilename = cloneString(filename);
+        journalEntries  = entries;
+    }
+
+    if (outJournalEntries != nullptr)
+    {
+        (*outJournalEntries) = journalEntries;
+    }
+    return true;
+}
+
+bool CommandManagerImpl::resetConfigJournal(const char * const filename)
+{
+    CFG_ASSERT(filename != nullptr);
+
+    // Truncated by opening it for writing.
+    FileIOCallbacks * io = getFileIOCallbacks();
+    FileHandle fileOut;
+    if (!io->open(&fileOut, filename, FileOpenMode::Write))
+    {
+        return false;
+    }
+    io->close(fileOut);
+
+    memFree(journalFilename);
+    journalFilename = cloneString(filename);
+    journalEntries  = 0;
+    return true;
+}
+
+void CommandManagerImpl::execStartupCommandLine(const int argc, const char * argv[])
+{
+    char   cmdline[MaxCommandArgStrLength] = {'\0'};
+    char * ptr     = cmdline;
+    int    length  = 0;
+    bool   setCmd  = false;
+
+    if (cvarManager != nullptr)
+    {
+        cvarManager->setAllowWritingInitOnlyVars(true);
+    }
+
+    // argv[0] assumed to be the program name.
+    for (int i = 1; i < argc; ++i)
+    {
+        const char * arg = argv[i];
+        if (*arg == '+')
+        {
+            if (length > 0)
+            {
+                if (setCmd)
+                {
+                    execNow(cmdline);
+                }
+                else
+                {
+                    execAppend(cmdline);
+                }
+            }
+
+            ++arg;
+            ptr = cmdline;
+            length = 0;
+
+            // 'set/reset' commands shall not be buffered when running the cmdline.
+            setCmd = (cmdCmpNames(arg, "set") == 0) || (cmdCmpNames(arg, "reset") == 0);
+        }
+
+        if ((lengthOfArray(cmdline) - length - 1) <= 0)
+        {
+            break;
+        }
+
+        const int written = copyString(ptr, lengthOfArray(cmdline) - length, arg);
+        ptr[written    ] = ' ';
+        ptr[written + 1] = '\0';
+
+        length += written + 1;
+        ptr    += written + 1;
+    }
+
+    if (length > 0)
+    {
+        if (setCmd)
+        {
+            execNow(cmdline);
+        }
+        else
+        {
+            execAppend(cmdline);
+        }
+    }
+
+    if (cvarManager != nullptr)
+    {
+        cvarManager->setAllowWritingInitOnlyVars(false);
+    }
+}
+
+bool CommandManagerImpl::submitCommandText(const char * const str)
+{
+    CFG_ASSERT(str != nullptr);
+    if (*str == '\0')
+    {
+        return true;
+    }
+    // Errors are only printed by the owning thread, once the rejections are noticed.
+    return submitQueue.push(str, lengthOfString(str));
+}
+
+void CommandManagerImpl::drainSubmitQueue()
+{
+    submitQueue.popAll([this](const char * const str)
+                       {
+                           pushCommandText(str, /* atFront = */ false, "submitCommandText");
+                       });
+
+    if (const std::uint32_t rejected = submitQueue.takeRejectedCount())
+    {
+        errorF("Buffer overflow! %u command strings rejected by CommandManager::submitCommandText()!", rejected);
+    }
+}
+
+int CommandManagerImpl::execBufferedCommands(const std::uint32_t maxCommandsToExec)
+{
+    return execBufferedCommandsHelper(maxCommandsToExec, nullptr);
+}
+
+int CommandManagerImpl::execBufferedCommandsForTime(const std::uint32_t budgetMicroseconds,
+                                                    std::uint32_t * const outMicrosecondsUsed,
+                                                    int * const outCommandsLeft)
+{
+    const ExecClock::time_point startTime = ExecClock::now();
+    const ExecClock::time_point deadline  = startTime + std::chrono::microseconds(budgetMicroseconds);
+
+    const int commandsExecuted = execBufferedCommandsHelper(ExecAll, &deadline);
+
+    if (outMicrosecondsUsed != nullptr)
+    {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(ExecClock::now() - startTime);
+        *outMicrosecondsUsed = static_cast<std::uint32_t>(elapsed.count());
+    }
+    if (outCommandsLeft != nullptr)
+    {
+        *outCommandsLeft = cmdQueueCount;
+    }
+    return commandsExecuted;
+}
+
+int CommandManagerImpl::execBufferedCommandsHelper(const std::uint32_t maxCommandsToExec,
+                                                   const ExecClock::time_point * const deadline)
+{
+    // Text from other threads goes after what was already buffered.
+    drainSubmitQueue();
+
+    if (cmdQueueCount == 0 || maxCommandsToExec == 0)
+    {
+        // The C++ code may have changed some CVars since the last batch.
+        publishCVarSnapshot();
+        return 0;
+    }
+
+    int commandsExecuted = 0;
+    ++execBatchDepth;
+
+    bool overflowed;
+    char tempBuffer[MaxCommandArgStrLength];
+
+    while (cmdQueueCount > 0)
+    {
+        // The first command always runs, so a tight budget still makes progress.
+        // Checked before parsing, since it doesn't depend on the command.
+        if (deadline != nullptr && commandsExecuted > 0 && ExecClock::now() >= *deadline)
+        {
+            break;
+        }
+
+        // Extracted before popping, so a command that doesn't fit its cost hint
+        // in the time budget can stay at the front of the queue. Its profile
+        // times are only added once it is popped, so they count only once.
+        std::uint64_t parseTime = 0, tokenizeTime = 0, lookupTime = 0;
+        const CommandTextRecord record = cmdQueue[cmdQueueHead];
+        const char * cmdStr = cmdText + record.offset;
+        const std::uint64_t parseStart = profileTimestamp();
+        #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        const bool gotCommand = (record.cmdTemplate != nullptr) ?
+            expandTemplateCommand(record.cmdTemplate, record.templateCommand, tempBuffer, lengthOfArray(tempBuffer), &overflowed) :
+            extractNextCommand(&cmdStr, tempBuffer, lengthOfArray(tempBuffer), &overflowed);
+        #else // !CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        const bool gotCommand = extractNextCommand(&cmdStr, tempBuffer, lengthOfArray(tempBuffer), &overflowed);
+        #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        profileAddTime(&parseTime, parseStart);
+
+        CommandArgs cmdArgs;
+        CommandImplBase * cmd = nullptr;
+        if (gotCommand && !overflowed)
+        {
+            const std::uint64_t tokenizeStart = profileTimestamp();
+            cmdArgs.tokenizeInPlace(tempBuffer);
+            profileAddTime(&tokenizeTime, tokenizeStart);
+
+            cmd = findCommandToExec(cmdArgs.getCommandName(), &lookupTime);
+
+            // Don't start a command known to be expensive if it would overrun the budget.
+            if (deadline != nullptr && commandsExecuted > 0 && cmd != nullptr && cmd->getCostHintMicros() != 0 &&
+                (ExecClock::now() + std::chrono::microseconds(cmd->getCostHintMicros())) > *deadline)
+            {
+                break;
+            }
+        }
+
+        execProfile.parseTime    += parseTime;
+        execProfile.tokenizeTime += tokenizeTime;
+        execProfile.lookupTime   += lookupTime;
+
+        //
+        // The command is popped from the queue before its handler runs,
+        // so execInsert/execAppend can be safely called from within a
+        // command handler. New text never overwrites the current command,
+        // which was already extracted into the temp buffer anyway.
+        //
+        cmdQueueHead = (cmdQueueHead + 1) & (cmdQueueCapacity - 1);
+        cmdTextLive -= record.length;
+        --cmdQueueCount;
+
+        #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        releaseCommandTemplate(record.cmdTemplate);
+        #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+        if (cmdQueueCount == 0)
+        {
+            clearCommandQueue();
+        }
+
+        if (overflowed)
+        {
+            // Malformed command line that won't fit in our buffers.
+            errorF("Discarding malformed command string...");
+            continue;
+        }
+        if (!gotCommand)
+        {
+            continue;
+        }
+
+        // Call the handler:
+        if (cmd != nullptr)
+        {
+            execResolved(cmd, cmdArgs);
+        }
+        ++commandsExecuted;
+
+        // If we have already executed a ludicrous number of commands,
+        // chances are there's a reentrant command in the buffer that
+        // is adding itself again and again. This should catch it.
+        if (commandsExecuted == MaxReentrantCommands)
+        {
+            clearCommandQueue();
+            errorF("%i commands executed in sequence! Possible reentrant loop...", commandsExecuted);
+            break;
+        }
+
+        // Reached our limit for this frame?
+        if ((maxCommandsToExec != ExecAll) &&
+            (static_cast<std::uint32_t>(commandsExecuted) == maxCommandsToExec))
+        {
+            break;
+        }
+    }
+
+    --execBatchDepth;
+    publishCVarSnapshot();
+    return commandsExecuted;
+}
+
+void CommandManagerImpl::publishCVarSnapshot()
+{
+    if (cvarManager != nullptr && execBatchDepth == 0)
+    {
+        cvarManager->publishCVarSnapshot();
+    }
+}
+
+bool CommandManagerImpl::hasBufferedCommands() const
+{
+    return cmdQueueCount > 0 || !submitQueue.isEmpty();
+}
+
+int CommandManagerImpl::getBufferedCommandsCount() const
+{
+    return cmdQueueCount;
+}
+
+void CommandManagerImpl::setCommandBufferSize(const int maxSizeInChars)
+{
+    // Text already in the buffer is kept if it exceeds the new size.
+    cmdBufferMaxSize = (maxSizeInChars > 0) ? maxSizeInChars : CommandBufferSize;
+}
+
+int CommandManagerImpl::getCommandBufferSize() const
+{
+    return cmdBufferMaxSize;
+}
+
+void CommandManagerImpl::setProfilingEnabled(const bool enable)
+{
+    profilingEnabled = enable;
+}
+
+bool CommandManagerImpl::isProfilingEnabled() const
+{
+    return profilingEnabled;
+}
+
+void CommandManagerImpl::resetProfilingStats()
+{
+    for (auto cmd = registeredCommands.getFirst(); cmd; cmd = cmd->getNext())
+    {
+        cmd->clearProfile();
+    }
+    execProfile = CommandExecProfile();
+}
+
+int CommandManagerImpl::getCommandProfiles(CommandProfile * outProfiles, const int maxProfiles) const
+{
+    if (outProfiles == nullptr || maxProfiles <= 0)
+    {
+        return -1;
+    }
+
+    int profilesFound = 0;
+    for (auto cmd = registeredCommands.getFirst(); cmd; cmd = cmd->getNext())
+    {
+        if (const CommandProfile * profile = cmd->getProfile())
+        {
+            if (profilesFound < maxProfiles)
+            {
+                outProfiles[profilesFound] = *profile;
+            }
+            ++profilesFound; // Keep incrementing even if outProfiles[] is full,
+                             // so the caller can know the total num found.
+        }
+    }
+    return profilesFound;
+}
+
+CommandExecProfile CommandManagerImpl::getExecProfile() const
+{
+    return execProfile;
+}
+
+bool CommandManagerImpl::pushCommandText(const char * const str, const bool atFront, const char * const callerName,
+                                         CommandTemplate * const cmdTemplate)
+{
+    // Split the text into individual commands. First pass just
+    // counts them, so we can reserve all the space upfront.
+    int commandCount = 0;
+    int totalChars   = 0;
+    for (const char * cmdStr = cmdSkipSeparators(str); *cmdStr != '\0';)
+    {
+        const char * cmdEnd = cmdFindEndOfCommand(cmdStr);
+        totalChars += static_cast<int>(cmdEnd - cmdStr) + 1;
+        ++commandCount;
+        cmdStr = cmdSkipSeparators(cmdEnd);
+    }
+
+    if (commandCount == 0)
+    {
+        return true;
+    }
+
+    // Check for buffer overflow:
+    if ((cmdTextLive + totalChars) > cmdBufferMaxSize)
+    {
+        return errorF("Buffer overflow! Command buffer depleted in CommandManager::%s()!", callerName);
+    }
+
+    reserveCommandText(totalChars);
+    reserveCommandQueue(commandCount);
+
+    // Inserted commands go in front of the queue, but keep the order they appear in the string.
+    const int mask = cmdQueueCapacity - 1;
+    int queueIndex;
+    if (atFront)
+    {
+        cmdQueueHead = (cmdQueueHead - commandCount) & mask;
+        queueIndex   = cmdQueueHead;
+    }
+    else
+    {
+        queueIndex = (cmdQueueHead + cmdQueueCount) & mask;
+    }
+
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    // The template was split with the same rules, so commands match one-to-one.
+    int commandIndex = 0;
+    if (cmdTemplate != nullptr)
+    {
+        CFG_ASSERT(static_cast<int>(cmdTemplate->commands.size()) == commandCount);
+        cmdTemplate->refCount += commandCount;
+    }
+    #else // !CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    (void)cmdTemplate;
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+    for (const char * cmdStr = cmdSkipSeparators(str); *cmdStr != '\0';)
+    {
+        const char * cmdEnd = cmdFindEndOfCommand(cmdStr);
+        const int length    = static_cast<int>(cmdEnd - cmdStr);
+
+        std::memcpy(cmdText + cmdTextUsed, cmdStr, length);
+        cmdText[cmdTextUsed + length] = '\0';
+
+        cmdQueue[queueIndex].offset = cmdTextUsed;
+        cmdQueue[queueIndex].length = length + 1;
+        #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        cmdQueue[queueIndex].cmdTemplate     = cmdTemplate;
+        cmdQueue[queueIndex].templateCommand = commandIndex++;
+        #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        queueIndex = (queueIndex + 1) & mask;
+
+        cmdTextUsed += length + 1;
+        cmdStr = cmdSkipSeparators(cmdEnd);
+    }
+
+    cmdTextLive   += totalChars;
+    cmdQueueCount += commandCount;
+    return true;
+}
+
+void CommandManagerImpl::reserveCommandText(const int charsNeeded)
+{
+    if ((cmdTextUsed + charsNeeded) <= cmdTextCapacity)
+    {
+        return;
+    }
+
+    // Keep at least half of the new buffer free after repacking, so
+    // the copying cost is amortized over the commands that follow.
+    const int requiredSize = cmdTextLive + charsNeeded;
+    int newCapacity = (cmdTextCapacity > 0) ? cmdTextCapacity : 1024;
+    while (newCapacity < requiredSize * 2)
+    {
+        newCapacity *= 2;
+    }
+
+    // Copy the live text in queue order, dropping the executed commands.
+    char * newText = memAlloc<char>(newCapacity, MemoryCategory::CommandBuffer);
+    int newUsed = 0;
+    for (int i = 0; i < cmdQueueCount; ++i)
+    {
+        CommandTextRecord & record = cmdQueue[(cmdQueueHead + i) & (cmdQueueCapacity - 1)];
+        std::memcpy(newText + newUsed, cmdText + record.offset, record.length);
+        record.offset = newUsed;
+        newUsed += record.length;
+    }
+
+    memFree(cmdText);
+    cmdText         = newText;
+    cmdTextCapacity = newCapacity;
+    cmdTextUsed     = newUsed;
+}
+
+void CommandManagerImpl::reserveCommandQueue(const int recordsNeeded)
+{
+    if ((cmdQueueCount + recordsNeeded) <= cmdQueueCapacity)
+    {
+        return;
+    }
+
+    int newCapacity = (cmdQueueCapacity > 0) ? cmdQueueCapacity : 64;
+    while (newCapacity < (cmdQueueCount + recordsNeeded))
+    {
+        newCapacity *= 2;
+    }
+
+    // Unwrap the ring into the new array, so the head restarts at zero.
+    CommandTextRecord * newQueue = memAlloc<CommandTextRecord>(newCapacity, MemoryCategory::CommandBuffer);
+    for (int i = 0; i < cmdQueueCount; ++i)
+    {
+        newQueue[i] = cmdQueue[(cmdQueueHead + i) & (cmdQueueCapacity - 1)];
+    }
+
+    memFree(cmdQueue);
+    cmdQueue         = newQueue;
+    cmdQueueCapacity = newCapacity;
+    cmdQueueHead     = 0;
+}
+
+void CommandManagerImpl::clearCommandQueue()
+{
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    for (int i = 0; i < cmdQueueCount; ++i)
+    {
+        releaseCommandTemplate(cmdQueue[(cmdQueueHead + i) & (cmdQueueCapacity - 1)].cmdTemplate);
+    }
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+    // Buffers are kept allocated for reuse.
+    cmdQueueHead  = 0;
+    cmdQueueCount = 0;
+    cmdTextUsed   = 0;
+    cmdTextLive   = 0;
+}
+
+void CommandManagerImpl::execTokenized(const CommandArgs & cmdArgs)
+{
+    if (CommandImplBase * cmd = findCommandToExec(cmdArgs.getCommandName()))
+    {
+        execResolved(cmd, cmdArgs);
+    }
+}
+
+// The lookup time goes into 'outLookupTime' if given, for the caller to add to the
+// profile later, or straight into the profile otherwise. Misses are always counted.
+CommandImplBase * CommandManagerImpl::findCommandToExec(const char * const cmdName, std::uint64_t * const outLookupTime) const
+{
+    // Validate the name length:
+    if (lengthOfString(cmdName) >= MaxCommandNameLength)
+    {
+        errorF("Command name too long! Max command name length is %i characters.", MaxCommandNameLength);
+        return nullptr;
+    }
+
+    // Find the command:
+    const std::uint64_t lookupStart = profileTimestamp();
+    auto cmd = registeredCommands.findByKey(cmdName);
+    profileAddTime(outLookupTime != nullptr ? outLookupTime : &execProfile.lookupTime, lookupStart);
+
+    if (cmd == nullptr)
+    {
+        if (lookupStart != 0)
+        {
+            ++execProfile.lookupMisses;
+        }
+        errorF("%s: Command not found.", cmdName);
+        return nullptr;
+    }
+    return cmd;
+}
+
+void CommandManagerImpl::execResolved(CommandImplBase * const cmd, const CommandArgs & cmdArgs)
+{
+    const char * const cmdName = cmdArgs.getCommandName();
+
+    // Check if this command is currently allowed to execute:
+    if (disabledCmdFlags != 0)
+    {
+        if (disabledCmdFlags == DisableAll)
+        {
+            errorF("Command execution is globally disabled!");
+            return;
+        }
+        if (cmd->getFlags() & disabledCmdFlags)
+        {
+            errorF("%s: Command is disabled!", cmdName);
+            return;
+        }
+    }
+
+    // Optional min/max arguments validation, if they are not negative (zero args is OK):
+    if (cmd->getMinArgs() >= 0)
+    {
+        if (cmdArgs.getArgCount() < cmd->getMinArgs())
+        {
+            errorF("%s: Not enough arguments! Expected at least %i.", cmdName, cmd->getMinArgs());
+            return;
+        }
+    }
+
+    if (cmd->getMaxArgs() >= 0)
+    {
+        if (cmdArgs.getArgCount() > cmd->getMaxArgs())
+        {
+            errorF("%s: Too many arguments provided! Expected up to %i.", cmdName, cmd->getMaxArgs());
+            return;
+        }
+    }
+
+    // Arguments pre-validated, call command handler:
+    const std::uint64_t handlerStart = profileTimestamp();
+    const std::uint32_t removalGeneration = cmdRemovalGeneration;
+    if (cmd->inlineHandler != nullptr)
+    {
+        (*cmd->inlineHandler)(cmdArgs);
+    }
+    else
+    {
+        cmd->onExecute(cmdArgs);
+    }
+
+    if (handlerStart != 0)
+    {
+        // The handler might have removed its own command.
+        if (removalGeneration == cmdRemovalGeneration || registeredCommands.findByKey(cmdName) == cmd)
+        {
+            cmd->addProfiledRun(profileNow() - handlerStart);
+        }
+        ++execProfile.commandsRun;
+    }
+}
+
+bool CommandManagerImpl::extractNextCommand(const char ** outStr, char * destBuf, const int destSizeInChars,
+                                            bool * outOverflowed, CommandTemplate * outTemplate) const
+{
+    const char * str = *outStr;
+    *outOverflowed   = false;
+
+    #if !CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    (void)outTemplate;
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+    // First, sanitize leading command separators and whitespace
+    // that might have been left over from a previous pass.
+    for (; *str != '\0'; ++str)
+    {
+        const int chr = *str;
+        if (!isWhitespace(chr) && chr != CommandTextSeparator)
+        {
+            break;
+        }
+    }
+
+    /*
+     * This simple parsing loop allows for commands mostly compatible
+     * with Unix Shell implementations. A couple examples:
+     *
+     * cmd_1 "hello world" \
+     *       "goodbye galaxy"
+     *
+     * ^ The backslash allows a multi-line command/arg-list.
+     *
+     * Multiple commands can also be placed on the same line if separated
+     * by a CommandTextSeparator (by default a ';'), example:
+     *
+     * cmd_1 hello; cmd_2 goodbye; cmd_3 "commands made easy"
+     *
+     * Quotes will keep whitespace-separated strings together as a single argument,
+     * ignoring occurrences of command separators inside the quoted blocks.
+     */
+
+    int  charsCopied = 0;
+    int  quoteCount  = 0;
+    bool quoted      = false;
+    bool singleQuote = false;
+    bool backslash   = false;
+    bool done        = false;
+
+    for (; !done && *str != '\0' && charsCopied < destSizeInChars; ++str)
+    {
+        const int chr = *str;
+        if (chr == '\r')
+        {
+            // Silently ignore Windows Carriage Returns.
+            // We only care about newlines.
+            continue;
+        }
+        else if (chr == '\\')
+        {
+            // A backslash allows a multi-line command.
+            backslash = true;
+            continue;
+        }
+        else if (chr == '\n')
+        {
+            // Ignore the newline if preceded by a backslash or between quotes.
+            done = !backslash && !quoted;
+            backslash = false;
+        }
+        else if (chr == '"')
+        {
+            // Remember if we are inside a quoted block.
+            // We have to ignore CommandTextSeparators inside them.
+            ++quoteCount;
+            quoted = quoteCount & 1;
+        }
+        else if (chr == '\'')
+        {
+            // Single quotes can start a quoted block or appear inside a double-quotes block.
+            if (!quoted)
+            {
+                ++quoteCount;
+                quoted = quoteCount & 1;
+                singleQuote = true;
+            }
+            else if (singleQuote)
+            {
+                ++quoteCount;
+                quoted = quoteCount & 1;
+                singleQuote = false;
+            }
+        }
+        else if (chr == CommandTextSeparator)
+        {
+            // Default command separator breaks a command
+            // string if not inside a quoted block.
+            done = !quoted;
+        }
+        #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        else if (chr == '$' && *(str + 1) == '(')
+        {
+            // When compiling a template the expansion is only recorded, to be filled in later.
+            const bool expanded = (outTemplate != nullptr) ?
+                                   outTemplate->addVarRef(&str, charsCopied) :
+                                   expandCVar(&str, &charsCopied, destBuf, destSizeInChars, 1);
+            if (!expanded)
+            {
+                // Skip the rest of the broken command.
+                for (; *str != '\0' && *str != '\n' && *str != CommandTextSeparator; ++str) { }
+                *outOverflowed = true; // This makes the command string be discarded.
+                done = true;
+            }
+            continue;
+        }
+        #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+        if (backslash && !(chr == ' ' || chr == '\t'))
+        {
+            // This prevents errors from lost backslashes in the middle of a string,
+            // which are probably leftovers from collapsing a line. Just ignore it.
+            backslash = false;
+        }
+
+        if (!done)
+        {
+            destBuf[charsCopied++] = static_cast<char>(chr);
+        }
+    }
+
+    if (charsCopied == destSizeInChars)
+    {
+        --charsCopied; // Truncated.
+        *outOverflowed = true;
+        errorF("Command string too long! Can't parse all arguments from it...");
+    }
+
+    destBuf[charsCopied] = '\0';
+    *outStr = str;
+
+    return charsCopied > 0;
+}
+
+#if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+bool CommandManagerImpl::expandCVar(const char ** outStr, int * outCharsCopied, char * destBuf,
+                                    const int destSizeInChars, const int recursionDepth) const
+{
+    if (cvarManager == nullptr)
+    {
+        return errorF("No CVarManager set. Unable to perform CVar argument expansion.");
+    }
+
+    // Max recursion depth for reentrant CVar expansions.
+    // If the maximum is reached, the whole substitution will fail.
+    constexpr int MaxRecursionDepth = 15;
+
+    const char * str   = *outStr;
+    int  parenthesis   = 0;
+    int  varNameLength = 0;
+    char varName[MaxCommandArgStrLength];
+
+    // Function should be entered while pointing to the '$'
+    CFG_ASSERT(*str == '$');
+
+    for (++str; *str != '\0' && *str != '\n' && *str != CommandTextSeparator; ++str)
+    {
+        if (*str == '(')
+        {
+            ++parenthesis;
+        }
+        else if (*str == ')')
+        {
+            --parenthesis;
+            break;
+        }
+        else if (*str == '$' && *(str + 1) == '(') // Reentrant expansion
+        {
+            if (recursionDepth == MaxRecursionDepth)
+            {
+                return errorF("Too many reentrant CVar argument expansions!");
+            }
+            if (!expandCVar(&str, &varNameLength, varName, MaxCommandArgStrLength, recursionDepth + 1))
+            {
+                return false;
+            }
+        }
+        else // Part of the var name
+        {
+            if (!isWhitespace(*str))
+            {
+                if (varNameLength == MaxCommandArgStrLength)
+                {
+                    return errorF("Buffer overflow in CVar name expansion!");
+                }
+                varName[varNameLength++] = *str;
+            }
+        }
+    }
+
+    if (parenthesis != 0)
+    {
+        return errorF("Unbalanced opening or closing parenthesis in CVar argument expansion!");
+    }
+    if (varNameLength == 0)
+    {
+        return errorF("Missing CVar name in argument expansion!");
+    }
+
+    varName[varNameLength] = '\0';
+    if (!cvarManager->isValidCVarName(varName))
+    {
+        return errorF("Invalid CVar name '%s' in argument expansion!", varName);
+    }
+
+    const CVar * const cvar = cvarManager->findCVar(varName);
+    if (cvar == nullptr)
+    {
+        return errorF("Trying to expand undefined CVar '$(%s)'.", varName);
+    }
+
+    // Formatted straight into the output, without a temporary string.
+    const int bufferOffset = *outCharsCopied;
+    const int charsLeft    = destSizeInChars - bufferOffset;
+    const int valueLength  = cvar->getStringValue(destBuf + bufferOffset, charsLeft);
+
+    if (valueLength >= charsLeft)
+    {
+        errorF("Overflow in CVar expansion! Output was truncated.");
+        *outCharsCopied += std::max(charsLeft - 1, 0);
+    }
+    else
+    {
+        *outCharsCopied += valueLength;
+    }
+    *outStr = str;
+
+    return true;
+}
+
+CommandTemplate * CommandManagerImpl::compileCommandTemplate(const char * const str) const
+{
+    auto cmdTemplate = memAlloc<CommandTemplate>(1, MemoryCategory::Commands);
+    construct(cmdTemplate);
+    cmdTemplate->addString(str, lengthOfString(str));
+
+    bool overflowed;
+    char tempBuffer[MaxCommandArgStrLength];
+
+    // Split with the same rules of pushCommandText(), so the buffered commands match one-to-one.
+    for (const char * cmdStr = cmdSkipSeparators(str); *cmdStr != '\0';)
+    {
+        const char * cmdEnd = cmdFindEndOfCommand(cmdStr);
+
+        CommandTemplate::Command cmd;
+        cmd.sourceText    = cmdTemplate->addString(cmdStr, static_cast<int>(cmdEnd - cmdStr));
+        cmd.literalText   = -1;
+        cmd.literalLength = 0;
+        cmd.firstVarRef   = static_cast<int>(cmdTemplate->varRefs.size());
+        cmd.varRefCount   = 0;
+
+        // Commands that don't compile are left for extractNextCommand() to report when they run.
+        const char * srcStr = cmdStr;
+        extractNextCommand(&srcStr, tempBuffer, lengthOfArray(tempBuffer), &overflowed, cmdTemplate);
+        if (!overflowed)
+        {
+            cmd.literalLength = lengthOfString(tempBuffer);
+            cmd.literalText   = cmdTemplate->addString(tempBuffer, cmd.literalLength);
+            cmd.varRefCount   = static_cast<int>(cmdTemplate->varRefs.size()) - cmd.firstVarRef;
+        }
+        else
+        {
+            cmdTemplate->varRefs.resize(cmd.firstVarRef);
+        }
+
+        cmdTemplate->commands.push_back(cmd);
+        cmdStr = cmdSkipSeparators(cmdEnd);
+    }
+
+    return cmdTemplate;
+}
+
+bool CommandManagerImpl::resolveTemplateVarRef(CommandTemplate * const cmdTemplate, CommandTemplate::VarRef * const ref) const
+{
+    if (ref->cvar != nullptr)
+    {
+        return true;
+    }
+
+    const char * const varName = cmdTemplate->getString(ref->varName);
+    if (!cvarManager->isValidCVarName(varName))
+    {
+        return errorF("Invalid CVar name '%s' in argument expansion!", varName);
+    }
+
+    ref->cvar = cvarManager->findCVar(varName);
+    if (ref->cvar == nullptr)
+    {
+        return errorF("Trying to expand undefined CVar '$(%s)'.", varName);
+    }
+    return true;
+}
+
+bool CommandManagerImpl::expandTemplateCommand(CommandTemplate * const cmdTemplate, const int commandIndex,
+                                               char * const destBuf, const int destSizeInChars,
+                                               bool * const outOverflowed) const
+{
+    const CommandTemplate::Command & cmd = cmdTemplate->commands[commandIndex];
+    *outOverflowed = false;
+
+    if (cmd.literalText < 0)
+    {
+        const char * str = cmdTemplate->getString(cmd.sourceText);
+        return extractNextCommand(&str, destBuf, destSizeInChars, outOverflowed);
+    }
+
+    if (cmd.varRefCount > 0)
+    {
+        if (cvarManager == nullptr)
+        {
+            *outOverflowed = true;
+            return errorF("No CVarManager set. Unable to perform CVar argument expansion.");
+        }
+
+        // CVar values are read every time, but the pointers are only looked up again if a CVar was removed.
+        if (cmdTemplate->resolvedManager != cvarManager ||
+            cmdTemplate->resolvedGeneration != cvarManager->getRemovalGeneration())
+        {
+            for (CommandTemplate::VarRef & ref : cmdTemplate->varRefs)
+            {
+                ref.cvar = nullptr;
+            }
+            cmdTemplate->resolvedManager    = cvarManager;
+            cmdTemplate->resolvedGeneration = cvarManager->getRemovalGeneration();
+        }
+    }
+
+    const char * const literal = cmdTemplate->getString(cmd.literalText);
+    int literalPos  = 0;
+    int charsCopied = 0;
+
+    for (int i = 0; ; ++i)
+    {
+        // Literal text up to the next expansion or the end of the command.
+        const int literalEnd = (i < cmd.varRefCount) ? cmdTemplate->varRefs[cmd.firstVarRef + i].insertPos : cmd.literalLength;
+        const int literalChars = literalEnd - literalPos;
+        if ((charsCopied + literalChars) >= destSizeInChars)
+        {
+            destBuf[0] = '\0';
+            *outOverflowed = true;
+            return errorF("Command string too long! Can't parse all arguments from it...");
+        }
+
+        std::memcpy(destBuf + charsCopied, literal + literalPos, literalChars);
+        charsCopied += literalChars;
+        literalPos   = literalEnd;
+
+        if (i == cmd.varRefCount)
+        {
+            break;
+        }
+
+        CommandTemplate::VarRef & ref = cmdTemplate->varRefs[cmd.firstVarRef + i];
+        if (!resolveTemplateVarRef(cmdTemplate, &ref))
+        {
+            destBuf[0] = '\0';
+            *outOverflowed = true; // This makes the command string be discarded.
+            return false;
+        }
+
+        const int charsLeft   = destSizeInChars - charsCopied;
+        const int valueLength = ref.cvar->getStringValue(destBuf + charsCopied, charsLeft);
+
+        if (valueLength >= charsLeft)
+        {
+            errorF("Overflow in CVar expansion! Output was truncated.");
+            charsCopied += std::max(charsLeft - 1, 0);
+        }
+        else
+        {
+            charsCopied += valueLength;
+        }
+    }
+
+    destBuf[charsCopied] = '\0';
+    return charsCopied > 0;
+}
+
+void CommandManagerImpl::execCommandTemplate(const CommandExecMode execMode, CommandTemplate * const cmdTemplate)
+{
+    const char * const str = cmdTemplate->getString(0);
+
+    switch (execMode)
+    {
+    case CommandExecMode::Immediate :
+        {
+            // A command handler might remove the alias, so hold on to the template until done.
+            ++cmdTemplate->refCount;
+
+            bool overflowed;
+            char tempBuffer[MaxCommandArgStrLength];
+            const int commandCount = static_cast<int>(cmdTemplate->commands.size());
+
+            for (int i = 0; i < commandCount; ++i)
+            {
+                const std::uint64_t parseStart = profileTimestamp();
+                const bool gotCommand = expandTemplateCommand(cmdTemplate, i, tempBuffer, lengthOfArray(tempBuffer), &overflowed);
+                profileAddTime(&execProfile.parseTime, parseStart);
+
+                if (overflowed)
+                {
+                    errorF("Discarding rest of command line due to malformed string...");
+                    break;
+                }
+                if (!gotCommand)
+                {
+                    continue;
+                }
+
+                CommandArgs cmdArgs;
+                const std::uint64_t tokenizeStart = profileTimestamp();
+                cmdArgs.tokenizeInPlace(tempBuffer);
+                profileAddTime(&execProfile.tokenizeTime, tokenizeStart);
+                execTokenized(cmdArgs);
+            }
+
+            releaseCommandTemplate(cmdTemplate);
+            break;
+        }
+    case CommandExecMode::Insert :
+        pushCommandText(str, /* atFront = */ true, "execInsert", cmdTemplate);
+        break;
+    case CommandExecMode::Append :
+        pushCommandText(str, /* atFront = */ false, "execAppend", cmdTemplate);
+        break;
+    default :
+        errorF("Invalid CommandExecMode enum value!");
+    } // switch (execMode)
+}
+#endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+// ========================================================
+// Virtual destructors anchored to this file:
+// ========================================================
+
+Command::~Command()
+{ }
+
+CommandManager::~CommandManager()
+{ }
+
+CommandHandlerMemFunc::BaseCallableHolder::~BaseCallableHolder()
+{ }
+
+// ================================================================================================
+//
+//                                 Interactive Terminal/Console
+//
+// ================================================================================================
+
+// ========================================================
+// color::canColorPrint():
+// ========================================================
+
+namespace color
+{
+
+bool canColorPrint() noexcept
+{
+    #ifdef CFG_USE_ANSI_COLOR_CODES
+        #if (CFG_USE_ANSI_COLOR_CODES == 0)
+        // Define to zero to disable.
+        return false;
+        #elif (CFG_USE_ANSI_COLOR_CODES == 1)
+        // Define to 1 to check for redirection.
+        // This can be cached, since it is unlikely that the standard
+        // streams will be redirected while the program is still running.
+        static bool notRedirected = CFG_ISATTY(CFG_STDOUT_FILENO) && CFG_ISATTY(CFG_STDERR_FILENO);
+        return notRedirected;
+        #else
+        // Define to anything else to always enable.
+        return true;
+        #endif // CFG_USE_ANSI_COLOR_CODES
+    #else // not defined -> always disable.
+    return false;
+    #endif // CFG_USE_ANSI_COLOR_CODES
+}
+
+} // namespace color {}
+
+// ========================================================
+// SpecialKeys::toString():
+// ========================================================
+
+std::string SpecialKeys::toString(const int key)
+{
+    std::string str;
+    switch (key)
+    {
+    case Return     : { str = "Return";     break; }
+    case Tab        : { str = "Tab";        break; }
+    case Backspace  : { str = "Backspace";  break; }
+    case Delete     : { str = "Delete";     break; }
+    case UpArrow    : { str = "UpArrow";    break; }
+    case DownArrow  : { str = "DownArrow";  break; }
+    case RightArrow : { str = "RightArrow"; break; }
+    case LeftArrow  : { str = "LeftArrow";  break; }
+    case Escape     : { str = "Escape";     break; }
+    case Control    : { str = "Control";    break; }
+    default         : { str.push_back(static_cast<char>(key)); break; }
+    } // switch (key)
+    return str;
+}
+
+// ========================================================
+// BuiltInCmd handlers:
+// ========================================================
+
+static void cmdExit(SimpleCommandTerminal & term)      { term.setExit();             }
+static void cmdClear(SimpleCommandTerminal & term)     { term.clear();               }
+static void cmdHistView(SimpleCommandTerminal & term)  { term.printCommandHistory(); }
+static void cmdHistClear(SimpleCommandTerminal & term) { term.clearCommandHistory(); }
+static void cmdHistSave(SimpleCommandTerminal & term)  { term.saveCommandHistory();  }
+static void cmdHistLoad(SimpleCommandTerminal & term)  { term.loadCommandHistory();  }
+
+// ========================================================
+// List of built-in commands:
+// ========================================================
+
+const SimpleCommandTerminal::BuiltInCmd SimpleCommandTerminal::builtInCmds[]
+{
+    { &cmdExit,      "exit",      "Exits the interactive terminal mode." },
+    { &cmdClear,     "clear",     "Clears the terminal screen."          },
+    { &cmdHistView,  "histView",  "Prints the current command history."  },
+    { &cmdHistClear, "histClear", "Erases the current command history."  },
+    { &cmdHistSave,  "histSave",  "Saves the current command history to \"" CFG_COMMAND_HIST_FILE "\"." },
+    { &cmdHistLoad,  "histLoad",  "Load previous command history from \""   CFG_COMMAND_HIST_FILE "\"." }
+};
+
+// ========================================================
+// SimpleCommandTerminal implementation:
+// ========================================================
+
+SimpleCommandTerminal::SimpleCommandTerminal(CommandManager * cmdMgr,
+                                             CVarManager    * cvarMgr,
+                                             const char     * newlineMark)
+    : lineBufferUsed(0)
+    , lineBufferInsertionPos(0)
+    , currCmdInHistory(0)
+    , indexCmdHistory(0)
+    , lineHasMarker(false)
+    , exitFlag(false)
+    , listAllCmdsOnTab(false)
+    , firstAutoCompletionTry(true)
+    , oldLineBufferUsed(0)
+    , nextDisplayedCompletionMatch(0)
+    , partialStrLength(0)
+    , completionMatchCount(0)
+    , cmdManager(cmdMgr)
+    , cvarManager(cvarMgr)
+    , cmdExecMode(CommandExecMode::Append)
+    , outputBuffer(nullptr)
+    , outputBufferSize(0)
+    , outputBufferUsed(0)
+    , pendingTextColor(nullptr)
+    , currentTextColor(nullptr)
+    , newlineMarkerStr(newlineMark)
+{
+    clearArray(completionMatches);
+    clearArray(lineBuffer);
+}
+
+SimpleCommandTerminal::~SimpleCommandTerminal()
+{
+    // Anything not flushed by the subclass is lost.
+    memFree(outputBuffer);
+}
+
+CommandManager * SimpleCommandTerminal::getCommandManager() const noexcept
+{
+    return cmdManager;
+}
+
+CommandExecMode SimpleCommandTerminal::getCommandExecMode() const noexcept
+{
+    return cmdExecMode;
+}
+
+CVarManager * SimpleCommandTerminal::getCVarManager() const noexcept
+{
+    return cvarManager;
+}
+
+void SimpleCommandTerminal::setCommandManager(CommandManager * cmdMgr) noexcept
+{
+    cmdManager = cmdMgr;
+}
+
+void SimpleCommandTerminal::setCommandExecMode(const CommandExecMode newMode) noexcept
+{
+    cmdExecMode = newMode;
+}
+
+void SimpleCommandTerminal::setCVarManager(CVarManager * cvarMgr) noexcept
+{
+    cvarManager = cvarMgr;
+}
+
+void SimpleCommandTerminal::setTextColor(const char * const ansiColorCode) noexcept
+{
+    if (outputBuffer != nullptr)
+    {
+        pendingTextColor = ansiColorCode; // Written with the next text.
+        return;
+    }
+    print(ansiColorCode);
+}
+
+void SimpleCommandTerminal::restoreTextColor() noexcept
+{
+    setTextColor(color::restore());
+}
+
+void SimpleCommandTerminal::printF(const char * const fmt, ...)
+{
+    CFG_ASSERT(fmt != nullptr);
+
+    va_list vaList;
+
+    // Batching: try to format straight into the output buffer first.
+    if (outputBuffer != nullptr)
+    {
+        const int charsFree = outputBufferSize - outputBufferUsed;
+
+        va_start(vaList, fmt);
+        const int result = std::vsnprintf(outputBuffer + outputBufferUsed, charsFree, fmt, vaList);
+        va_end(vaList);
+
+        if (result <= 0)
+        {
+            return;
+        }
+        if (result < charsFree && (pendingTextColor == nullptr || *pendingTextColor == '\0'))
+        {
+            outputBufferUsed += result;
+            return;
+        }
+        // Didn't fit or a color code must go first. Use the slow path below.
+    }
+
+    char tempStr[LineBufferMaxSize];
+
+    va_start(vaList, fmt);
+    const int result = std::vsnprintf(tempStr, lengthOfArray(tempStr), fmt, vaList);
+    va_end(vaList);
+
+    if (result > 0)
+    {
+        print(tempStr);
+    }
+}
+
+void SimpleCommandTerminal::setOutputBufferSize(const int sizeInChars)
+{
+    flushOutput();
+    memFree(outputBuffer);
+
+    outputBuffer     = (sizeInChars > 0 ? memAlloc<char>(sizeInChars, MemoryCategory::Terminals) : nullptr);
+    outputBufferSize = (sizeInChars > 0 ? sizeInChars : 0);
+    outputBufferUsed = 0;
+}
+
+int SimpleCommandTerminal::getOutputBufferSize() const noexcept
+{
+    return outputBufferSize;
+}
+
+void SimpleCommandTerminal::flushOutput()
+{
+    // A color change still pending (typically the restoreTextColor() after
+    // some colored text) must go out too, or the terminal keeps that color.
+    if (outputBuffer != nullptr)
+    {
+        bufferPendingTextColor();
+    }
+
+    if (outputBufferUsed > 0)
+    {
+        // Reset first, in case writeOutput() prints something.
+        const int length = outputBufferUsed;
+        outputBufferUsed = 0;
+        writeOutput(outputBuffer, length);
+    }
+}
+
+void SimpleCommandTerminal::writeOutput(const char * /* text */, int /* length */)
+{
+    // A no-op by default.
+}
+
+void SimpleCommandTerminal::bufferOutput(const char * const text, const int length)
+{
+    if (outputBuffer == nullptr)
+    {
+        writeOutput(text, length);
+        return;
+    }
+    if (length <= 0)
+    {
+        return;
+    }
+
+    // Color codes only go out right before the text they apply to.
+    bufferPendingTextColor();
+
+    if (length > (outputBufferSize - outputBufferUsed))
+    {
+        flushOutput();
+        if (length >= outputBufferSize)
+        {
+            writeOutput(text, length); // Too big to be worth buffering.
+            return;
+        }
+    }
+
+    std::memcpy(outputBuffer + outputBufferUsed, text, length);
+    outputBufferUsed += length;
+}
+
+void SimpleCommandTerminal::bufferPendingTextColor()
+{
+    if (pendingTextColor == nullptr)
+    {
+        return;
+    }
+
+    const char * const colorCode = pendingTextColor;
+    pendingTextColor = nullptr;
+
+    // Only if different from the color already in use.
+    if (*colorCode != '\0' && (currentTextColor == nullptr || std::strcmp(colorCode, currentTextColor) != 0))
+    {
+        currentTextColor = colorCode;
+        bufferOutput(colorCode, lengthOfString(colorCode));
+    }
+}
+
+void SimpleCommandTerminal::clear()
+{
+    // If a child class overrides clear(), this should still
+    // be called at the end to insert a new line marker in
+    // the just cleared terminal buffer.
+
+    print(newlineMarkerStr.c_str());
+
+    lineBufferUsed               = 0;
+    lineBufferInsertionPos       = 0;
+    lineHasMarker                = true;
+    listAllCmdsOnTab             = false;
+    firstAutoCompletionTry       = true;
+    oldLineBufferUsed            = 0;
+    nextDisplayedCompletionMatch = 0;
+    partialStrLength             = 0;
+    completionMatchCount         = 0;
+
+    clearArray(completionMatches);
+    clearArray(lineBuffer);
+
+    for (auto & s : argStringMatches)
+    {
+        s.clear();
+    }
+}
+
+void SimpleCommandTerminal::update()
+{
+    // Might not have the newline marker yet if the CommandManager was still processing commands.
+    if (!lineHasMarker && !exitFlag)
+    {
+        print(newlineMarkerStr.c_str());
+        lineHasMarker = true;
+    }
+
+    flushOutput();
+}
+
+bool SimpleCommandTerminal::exit() const
+{
+    return exitFlag;
+}
+
+void SimpleCommandTerminal::cancelExit()
+{
+    exitFlag = false;
+}
+
+void SimpleCommandTerminal::setExit()
+{
+    exitFlag = true;
+    onExit();
+}
+
+void SimpleCommandTerminal::onExit()
+{
+    // A no-op by default.
+}
+
+void SimpleCommandTerminal::onSetClipboardString(const char * /* str */)
+{
+    // A no-op by default.
+}
+
+const char * SimpleCommandTerminal::onGetClipboardString()
+{
+    return nullptr; // A no-op by default.
+}
+
+bool SimpleCommandTerminal::handleKeyInput(const int key, const char chr)
+{
+    // Reset some [TAB] auto-completion states:
+    if (key != SpecialKeys::Tab)
+    {
+        listAllCmdsOnTab             = false;
+        firstAutoCompletionTry       = true;
+        nextDisplayedCompletionMatch = 0;
+        oldLineBufferUsed            = 0;
+    }
+
+    switch (key)
+    {
+    case SpecialKeys::Return     : return finishCommand();
+    case SpecialKeys::Tab        : return tabCompletion();
+    case SpecialKeys::Backspace  : return popChar();
+    case SpecialKeys::Delete     : return delChar();
+    case SpecialKeys::UpArrow    : return nextCmdFromHistory();
+    case SpecialKeys::DownArrow  : return prevCmdFromHistory();
+    case SpecialKeys::RightArrow : return navigateTextRight();
+    case SpecialKeys::LeftArrow  : return navigateTextLeft();
+    case SpecialKeys::Escape     : return discardInput();
+    case SpecialKeys::Control    : return handleCtrlKey(chr);
+    default                      : return insertChar(chr);
+    } // switch (key)
+}
+
+int SimpleCommandTerminal::getCommandHistorySize() const noexcept
+{
+    return indexCmdHistory;
+}
+
+const char * SimpleCommandTerminal::getCommandFromHistory(const int index) const
+{
+    CFG_ASSERT(index >= 0 && index < getCommandHistorySize());
+    return cmdHistory[index].c_str();
+}
+
+void SimpleCommandTerminal::clearCommandHistory()
+{
+    for (int i = 0; i < CmdHistoryMaxSize; ++i)
+    {
+        cmdHistory[i].clear();
+    }
+
+    currCmdInHistory = 0;
+    indexCmdHistory  = 0;
+}
+
+void SimpleCommandTerminal::printCommandHistory()
+{
+    printLn("----- Command History -----");
+
+    const int histSize = getCommandHistorySize();
+    for (int i = 0; i < histSize; ++i)
+    {
+        printF("[%02i]: %s\n", i, getCommandFromHistory(i));
+    }
+}
+
+bool SimpleCommandTerminal::saveCommandHistory()
+{
+    FileIOCallbacks * io = getFileIOCallbacks();
+
+    FileHandle fileOut;
+    if (!io->open(&fileOut, CFG_COMMAND_HIST_FILE, FileOpenMode::Write))
+    {
+        return false;
+    }
+
+    const int histSize = getCommandHistorySize();
+    for (int i = 0; i < histSize; ++i)
+    {
+        io->writeFormat(fileOut, "%s\n", getCommandFromHistory(i));
+    }
+
+    printF("Command history saved to \"%s\".\n", CFG_COMMAND_HIST_FILE);
+    io->close(fileOut);
+    return true;
+}
+
+bool SimpleCommandTerminal::loadCommandHistory()
+{
+    FileIOCallbacks * io = getFileIOCallbacks();
+
+    FileHandle fileIn;
+    if (!io->open(&fileIn, CFG_COMMAND_HIST_FILE, FileOpenMode::Read))
+    {
+        return false;
+    }
+
+    clearCommandHistory(); // Current history is lost, if any.
+
+    // Copy the new history:
+    char line[LineBufferMaxSize];
+    while (io->readLine(fileIn, line, lengthOfArray(line)))
+    {
+        addCmdToHistory(rightTrimString(line)); // RTrim to get rid of the newline.
+    }
+
+    printF("Command history restored from \"%s\".\n", CFG_COMMAND_HIST_FILE);
+    io->close(fileIn);
+    return true;
+}
+
+int SimpleCommandTerminal::getBuiltInCommandsCount() const noexcept
+{
+    return lengthOfArray(builtInCmds);
+}
+
+const SimpleCommandTerminal::BuiltInCmd * SimpleCommandTerminal::getBuiltInCommand(const int index) const
+{
+    CFG_ASSERT(index >= 0 && index < getBuiltInCommandsCount());
+    return &builtInCmds[index];
+}
+
+const SimpleCommandTerminal::BuiltInCmd * SimpleCommandTerminal::getBuiltInCommand(const char * const name) const
+{
+    if (name == nullptr || *name == '\0')
+    {
+        return nullptr;
+    }
+
+    const int builtInCount = getBuiltInCommandsCount();
+    for (int i = 0; i < builtInCount; ++i)
+    {
+        if (cmdCmpNames(name, builtInCmds[i].name) == 0)
+        {
+            return &builtInCmds[i];
+        }
+    }
+
+    return nullptr;
+}
+
+void SimpleCommandTerminal::setLineBuffer(const char * str)
+{
+    if (str == nullptr)
+    {
+        return;
+    }
+
+    clearVisibleEditLine();
+    if (*str != '\0')
+    {
+        print(str);
+        lineBufferUsed = copyString(lineBuffer, lengthOfArray(lineBuffer), str);
+        lineBufferInsertionPos = lineBufferUsed;
+    }
+    else
+    {
+        clearLineInputBuffer();
+    }
+}
+
+const char * SimpleCommandTerminal::getLineBuffer() const
+{
+    return lineBuffer;
+}
+
+bool SimpleCommandTerminal::isLineBufferEmpty() const
+{
+    return lineBufferUsed == 0;
+}
+
+void SimpleCommandTerminal::newLineNoMarker()
+{
+    print("\n");
+    lineHasMarker = false;
+}
+
+void SimpleCommandTerminal::newLineWithMarker()
+{
+    printF("\n%s", newlineMarkerStr.c_str());
+    lineHasMarker = true;
+}
+
+void SimpleCommandTerminal::clearVisibleEditLine()
+{
+    // Fill the line with blanks to clear it out.
+    char blankLine[LineBufferMaxSize];
+    const int charsToFill = std::min(static_cast<int>(lineBufferUsed + newlineMarkerStr.length()), lengthOfArray(blankLine));
+
+    std::memset(blankLine, ' ', charsToFill);
+    blankLine[charsToFill] = '\0';
+
+    printF("\r%s\r%s", blankLine, newlineMarkerStr.c_str());
+    lineHasMarker = true;
+}
+
+void SimpleCommandTerminal::clearLineInputBuffer()
+{
+    lineBufferUsed         = 0;
+    lineBufferInsertionPos = 0;
+    lineBuffer[0]          = '\0';
+}
+
+bool SimpleCommandTerminal::finishCommand()
+{
+    // Break this line but don't put the new line marker yet,
+    // let the command be processed first.
+    newLineNoMarker();
+
+    // Add to the history and run the command:
+    if (!isLineBufferEmpty())
+    {
+        // But ignore blank lines/empty command.
+        if (*lineBuffer != '\0' && *lineBuffer != '\n' && *lineBuffer != '\r')
+        {
+            addCmdToHistory(lineBuffer);
+            execCmdLine(lineBuffer);
+        }
+        clearLineInputBuffer();
+    }
+
+    bool canAddMarker;
+    if (cmdManager == nullptr)
+    {
+        canAddMarker = true;
+    }
+    else if (cmdManager->hasBufferedCommands())
+    {
+        canAddMarker = false;
+    }
+    else
+    {
+        canAddMarker = true;
+    }
+
+    if (canAddMarker && !lineHasMarker && !exitFlag)
+    {
+        print(newlineMarkerStr.c_str());
+        lineHasMarker = true;
+    }
+
+    return true; // Input [RETURN] was handled.
+}
+
+void SimpleCommandTerminal::execCmdLine(const char * cmd)
+{
+    char cmdName[LineBufferMaxSize];
+    const char * cmdPtr = cmd;
+
+    // Skip leading whitespace:
+    for (; *cmdPtr != '\0' && isWhitespace(*cmdPtr); ++cmdPtr) { }
+    const char * firstNonWhite = cmdPtr;
+
+    // Copy until the first whitespace to get the command name:
+    char * p = cmdName;
+    for (; *cmdPtr != '\0' && !isWhitespace(*cmdPtr); ++p, ++cmdPtr)
+    {
+        *p = *cmdPtr;
+    }
+    *p = '\0';
+
+    if (*cmdName == '\0')
+    {
+        return; // Just whitespace.
+    }
+
+    //
+    // Check if not setting a CVar with the shortcut notation:
+    // "varName value"
+    //
+    // Or if printing the variable value by referencing it.
+    //
+    if (cvarManager != nullptr)
+    {
+        if (CVar * cvar = cvarManager->findCVar(cmdName))
+        {
+            CommandArgs cmdArgs(cmd);
+            if (cmdArgs.getArgCount() < 1)
+            {
+                printF("%s is: \"%s\"  |  default: \"%s\"\n",
+                       cvar->getNameCString(),
+                       CVarValueChars(*cvar).c_str(),
+                       CVarValueChars(*cvar, true).c_str());
+            }
+            else
+            {
+                if (cmdArgs.getArgCount() > 1)
+                {
+                    setTextColor(color::yellow());
+                    printLn("CVar update takes one argument. Ignoring extraneous ones...");
+                    restoreTextColor();
+                }
+                if (!cvar->setStringValue(cmdArgs[0]))
+                {
+                    setTextColor(color::yellow());
+                    printF("Cannot set %s to \"%s\"!\n", cmdName, cmdArgs[0]);
+                    restoreTextColor();
+                }
+            }
+            return;
+        }
+    }
+
+    //
+    // Check the built-in commands second:
+    //
+    if (const BuiltInCmd * const builtIn = getBuiltInCommand(cmdName))
+    {
+        builtIn->handler(*this);
+        return;
+    }
+
+    //
+    // Try the user-defined commands last:
+    //
+    if ((cmdManager != nullptr) && cmdManager->findCommand(cmdName))
+    {
+        cmdManager->execute(cmdExecMode, firstNonWhite);
+        return;
+    }
+
+    printF("%s: Command not found.\n", cmdName);
+}
+
+void SimpleCommandTerminal::addCmdToHistory(const char * cmd)
+{
+    if (indexCmdHistory < CmdHistoryMaxSize) // Insert at front:
+    {
+        cmdHistory[indexCmdHistory++] = cmd;
+    }
+    else // Full, remove oldest:
+    {
+        CFG_ASSERT(indexCmdHistory == CmdHistoryMaxSize);
+
+        // Pop tail and shift everyone:
+        for (int i = 0; i < indexCmdHistory - 1; ++i)
+        {
+            cmdHistory[i] = cmdHistory[i + 1];
+        }
+
+        // Insert new at front:
+        cmdHistory[indexCmdHistory - 1] = cmd;
+    }
+
+    currCmdInHistory = indexCmdHistory - 1;
+}
+
+bool SimpleCommandTerminal::nextCmdFromHistory()
+{
+    CFG_ASSERT(currCmdInHistory >= 0 && currCmdInHistory < lengthOfArray(cmdHistory));
+    const char * cmd = cmdHistory[currCmdInHistory].c_str();
+
+    if (currCmdInHistory > 0)
+    {
+        --currCmdInHistory;
+        if (std::strcmp(cmd, lineBuffer) == 0 && currCmdInHistory >= 0)
+        {
+            cmd = cmdHistory[currCmdInHistory].c_str();
+        }
+    }
+
+    setLineBuffer(cmd);
+    return true;
+}
+
+bool SimpleCommandTerminal::prevCmdFromHistory()
+{
+    const char * cmd;
+    if (currCmdInHistory < (indexCmdHistory - 1))
+    {
+        ++currCmdInHistory;
+        CFG_ASSERT(currCmdInHistory >= 0 && currCmdInHistory < lengthOfArray(cmdHistory));
+        cmd = cmdHistory[currCmdInHistory].c_str();
+
+        // Need this check if going up and down on the same two commands.
+        if (std::strcmp(cmd, lineBuffer) == 0 && currCmdInHistory < indexCmdHistory)
+        {
+            ++currCmdInHistory;
+            cmd = cmdHistory[currCmdInHistory].c_str();
+        }
+    }
+    else
+    {
+        cmd = "";
+    }
+
+    setLineBuffer(cmd);
+    return true;
+}
+
+bool SimpleCommandTerminal::navigateTextLeft()
+{
+    if (lineBufferInsertionPos <= 0)
+    {
+        return true; // Return whether the input was handled or not.
+                     // In this case, always true.
+    }
+
+    lineBufferInsertionPos--;
+    redrawInputLine();
+    return true;
+}
+
+bool SimpleCommandTerminal::navigateTextRight()
+{
+    if (lineBufferInsertionPos >= lineBufferUsed)
+    {
+        return true; // Same as above.
+    }
+
+    lineBufferInsertionPos++;
+    redrawInputLine();
+    return true;
+}
+
+void SimpleCommandTerminal::redrawInputLine()
+{
+    // Workaround to position the cursor without
+    // a gotoxy()-like function: redraw the whole line.
+    printF("\r%s%.*s", newlineMarkerStr.c_str(), lineBufferInsertionPos, lineBuffer);
+}
+
+bool SimpleCommandTerminal::handleCtrlKey(const char chr)
+{
+    switch (chr)
+    {
+    // Copy input line to clipboard: PC=CTRL+c, Mac=CMD+c
+    case 'c' :
+        onSetClipboardString(lineBuffer);
+        return true;
+
+    // Paste from clipboard: PC=CTRL+v, Mac=CMD+v
+    case 'v' :
+        for (const char * str = onGetClipboardString();
+             str != nullptr && *str != '\0'; ++str)
+        {
+            // Using this loop to allow inserting at the current cursor pos.
+            insertChar(*str);
+        }
+        return true;
+
+    // [CTRL] + l clears the screen
+    case 'l' :
+        clear();
+        return true;
+
+    // Unix-style command history: [CTRL] + n = previous command
+    case 'n' :
+        return prevCmdFromHistory();
+
+    // Unix-style command history: [CTRL] + p = next command
+    case 'p' :
+        return nextCmdFromHistory();
+
+    default :
+        return false;
+    } // switch (chr)
+}
+
+bool SimpleCommandTerminal::hasFullNameInLineBuffer() const
+{
+    bool foundNonWhiteChar = false;
+    for (int i = 0; i < lineBufferUsed; ++i)
+    {
+        if (lineBuffer[i] != ' ')
+        {
+            foundNonWhiteChar = true;
+        }
+        else
+        {
+            if (!foundNonWhiteChar)
+            {
+                continue;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void SimpleCommandTerminal::listAllCommands()
+{
+    if (cmdManager == nullptr)
+    {
+        return;
+    }
+
+    if (!listAllCmdsOnTab)
+    {
+        printF("\rPress [%s] again to list commands...\n",
+               SpecialKeys::toString(SpecialKeys::Tab).c_str());
+        listAllCmdsOnTab = true;
+        return;
+    }
+
+    //
+    // List all available commands (or up to MaxCompletionMatches):
+    //
+
+    struct CmdList
+    {
+        int count = 0;
+        const Command * cmds[MaxCompletionMatches]{};
+    };
+    CmdList cmdList{};
+
+    cmdManager->enumerateAllCommands(
+            [](Command * cmd, void * userContext)
+            {
+                auto list = static_cast<CmdList *>(userContext);
+                if (list->count == SimpleCommandTerminal::MaxCompletionMatches)
+                {
+                    return false; // Stop the enumeration.
+                }
+                list->cmds[list->count++] = cmd;
+                return true;
+            },
+            &cmdList);
+
+    std::sort(cmdList.cmds, cmdList.cmds + cmdList.count,
+              [](const Command * const a, const Command * const b)
+              {
+                  return cmdCmpNames(a->getNameCString(), b->getNameCString()) < 0;
+              });
+
+    int cmdsWrittenInALine = 0;
+    const int builtInCount = getBuiltInCommandsCount();
+
+    // List the build-ins first in alternate color:
+    setTextColor(color::cyan());
+    for (int c = 0; c < builtInCount; ++c)
+    {
+        const BuiltInCmd * const cmd = getBuiltInCommand(c);
+        printF("%-*s", MaxCommandNameLength, cmd->name);
+
+        if (++cmdsWrittenInALine >= MaxCmdMatchesPerLine && c != (builtInCount - 1))
+        {
+            cmdsWrittenInALine = 0;
+            print("\n");
+        }
+    }
+
+    // Now the rest in normal color:
+    restoreTextColor();
+    for (int c = 0; c < cmdList.count; ++c)
+    {
+        const Command * const cmd = cmdList.cmds[c];
+        printF("%-*s", MaxCommandNameLength, cmd->getNameCString());
+
+        if (++cmdsWrittenInALine >= MaxCmdMatchesPerLine && c != (cmdList.count - 1))
+        {
+            cmdsWrittenInALine = 0;
+            print("\n");
+        }
+    }
+
+    const int totalCmds = cmdManager->getRegisteredCommandsCount();
+    if (cmdList.count < totalCmds)
+    {
+        setTextColor(color::cyan());
+        printF("\n+%i commands...", (totalCmds - cmdList.count));
+        restoreTextColor();
+    }
+
+    newLineWithMarker();
+    listAllCmdsOnTab = false;
+}
+
+void SimpleCommandTerminal::listMatches(const char * const partialStr, const char ** matches, const int matchesFound,
+                                        const int maxMatches, const int maxPerLine, const int spacing, const bool coloredMatch)
+{
+    int writtenInALine   = 0;
+    const int partialLen = lengthOfString(partialStr);
+
+    for (int i = 0; i < matchesFound; ++i)
+    {
+        if (i != maxMatches)
+        {
+            CFG_ASSERT(matches[i] != nullptr);
+
+            if (coloredMatch)
+            {
+                setTextColor(color::cyan());
+                printF("%.*s", partialLen, matches[i]);
+                restoreTextColor();
+            }
+            else
+            {
+                printF("%.*s", partialLen, matches[i]);
+            }
+
+            if (maxPerLine > 1)
+            {
+                printF("%-*s", spacing - partialLen, matches[i] + partialLen); // A bunch per line, column align.
+            }
+            else
+            {
+                printF("%s", matches[i] + partialLen); // One per line.
+            }
+        }
+        else
+        {
+            setTextColor(color::cyan());
+            printF("+%i matches...", (matchesFound - maxMatches));
+            restoreTextColor();
+            break;
+        }
+
+        if (++writtenInALine >= maxPerLine)
+        {
+            if ((matchesFound - i) > 1)
+            {
+                print("\n");
+            }
+            writtenInALine = 0;
+        }
+    }
+}
+
+bool SimpleCommandTerminal::displayCompletionMatches(const char * const partialString, const int maxPerLine,
+                                                     const bool whitespaceAfter1Match, const bool allowCyclingValues,
+                                                     const FindMatchesCallback & findMatchesCb)
+{
+    if (firstAutoCompletionTry) // Fist [TAB], list possible matches and save them for subsequent cycling:
+    {
+        int matchesFound = 0;
+        findMatchesCb(*this, partialString, completionMatches, &matchesFound, MaxCompletionMatches);
+
+        if (matchesFound <= 0)
+        {
+            return false; // No matches for auto-completion.
+        }
+
+        if (matchesFound == 1) // Exactly one:
+        {
+            const int partialLen    = lengthOfString(partialString);
+            const char * completion = completionMatches[0] + partialLen;
+
+            lineBufferUsed += copyString(lineBuffer + lineBufferUsed, lengthOfArray(lineBuffer) - lineBufferUsed, completion);
+
+            if (whitespaceAfter1Match)
+            {
+                lineBuffer[lineBufferUsed++] = ' ';
+                lineBuffer[lineBufferUsed]   = '\0';
+                printF("%s ", completion);
+            }
+            else
+            {
+                printF("%s", completion);
+            }
+
+            lineBufferInsertionPos = lineBufferUsed;
+        }
+        else // There is more than one match, print a list:
+        {
+            const int maxMatches = MaxCompletionMatches;
+
+            newLineNoMarker();
+            listMatches(partialString, completionMatches, matchesFound, maxMatches,
+                        maxPerLine, MaxCommandNameLength, allowCyclingValues);
+            newLineWithMarker();
+            print(lineBuffer);
+
+            if (allowCyclingValues)
+            {
+                // Save for [TAB] cycling:
+                firstAutoCompletionTry = false;
+                completionMatchCount   = std::min(matchesFound, maxMatches);
+                partialStrLength       = lengthOfString(partialString);
+                oldLineBufferUsed      = lineBufferUsed;
+            }
+        }
+
+        return true;
+    }
+    else // Cycling a list of possible matches after the first [TAB]:
+    {
+        const int partialLen  = std::min(partialStrLength, LineBufferMaxSize - 1);
+        const char * matchStr = completionMatches[nextDisplayedCompletionMatch];
+
+        clearVisibleEditLine();
+        if ((oldLineBufferUsed - partialLen) > 0)
+        {
+            printF("%.*s", oldLineBufferUsed - partialLen, lineBuffer);
+        }
+
+        // Partial name in normal color:
+        printF("%.*s", partialLen, matchStr);
+
+        // Auto-completed guess in alternate color:
+        setTextColor(color::cyan());
+        print(matchStr + partialLen);
+        restoreTextColor();
+
+        lineBufferUsed  = oldLineBufferUsed;
+        lineBufferUsed += copyString(lineBuffer + lineBufferUsed, lengthOfArray(lineBuffer) - lineBufferUsed, matchStr + partialLen);
+        lineBufferInsertionPos = lineBufferUsed;
+
+        // Cycle in case the user hits TAB again.
+        nextDisplayedCompletionMatch = (nextDisplayedCompletionMatch + 1) % completionMatchCount;
+        return true;
+    }
+}
+
+// warning C4706: assignment within conditional expression
+// Granted, to logic in the following function is a bit dodgy,
+// should review that in the future...
+#ifdef _MSC_VER
+    #pragma warning(push)
+    #pragma warning(disable: 4706)
+#endif // _MSC_VER
+
+bool SimpleCommandTerminal::tabCompletion()
+{
+    if (lineBufferInsertionPos != lineBufferUsed)
+    {
+        // Auto-completion not attempted if the cursor is not at the end of input line.
+        return true;
+    }
+
+    if (isLineBufferEmpty())
+    {
+        listAllCommands(); // Only after 2 consecutive TABs.
+        return true;
+    }
+
+    // A Command or CVar name is already completed, now we'll do argument auto-completion:
+    if (hasFullNameInLineBuffer())
+    {
+        // Check for "$(var)" CVar substitution/expansion and try to complete the var name:
+        if (const char * cvarExpansionPtr = std::strrchr(lineBuffer, '$'))
+        {
+            if (cvarManager != nullptr && *(++cvarExpansionPtr) == '(')
+            {
+                if (!std::strrchr(++cvarExpansionPtr, ')')) // If the "$(..." not closed yet, try completing:
+                {
+                    auto findMatchesCallback = [](SimpleCommandTerminal & term, const char * const partialName,
+                                                  const char ** outMatches, int * outMatchesFound, const int maxMatches)
+                    {
+                        auto cvarMgr = term.getCVarManager();
+                        *outMatchesFound = cvarMgr->findCVarsWithPartialName(partialName, outMatches, maxMatches);
+                    };
+
+                    const char * const partialCVarName = cvarExpansionPtr;
+                    displayCompletionMatches(partialCVarName, MaxCVarMatchesPerLine, false, true, findMatchesCallback);
+                    return true;
+                }
+            }
+        }
+
+        // Command argument or CVar value auto-completion:
+        char cmdName[LineBufferMaxSize];
+        const char * cmdPtr = lineBuffer;
+
+        // Skip leading whitespace:
+        for (; *cmdPtr != '\0' && isWhitespace(*cmdPtr); ++cmdPtr) { }
+
+        // Copy until the first whitespace to get the command name:
+        char * p = cmdName;
+        for (; *cmdPtr != '\0' && !isWhitespace(*cmdPtr); ++p, ++cmdPtr)
+        {
+            *p = *cmdPtr;
+        }
+        *p = '\0';
+
+        int  argCount = 0;
+        bool quotes   = false;
+        bool gotWhite = false;
+
+        // Last partial argument is the completion target.
+        // Quoted strings keep whitespace.
+        const char * lastWsPtr = cmdPtr;
+        for (; *cmdPtr != '\0'; ++cmdPtr)
+        {
+            if (!quotes && isWhitespace(*cmdPtr))
+            {
+                lastWsPtr = cmdPtr; // Save the last whitespace.
+                gotWhite  = true;
+            }
+            else if (*cmdPtr == '"' || *cmdPtr == '\'')
+            {
+                quotes = !quotes;
+            }
+            else // Not whitespace, not quotes:
+            {
+                if (gotWhite)
+                {
+                    gotWhite = false;
+                    ++argCount;
+                }
+            }
+        }
+
+        // Get to the start of the partial argument:
+        for (; *lastWsPtr != '\0' && isWhitespace(*lastWsPtr); ++lastWsPtr) { }
+        const char * const partialArgStr = lastWsPtr;
+
+        //
+        // See if we are completing the value of a CVar or arguments of a command:
+        //
+        const CVar    * cvar = nullptr;
+        const Command * cmd  = nullptr;
+
+        if ((cvarManager != nullptr) && (cvar = cvarManager->findCVar(cmdName)))
+        {
+            std::string * varValueStrings = argStringMatches;
+            auto findMatchesCallback = [cvar, varValueStrings](SimpleCommandTerminal &, const char * const partialArg,
+                                                               const char ** outMatches, int * outMatchesFound, const int maxMatches)
+            {
+                CFG_ASSERT(maxMatches <= MaxCompletionMatches);
+                const int matchesFound = cvar->valueCompletion(partialArg, varValueStrings, maxMatches);
+
+                const int count = std::min(matchesFound, maxMatches);
+                for (int m = 0; m < count; ++m)
+                {
+                    outMatches[m] = varValueStrings[m].c_str();
+                }
+                *outMatchesFound = matchesFound;
+            };
+
+            const bool allowCyclingValues = (*partialArgStr == '\0' || cvar->getValueCompletionCallback() != nullptr);
+            displayCompletionMatches(partialArgStr, MaxArgMatchesPerLine, false, allowCyclingValues, findMatchesCallback);
+        }
+        else if ((cmdManager != nullptr) && (cmd = cmdManager->findCommand(cmdName)))
+        {
+            std::string * argCompletionStrings = argStringMatches;
+            auto findMatchesCallback = [cmd, argCompletionStrings](SimpleCommandTerminal &, const char * const partialArg,
+                                                                   const char ** outMatches, int * outMatchesFound, const int maxMatches)
+            {
+                CFG_ASSERT(maxMatches <= MaxCompletionMatches);
+                const int matchesFound = cmd->argumentCompletion(partialArg, argCompletionStrings, maxMatches);
+
+                const int count = std::min(matchesFound, maxMatches);
+                for (int m = 0; m < count; ++m)
+                {
+                    outMatches[m] = argCompletionStrings[m].c_str();
+                }
+                *outMatchesFound = matchesFound;
+            };
+            displayCompletionMatches(partialArgStr, MaxArgMatchesPerLine, true, true, findMatchesCallback);
+        }
+        // else no match found.
+    }
+    else // Not a full name typed yet, try Cmd/CVar name completion:
+    {
+        // Skip leading whitespace:
+        const char * partialCmdName = lineBuffer;
+        for (; *partialCmdName != '\0' && isWhitespace(*partialCmdName); ++partialCmdName) { }
+
+        // Turns out it was an empty string.
+        if (*partialCmdName == '\0')
+        {
+            return true;
+        }
+
+        //
+        // Try the console built-ins first:
+        //
+        bool matchFound;
+        {
+            auto findMatchesCallback = [](SimpleCommandTerminal & term, const char * const partialName,
+                                          const char ** outMatches, int * outMatchesFound, const int maxMatches)
+            {
+                int matchesFound = 0;
+                const int partialLen = lengthOfString(partialName);
+                for (int i = 0; i < term.getBuiltInCommandsCount(); ++i)
+                {
+                    if (cmdCmpNames(partialName, term.getBuiltInCommand(i)->name, partialLen) == 0)
+                    {
+                        if (matchesFound < maxMatches)
+                        {
+                            outMatches[matchesFound] = term.getBuiltInCommand(i)->name;
+                        }
+                        ++matchesFound;
+                    }
+                }
+                *outMatchesFound = matchesFound;
+            };
+            matchFound = displayCompletionMatches(partialCmdName, MaxCmdMatchesPerLine, true, true, findMatchesCallback);
+        }
+
+        //
+        // CVar names second, to check for setting the var value:
+        //
+        if (!matchFound && cvarManager != nullptr)
+        {
+            auto findMatchesCallback = [](SimpleCommandTerminal & term, const char * const partialName,
+                                          const char ** outMatches, int * outMatchesFound, const int maxMatches)
+            {
+                auto cvarMgr = term.getCVarManager();
+                *outMatchesFound = cvarMgr->findCVarsWithPartialName(partialName, outMatches, maxMatches);
+            };
+            matchFound = displayCompletionMatches(partialCmdName, MaxCVarMatchesPerLine, true, true, findMatchesCallback);
+        }
+
+        //
+        // Lastly the user-defined commands:
+        //
+        if (!matchFound && cmdManager != nullptr)
+        {
+            auto findMatchesCallback = [](SimpleCommandTerminal & term, const char * const partialName,
+                                          const char ** outMatches, int * outMatchesFound, const int maxMatches)
+            {
+                auto cmdMgr = term.getCommandManager();
+                *outMatchesFound = cmdMgr->findCommandsWithPartialName(partialName, outMatches, maxMatches);
+            };
+            displayCompletionMatches(partialCmdName, MaxCmdMatchesPerLine, true, true, findMatchesCallback);
+        }
+    }
+
+    return true;
+}
+
+#ifdef _MSC_VER
+    #pragma warning(pop)
+#endif // _MSC_VER
+
+bool SimpleCommandTerminal::discardInput()
+{
+    currCmdInHistory = indexCmdHistory - 1; // Reset command history traversal marker.
+    setLineBuffer("");
+    return true;
+}
+
+bool SimpleCommandTerminal::popChar()
+{
+    if (isLineBufferEmpty() || lineBufferInsertionPos <= 0)
+    {
+        return true; // Input is always handled by this call, so return true.
+    }
+
+    clearVisibleEditLine();
+
+    if (lineBufferInsertionPos == lineBufferUsed) // Erasing last character only:
+    {
+        lineBufferUsed--;
+        lineBufferInsertionPos--;
+
+        lineBuffer[lineBufferUsed] = '\0';
+        print(lineBuffer);
+    }
+    else // Erasing at arbitrary position:
+    {
+        lineBufferUsed--;
+        lineBufferInsertionPos--;
+
+        int i;
+        for (i = lineBufferInsertionPos; i != lineBufferUsed; ++i)
+        {
+            lineBuffer[i] = lineBuffer[i + 1];
+        }
+        lineBuffer[i] = '\0';
+
+        // Reposition the cursor:
+        print(lineBuffer);
+        redrawInputLine();
+    }
+
+    return true;
+}
+
+bool SimpleCommandTerminal::delChar()
+{
+    if (isLineBufferEmpty() || lineBufferInsertionPos == lineBufferUsed)
+    {
+        return true; // Input is always handled by this call, so return true.
+    }
+
+    clearVisibleEditLine();
+    lineBufferUsed--;
+
+    int i;
+    for (i = lineBufferInsertionPos; i != lineBufferUsed; ++i)
+    {
+        lineBuffer[i] = lineBuffer[i + 1];
+    }
+    lineBuffer[i] = '\0';
+
+    // Reposition the cursor:
+    print(lineBuffer);
+    redrawInputLine();
+    return true;
+}
+
+bool SimpleCommandTerminal::insertChar(const char chr)
+{
+    if (!std::isprint(chr) || lineBufferUsed >= (LineBufferMaxSize - 1))
+    {
+        return false; // Not printable, don't consume the input event.
+    }
+
+    if (lineBufferInsertionPos == lineBufferUsed)
+    {
+        // Inserting at the end, usual case.
+        lineBuffer[lineBufferUsed++] = chr;
+        lineBuffer[lineBufferUsed]   = '\0';
+        lineBufferInsertionPos++;
+
+        // Print the char just pushed:
+        printF("%c", chr);
+    }
+    else // Inserting at any other position:
+    {
+        int i;
+        for (i = lineBufferUsed; i > lineBufferInsertionPos; --i)
+        {
+            lineBuffer[i] = lineBuffer[i - 1];
+        }
+
+        lineBuffer[i] = chr;
+        lineBuffer[++lineBufferUsed] = '\0';
+        lineBufferInsertionPos++;
+
+        // Position the cursor:
+        clearVisibleEditLine();
+        print(lineBuffer);
+        redrawInputLine();
+    }
+
+    return true;
+}
+
+// ========================================================
+// Terminal key decoding:
+// ========================================================
+
+#if defined(CFG_BUILD_UNIX_TERMINAL) || defined(CFG_BUILD_REMOTE_TERMINAL)
+
+static int decodeTerminalKey(const unsigned char * bytes, const int byteCount, const bool incompleteIsEscape, int * outKey)
+{
+    //
+    // Converts the system specific console chars at the start of
+    // 'bytes' to the generic representation of SpecialKeys. Returns
+    // the number of bytes used, or zero if 'bytes' ends in the middle
+    // of an escape sequence and more input is needed to decode it.
+    //
+    // NOTE: For the UnixTerminal this function is
+    // only meant to be called from the input thread.
+    //
+    CFG_ASSERT(byteCount > 0);
+
+    const int c = bytes[0];
+    switch (c)
+    {
+    case '\n' : *outKey = SpecialKeys::Return;    return 1;
+    case '\r' : *outKey = SpecialKeys::Return;    return 1;
+    case 0x7F : *outKey = SpecialKeys::Backspace; return 1;
+    case 0x08 : *outKey = SpecialKeys::Backspace; return 1;
+    case 0x09 : *outKey = SpecialKeys::Tab;       return 1;
+
+    // These are hacks to catch CTRL+c|v, CTRL+p, CTRL+n, CTRL+l, respectively.
+    // Upper bits in the word is the CTRL key flag, lower 8 are the ASCII char.
+    case 0x03 : *outKey = (SpecialKeys::Control | 'c'); return 1;
+    case 0x16 : *outKey = (SpecialKeys::Control | 'v'); return 1;
+    case 0x10 : *outKey = (SpecialKeys::Control | 'p'); return 1;
+    case 0x0E : *outKey = (SpecialKeys::Control | 'n'); return 1;
+    case 0x0C : *outKey = (SpecialKeys::Control | 'l'); return 1;
+
+    case 0x1B : // Arrow key or ESCAPE:
+        {
+            //
+            // Both ESCAPE and the arrow keys start with 0x1B. The arrows are
+            // followed by "[A".."[D" and DELETE by "[3~", which the terminal
+            // sends together with the 0x1B, so a lone 0x1B that is not followed
+            // by more input within a short timeout is the ESCAPE key itself.
+            //
+            *outKey = SpecialKeys::Escape;
+            if (byteCount < 2)
+            {
+                return (incompleteIsEscape ? 1 : 0);
+            }
+            if (bytes[1] != 0x5B)
+            {
+                return 1;
+            }
+            if (byteCount < 3)
+            {
+                return (incompleteIsEscape ? 2 : 0);
+            }
+            switch (bytes[2])
+            {
+            case 0x33 :
+                {
+                    // Delete is another weirdo. It produces
+                    // a trailing input char we must consume.
+                    if (byteCount < 4 && !incompleteIsEscape)
+                    {
+                        return 0;
+                    }
+                    *outKey = SpecialKeys::Delete;
+                    return (byteCount < 4 ? 3 : 4);
+                }
+            case 0x41 : *outKey = SpecialKeys::UpArrow;    break;
+            case 0x42 : *outKey = SpecialKeys::DownArrow;  break;
+            case 0x43 : *outKey = SpecialKeys::RightArrow; break;
+            case 0x44 : *outKey = SpecialKeys::LeftArrow;  break;
+            default   : break;
+            } // switch (bytes[2])
+            return 3;
+        }
+
+    default :
+        *outKey = c; // Any other key
+        return 1;
+    } // switch (c)
+}
+
+#endif // CFG_BUILD_UNIX_TERMINAL || CFG_BUILD_REMOTE_TERMINAL
+
+// ========================================================
+// class UnixTerminal:
+// ========================================================
+
+#ifdef CFG_BUILD_UNIX_TERMINAL
+
+//
+// The input thread owns stdin
+// The main thread owns stdout
+//
+// The input thread sleeps in poll() until stdin has data or it
+// is woken up through a self-pipe. Bytes are read in batches,
+// decoded into key codes and published to the main thread with
+// a single-producer/single-consumer ring buffer, so no locks are
+// needed and keys come out in the same order they were typed.
+//
+class UnixTerminal final
+    : public NativeTerminal
+{
+public:
+
+     UnixTerminal();
+    ~UnixTerminal();
+
+    bool isTTY()    const override;
+    bool hasInput() const override;
+    int  getInput() override;
+    bool waitForInput(int timeoutMilliseconds) override;
+
+    void print(const char * text)   override;
+    void printLn(const char * text) override;
+
+    void clear()  override;
+    void onExit() override;
+
+    // Since clipboard handling requires system-specific code this
+    // class just implements a simple application-side replacement
+    // by keeping a local string. So it will work inside the terminal
+    // but cannot be shared with any other applications.
+    void onSetClipboardString(const char * str) override;
+    const char * onGetClipboardString() override;
+
+    void writeOutput(const char * text, int length) override;
+
+private:
+
+    static void sysCls();
+    static void signalPipe(int fd);
+    static void drainPipe(int fd);
+    static void inputThreadFunction(UnixTerminal * term);
+    void stopInputThread();
+    void printWelcomeMessage();
+
+private:
+
+    // Terminal IO with the TERMIOS library.
+    struct termios oldTermAttr;
+    struct termios newTermAttr;
+
+    // True if stdin & stdout are NOT redirected and we can run interactive mode.
+    volatile bool isATerminal;
+
+    // Signals the input thread to return. Set before writing to the wakeup pipe.
+    std::atomic<bool> quitInputThread;
+
+    // Set by each side before going to sleep, so the other side knows it must write to the pipe.
+    std::atomic<bool> inputThreadWaiting; // Input thread is waiting for free space in the ring.
+    std::atomic<bool> mainThreadWaiting;  // Main thread is inside waitForInput().
+
+    // Self-pipes. [0] is the read end, [1] the write end.
+    int wakeupPipe[2];    // Wakes the input thread, for shutdown or when the ring has space again.
+    int inputReadyPipe[2]; // Wakes the main thread from waitForInput().
+
+    // Thread that listens to the user input and writes to inputRing[].
+    std::thread inputThread;
+
+    // SPSC ring of decoded keys. The positions are free running counters.
+    // Only the input thread writes inputRingWritePos and only the main thread writes inputRingReadPos.
+    static constexpr std::uint32_t InputRingSize = 2048; // Must be a power of two.
+    std::atomic<std::uint32_t> inputRingWritePos;
+    std::atomic<std::uint32_t> inputRingReadPos;
+    std::int32_t inputRing[InputRingSize];
+
+    // Max bytes taken from stdin per read() call.
+    static constexpr int InputReadBatchSize = 256;
+
+    // A lone ESCAPE byte is only reported as the ESCAPE key if the rest
+    // of an arrow key sequence doesn't follow within this many milliseconds.
+    static constexpr int EscapeSequenceTimeoutMs = 30;
+
+    // Local clipboard string, to avoid OS-specific code.
+    // Unfortunately cannot be shared with external applications.
+    std::string clipboardString;
+};
+
+// ========================================================
+// UnixTerminal implementation:
+// ========================================================
+
+// Out-of-class definitions, needed when these are bound to references (e.g. by std::min).
+constexpr std::uint32_t UnixTerminal::InputRingSize;
+constexpr int UnixTerminal::InputReadBatchSize;
+constexpr int UnixTerminal::EscapeSequenceTimeoutMs;
+
+UnixTerminal::UnixTerminal()
+    : isATerminal(false)
+    , quitInputThread(true)
+    , inputThreadWaiting(false)
+    , mainThreadWaiting(false)
+    , inputRingWritePos(0)
+    , inputRingReadPos(0)
+{
+    wakeupPipe[0]     = wakeupPipe[1]     = -1;
+    inputReadyPipe[0] = inputReadyPipe[1] = -1;
+
+    if (!CFG_ISATTY(CFG_STDIN_FILENO) || !CFG_ISATTY(CFG_STDOUT_FILENO))
+    {
+        errorF("stdin/stdout is not a TTY! UnixTerminal refuses to run.");
+        return;
+    }
+
+    //
+    // Non-blocking self-pipes for the thread wakeups:
+    //
+    if (pipe(wakeupPipe) != 0 || pipe(inputReadyPipe) != 0)
+    {
+        errorF("Failed to create the UnixTerminal wakeup pipes!");
+        return;
+    }
+    for (int fd : { wakeupPipe[0], wakeupPipe[1], inputReadyPipe[0], inputReadyPipe[1] })
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    //
+    // Set termios attributes for standard input:
+    //
+    if (tcgetattr(CFG_STDIN_FILENO, &oldTermAttr) != 0)
+    {
+        errorF("Failed to get current terminal settings!");
+        return;
+    }
+
+    newTermAttr = oldTermAttr;      // Make new settings same as old settings
+    newTermAttr.c_lflag &= ~ICANON; // Disable buffered IO
+    newTermAttr.c_lflag &= ~ECHO;   // Disable input echo
+    newTermAttr.c_lflag &= ~ISIG;   // Disable CTRL+c interrupt signals, so we can use it for copy/paste
+    newTermAttr.c_cc[VMIN] = 1;     // Minimum input required = 1 char
+
+    if (tcsetattr(CFG_STDIN_FILENO, TCSANOW, &newTermAttr) != 0)
+    {
+        errorF("Failed to set new terminal settings!");
+        return;
+    }
+
+    isATerminal     = true;
+    quitInputThread = false;
+    clearArray(inputRing);
+
+    // The stream is unbuffered, so batching makes each flush a single write.
+    std::cout.sync_with_stdio(false);
+    std::cout << std::unitbuf;
+    setOutputBufferSize(CFG_TERMINAL_OUTPUT_BUFFER_SIZE);
+
+    printWelcomeMessage();
+
+    // Start the input listener thread:
+    inputThread = std::thread(inputThreadFunction, this);
+}
+
+UnixTerminal::~UnixTerminal()
+{
+    flushOutput();
+
+    // Wait for the input thread to return...
+    stopInputThread();
+
+    // It is very important to restore the original attributes
+    // otherwise the OS might not do it when the application exits.
+    // But only restore it if we ever had a chance to initialize.
+    if (isATerminal)
+    {
+        tcsetattr(CFG_STDIN_FILENO, TCSANOW, &oldTermAttr);
+    }
+
+    for (int fd : { wakeupPipe[0], wakeupPipe[1], inputReadyPipe[0], inputReadyPipe[1] })
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+void UnixTerminal::stopInputThread()
+{
+    quitInputThread = true;
+    if (inputThread.joinable())
+    {
+        // The thread is usually sleeping in poll(), no keypress needed to wake it up.
+        signalPipe(wakeupPipe[1]);
+        inputThread.join();
+    }
+}
+
+void UnixTerminal::signalPipe(const int fd)
+{
+    // The pipe is non-blocking. If it is full there's already a wakeup pending.
+    const char byte = 1;
+    (void)write(fd, &byte, 1);
+}
+
+void UnixTerminal::drainPipe(const int fd)
+{
+    char bytes[64];
+    while (read(fd, bytes, sizeof(bytes)) > 0) { }
+}
+
+void UnixTerminal::inputThreadFunction(UnixTerminal * term)
+{
+    CFG_ASSERT(term != nullptr);
+
+    // Bytes read but not decoded yet. Only an incomplete
+    // escape sequence is ever left over between reads.
+    unsigned char bytes[InputReadBatchSize + 8];
+    int  byteCount   = 0;
+    bool stdinClosed = false;
+
+    // Keep checking for input until the terminal is shutdown.
+    while (!term->quitInputThread)
+    {
+        const std::uint32_t writePos = term->inputRingWritePos.load(std::memory_order_relaxed);
+        const std::uint32_t readPos  = term->inputRingReadPos.load(std::memory_order_acquire);
+
+        // Each key takes at least one byte, so never read more bytes than there are free ring slots.
+        const int freeSlots = static_cast<int>(InputRingSize - (writePos - readPos)) - byteCount;
+        const int readSize  = std::min(freeSlots, InputReadBatchSize);
+        const bool readStdin = (!stdinClosed && readSize > 0);
+
+        pollfd fds[2];
+        fds[0].fd      = term->wakeupPipe[0];
+        fds[0].events  = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd      = (readStdin ? CFG_STDIN_FILENO : -1); // Negative fds are ignored by poll().
+        fds[1].events  = POLLIN;
+        fds[1].revents = 0;
+
+        if (!readStdin)
+        {
+            // Ring is full; sleep until the main thread consumes some keys.
+            // Check again after raising the flag, since getInput() might have just run.
+            term->inputThreadWaiting = true;
+            if (term->inputRingReadPos.load() != readPos)
+            {
+                term->inputThreadWaiting = false;
+                continue;
+            }
+        }
+
+        const int timeoutMs = (byteCount > 0 ? EscapeSequenceTimeoutMs : -1);
+        const int pollResult = poll(fds, 2, timeoutMs);
+        term->inputThreadWaiting = false;
+
+        if (pollResult < 0)
+        {
+            continue; // EINTR
+        }
+        if (fds[0].revents != 0)
+        {
+            drainPipe(term->wakeupPipe[0]);
+        }
+        if (fds[1].revents != 0)
+        {
+            const ssize_t bytesRead = read(CFG_STDIN_FILENO, bytes + byteCount, readSize);
+            if (bytesRead > 0)
+            {
+                byteCount += static_cast<int>(bytesRead);
+            }
+            else if (bytesRead == 0 || (fds[1].revents & (POLLHUP | POLLERR | POLLNVAL)) != 0)
+            {
+                stdinClosed = true; // EOF or error.
+            }
+        }
+
+        // Decode as many complete keys as possible and publish them all at once.
+        // If the poll timed out, a pending escape sequence is not going to be completed.
+        const bool incompleteIsEscape = (pollResult == 0 || stdinClosed);
+        std::uint32_t newWritePos = writePos;
+        int consumed = 0;
+        while (consumed < byteCount)
+        {
+            int key = 0;
+            const int keyBytes = decodeTerminalKey(bytes + consumed, byteCount - consumed, incompleteIsEscape, &key);
+            if (keyBytes == 0)
+            {
+                break;
+            }
+            term->inputRing[newWritePos++ & (InputRingSize - 1)] = key;
+            consumed += keyBytes;
+        }
+        if (consumed > 0)
+        {
+            byteCount -= consumed;
+            std::memmove(bytes, bytes + consumed, byteCount);
+        }
+
+        if (newWritePos != writePos)
+        {
+            term->inputRingWritePos.store(newWritePos);
+            if (term->mainThreadWaiting.exchange(false))
+            {
+                signalPipe(term->inputReadyPipe[1]);
+            }
+        }
+    }
+}
+
+bool UnixTerminal::isTTY() const
+{
+    return isATerminal;
+}
+
+bool UnixTerminal::hasInput() const
+{
+    if (!isATerminal)
+    {
+        // Never return input if not initialized properly.
+        return false;
+    }
+    return inputRingReadPos.load(std::memory_order_relaxed) != inputRingWritePos.load(std::memory_order_acquire);
+}
+
+int UnixTerminal::getInput()
+{
+    if (!hasInput())
+    {
+        // Null input if not initialized properly
+        // or if nothing in the buffer.
+        return 0;
+    }
+
+    const std::uint32_t readPos = inputRingReadPos.load(std::memory_order_relaxed);
+    const int key = inputRing[readPos & (InputRingSize - 1)];
+    inputRingReadPos.store(readPos + 1);
+
+    // The input thread stops reading stdin while the ring is full.
+    if (inputThreadWaiting.exchange(false))
+    {
+        signalPipe(wakeupPipe[1]);
+    }
+    return key;
+}
+
+bool UnixTerminal::waitForInput(const int timeoutMilliseconds)
+{
+    if (!isATerminal)
+    {
+        return false;
+    }
+
+    // Don't leave text behind while the caller sleeps.
+    flushOutput();
+
+    if (hasInput())
+    {
+        return true;
+    }
+
+    // Raise the flag first, so a key pushed right after the hasInput()
+    // check below is guaranteed to write to the pipe and wake us up.
+    mainThreadWaiting = true;
+    if (!hasInput() && !quitInputThread)
+    {
+        pollfd fd;
+        fd.fd      = inputReadyPipe[0];
+        fd.events  = POLLIN;
+        fd.revents = 0;
+        poll(&fd, 1, timeoutMilliseconds);
+    }
+    mainThreadWaiting = false;
+
+    drainPipe(inputReadyPipe[0]);
+    return hasInput();
+}
+
+void UnixTerminal::printWelcomeMessage()
+{
+    if (!isATerminal)
+    {
+        return;
+    }
+
+    sysCls();
+
+    const std::time_t currTime = std::time(nullptr);
+    std::string timeStr = std::ctime(&currTime);
+    timeStr.pop_back(); // Pop the default newline added by ctime.
+
+    printF("+----------%s Unix Terminal %s----------+\n"
+           "|   Session started: %s   |\n"
+           "|     %s      |\n"
+           "+-----------------------------------+\n",
+           color::cyan(), color::restore(),
+           ttyname(CFG_STDIN_FILENO), timeStr.c_str());
+
+    newLineWithMarker();
+}
+
+void UnixTerminal::print(const char * text)
+{
+    // We can print even if redirected to a file.
+    if (text != nullptr && *text != '\0')
+    {
+        bufferOutput(text, lengthOfString(text));
+    }
+}
+
+void UnixTerminal::printLn(const char * text)
+{
+    // We can print even if redirected to a file.
+    // printLn() can take an empty string to just output the newline.
+    if (text != nullptr)
+    {
+        bufferOutput(text, lengthOfString(text));
+        bufferOutput("\n", 1);
+    }
+}
+
+void UnixTerminal::writeOutput(const char * text, const int length)
+{
+    std::cout.write(text, length);
+}
+
+void UnixTerminal::clear()
+{
+    if (!isATerminal)
+    {
+        return;
+    }
+
+    flushOutput();
+    sysCls();
+
+    // Let the parent class set the newline marker, etc.
+    SimpleCommandTerminal::clear();
+}
+
+void UnixTerminal::onExit()
+{
+    // Stop the thread now instead of waiting for the destructor.
+    stopInputThread();
+    printLn("");
+    flushOutput();
+}
+
+void UnixTerminal::onSetClipboardString(const char * str)
+{
+    clipboardString = str;
+}
+
+const char * UnixTerminal::onGetClipboardString()
+{
+    return clipboardString.c_str();
+}
+
+void UnixTerminal::sysCls()
+{
+    // Relying on system() is a major security hole, but this is
+    // just a demo for the SimpleCommandTerminal, so I'm cool with it :P.
+    //
+    // The void cast is so silence this warning:
+    //  "ignoring return value of 'int system(const char*)', declared with attribute warn_unused_result [-Wunused-result]"
+    // Don't really care if it succeeded or not.
+    (void)std::system("clear");
+}
+
+#endif // CFG_BUILD_UNIX_TERMINAL
+
+// ========================================================
+// class WindowsTerminal:
+// ========================================================
+
+#ifdef CFG_BUILD_WIN_TERMINAL
+
+//
+// Simple ConIO-based Windows terminal.
+//
+class WindowsTerminal final
+    : public NativeTerminal
+{
+public:
+
+     WindowsTerminal();
+    ~WindowsTerminal();
+
+    bool isTTY()    const override;
+    bool hasInput() const override;
+    int  getInput() override;
+
+    void print(const char * text)   override;
+    void printLn(const char * text) override;
+    void clear() override;
+
+    void writeOutput(const char * text, int length) override;
+
+private:
+
+    void printWelcomeMessage();
+    bool isATerminal;
+};
+
+// ========================================================
+// WindowsTerminal implementation:
+// ========================================================
+
+WindowsTerminal::WindowsTerminal()
+{
+    if (!CFG_ISATTY(CFG_STDIN_FILENO) || !CFG_ISATTY(CFG_STDOUT_FILENO))
+    {
+        errorF("stdin/stdout is not a TTY! WindowsTerminal refuses to run.");
+        isATerminal = false;
+        return;
+    }
+
+    // The stream is unbuffered, so batching makes each flush a single write.
+    std::cout.sync_with_stdio(false);
+    std::cout << std::unitbuf;
+    setOutputBufferSize(CFG_TERMINAL_OUTPUT_BUFFER_SIZE);
+
+    isATerminal = true;
+    printWelcomeMessage();
+}
+
+WindowsTerminal::~WindowsTerminal()
+{
+    flushOutput();
+}
+
+bool WindowsTerminal::isTTY() const
+{
+    return isATerminal;
+}
+
+bool WindowsTerminal::hasInput() const
+{
+    if (!isATerminal)
+    {
+        // Never return input if not initialized properly.
+        return false;
+    }
+    return _kbhit() != 0;
+}
+
+int WindowsTerminal::getInput()
+{
+    if (!isATerminal)
+    {
+        return 0;
+    }
+
+    // _getch reference: https://msdn.microsoft.com/en-us/library/078sfkak.aspx
+    const int key = _getch();
+
+    // Check for special keys:
+    switch (key)
+    {
+    case 0x0D : return SpecialKeys::Return;
+    case 0x09 : return SpecialKeys::Tab;
+    case 0x08 : return SpecialKeys::Backspace;
+    case 0x1b : return SpecialKeys::Escape;
+    // Hacks to catch CTRL+key:
+    case 0x10 : return (SpecialKeys::Control | 'p');
+    case 0x0E : return (SpecialKeys::Control | 'n');
+    case 0x0C : return (SpecialKeys::Control | 'l');
+    // Some special keys produce two consecutive codes:
+    case 0xE0 :
+        switch (_getch())
+        {
+        case 0x53 : return SpecialKeys::Delete;
+        case 0x48 : return SpecialKeys::UpArrow;
+        case 0x50 : return SpecialKeys::DownArrow;
+        case 0x4D : return SpecialKeys::RightArrow;
+        case 0x4B : return SpecialKeys::LeftArrow;
+        default   : return '?'; // Unknown key code.
+        } // switch (_getch())
+    default :
+        break;
+    } // switch (key)
+
+    return key;
+}
+
+void WindowsTerminal::print(const char * text)
+{
+    // We can print even if redirected to a file.
+    if (text != nullptr && *text != '\0')
+    {
+        bufferOutput(text, lengthOfString(text));
+    }
+}
+
+void WindowsTerminal::printLn(const char * text)
+{
+    // We can print even if redirected to a file.
+    // printLn() can take an empty string to just output the newline.
+    if (text != nullptr)
+    {
+        bufferOutput(text, lengthOfString(text));
+        bufferOutput("\n", 1);
+    }
+}
+
+void WindowsTerminal::writeOutput(const char * text, const int length)
+{
+    std::cout.write(text, length);
+}
+
+void WindowsTerminal::clear()
+{
+    if (!isATerminal)
+    {
+        return;
+    }
+
+    // Feeling lazy, but there's an alternative to "CLS":
+    // https://msdn.microsoft.com/en-us/library/windows/desktop/ms682022(v=vs.85).aspx
+    flushOutput();
+    (void)std::system("cls");
+
+    // Let the parent class set the newline marker, etc.
+    SimpleCommandTerminal::clear();
+}
+
+void WindowsTerminal::printWelcomeMessage()
+{
+    if (!isATerminal)
+    {
+        return;
+    }
+
+    (void)std::system("cls");
+
+    char timeStr[256] = {'\0'};
+    const std::time_t currTime = std::time(nullptr);
+    ctime_s(timeStr, lengthOfArray(timeStr), &currTime);
+    timeStr[lengthOfString(timeStr) - 1] = '\0'; // Erase the default newline added by ctime.
+
+    printF("+-------- Windows Terminal ---------+\n"
+           "|        Session started on:        |\n"
+           "|      %s     |\n"
+           "+-----------------------------------+\n",
+           timeStr);
+
+    newLineWithMarker();
+}
+
+#endif // CFG_BUILD_WIN_TERMINAL
+
+// ========================================================
+// NativeTerminal implementation:
+// ========================================================
+
+NativeTerminal::~NativeTerminal()
+{ }
+
+bool NativeTerminal::waitForInput(int /* timeoutMilliseconds */)
+{
+    // Default for terminals that can't block on their input.
+    return hasInput();
+}
+
+NativeTerminal * NativeTerminal::createUnixTerminalInstance()
+{
+    #ifdef CFG_BUILD_UNIX_TERMINAL
+    auto unixTerm = memAlloc<UnixTerminal>(1, MemoryCategory::Terminals);
+    return construct(unixTerm);
+    #else // !CFG_BUILD_UNIX_TERMINAL
+    return nullptr;
+    #endif // CFG_BUILD_UNIX_TERMINAL
 }
 
-bool SimpleCommandTerminal::delChar()
+NativeTerminal * NativeTerminal::createWindowsTerminalInstance()
 {
-    if (isLineBufferEmpty() || lineBufferInsertionPos == lineBufferUsed)
-    {
-        return true; // Input is always handled by this call, so return true.
-    }
+    #ifdef CFG_BUILD_WIN_TERMINAL
+    auto winTerm = memAlloc<WindowsTerminal>(1, MemoryCategory::Terminals);
+    return construct(winTerm);
+    #else // !CFG_BUILD_WIN_TERMINAL
+    return nullptr;
+    #endif // CFG_BUILD_WIN_TERMINAL
+}
 
-    clearVisibleEditLine();
-    lineBufferUsed--;
+void NativeTerminal::destroyInstance(NativeTerminal * term)
+{
+    destroy(term);
+    memFree(term);
+}
 
-    int i;
-    for (i = lineBufferInsertionPos; i != lineBufferUsed; ++i)
-    {
-        lineBuffer[i] = lineBuffer[i + 1];
-    }
-    lineBuffer[i] = '\0';
+// ========================================================
+// struct RemoteOutputChunk:
+// ========================================================
 
-    // Reposition the cursor:
-    print(lineBuffer);
-    redrawInputLine();
-    return true;
-}
+#ifdef CFG_BUILD_REMOTE_TERMINAL
 
-bool SimpleCommandTerminal::insertChar(const char chr)
+//
+// A block of text output shared by the sessions of a
+// RemoteTerminalServer. Each session queues a reference
+// to it, and the last one to send the text frees it.
+// The text follows the header in the same allocation.
+//
+struct RemoteOutputChunk final
 {
-    if (!std::isprint(chr) || lineBufferUsed >= (LineBufferMaxSize - 1))
+    int refCount; // Sessions that still have to send this block.
+    int length;   // Chars of text after the header.
+
+    const char * getText() const noexcept
     {
-        return false; // Not printable, don't consume the input event.
+        return reinterpret_cast<const char *>(this + 1);
     }
 
-    if (lineBufferInsertionPos == lineBufferUsed)
+    // Converts newlines to CR+LF, since the clients are in raw mode.
+    static RemoteOutputChunk * create(const char * const text, const int textLength)
     {
-        // Inserting at the end, usual case.
-        lineBuffer[lineBufferUsed++] = chr;
-        lineBuffer[lineBufferUsed]   = '\0';
-        lineBufferInsertionPos++;
+        int newlines = 0;
+        for (int i = 0; i < textLength; ++i)
+        {
+            newlines += (text[i] == '\n');
+        }
 
-        // Print the char just pushed:
-        printF("%c", chr);
+        auto chunk = reinterpret_cast<RemoteOutputChunk *>(memAlloc<char>(sizeof(RemoteOutputChunk) + textLength + newlines, MemoryCategory::Terminals));
+        chunk->refCount = 0;
+        chunk->length   = textLength + newlines;
+
+        char * dest = reinterpret_cast<char *>(chunk + 1);
+        for (int i = 0; i < textLength; ++i)
+        {
+            if (text[i] == '\n')
+            {
+                *dest++ = '\r';
+            }
+            *dest++ = text[i];
+        }
+        return chunk;
     }
-    else // Inserting at any other position:
+
+    static void release(RemoteOutputChunk * chunk) noexcept
     {
-        int i;
-        for (i = lineBufferUsed; i > lineBufferInsertionPos; --i)
+        CFG_ASSERT(chunk->refCount > 0);
+        if (--chunk->refCount == 0)
         {
-            lineBuffer[i] = lineBuffer[i - 1];
+            memFree(chunk);
         }
-
-        lineBuffer[i] = chr;
-        lineBuffer[++lineBufferUsed] = '\0';
-        lineBufferInsertionPos++;
-
-        // Position the cursor:
-        clearVisibleEditLine();
-        print(lineBuffer);
-        redrawInputLine();
     }
+};
 
-    return true;
+static void setSocketNonBlocking(const int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+    #ifdef SO_NOSIGPIPE
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+    #endif // SO_NOSIGPIPE
 }
 
 // ========================================================
-// class UnixTerminal:
+// class RemoteTerminalSession:
 // ========================================================
 
-#ifdef CFG_BUILD_UNIX_TERMINAL
-
 //
-// The input thread owns stdin
-// The main thread owns stdout
+// The terminal of a client connected to a RemoteTerminalServer.
+// Input bytes are read in batches from the non-blocking socket
+// and fed to handleKeyInput(). Output goes to a queue of shared
+// chunks that is drained with scatter/gather writes.
 //
-class UnixTerminal final
-    : public NativeTerminal
+class RemoteTerminalSession final
+    : public SimpleCommandTerminal
 {
 public:
 
-     UnixTerminal();
-    ~UnixTerminal();
-
-    bool isTTY()    const override;
-    bool hasInput() const override;
-    int  getInput() override;
+    RemoteTerminalSession(int socket, CommandManager * cmdMgr, CVarManager * cvarMgr);
+    ~RemoteTerminalSession();
 
     void print(const char * text)   override;
     void printLn(const char * text) override;
+    void clear() override;
 
-    void clear()  override;
-    void onExit() override;
+    void sendWelcomeMessage(int sessionId, bool telnetNegotiation);
 
-    // Since clipboard handling requires system-specific code this
-    // class just implements a simple application-side replacement
-    // by keeping a local string. So it will work inside the terminal
-    // but cannot be shared with any other applications.
-    void onSetClipboardString(const char * str) override;
-    const char * onGetClipboardString() override;
+    // Queues a reference to a block of output. Fails if the client fell too far behind.
+    bool enqueueOutput(RemoteOutputChunk * chunk);
 
-private:
+    // Both return false if the connection was lost.
+    bool receiveInput();
+    bool sendOutput();
 
-    static void sysCls();
-    static int  sysWaitChar();
-    static void inputThreadFunction(UnixTerminal * term);
-    void printWelcomeMessage();
+    // Decodes a lone ESCAPE byte once it is clear no arrow key sequence will follow it.
+    void checkEscapeTimeout(std::chrono::steady_clock::time_point now);
 
-private:
+    int  getSocket()         const noexcept { return socketFd; }
+    bool hasPendingOutput()  const noexcept { return sendQueueHead != sendQueue.size(); }
+    bool hasPendingEscape()  const noexcept { return inputByteCount > 0; }
+    bool shouldDisconnect()  const noexcept { return disconnected || overflowed || exit(); }
 
-    // Terminal IO with the TERMIOS library.
-    struct termios oldTermAttr;
-    struct termios newTermAttr;
+    // Same timeout of the UnixTerminal.
+    static constexpr int EscapeSequenceTimeoutMs = 30;
 
-    // True if stdin & stdout are NOT redirected and we can run interactive mode.
-    volatile bool isATerminal;
+protected:
 
-    // Signals the input thread to return. No need for an atomic,
-    // there's no harm if the input thread sees an inconsistent
-    // state for a frame, it will get the message eventually.
-    volatile bool quitInputThread;
+    void writeOutput(const char * text, int length) override;
 
-    // Thread that listens to the user input and writes to inputBuffer[].
-    std::thread inputThread;
+private:
 
-    // Next index to write in the input buffer/stack.
-    std::atomic<int> inputBufferInsertionPos;
+    void decodeInput(bool incompleteIsEscape);
 
-    // Line input buffer for our async terminal:
-    static constexpr int InputBufferSize = 2048;
-    std::int32_t inputBuffer[InputBufferSize];
+    enum TelnetState : std::uint8_t
+    {
+        TelnetData,       // Normal input.
+        TelnetCommand,    // Got an IAC, command byte follows.
+        TelnetOption,     // Got IAC WILL/WONT/DO/DONT, option byte follows.
+        TelnetSubNeg,     // Inside an IAC SB ... IAC SE sub-negotiation.
+        TelnetSubNegIac   // Got an IAC inside a sub-negotiation.
+    };
 
-    // Local clipboard string, to avoid OS-specific code.
-    // Unfortunately cannot be shared with external applications.
-    std::string clipboardString;
+    static constexpr int InputBufferSize = 4096;
+
+    const int   socketFd;               // Non-blocking client socket. Owned by the session.
+    bool        disconnected;           // Set when the socket is closed by the client or an error happens.
+    bool        overflowed;             // Set when the pending output exceeded CFG_REMOTE_TERMINAL_MAX_PENDING_OUTPUT.
+    bool        lastInputWasCR;         // A LF or NUL right after a CR is part of the same [RETURN].
+    TelnetState telnetState;            // Telnet commands are filtered out of the input.
+    int         inputByteCount;         // Bytes of inputBytes[] not decoded yet (an incomplete escape sequence).
+    int         pendingOutputChars;     // Total chars of the queued chunks not sent yet.
+    int         sendOffset;             // Chars of the first queued chunk already sent.
+    std::size_t sendQueueHead;          // Index of the first chunk in sendQueue[] not fully sent.
+    MemVector<RemoteOutputChunk *, MemoryCategory::Terminals> sendQueue;
+    std::chrono::steady_clock::time_point escapeDeadline;
+    unsigned char inputBytes[InputBufferSize + 8];
 };
 
-// ========================================================
-// UnixTerminal implementation:
-// ========================================================
+// Needed when bound to a reference, e.g. by std::chrono::milliseconds.
+constexpr int RemoteTerminalSession::EscapeSequenceTimeoutMs;
 
-UnixTerminal::UnixTerminal()
-    : isATerminal(false)
-    , quitInputThread(true)
+RemoteTerminalSession::RemoteTerminalSession(const int socket, CommandManager * cmdMgr, CVarManager * cvarMgr)
+    : SimpleCommandTerminal(cmdMgr, cvarMgr)
+    , socketFd(socket)
+    , disconnected(false)
+    , overflowed(false)
+    , lastInputWasCR(false)
+    , telnetState(TelnetData)
+    , inputByteCount(0)
+    , pendingOutputChars(0)
+    , sendOffset(0)
+    , sendQueueHead(0)
 {
-    if (!CFG_ISATTY(CFG_STDIN_FILENO) || !CFG_ISATTY(CFG_STDOUT_FILENO))
+    setOutputBufferSize(CFG_TERMINAL_OUTPUT_BUFFER_SIZE);
+}
+
+RemoteTerminalSession::~RemoteTerminalSession()
+{
+    for (std::size_t i = sendQueueHead; i < sendQueue.size(); ++i)
     {
-        errorF("stdin/stdout is not a TTY! UnixTerminal refuses to run.");
-        return;
+        RemoteOutputChunk::release(sendQueue[i]);
     }
+    close(socketFd);
+}
 
-    //
-    // Set termios attributes for standard input:
-    //
-    if (tcgetattr(CFG_STDIN_FILENO, &oldTermAttr) != 0)
+void RemoteTerminalSession::print(const char * text)
+{
+    if (text != nullptr && *text != '\0')
     {
-        errorF("Failed to get current terminal settings!");
-        return;
+        bufferOutput(text, lengthOfString(text));
     }
+}
 
-    newTermAttr = oldTermAttr;      // Make new settings same as old settings
-    newTermAttr.c_lflag &= ~ICANON; // Disable buffered IO
-    newTermAttr.c_lflag &= ~ECHO;   // Disable input echo
-    newTermAttr.c_lflag &= ~ISIG;   // Disable CTRL+c interrupt signals, so we can use it for copy/paste
-    newTermAttr.c_cc[VMIN] = 1;     // Minimum input required = 1 char
-
-    if (tcsetattr(CFG_STDIN_FILENO, TCSANOW, &newTermAttr) != 0)
+void RemoteTerminalSession::printLn(const char * text)
+{
+    if (text != nullptr)
     {
-        errorF("Failed to set new terminal settings!");
-        return;
+        bufferOutput(text, lengthOfString(text));
+        bufferOutput("\n", 1);
     }
+}
 
-    isATerminal             = true;
-    quitInputThread         = false;
-    inputBufferInsertionPos = 0;
-    clearArray(inputBuffer);
+void RemoteTerminalSession::clear()
+{
+    // ANSI clear screen and cursor to the top-left corner.
+    bufferOutput("\033[2J\033[H", 7);
 
-    std::cout.sync_with_stdio(false);
-    std::cout << std::unitbuf; // Unbuffered.
+    // Let the parent class set the newline marker, etc.
+    SimpleCommandTerminal::clear();
+}
 
-    printWelcomeMessage();
+void RemoteTerminalSession::sendWelcomeMessage(const int sessionId, const bool telnetNegotiation)
+{
+    if (telnetNegotiation)
+    {
+        // IAC WILL ECHO, IAC WILL SUPPRESS-GO-AHEAD: character mode with echo done by us.
+        const char telnetCommands[] = { '\xFF', '\xFB', '\x01', '\xFF', '\xFB', '\x03' };
+        RemoteOutputChunk * chunk = reinterpret_cast<RemoteOutputChunk *>(
+            memAlloc<char>(sizeof(RemoteOutputChunk) + sizeof(telnetCommands), MemoryCategory::Terminals));
+        chunk->refCount = 0;
+        chunk->length   = sizeof(telnetCommands);
+        std::memcpy(chunk + 1, telnetCommands, sizeof(telnetCommands));
+        enqueueOutput(chunk);
+    }
 
-    // Start the input listener thread:
-    inputThread = std::thread(inputThreadFunction, this);
+    printF("+--------%s Remote Terminal %s--------+\n"
+           "|         Session #%-5i          |\n"
+           "+-----------------------------------+\n",
+           color::cyan(), color::restore(), sessionId);
+
+    newLineWithMarker();
 }
 
-UnixTerminal::~UnixTerminal()
+bool RemoteTerminalSession::enqueueOutput(RemoteOutputChunk * chunk)
 {
-    // It is very important to restore the original attributes
-    // otherwise the OS might not do it when the application exits.
-    // But only restore it if we ever had a chance to initialize.
-    if (isATerminal)
+    if (overflowed)
     {
-        tcsetattr(CFG_STDIN_FILENO, TCSANOW, &oldTermAttr);
+        return false;
+    }
+    if (pendingOutputChars + chunk->length > CFG_REMOTE_TERMINAL_MAX_PENDING_OUTPUT)
+    {
+        overflowed = true;
+        return false;
     }
 
-    // Wait for the input thread to return...
-    quitInputThread = true;
-    if (inputThread.joinable())
+    chunk->refCount++;
+    pendingOutputChars += chunk->length;
+    sendQueue.push_back(chunk);
+    return true;
+}
+
+void RemoteTerminalSession::writeOutput(const char * text, const int length)
+{
+    RemoteOutputChunk * chunk = RemoteOutputChunk::create(text, length);
+    if (!enqueueOutput(chunk))
     {
-        inputThread.join();
+        memFree(chunk);
     }
 }
 
-void UnixTerminal::inputThreadFunction(UnixTerminal * term)
+bool RemoteTerminalSession::sendOutput()
 {
-    CFG_ASSERT(term != nullptr);
+    constexpr int MaxIOVecs = 64;
 
-    // Keep checking for input until the terminal is shutdown.
-    while (!term->quitInputThread && term->isATerminal)
+    while (hasPendingOutput() && !disconnected)
     {
-        if (term->inputBufferInsertionPos < UnixTerminal::InputBufferSize)
+        iovec ioVecs[MaxIOVecs];
+        int ioVecCount = 0;
+        for (std::size_t i = sendQueueHead; i < sendQueue.size() && ioVecCount < MaxIOVecs; ++i, ++ioVecCount)
+        {
+            const int offset = (i == sendQueueHead ? sendOffset : 0);
+            ioVecs[ioVecCount].iov_base = const_cast<char *>(sendQueue[i]->getText() + offset);
+            ioVecs[ioVecCount].iov_len  = sendQueue[i]->length - offset;
+        }
+
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov    = ioVecs;
+        message.msg_iovlen = ioVecCount;
+
+        const ssize_t result = sendmsg(socketFd, &message, CFG_SOCKET_SEND_FLAGS);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break; // Socket buffer full. Wait for POLLOUT.
+            }
+            disconnected = true;
+            return false;
+        }
+
+        // Release the chunks that were fully sent.
+        int charsSent = static_cast<int>(result);
+        pendingOutputChars -= charsSent;
+        while (charsSent > 0)
         {
-            term->inputBuffer[term->inputBufferInsertionPos++] = sysWaitChar();
+            RemoteOutputChunk * chunk = sendQueue[sendQueueHead];
+            const int charsLeft = chunk->length - sendOffset;
+            if (charsSent < charsLeft)
+            {
+                sendOffset += charsSent;
+                break;
+            }
+            charsSent -= charsLeft;
+            sendOffset = 0;
+            RemoteOutputChunk::release(chunk);
+            ++sendQueueHead;
         }
     }
+
+    // Compact the queue once the sent entries dominate it.
+    if (sendQueueHead == sendQueue.size())
+    {
+        sendQueue.clear();
+        sendQueueHead = 0;
+    }
+    else if (sendQueueHead > 64 && sendQueueHead * 2 > sendQueue.size())
+    {
+        sendQueue.erase(sendQueue.begin(), sendQueue.begin() + sendQueueHead);
+        sendQueueHead = 0;
+    }
+    return !disconnected;
 }
 
-bool UnixTerminal::isTTY() const
+bool RemoteTerminalSession::receiveInput()
 {
-    return isATerminal;
+    // Bound the work per call, so a client pasting a lot of text doesn't starve the others.
+    constexpr int MaxReadsPerCall = 16;
+
+    for (int r = 0; r < MaxReadsPerCall; ++r)
+    {
+        unsigned char bytes[InputBufferSize];
+        const ssize_t result = read(socketFd, bytes, InputBufferSize - inputByteCount);
+        if (result == 0)
+        {
+            disconnected = true;
+            return false;
+        }
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            disconnected = true;
+            return false;
+        }
+
+        // Filter out the telnet commands:
+        for (ssize_t i = 0; i < result; ++i)
+        {
+            const unsigned char c = bytes[i];
+            switch (telnetState)
+            {
+            case TelnetData :
+                if (c == 0xFF) { telnetState = TelnetCommand; }
+                else           { inputBytes[inputByteCount++] = c; }
+                break;
+            case TelnetCommand :
+                if (c >= 0xFB && c <= 0xFE) { telnetState = TelnetOption; } // WILL/WONT/DO/DONT
+                else if (c == 0xFA)         { telnetState = TelnetSubNeg; } // SB
+                else if (c == 0xFF)         { telnetState = TelnetData; inputBytes[inputByteCount++] = c; } // Escaped 0xFF
+                else                        { telnetState = TelnetData; }
+                break;
+            case TelnetOption :
+                telnetState = TelnetData;
+                break;
+            case TelnetSubNeg :
+                if (c == 0xFF) { telnetState = TelnetSubNegIac; }
+                break;
+            case TelnetSubNegIac :
+                telnetState = (c == 0xF0 ? TelnetData : TelnetSubNeg); // SE
+                break;
+            } // switch (telnetState)
+        }
+
+        decodeInput(false);
+        if (inputByteCount > 0)
+        {
+            escapeDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(EscapeSequenceTimeoutMs);
+        }
+    }
+    return true;
 }
 
-bool UnixTerminal::hasInput() const
+void RemoteTerminalSession::checkEscapeTimeout(const std::chrono::steady_clock::time_point now)
 {
-    if (!isATerminal)
+    if (inputByteCount > 0 && now >= escapeDeadline)
     {
-        // Never return input if not initialized properly.
-        return false;
+        decodeInput(true);
     }
-    return inputBufferInsertionPos > 0;
 }
 
-int UnixTerminal::getInput()
+void RemoteTerminalSession::decodeInput(const bool incompleteIsEscape)
 {
-    if (!isATerminal || inputBufferInsertionPos <= 0)
+    int consumed = 0;
+    while (consumed < inputByteCount && !exit())
     {
-        // Null input if not initialized properly
-        // or if nothing in the buffer.
-        return 0;
+        const unsigned char c = inputBytes[consumed];
+        if (lastInputWasCR && (c == '\n' || c == '\0'))
+        {
+            // CR+LF or CR+NUL from a telnet client is a single [RETURN].
+            lastInputWasCR = false;
+            ++consumed;
+            continue;
+        }
+        lastInputWasCR = (c == '\r');
+
+        int key = 0;
+        const int keyBytes = decodeTerminalKey(inputBytes + consumed, inputByteCount - consumed, incompleteIsEscape, &key);
+        if (keyBytes == 0)
+        {
+            break;
+        }
+        consumed += keyBytes;
+
+        // Upper 24bits are a SpecialKeys constant or zero.
+        // Lower 8bits are an ASCII char or zero.
+        handleKeyInput(key & 0xFFFFFF00, key & 0xFF);
+    }
+
+    if (exit())
+    {
+        inputByteCount = 0; // Ignore anything typed after "exit".
+    }
+    else if (consumed > 0)
+    {
+        inputByteCount -= consumed;
+        std::memmove(inputBytes, inputBytes + consumed, inputByteCount);
     }
-    return inputBuffer[--inputBufferInsertionPos];
 }
 
-void UnixTerminal::printWelcomeMessage()
+// ========================================================
+// class RemoteTerminalServerImpl:
+// ========================================================
+
+class RemoteTerminalServerImpl final
+    : public RemoteTerminalServer
 {
-    if (!isATerminal)
-    {
-        return;
-    }
+public:
 
-    sysCls();
+    RemoteTerminalServerImpl(CommandManager * cmdMgr, CVarManager * cvarMgr);
+    ~RemoteTerminalServerImpl();
 
-    const std::time_t currTime = std::time(nullptr);
-    std::string timeStr = std::ctime(&currTime);
-    timeStr.pop_back(); // Pop the default newline added by ctime.
+    bool listenTcp(int port, const char * bindAddress, bool telnetNegotiation) override;
+    bool listenUnix(const char * socketPath) override;
+    int  serve(int timeoutMilliseconds) override;
+    int  getSessionCount() const override;
+    void closeAllSessions() override;
 
-    printF("+----------%s Unix Terminal %s----------+\n"
-           "|   Session started: %s   |\n"
-           "|     %s      |\n"
-           "+-----------------------------------+\n",
-           color::cyan(), color::restore(),
-           ttyname(CFG_STDIN_FILENO), timeStr.c_str());
+    void print(const char * text)   override;
+    void printLn(const char * text) override;
 
-    newLineWithMarker();
+    // No new line marker for the shared output, the sessions print their own.
+    void update() override;
+
+protected:
+
+    void writeOutput(const char * text, int length) override;
+
+private:
+
+    struct Listener final
+    {
+        int         socketFd;
+        bool        telnetNegotiation;
+        MemString<MemoryCategory::Terminals> unixSocketPath; // Empty for TCP.
+    };
+
+    template<typename T>
+    using Array = MemVector<T, MemoryCategory::Terminals>;
+
+    bool startListening(int socket, const void * address, socklen_t addressSize,
+                        bool telnetNegotiation, const char * unixSocketPath);
+    void acceptClients(const Listener & listener);
+    void flushSessions();
+    void removeDisconnectedSessions();
+
+    int nextSessionId;
+    Array<Listener> listeners;
+    Array<RemoteTerminalSession *> sessions;
+    Array<pollfd> pollFds;
+};
+
+RemoteTerminalServerImpl::RemoteTerminalServerImpl(CommandManager * cmdMgr, CVarManager * cvarMgr)
+    : RemoteTerminalServer(cmdMgr, cvarMgr)
+    , nextSessionId(0)
+{
+    setOutputBufferSize(CFG_TERMINAL_OUTPUT_BUFFER_SIZE);
 }
 
-void UnixTerminal::print(const char * text)
+RemoteTerminalServerImpl::~RemoteTerminalServerImpl()
 {
-    // We can print even if redirected to a file.
-    if (text != nullptr && *text != '\0')
+    closeAllSessions();
+
+    for (const Listener & listener : listeners)
     {
-        std::cout << text;
+        close(listener.socketFd);
+        if (!listener.unixSocketPath.empty())
+        {
+            unlink(listener.unixSocketPath.c_str());
+        }
     }
 }
 
-void UnixTerminal::printLn(const char * text)
+bool RemoteTerminalServerImpl::startListening(const int socket, const void * address, const socklen_t addressSize,
+                                              const bool telnetNegotiation, const char * unixSocketPath)
 {
-    // We can print even if redirected to a file.
-    // printLn() can take an empty string to just output the newline.
-    if (text != nullptr)
+    if (bind(socket, static_cast<const sockaddr *>(address), addressSize) != 0 || listen(socket, SOMAXCONN) != 0)
     {
-        std::cout << text << std::endl;
+        errorF("RemoteTerminalServer failed to listen: %s", std::strerror(errno));
+        close(socket);
+        return false;
     }
+
+    setSocketNonBlocking(socket);
+    listeners.push_back({ socket, telnetNegotiation, (unixSocketPath != nullptr ? unixSocketPath : "") });
+    return true;
 }
 
-void UnixTerminal::clear()
+bool RemoteTerminalServerImpl::listenTcp(const int port, const char * bindAddress, const bool telnetNegotiation)
 {
-    if (!isATerminal)
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(static_cast<std::uint16_t>(port));
+
+    if (bindAddress == nullptr || inet_pton(AF_INET, bindAddress, &address.sin_addr) != 1)
     {
-        return;
+        return errorF("RemoteTerminalServer: Invalid bind address \"%s\".", (bindAddress != nullptr ? bindAddress : ""));
     }
 
-    sysCls();
+    const int socketFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (socketFd < 0)
+    {
+        return errorF("RemoteTerminalServer failed to create a TCP socket: %s", std::strerror(errno));
+    }
 
-    // Let the parent class set the newline marker, etc.
-    SimpleCommandTerminal::clear();
+    int yes = 1;
+    setsockopt(socketFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    return startListening(socketFd, &address, sizeof(address), telnetNegotiation, nullptr);
 }
 
-void UnixTerminal::onExit()
+bool RemoteTerminalServerImpl::listenUnix(const char * socketPath)
 {
-    // Signal the thread to return now instead of waiting for the destructor.
-    quitInputThread = true;
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
 
-    // But the thread might still be waiting on sysWaitChar(), so we
-    // need to ask the user to hit another key so that the terminal
-    // may shutdown properly.
-    printLn("Press any key to continue...");
-    if (inputThread.joinable())
+    if (socketPath == nullptr || *socketPath == '\0' ||
+        lengthOfString(socketPath) >= static_cast<int>(sizeof(address.sun_path)))
     {
-        inputThread.join();
+        return errorF("RemoteTerminalServer: Invalid Unix socket path.");
     }
-    printLn("");
-}
-
-void UnixTerminal::onSetClipboardString(const char * str)
-{
-    clipboardString = str;
-}
+    copyString(address.sun_path, sizeof(address.sun_path), socketPath);
 
-const char * UnixTerminal::onGetClipboardString()
-{
-    return clipboardString.c_str();
-}
+    const int socketFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketFd < 0)
+    {
+        return errorF("RemoteTerminalServer failed to create a Unix socket: %s", std::strerror(errno));
+    }
 
-void UnixTerminal::sysCls()
-{
-    // Relying on system() is a major security hole, but this is
-    // just a demo for the SimpleCommandTerminal, so I'm cool with it :P.
-    //
-    // The void cast is so silence this warning:
-    //  "ignoring return value of 'int system(const char*)', declared with attribute warn_unused_result [-Wunused-result]"
-    // Don't really care if it succeeded or not.
-    (void)std::system("clear");
+    unlink(socketPath); // Stale socket file of a previous run.
+    return startListening(socketFd, &address, sizeof(address), false, socketPath);
 }
 
-int UnixTerminal::sysWaitChar()
+void RemoteTerminalServerImpl::acceptClients(const Listener & listener)
 {
-    //
-    // Converts any system specific console char
-    // to the generic representation of SpecialKeys.
-    //
-    // NOTE: This function is only meant to be called
-    // from the input thread.
-    //
-    int c = std::getchar();
-    switch (c)
+    for (;;)
     {
-    case '\n' : return SpecialKeys::Return;
-    case '\r' : return SpecialKeys::Return;
-    case 0x7F : return SpecialKeys::Backspace;
-    case 0x09 : return SpecialKeys::Tab;
-
-    // These are hacks to catch CTRL+c|v, CTRL+p, CTRL+n, CTRL+l, respectively.
-    // Upper bits in the word is the CTRL key flag, lower 8 are the ASCII char.
-    case 0x03 : return (SpecialKeys::Control | 'c');
-    case 0x16 : return (SpecialKeys::Control | 'v');
-    case 0x10 : return (SpecialKeys::Control | 'p');
-    case 0x0E : return (SpecialKeys::Control | 'n');
-    case 0x0C : return (SpecialKeys::Control | 'l');
-
-    default :
-        if (c == 0x1B) // Arrow key or ESCAPE:
+        const int clientFd = accept(listener.socketFd, nullptr, nullptr);
+        if (clientFd < 0)
         {
-            //
-            // Unlikely to be able to fix it but just to leave registered:
-            //
-            // There is a "bug" with the ESCAPE key.
-            // To get an ESC event the user will have to type it TWICE.
-            // The fist time it will enter the if above, but since both
-            // ESC and the arrows return 0x1B we have to getchar() again
-            // to know which key was really pressed.
-            //
-            // If it was an arrow key, getchar will return immediately, but if it was
-            // the ESCAPE key, it will block and only return at the next key press.
-            //
-            // NOTE: This was only observed and tested on a Mac Laptop keyboard.
-            //
-            c = std::getchar();
-            if (c == 0x5B)
+            if (errno == EINTR)
             {
-                c = std::getchar();
-                switch (c)
-                {
-                case 0x33 :
-                    {
-                        // Delete is another weirdo. It produces a trailing
-                        // input char we must consume before retuning.
-                        std::getchar();
-                        return SpecialKeys::Delete;
-                    }
-                case 0x41 : return SpecialKeys::UpArrow;
-                case 0x42 : return SpecialKeys::DownArrow;
-                case 0x43 : return SpecialKeys::RightArrow;
-                case 0x44 : return SpecialKeys::LeftArrow;
-                default   : break;
-                } // switch (c)
+                continue;
             }
-            return SpecialKeys::Escape;
+            break; // EAGAIN or an error with this client only.
         }
-        break;
-    } // switch (c)
-
-    return c; // Any other key
-}
 
-#endif // CFG_BUILD_UNIX_TERMINAL
+        if (static_cast<int>(sessions.size()) >= CFG_REMOTE_TERMINAL_MAX_SESSIONS)
+        {
+            const char message[] = "Too many remote terminal sessions. Try again later.\r\n";
+            (void)send(clientFd, message, sizeof(message) - 1, CFG_SOCKET_SEND_FLAGS);
+            close(clientFd);
+            continue;
+        }
 
-// ========================================================
-// class WindowsTerminal:
-// ========================================================
+        setSocketNonBlocking(clientFd);
+        if (listener.unixSocketPath.empty())
+        {
+            // Echo of single keystrokes shouldn't wait for Nagle's algorithm.
+            int yes = 1;
+            setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        }
 
-#ifdef CFG_BUILD_WIN_TERMINAL
+        auto session = memAlloc<RemoteTerminalSession>(1, MemoryCategory::Terminals);
+        construct(session, clientFd, getCommandManager(), getCVarManager());
+        session->sendWelcomeMessage(++nextSessionId, listener.telnetNegotiation);
+        sessions.push_back(session);
+    }
+}
 
-//
-// Simple ConIO-based Windows terminal.
-//
-class WindowsTerminal final
-    : public NativeTerminal
+void RemoteTerminalServerImpl::flushSessions()
 {
-public:
-
-    WindowsTerminal();
+    // Shared output of the commands goes out first, then the
+    // echo and new line marker of each session. A session only
+    // prints its marker when all buffered commands have run.
+    flushOutput();
 
-    bool isTTY()    const override;
-    bool hasInput() const override;
-    int  getInput() override;
-
-    void print(const char * text)   override;
-    void printLn(const char * text) override;
-    void clear() override;
-
-private:
-
-    void printWelcomeMessage();
-    bool isATerminal;
-};
-
-// ========================================================
-// WindowsTerminal implementation:
-// ========================================================
+    const auto cmdMgr = getCommandManager();
+    const bool commandsPending = (cmdMgr != nullptr && cmdMgr->hasBufferedCommands());
 
-WindowsTerminal::WindowsTerminal()
-{
-    if (!CFG_ISATTY(CFG_STDIN_FILENO) || !CFG_ISATTY(CFG_STDOUT_FILENO))
+    for (RemoteTerminalSession * session : sessions)
     {
-        errorF("stdin/stdout is not a TTY! WindowsTerminal refuses to run.");
-        isATerminal = false;
-        return;
+        if (commandsPending)
+        {
+            session->flushOutput();
+        }
+        else
+        {
+            session->update();
+        }
+        session->sendOutput();
     }
-
-    std::cout.sync_with_stdio(false);
-    std::cout << std::unitbuf; // Unbuffered.
-
-    isATerminal = true;
-    printWelcomeMessage();
 }
 
-bool WindowsTerminal::isTTY() const
+void RemoteTerminalServerImpl::removeDisconnectedSessions()
 {
-    return isATerminal;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < sessions.size(); ++i)
+    {
+        RemoteTerminalSession * session = sessions[i];
+        if (session->shouldDisconnect())
+        {
+            session->flushOutput();
+            session->sendOutput(); // Last chance to say goodbye.
+            destroy(session);
+            memFree(session);
+        }
+        else
+        {
+            sessions[kept++] = session;
+        }
+    }
+    sessions.resize(kept);
 }
 
-bool WindowsTerminal::hasInput() const
+int RemoteTerminalServerImpl::serve(int timeoutMilliseconds)
 {
-    if (!isATerminal)
+    flushSessions();
+    removeDisconnectedSessions();
+
+    pollFds.clear();
+    for (const Listener & listener : listeners)
     {
-        // Never return input if not initialized properly.
-        return false;
+        pollFds.push_back({ listener.socketFd, POLLIN, 0 });
     }
-    return _kbhit() != 0;
-}
 
-int WindowsTerminal::getInput()
-{
-    if (!isATerminal)
+    bool anyPendingEscape = false;
+    for (RemoteTerminalSession * session : sessions)
     {
-        return 0;
+        const short events = POLLIN | (session->hasPendingOutput() ? POLLOUT : 0);
+        pollFds.push_back({ session->getSocket(), events, 0 });
+        anyPendingEscape |= session->hasPendingEscape();
     }
 
-    // _getch reference: https://msdn.microsoft.com/en-us/library/078sfkak.aspx
-    const int key = _getch();
+    if (anyPendingEscape && (timeoutMilliseconds < 0 || timeoutMilliseconds > RemoteTerminalSession::EscapeSequenceTimeoutMs))
+    {
+        timeoutMilliseconds = RemoteTerminalSession::EscapeSequenceTimeoutMs;
+    }
 
-    // Check for special keys:
-    switch (key)
+    if (poll(pollFds.data(), static_cast<nfds_t>(pollFds.size()), timeoutMilliseconds) < 0)
     {
-    case 0x0D : return SpecialKeys::Return;
-    case 0x09 : return SpecialKeys::Tab;
-    case 0x08 : return SpecialKeys::Backspace;
-    case 0x1b : return SpecialKeys::Escape;
-    // Hacks to catch CTRL+key:
-    case 0x10 : return (SpecialKeys::Control | 'p');
-    case 0x0E : return (SpecialKeys::Control | 'n');
-    case 0x0C : return (SpecialKeys::Control | 'l');
-    // Some special keys produce two consecutive codes:
-    case 0xE0 :
-        switch (_getch())
+        return 0; // EINTR
+    }
+
+    int socketsServiced = 0;
+    const std::size_t listenerCount = listeners.size();
+    const std::size_t sessionCount  = sessions.size(); // New clients are not in pollFds.
+    const auto now = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < sessionCount; ++i)
+    {
+        RemoteTerminalSession * session = sessions[i];
+        const short revents = pollFds[listenerCount + i].revents;
+
+        if (revents != 0)
         {
-        case 0x53 : return SpecialKeys::Delete;
-        case 0x48 : return SpecialKeys::UpArrow;
-        case 0x50 : return SpecialKeys::DownArrow;
-        case 0x4D : return SpecialKeys::RightArrow;
-        case 0x4B : return SpecialKeys::LeftArrow;
-        default   : return '?'; // Unknown key code.
-        } // switch (_getch())
-    default :
-        break;
-    } // switch (key)
+            ++socketsServiced;
+        }
+        if ((revents & (POLLIN | POLLHUP | POLLERR)) != 0)
+        {
+            session->receiveInput();
+        }
+        session->checkEscapeTimeout(now);
 
-    return key;
-}
+        // Reply to the keystrokes right away, don't wait for the next serve().
+        session->flushOutput();
+        session->sendOutput();
+    }
 
-void WindowsTerminal::print(const char * text)
-{
-    // We can print even if redirected to a file.
-    if (text != nullptr && *text != '\0')
+    for (std::size_t i = 0; i < listenerCount; ++i)
     {
-        std::cout << text;
+        if (pollFds[i].revents != 0)
+        {
+            acceptClients(listeners[i]);
+            ++socketsServiced;
+        }
     }
+
+    removeDisconnectedSessions();
+    return socketsServiced;
 }
 
-void WindowsTerminal::printLn(const char * text)
+int RemoteTerminalServerImpl::getSessionCount() const
 {
-    // We can print even if redirected to a file.
-    // printLn() can take an empty string to just output the newline.
-    if (text != nullptr)
+    return static_cast<int>(sessions.size());
+}
+
+void RemoteTerminalServerImpl::closeAllSessions()
+{
+    flushOutput();
+    for (RemoteTerminalSession * session : sessions)
     {
-        std::cout << text << std::endl;
+        session->flushOutput();
+        session->sendOutput();
+        destroy(session);
+        memFree(session);
     }
+    sessions.clear();
 }
 
-void WindowsTerminal::clear()
+void RemoteTerminalServerImpl::print(const char * text)
 {
-    if (!isATerminal)
+    if (text != nullptr && *text != '\0')
     {
-        return;
+        bufferOutput(text, lengthOfString(text));
     }
-
-    // Feeling lazy, but there's an alternative to "CLS":
-    // https://msdn.microsoft.com/en-us/library/windows/desktop/ms682022(v=vs.85).aspx
-    (void)std::system("cls");
-
-    // Let the parent class set the newline marker, etc.
-    SimpleCommandTerminal::clear();
 }
 
-void WindowsTerminal::printWelcomeMessage()
+void RemoteTerminalServerImpl::printLn(const char * text)
 {
-    if (!isATerminal)
+    if (text != nullptr)
     {
-        return;
+        bufferOutput(text, lengthOfString(text));
+        bufferOutput("\n", 1);
     }
+}
 
-    (void)std::system("cls");
-
-    char timeStr[256] = {'\0'};
-    const std::time_t currTime = std::time(nullptr);
-    ctime_s(timeStr, lengthOfArray(timeStr), &currTime);
-    timeStr[lengthOfString(timeStr) - 1] = '\0'; // Erase the default newline added by ctime.
-
-    printF("+-------- Windows Terminal ---------+\n"
-           "|        Session started on:        |\n"
-           "|      %s     |\n"
-           "+-----------------------------------+\n",
-           timeStr);
+void RemoteTerminalServerImpl::update()
+{
+    flushOutput();
+}
 
-    newLineWithMarker();
+void RemoteTerminalServerImpl::writeOutput(const char * text, const int length)
+{
+    if (sessions.empty())
+    {
+        return;
+    }
+
+    // Formatted and converted once, then referenced by all the sessions.
+    RemoteOutputChunk * chunk = RemoteOutputChunk::create(text, length);
+    for (RemoteTerminalSession * session : sessions)
+    {
+        session->enqueueOutput(chunk);
+    }
+    if (chunk->refCount == 0)
+    {
+        memFree(chunk);
+    }
 }
 
-#endif // CFG_BUILD_WIN_TERMINAL
+#endif // CFG_BUILD_REMOTE_TERMINAL
 
 // ========================================================
-// NativeTerminal implementation:
+// RemoteTerminalServer implementation:
 // ========================================================
 
-NativeTerminal::~NativeTerminal()
+RemoteTerminalServer::RemoteTerminalServer(CommandManager * cmdMgr, CVarManager * cvarMgr)
+    : SimpleCommandTerminal(cmdMgr, cvarMgr, "")
 { }
 
-NativeTerminal * NativeTerminal::createUnixTerminalInstance()
-{
-    #ifdef CFG_BUILD_UNIX_TERMINAL
-    auto unixTerm = memAlloc<UnixTerminal>(1);
-    return construct(unixTerm);
-    #else // !CFG_BUILD_UNIX_TERMINAL
-    return nullptr;
-    #endif // CFG_BUILD_UNIX_TERMINAL
-}
+RemoteTerminalServer::~RemoteTerminalServer()
+{ }
 
-NativeTerminal * NativeTerminal::createWindowsTerminalInstance()
+RemoteTerminalServer * RemoteTerminalServer::createInstance(CommandManager * cmdMgr, CVarManager * cvarMgr)
 {
-    #ifdef CFG_BUILD_WIN_TERMINAL
-    auto winTerm = memAlloc<WindowsTerminal>(1);
-    return construct(winTerm);
-    #else // !CFG_BUILD_WIN_TERMINAL
+    #ifdef CFG_BUILD_REMOTE_TERMINAL
+    auto server = memAlloc<RemoteTerminalServerImpl>(1, MemoryCategory::Terminals);
+    return construct(server, cmdMgr, cvarMgr);
+    #else // !CFG_BUILD_REMOTE_TERMINAL
+    (void)cmdMgr;
+    (void)cvarMgr;
     return nullptr;
-    #endif // CFG_BUILD_WIN_TERMINAL
+    #endif // CFG_BUILD_REMOTE_TERMINAL
 }
 
-void NativeTerminal::destroyInstance(NativeTerminal * term)
+void RemoteTerminalServer::destroyInstance(RemoteTerminalServer * server)
 {
-    destroy(term);
-    memFree(term);
+    destroy(server);
+    memFree(server);
 }
 
 // ================================================================================================
@@ -7009,7 +14610,8 @@ static void cvarValueOp(const char * const opName, const CommandArgs & args, Sim
         return;
     }
 
-    const double argVal = std::strtod(args[1], nullptr);
+    double argVal;
+    parseDouble(args[1], lengthOfString(args[1]), &argVal);
     const double varVal = cvar->getFloatValue();
 
     OP<double> op;
@@ -7149,7 +14751,7 @@ static void cmdPrint(const CommandArgs & args, SimpleCommandTerminal * term)
         return;
     }
 
-    term->printF("%s = %s;", cvar->getNameCString(), cvar->getStringValue().c_str());
+    term->printF("%s = %s;", cvar->getNameCString(), CVarValueChars(*cvar).c_str());
 
     const std::string flags = cvar->getFlagsString();
     if (!flags.empty())
@@ -7171,8 +14773,8 @@ static void cmdPrint(const CommandArgs & args, SimpleCommandTerminal * term)
         term->printF("  range:[%s, %s];", range[0].c_str(), range[1].c_str());
     }
 
-    const std::string defaultVal = cvar->getDefaultValueString();
-    if (!defaultVal.empty())
+    const CVarValueChars defaultVal{ *cvar, true };
+    if (defaultVal.size() != 0)
     {
         term->printF("  default:%s;", defaultVal.c_str());
     }
@@ -7308,13 +14910,13 @@ static bool findSubstring(const char * const str,    const int strLength,
         int i;
         for (i = 0; i < strLength; ++i)
         {
-            tempStr[i] = static_cast<char>(std::tolower(str[i]));
+            tempStr[i] = asciiToLower(str[i]);
         }
         tempStr[i] = '\0';
 
         for (i = 0; i < subLength; ++i)
         {
-            tempSubstr[i] = static_cast<char>(std::tolower(substr[i]));
+            tempSubstr[i] = asciiToLower(substr[i]);
         }
         tempSubstr[i] = '\0';
 
@@ -7543,6 +15145,186 @@ static void cmdListCmds(const CommandArgs & args, SimpleCommandTerminal * term)
     term->print("=================================================\n");
 }
 
+//
+// profCmds [on|off|reset] [sort=total|max|count]
+//
+// Prints the execution stats of the commands that ran while profiling was on,
+// sorted by total time (the default), max time or call count. "on" and "off"
+// enable/disable the profiling, "reset" clears the stats before printing.
+// Percentiles are the upper bounds of the histogram buckets they fall in.
+//
+static std::uint64_t profileHistogramPercentile(const CommandProfile & profile, const double fraction)
+{
+    const std::uint64_t target = static_cast<std::uint64_t>(profile.callCount * fraction);
+    std::uint64_t count = 0;
+    for (int b = 0; b < CommandProfileHistogramSize; ++b)
+    {
+        count += profile.histogram[b];
+        if (count > target)
+        {
+            return std::uint64_t(1) << b;
+        }
+    }
+    return std::uint64_t(1) << (CommandProfileHistogramSize - 1);
+}
+
+static void cmdProfCmds(const CommandArgs & args, SimpleCommandTerminal * term)
+{
+    if (args.getArgCount() > 2)
+    {
+        printHelp("profCmds", "[on|off|reset] [sort=total|max|count]", term);
+        return;
+    }
+
+    const auto cmdManager = term->getCommandManager();
+    if (cmdManager == nullptr)
+    {
+        return;
+    }
+
+    enum class SortBy { Total, Max, Count };
+    SortBy sortBy = SortBy::Total;
+
+    for (int i = 0; i < args.getArgCount(); ++i)
+    {
+        if (args.compare(i, "on") == 0)
+        {
+            cmdManager->setProfilingEnabled(true);
+        }
+        else if (args.compare(i, "off") == 0)
+        {
+            cmdManager->setProfilingEnabled(false);
+        }
+        else if (args.compare(i, "reset") == 0)
+        {
+            cmdManager->resetProfilingStats();
+        }
+        else if (args.compare(i, "sort=total") == 0)
+        {
+            sortBy = SortBy::Total;
+        }
+        else if (args.compare(i, "sort=max") == 0)
+        {
+            sortBy = SortBy::Max;
+        }
+        else if (args.compare(i, "sort=count") == 0)
+        {
+            sortBy = SortBy::Count;
+        }
+        else
+        {
+            printHelp("profCmds", "[on|off|reset] [sort=total|max|count]", term);
+            return;
+        }
+    }
+
+    std::vector<CommandProfile> profiles(cmdManager->getRegisteredCommandsCount() + 1);
+    const int profileCount = cmdManager->getCommandProfiles(profiles.data(), static_cast<int>(profiles.size()));
+    profiles.resize(std::max(profileCount, 0));
+
+    std::sort(std::begin(profiles), std::end(profiles),
+              [sortBy](const CommandProfile & a, const CommandProfile & b)
+              {
+                  switch (sortBy)
+                  {
+                  case SortBy::Max   : return a.maxTime   > b.maxTime;
+                  case SortBy::Count : return a.callCount > b.callCount;
+                  default            : return a.totalTime > b.totalTime;
+                  } // switch (sortBy)
+              });
+
+    term->print("================ Command Profile ================\n");
+    term->printF("%-*s %10s %12s %10s %10s %10s %8s %8s\n", MaxCommandNameLength - 1, "command",
+                 "calls", "total ms", "avg us", "min us", "max us", "p50 us", "p99 us");
+
+    for (const CommandProfile & profile : profiles)
+    {
+        if (profile.command->isAlias())
+        {
+            term->setTextColor(color::magenta());
+        }
+        term->printF("%-*s ", MaxCommandNameLength - 1, profile.command->getNameCString());
+        if (profile.command->isAlias())
+        {
+            term->restoreTextColor();
+        }
+
+        term->printF("%10llu %12.3f %10.2f %10.2f %10.2f %8llu %8llu\n",
+                     static_cast<unsigned long long>(profile.callCount),
+                     profile.totalTime / 1e6, (profile.totalTime / 1e3) / profile.callCount,
+                     profile.minTime / 1e3, profile.maxTime / 1e3,
+                     static_cast<unsigned long long>(profileHistogramPercentile(profile, 0.50)),
+                     static_cast<unsigned long long>(profileHistogramPercentile(profile, 0.99)));
+    }
+
+    const CommandExecProfile execProfile = cmdManager->getExecProfile();
+    term->setTextColor(color::cyan());
+    term->printF("%u commands profiled, %llu handler calls.\n", static_cast<unsigned>(profiles.size()),
+                 static_cast<unsigned long long>(execProfile.commandsRun));
+    term->printF("parse %.3f ms, tokenize %.3f ms, lookup %.3f ms, %llu lookup misses.\n",
+                 execProfile.parseTime / 1e6, execProfile.tokenizeTime / 1e6, execProfile.lookupTime / 1e6,
+                 static_cast<unsigned long long>(execProfile.lookupMisses));
+    if (!cmdManager->isProfilingEnabled())
+    {
+        term->print("Profiling is disabled. Use 'profCmds on' to enable it.\n");
+    }
+    term->restoreTextColor();
+
+    term->print("=================================================\n");
+}
+
+//
+// memStats [reset]
+//
+// Prints the memory held by the library, by category. Only available
+// if the library was built with CFG_MEMORY_STATS. "reset" resets the
+// peaks to the current live bytes after printing.
+//
+static void cmdMemStats(const CommandArgs & args, SimpleCommandTerminal * term)
+{
+    const bool resetPeaks = (args.getArgCount() == 1 && args.compare(0, "reset") == 0);
+    if (args.getArgCount() > 1 || (args.getArgCount() == 1 && !resetPeaks))
+    {
+        printHelp("memStats", "[reset]", term);
+        return;
+    }
+
+    MemoryStats stats;
+    if (!getMemoryStats(&stats))
+    {
+        term->setTextColor(color::yellow());
+        term->print("Memory stats not available. Build the library with CFG_MEMORY_STATS defined to 1.\n");
+        term->restoreTextColor();
+        return;
+    }
+
+    term->print("================ Memory Stats ===================\n");
+    term->printF("%-16s %12s %12s %10s %10s\n", "category", "live KB", "peak KB", "allocs", "frees");
+
+    auto printStats = [term](const char * const name, const MemoryCategoryStats & catStats)
+    {
+        term->printF("%-16s %12.2f %12.2f %10llu %10llu\n", name,
+                     catStats.liveBytes / 1024.0, catStats.peakBytes / 1024.0,
+                     static_cast<unsigned long long>(catStats.allocCount),
+                     static_cast<unsigned long long>(catStats.freeCount));
+    };
+
+    for (int c = 0; c < static_cast<int>(MemoryCategory::Count); ++c)
+    {
+        printStats(getMemoryCategoryName(static_cast<MemoryCategory>(c)), stats.categories[c]);
+    }
+
+    term->setTextColor(color::cyan());
+    printStats("total", stats.total);
+    term->restoreTextColor();
+
+    if (resetPeaks)
+    {
+        resetMemoryPeaks();
+    }
+    term->print("=================================================\n");
+}
+
 //
 // listCVars [search pattern] [-sort] [-values]
 //
@@ -7663,7 +15445,7 @@ static void cmdListCVars(const CommandArgs & args, SimpleCommandTerminal * term)
     {
         for (const auto cvar : cvarList.patternMatching)
         {
-            term->printF("%-*s \"%s\"\n", cvarList.longestCVarName, cvar->getNameCString(), cvar->getStringValue().c_str());
+            term->printF("%-*s \"%s\"\n", cvarList.longestCVarName, cvar->getNameCString(), CVarValueChars(*cvar).c_str());
         }
     }
     else // Verbose info print:
@@ -7707,32 +15489,31 @@ static void cmdListCVars(const CommandArgs & args, SimpleCommandTerminal * term)
 }
 
 //
-// saveConfig [filename]
-//
-// Writes all modified (persistent) CVars to file and clears the modified
-// flag of each. The filename is optional. If not provided, a default name
-// will be used. Command aliases will also be saved.
-//
-// Warning: Exiting file is overwritten.
+// Full save used by the saveConfig command and to compact the journal.
+// The binary snapshot is written first, while the modified flags are still set.
 //
-static void cmdSaveConfig(const CommandArgs & args, SimpleCommandTerminal * term)
+static bool writeConfigFile(const char * const filename, const bool binary, SimpleCommandTerminal * term)
 {
-    if (args.getArgCount() > 1)
-    {
-        printHelp("saveConfig", "[filename]", term);
-        return;
-    }
-
     const auto cmdManager  = term->getCommandManager();
     const auto cvarManager = term->getCVarManager();
-    const char * filename  = (!args.isEmpty() ? args[0] : CFG_DEFAULT_CONFIG_FILE);
+
+    if (binary && cmdManager != nullptr)
+    {
+        const std::string snapshotFile = std::string(filename) + ".bin";
+        if (!cmdManager->saveConfigSnapshot(snapshotFile.c_str()))
+        {
+            term->setTextColor(color::red());
+            term->printF("Failed to write config snapshot \"%s\".\n", snapshotFile.c_str());
+            term->restoreTextColor();
+        }
+    }
 
     FileIOCallbacks * io = getFileIOCallbacks();
 
     FileHandle fileIn;
     if (!io->open(&fileIn, filename, FileOpenMode::Write))
     {
-        return;
+        return false;
     }
 
     //
@@ -7751,24 +15532,27 @@ static void cmdSaveConfig(const CommandArgs & args, SimpleCommandTerminal * term
     {
         io->writeString(fileIn, "\n# CVars:\n");
 
-        cvarManager->enumerateAllCVars(
+        cvarManager->enumerateCVarsWithFlags(CVar::Flags::Persistent,
                 [](CVar * cvar, void * fileHandle)
                 {
-                    if (cvar->isPersistent())
-                    {
-                        FileIOCallbacks * iocb = getFileIOCallbacks();
-                        auto var = static_cast<const CVarImplBase *>(cvar);
+                    FileIOCallbacks * iocb = getFileIOCallbacks();
+                    auto var = static_cast<const CVarImplBase *>(cvar);
 
-                        char tempStr[MaxCommandArgStrLength];
-                        iocb->writeFormat(fileHandle, "%s\n", var->toCfgString(tempStr, MaxCommandArgStrLength));
-                    }
+                    char tempStr[MaxCommandArgStrLength];
+                    iocb->writeFormat(fileHandle, "%s\n", var->toCfgString(tempStr, MaxCommandArgStrLength));
+                    return true;
+                },
+                fileIn);
 
-                    // Variable was synchronized with the persistent
-                    // storage, so we can now clear the modified flag.
+        // Variables were synchronized with the persistent
+        // storage, so we can now clear the modified flags.
+        cvarManager->enumerateCVarsWithFlags(CVar::Flags::Modified,
+                [](CVar * cvar, void *)
+                {
                     cvar->clearModified();
                     return true;
                 },
-                fileIn);
+                nullptr);
     }
 
     //
@@ -7797,11 +15581,106 @@ static void cmdSaveConfig(const CommandArgs & args, SimpleCommandTerminal * term
     io->writeString(fileIn, "\n");
     io->close(fileIn);
 
-    term->printF("Config file \"%s\" successfully written.\n", filename);
+    //
+    // The main file is now up-to-date, so the journal of
+    // incremental saves is discarded by truncating it.
+    //
+    const std::string journalFile = std::string(filename) + ".journal";
+    if (cmdManager != nullptr)
+    {
+        cmdManager->resetConfigJournal(journalFile.c_str());
+    }
+    else
+    {
+        FileHandle journalOut;
+        if (io->open(&journalOut, journalFile.c_str(), FileOpenMode::Write))
+        {
+            io->close(journalOut);
+        }
+    }
+    return true;
+}
+
+//
+// saveConfig [filename] [-binary] [-incremental]
+//
+// Writes all modified (persistent) CVars to file and clears the modified
+// flag of each. The filename is optional. If not provided, a default name
+// will be used. Command aliases will also be saved.
+//
+// "-binary" also writes a binary snapshot to "<filename>.bin" that can be
+// loaded faster with "reloadConfig -binary". The text file is still written,
+// since it is used as the fallback when the snapshot doesn't match the CVars.
+//
+// "-incremental" only appends the CVars modified since the last save to
+// "<filename>.journal", which is applied by "reloadConfig -incremental".
+// Aliases are not journaled. A full save compacts the journal into the main
+// file and is done automatically once the journal has more than
+// CFG_CONFIG_JOURNAL_MAX_ENTRIES entries.
+//
+// Warning: Exiting file is overwritten.
+//
+static void cmdSaveConfig(const CommandArgs & args, SimpleCommandTerminal * term)
+{
+    if (args.getArgCount() > 3)
+    {
+        printHelp("saveConfig", "[filename] [-binary] [-incremental]", term);
+        return;
+    }
+
+    const char * filename;
+    if (args.isEmpty() ||
+        args.compare(0, "-binary")      == 0 ||
+        args.compare(0, "-incremental") == 0)
+    {
+        filename = CFG_DEFAULT_CONFIG_FILE;
+    }
+    else
+    {
+        filename = args[0];
+    }
+
+    bool binary      = false;
+    bool incremental = false;
+    for (int i = 0; i < args.getArgCount(); ++i)
+    {
+        if (args.compare(i, "-binary") == 0)
+        {
+            binary = true;
+        }
+        else if (args.compare(i, "-incremental") == 0)
+        {
+            incremental = true;
+        }
+    }
+
+    const auto cmdManager = term->getCommandManager();
+    if (incremental && cmdManager != nullptr)
+    {
+        int journalEntries = 0;
+        const std::string journalFile = std::string(filename) + ".journal";
+        if (!cmdManager->appendConfigJournal(journalFile.c_str(), &journalEntries))
+        {
+            term->setTextColor(color::red());
+            term->printF("Failed to write config journal \"%s\".\n", journalFile.c_str());
+            term->restoreTextColor();
+            return;
+        }
+        if (journalEntries <= CFG_CONFIG_JOURNAL_MAX_ENTRIES)
+        {
+            return;
+        }
+        term->printF("Compacting config journal \"%s\" with %i entries.\n", journalFile.c_str(), journalEntries);
+    }
+
+    if (writeConfigFile(filename, binary, term))
+    {
+        term->printF("Config file \"%s\" successfully written.\n", filename);
+    }
 }
 
 //
-// reloadConfig [filename] [-echo] [-force]
+// reloadConfig [filename] [-echo] [-force] [-compiled] [-binary] [-incremental]
 //
 // Loads the configuration file, possibly overwriting the values of currently modified CVars.
 // If there are pending persistent CVars that are not saved yet, this command fails with a
@@ -7809,13 +15688,17 @@ static void cmdSaveConfig(const CommandArgs & args, SimpleCommandTerminal * term
 // will allow updating ReadOnly and InitOnly CVars alike.
 //
 // "-echo" will print each command in the configuration file to the terminal screen.
+// "-compiled" runs the cached compiled program of the file (see CommandManager::compileConfigFile()).
+// "-binary" loads the "<filename>.bin" snapshot written by "saveConfig -binary" instead,
+// falling back to the text file if the snapshot is missing or doesn't match the CVars.
+// "-incremental" then applies the "<filename>.journal" written by "saveConfig -incremental".
 // The filename is optional. If not provided, a default name will be used.
 //
 static void cmdReloadConfig(const CommandArgs & args, SimpleCommandTerminal * term)
 {
-    if (args.getArgCount() > 3)
+    if (args.getArgCount() > 6)
     {
-        printHelp("reloadConfig", "[filename] [-echo] [-force]", term);
+        printHelp("reloadConfig", "[filename] [-echo] [-force] [-compiled] [-binary] [-incremental]", term);
         return;
     }
 
@@ -7829,8 +15712,11 @@ static void cmdReloadConfig(const CommandArgs & args, SimpleCommandTerminal * te
 
     const char * filename;
     if (args.isEmpty() ||
-        args.compare(0, "-echo")  == 0 ||
-        args.compare(0, "-force") == 0)
+        args.compare(0, "-echo")        == 0 ||
+        args.compare(0, "-force")       == 0 ||
+        args.compare(0, "-compiled")    == 0 ||
+        args.compare(0, "-binary")      == 0 ||
+        args.compare(0, "-incremental") == 0)
     {
         // No filename provided or just the flags.
         filename = CFG_DEFAULT_CONFIG_FILE;
@@ -7842,6 +15728,9 @@ static void cmdReloadConfig(const CommandArgs & args, SimpleCommandTerminal * te
 
     bool consoleEcho = false;
     bool forceReload = false;
+    bool useCompiled = false;
+    bool useBinary   = false;
+    bool useJournal  = false;
     for (int i = 0; i < args.getArgCount(); ++i)
     {
         if (args.compare(i, "-echo") == 0)
@@ -7852,6 +15741,18 @@ static void cmdReloadConfig(const CommandArgs & args, SimpleCommandTerminal * te
         {
             forceReload = true;
         }
+        else if (args.compare(i, "-compiled") == 0)
+        {
+            useCompiled = true;
+        }
+        else if (args.compare(i, "-binary") == 0)
+        {
+            useBinary = true;
+        }
+        else if (args.compare(i, "-incremental") == 0)
+        {
+            useJournal = true;
+        }
     }
 
     //
@@ -7859,16 +15760,12 @@ static void cmdReloadConfig(const CommandArgs & args, SimpleCommandTerminal * te
     // If there's any, we will refuse overwriting unless -force is set.
     //
     bool hasModifiedVars = false;
-    cvarManager->enumerateAllCVars(
-            [](CVar * cvar, void * userContext)
+    cvarManager->enumerateCVarsWithFlags(CVar::Flags::Modified,
+            [](CVar *, void * userContext)
             {
-                if (cvar->isModified())
-                {
-                    auto pHasModifiedVars = static_cast<bool *>(userContext);
-                    (*pHasModifiedVars) = true;
-                    return false; // We can stop iterating now.
-                }
-                return true;
+                auto pHasModifiedVars = static_cast<bool *>(userContext);
+                (*pHasModifiedVars) = true;
+                return false; // We can stop iterating now.
             },
             &hasModifiedVars);
 
@@ -7887,36 +15784,68 @@ static void cmdReloadConfig(const CommandArgs & args, SimpleCommandTerminal * te
     // ReadOnly and InitOnly CVars can also be updated by this.
     //
     cvarManager->setAllowWritingReadOnlyVars(true);
-    if (!cmdManager->execConfigFile(filename, (consoleEcho ? term : nullptr)))
+    bool loaded = false;
+    if (useBinary)
     {
-        term->setTextColor(color::red());
-        term->printF("Failed to reload config file \"%s\".\n", filename);
-        term->restoreTextColor();
+        const std::string snapshotFile = std::string(filename) + ".bin";
+        if (cmdManager->loadConfigSnapshot(snapshotFile.c_str()))
+        {
+            term->printF("Config snapshot \"%s\" successfully loaded.\n", snapshotFile.c_str());
+            loaded = true;
+        }
+        else
+        {
+            term->printF("Config snapshot \"%s\" not usable; loading the text file.\n", snapshotFile.c_str());
+        }
     }
-    else
+
+    if (!loaded)
+    {
+        loaded = useCompiled ? cmdManager->execCompiledConfig(filename, (consoleEcho ? term : nullptr))
+                             : cmdManager->execConfigFile(filename, (consoleEcho ? term : nullptr));
+        if (!loaded)
+        {
+            term->setTextColor(color::red());
+            term->printF("Failed to reload config file \"%s\".\n", filename);
+            term->restoreTextColor();
+        }
+        else
+        {
+            term->printF("Config file \"%s\" successfully loaded.\n", filename);
+        }
+    }
+
+    // The journal is newer than the main file, so it is applied last.
+    // It changes on every incremental save, so it is never compiled.
+    if (loaded && useJournal)
     {
-        term->printF("Config file \"%s\" successfully loaded.\n", filename);
+        const std::string journalFile = std::string(filename) + ".journal";
+        if (cmdManager->execConfigFile(journalFile.c_str(), (consoleEcho ? term : nullptr)))
+        {
+            term->printF("Config journal \"%s\" successfully applied.\n", journalFile.c_str());
+        }
     }
     cvarManager->setAllowWritingReadOnlyVars(false);
 }
 
 //
-// exec <config-file | command-string> [-echo]
+// exec <config-file | command-string> [-echo] [-compiled]
 //
 // Executes the first argument. If it is a filename ended in ".cfg" or ".ini",
 // it is loaded and executed as a configuration file. Otherwise, the string is
 // appended in the CommandManager buffer for later execution as a command line.
 //
 // If "-echo" is passed after the filename/string, the commands are echoed to the terminal.
+// "-compiled" runs config files from their cached compiled program (see CommandManager::compileConfigFile()).
 //
 static void cmdExec(const CommandArgs & args, SimpleCommandTerminal * term)
 {
-    if (args.getArgCount() < 1 || args.getArgCount() > 2)
+    if (args.getArgCount() < 1 || args.getArgCount() > 3)
     {
-        printHelp("exec", "<config-file | command-string> [-echo]", term);
+        printHelp("exec", "<config-file | command-string> [-echo] [-compiled]", term);
         return;
     }
-    if (args.compare(0, "-echo") == 0) // Flag in the wrong place?
+    if (args.compare(0, "-echo") == 0 || args.compare(0, "-compiled") == 0) // Flag in the wrong place?
     {
         term->print("Expected filename or command string after 'exec' command.\n");
         return;
@@ -7929,7 +15858,8 @@ static void cmdExec(const CommandArgs & args, SimpleCommandTerminal * term)
     }
 
     const char * execString  = args[0];
-    const bool   consoleEcho = (args.compare(1, "-echo") == 0);
+    const bool   consoleEcho = (args.compare(1, "-echo") == 0 || args.compare(2, "-echo") == 0);
+    const bool   useCompiled = (args.compare(1, "-compiled") == 0 || args.compare(2, "-compiled") == 0);
     bool         isFilename  = false;
 
     //
@@ -7954,7 +15884,9 @@ static void cmdExec(const CommandArgs & args, SimpleCommandTerminal * term)
         term->printF("Executing config file \"%s\"...\n", execString);
 
         // Config files are executed immediately.
-        if (!cmdManager->execConfigFile(execString, (consoleEcho ? term : nullptr)))
+        const bool executed = useCompiled ? cmdManager->execCompiledConfig(execString, (consoleEcho ? term : nullptr))
+                                          : cmdManager->execConfigFile(execString, (consoleEcho ? term : nullptr));
+        if (!executed)
         {
             term->setTextColor(color::red());
             term->printF("Failed to exec config file \"%s\".\n", execString);
@@ -8043,11 +15975,17 @@ void registerDefaultCommands(CommandManager * cmdManager, SimpleCommandTerminal
     cmdManager->registerCommand("listCmds", makeCmdHandler(&cmdListCmds), nullCompletionHandler,
                                 term, "Prints a list of the available commands.");
 
+    cmdManager->registerCommand("profCmds", makeCmdHandler(&cmdProfCmds), nullCompletionHandler,
+                                term, "Prints execution time stats of the commands. Can also enable/disable or reset them.");
+
+    cmdManager->registerCommand("memStats", makeCmdHandler(&cmdMemStats), nullCompletionHandler,
+                                term, "Prints the memory used by the library by category. Can also reset the peaks.");
+
     cmdManager->registerCommand("listCVars", makeCmdHandler(&cmdListCVars), nullCompletionHandler,
                                 term, "Prints a list of the registered CVars.");
 
     cmdManager->registerCommand("saveConfig", makeCmdHandler(&cmdSaveConfig), nullCompletionHandler,
-                                term, "Writes a configuration file with the registered CVars and command aliases. Clears modified flags.");
+                                term, "Writes a config file with the CVars and aliases, or appends modified CVars to its journal.");
 
     cmdManager->registerCommand("reloadConfig", makeCmdHandler(&cmdReloadConfig), nullCompletionHandler,
                                 term, "Loads a configuration file updating existing CVars and possibly creating new ones.");
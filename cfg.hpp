@@ -45,6 +45,36 @@
     #define CFG_PRINTF_FUNC(fmtIndex, varIndex) /* unimplemented */
 #endif // GNU | Clang
 
+//
+// If defined to nonzero, CVar values can be read from any thread while the
+// main thread updates them via the console, 'set', 'reloadConfig', etc.
+// Int, bool, float and enum values are stored as lock-free atomics and
+// string values are guarded by a small reader/writer spin lock owned by
+// each CVar. Registration and removal of CVars are still NOT thread-safe.
+//
+// This changes the inline CVarRef reads, so it must be defined to the same
+// value for cfg.cpp and every file including this header. Zero by default.
+//
+#ifndef CFG_THREAD_SAFE_CVARS
+    #define CFG_THREAD_SAFE_CVARS 0
+#endif // CFG_THREAD_SAFE_CVARS
+
+#if CFG_THREAD_SAFE_CVARS
+    #include <atomic>
+#endif // CFG_THREAD_SAFE_CVARS
+
+//
+// Size in bytes of the inline storage of an InlineDelegate. Callables bound
+// to CommandHandlerInline and CommandArgCompletionInline must fit in it.
+// The default holds an object pointer plus a pointer to member function,
+// or a lambda capturing up to four pointers.
+//
+// Like the above, this must be the same for cfg.cpp and every includer.
+//
+#ifndef CFG_INLINE_DELEGATE_SIZE
+    #define CFG_INLINE_DELEGATE_SIZE 32
+#endif // CFG_INLINE_DELEGATE_SIZE
+
 //
 // All public members of the CFG library are defined inside this namespace.
 //
@@ -57,6 +87,66 @@ class CVarManager;
 class CommandManager;
 class SimpleCommandTerminal;
 
+// ========================================================
+// struct HashedName:
+// ========================================================
+
+//
+// A CVar or Command name with its hashes computed at compile time,
+// when constructed in a constant expression. Both the case sensitive
+// and the case insensitive hashes are kept, so the same value works
+// with any setting of the CFG_*_CASE_SENSITIVE_NAMES switches of cfg.cpp.
+// The name string is referenced, not copied.
+//
+struct HashedName final
+{
+    const char *  name;       // Never null.
+    std::uint32_t hash;       // One-at-a-Time hash of the name.
+    std::uint32_t hashNoCase; // Same, with the ASCII letters lowered.
+
+    constexpr HashedName(const char * str)
+        : name(str)
+        , hash(hashOf(str, false))
+        , hashNoCase(hashOf(str, true))
+    { }
+
+    constexpr HashedName(const char * str, std::uint32_t strHash, std::uint32_t strHashNoCase)
+        : name(str)
+        , hash(strHash)
+        , hashNoCase(strHashNoCase)
+    { }
+
+    // constexpr version of the One-at-a-Time hash used by the manager tables.
+    static constexpr std::uint32_t hashOf(const char * str, bool ignoreCase, std::uint32_t h = 0)
+    {
+        return (*str == '\0') ? finalize(h)
+             : hashOf(str + 1, ignoreCase, mix(h + (ignoreCase ? toLower(*str) : static_cast<std::uint32_t>(*str))));
+    }
+
+private:
+
+    static constexpr std::uint32_t toLower(char c)
+    {
+        return static_cast<std::uint32_t>((c >= 'A' && c <= 'Z') ? (c - 'A' + 'a') : c);
+    }
+    static constexpr std::uint32_t mix(std::uint32_t h)         { return shiftXor(h + (h << 10), 6); }
+    static constexpr std::uint32_t finalize(std::uint32_t h)    { return finalizeStep(shiftXor(h + (h << 3), 11)); }
+    static constexpr std::uint32_t finalizeStep(std::uint32_t h) { return h + (h << 15); }
+    static constexpr std::uint32_t shiftXor(std::uint32_t h, int shift) { return h ^ (h >> shift); }
+};
+
+//
+// Build a HashedName from a string literal, forcing both hashes to be
+// folded at compile time even when used outside of a constant expression,
+// e.g.: cvarManager->findCVar(CFG_CVAR("r_shadowQuality"));
+//
+#define CFG_HASHED_NAME(str)                                                                              \
+    ::cfg::HashedName((str),                                                                              \
+        ::std::integral_constant<std::uint32_t, ::cfg::HashedName::hashOf((str), false)>::value,         \
+        ::std::integral_constant<std::uint32_t, ::cfg::HashedName::hashOf((str), true)>::value)
+#define CFG_CVAR(str) CFG_HASHED_NAME(str)
+#define CFG_CMD(str)  CFG_HASHED_NAME(str)
+
 // ================================================================================================
 //
 //                              CVars - Configuration Variables
@@ -93,6 +183,22 @@ using CVarValueCompletionCallback = int (*)(const char *, std::string *, int);
 //
 using CVarEnumerateCallback = bool (*)(CVar *, void *);
 
+//
+// Callback for the CVar change listeners. See CVarManager::addChangeListener().
+//
+// First argument is the CVar whose value has changed.
+// Second argument is the user-provided "context" pointer
+// that was given when the listener was added.
+//
+using CVarChangeCallback = void (*)(CVar *, void *);
+
+// When the change listeners are called.
+enum class CVarChangeDelivery
+{
+    Immediate, // Called from inside the method that changed the value.
+    Batched    // Queued and called by CVarManager::deliverChangeNotifications().
+};
+
 // ========================================================
 // class CVar:
 // ========================================================
@@ -228,6 +334,23 @@ public:
     virtual std::string getStringValue() const = 0;
     virtual bool setStringValue(std::string newValue) = 0;
 
+    // Allocation-free variants of the string get/set:
+    //
+    // getStringValue() formats the value into the caller buffer, which is
+    // always null terminated, truncating if needed. Returns the length
+    // of the whole value string, so a return >= destSizeInChars means
+    // the output was truncated.
+    //
+    // setStringValue() takes a string that doesn't have to be null terminated.
+    //
+    // getStringValueView() points to the value stored by a String CVar, without
+    // copying. It fails for the other types. The view is valid until the next
+    // value change, so with CFG_THREAD_SAFE_CVARS only use it on the thread
+    // that sets the values.
+    virtual int getStringValue(char * destBuf, int destSizeInChars) const = 0;
+    virtual bool setStringValue(const char * newValue, int length) = 0;
+    virtual bool getStringValueView(const char ** outStr, int * outLength) const = 0;
+
     //
     // Allowed value ranges and default/reset value:
     //
@@ -248,12 +371,328 @@ public:
     // Get the default reset value as a string for Console/Terminal printing.
     virtual std::string getDefaultValueString() const = 0;
 
+    // Same as above, but formats into a caller buffer like getStringValue(char *, int).
+    virtual int getDefaultValueString(char * destBuf, int destSizeInChars) const = 0;
+
     // Similar to getAllowedValueStrings(), but will forward to an argument completion callback
     // first if the CVar has one. If no callback is set, then it returns the allowed values.
+    // Allowed strings and enum constants are filtered by the 'partialVal' prefix and sorted.
     virtual int valueCompletion(const char * partialVal, std::string * outMatches, int maxMatches) const = 0;
     virtual CVarValueCompletionCallback getValueCompletionCallback() const = 0;
 };
 
+// ========================================================
+// class CVarRef:
+// ========================================================
+
+//
+// Maps the value types a CVarRef can be bound to into the CVar type
+// categories that store them. Only the specializations below are defined.
+//
+template<typename T> struct CVarRefTraits;
+template<> struct CVarRefTraits<std::int64_t> { static constexpr CVar::Type TypeTag = CVar::Type::Int;    static constexpr CVar::Type AltTypeTag = CVar::Type::Enum;   };
+template<> struct CVarRefTraits<bool>         { static constexpr CVar::Type TypeTag = CVar::Type::Bool;   static constexpr CVar::Type AltTypeTag = CVar::Type::Bool;   };
+template<> struct CVarRefTraits<double>       { static constexpr CVar::Type TypeTag = CVar::Type::Float;  static constexpr CVar::Type AltTypeTag = CVar::Type::Float;  };
+template<> struct CVarRefTraits<std::string>  { static constexpr CVar::Type TypeTag = CVar::Type::String; static constexpr CVar::Type AltTypeTag = CVar::Type::String; };
+
+//
+// Common base of the typed CVarRef handles. Keeps the handle linked
+// to the CVar it refers to, so that the CVar can null all of its
+// references when it gets removed from the CVarManager.
+//
+// Binding, copying and destroying references is NOT thread-safe and
+// should happen on the same thread that registers and removes the CVars.
+//
+class CVarRefBase
+{
+public:
+
+    // True if bound to a live CVar. References are reset
+    // to null when the CVar they refer to is removed.
+    bool isValid() const noexcept { return valuePtr != nullptr; }
+    explicit operator bool() const noexcept { return isValid(); }
+
+    // The CVar this reference is bound to or null.
+    CVar * getCVar() const noexcept { return cvar; }
+
+    // Unbinds the reference, if bound. isValid() will return false afterwards.
+    void reset();
+
+protected:
+
+    friend class CVarImplBase;
+
+    CVarRefBase() = default;
+    ~CVarRefBase();
+
+    // Copying is done by the typed CVarRef.
+    CVarRefBase(const CVarRefBase &) = delete;
+    CVarRefBase & operator = (const CVarRefBase &) = delete;
+
+    // Binding fails with an error if the CVar type is not one of the given tags.
+    void bind(CVar * target, CVar::Type typeTag, CVar::Type altTypeTag);
+    void copyFrom(const CVarRefBase & other);
+
+    const void  * valuePtr = nullptr; // Points to the value stored inside the CVar instance.
+    CVar        * cvar     = nullptr; // The CVar we are bound to, or null.
+    CVarRefBase * prevRef  = nullptr; // Links in the CVar's list of references.
+    CVarRefBase * nextRef  = nullptr;
+};
+
+//
+// Typed, cached handle to the value of a CVar.
+//
+// Reading a CVar through a CVarRef is a plain load of the value stored
+// inside the CVar, with no name lookup and no virtual function calls,
+// so it can be used by code that reads a lot of vars very frequently.
+// References remain valid across value updates (set*(), 'set', 'reloadConfig',
+// etc) and are automatically nulled if the CVar is removed. Supported types:
+//
+//  std::int64_t => Int and Enum CVars
+//  bool         => Bool CVars
+//  double       => Float CVars
+//  std::string  => String CVars
+//
+// Example:
+//  cfg::CVarRef<std::int64_t> shadowQuality{ cvarManager->registerCVarInt("r_shadowQuality", ...) };
+//  if (shadowQuality.get() > 2) { ... }
+//
+template<typename T>
+class CVarRef final
+    : public CVarRefBase
+{
+public:
+
+    using Traits = CVarRefTraits<T>;
+
+    CVarRef() = default;
+
+    // Binds to the given CVar. A null CVar produces an empty reference.
+    // Fails with an error and yields an empty reference if the types mismatch.
+    explicit CVarRef(CVar * target) { bind(target, Traits::TypeTag, Traits::AltTypeTag); }
+
+    CVarRef(const CVarRef & other) : CVarRefBase() { copyFrom(other); }
+    CVarRef & operator = (const CVarRef & other) { copyFrom(other); return *this; }
+
+    // Rebinds to another CVar or unbinds it if null.
+    void bindTo(CVar * target) { bind(target, Traits::TypeTag, Traits::AltTypeTag); }
+
+    // Reads the current value. The reference must be valid.
+    // With CFG_THREAD_SAFE_CVARS this can be called from any thread.
+    T get() const
+    {
+        CFG_ASSERT(valuePtr != nullptr);
+        #if CFG_THREAD_SAFE_CVARS
+        return static_cast<const std::atomic<T> *>(valuePtr)->load(std::memory_order_acquire);
+        #else // !CFG_THREAD_SAFE_CVARS
+        return *static_cast<const T *>(valuePtr);
+        #endif // CFG_THREAD_SAFE_CVARS
+    }
+};
+
+//
+// String references read through the library, since the
+// string CVar value is not a plain object we can just load.
+//
+template<>
+class CVarRef<std::string> final
+    : public CVarRefBase
+{
+public:
+
+    using Traits = CVarRefTraits<std::string>;
+
+    CVarRef() = default;
+    explicit CVarRef(CVar * target) { bind(target, Traits::TypeTag, Traits::AltTypeTag); }
+
+    CVarRef(const CVarRef & other) : CVarRefBase() { copyFrom(other); }
+    CVarRef & operator = (const CVarRef & other) { copyFrom(other); return *this; }
+
+    void bindTo(CVar * target) { bind(target, Traits::TypeTag, Traits::AltTypeTag); }
+
+    // Copy of the current value. The reference must be valid.
+    // With CFG_THREAD_SAFE_CVARS this can be called from any thread.
+    std::string get() const;
+};
+
+// Shorthand names for the supported reference types.
+using CVarRefInt    = CVarRef<std::int64_t>;
+using CVarRefBool   = CVarRef<bool>;
+using CVarRefFloat  = CVarRef<double>;
+using CVarRefString = CVarRef<std::string>;
+
+// ========================================================
+// struct CVarDesc:
+// ========================================================
+
+//
+// Static description of a CVar for CVarManager::registerCVars(). Meant to be
+// declared in constexpr arrays, so the name hashes are computed at compile time:
+//
+//   static constexpr cfg::CVarDesc myCVars[] = {
+//       cfg::CVarDesc::makeInt("r_width", "Screen width", 0, 1024, 640, 8192),
+//       cfg::CVarDesc::makeBool("r_vsync", "Vertical sync", cfg::CVar::Flags::Persistent, true),
+//   };
+//
+// The strings, including the allowed strings and enum constants, are referenced by
+// the registered CVars instead of copied, so they must outlive the CVarManager.
+//
+struct CVarDesc final
+{
+    HashedName                  name;
+    const char *                description;   // Can be null.
+    std::uint32_t               flags;
+    CVar::Type                  type;
+    std::int64_t                intValue;      // Int, Bool and Enum.
+    std::int64_t                intMin;        // Int.
+    std::int64_t                intMax;        // Int.
+    double                      floatValue;    // Float.
+    double                      floatMin;      // Float.
+    double                      floatMax;      // Float.
+    const char *                stringValue;   // String.
+    const char **               strings;       // Allowed strings of a String (can be null) or constant names of an Enum.
+    const std::int64_t *        enumConstants; // Enum.
+    CVarValueCompletionCallback completionCb;  // Optional.
+
+    static constexpr CVarDesc makeBool(const char * name, const char * description, std::uint32_t flags,
+                                       bool initValue, CVarValueCompletionCallback completionCb = nullptr)
+    {
+        return CVarDesc{ HashedName(name), description, flags, CVar::Type::Bool, (initValue ? 1 : 0), 0, 1,
+                         0.0, 0.0, 0.0, nullptr, nullptr, nullptr, completionCb };
+    }
+
+    static constexpr CVarDesc makeInt(const char * name, const char * description, std::uint32_t flags,
+                                      std::int64_t initValue, std::int64_t minValue, std::int64_t maxValue,
+                                      CVarValueCompletionCallback completionCb = nullptr)
+    {
+        return CVarDesc{ HashedName(name), description, flags, CVar::Type::Int, initValue, minValue, maxValue,
+                         0.0, 0.0, 0.0, nullptr, nullptr, nullptr, completionCb };
+    }
+
+    static constexpr CVarDesc makeFloat(const char * name, const char * description, std::uint32_t flags,
+                                        double initValue, double minValue, double maxValue,
+                                        CVarValueCompletionCallback completionCb = nullptr)
+    {
+        return CVarDesc{ HashedName(name), description, flags, CVar::Type::Float, 0, 0, 0,
+                         initValue, minValue, maxValue, nullptr, nullptr, nullptr, completionCb };
+    }
+
+    static constexpr CVarDesc makeString(const char * name, const char * description, std::uint32_t flags,
+                                         const char * initValue, const char ** allowedStrings,
+                                         CVarValueCompletionCallback completionCb = nullptr)
+    {
+        return CVarDesc{ HashedName(name), description, flags, CVar::Type::String, 0, 0, 0,
+                         0.0, 0.0, 0.0, initValue, allowedStrings, nullptr, completionCb };
+    }
+
+    static constexpr CVarDesc makeEnum(const char * name, const char * description, std::uint32_t flags,
+                                       std::int64_t initValue, const std::int64_t * enumConstants, const char ** constNames,
+                                       CVarValueCompletionCallback completionCb = nullptr)
+    {
+        return CVarDesc{ HashedName(name), description, flags, CVar::Type::Enum, initValue, 0, 0,
+                         0.0, 0.0, 0.0, nullptr, constNames, enumConstants, completionCb };
+    }
+};
+
+// ========================================================
+// class CVarSnapshot:
+// ========================================================
+
+//
+// Immutable copy of the values of every CVar of a CVarManager, taken by
+// CVarManager::publishCVarSnapshot(). Any thread can grab the current version
+// with CVarManager::acquireCVarSnapshot() and read a consistent set of values
+// from it, with no locks, while the main thread keeps changing the CVars.
+// The value strings stay valid for as long as the snapshot is held.
+//
+// Readers are not told about missing vars, they get the default value passed
+// in instead. Values are converted between types just like the CVar getters.
+//
+class CVarSnapshot
+{
+public:
+
+    // Increments by one with each snapshot published by the manager, starting at 1.
+    virtual std::uint64_t getVersion() const = 0;
+
+    // Number of CVars that were registered when the snapshot was taken.
+    virtual int getCVarCount() const = 0;
+
+    virtual bool hasCVar(const char * name) const = 0;
+    virtual bool hasCVar(const HashedName & name) const = 0;
+
+    virtual bool getBool(const char * name, bool defaultValue = false) const = 0;
+    virtual std::int64_t getInt(const char * name, std::int64_t defaultValue = 0) const = 0;
+    virtual double getFloat(const char * name, double defaultValue = 0.0) const = 0;
+    virtual const char * getString(const char * name, const char * defaultValue = "") const = 0;
+
+    // Same as above, skipping the name hashing. See CFG_CVAR().
+    virtual bool getBool(const HashedName & name, bool defaultValue = false) const = 0;
+    virtual std::int64_t getInt(const HashedName & name, std::int64_t defaultValue = 0) const = 0;
+    virtual double getFloat(const HashedName & name, double defaultValue = 0.0) const = 0;
+    virtual const char * getString(const HashedName & name, const char * defaultValue = "") const = 0;
+
+protected:
+
+    friend class CVarSnapshotRef;
+
+    // Snapshots are owned and freed by the manager.
+    // A CVarSnapshotRef releases its reference with release().
+    virtual ~CVarSnapshot();
+    virtual void release() const = 0;
+};
+
+//
+// Holds a reference to a CVarSnapshot, released when the holder is
+// reset or destroyed. Only movable. An empty reference is returned
+// by acquireCVarSnapshot() if snapshots are not enabled.
+//
+class CVarSnapshotRef final
+{
+public:
+
+    CVarSnapshotRef() = default;
+    ~CVarSnapshotRef() { reset(); }
+
+    CVarSnapshotRef(const CVarSnapshotRef &) = delete;
+    CVarSnapshotRef & operator = (const CVarSnapshotRef &) = delete;
+
+    CVarSnapshotRef(CVarSnapshotRef && other) noexcept
+        : snapshot(other.snapshot)
+    {
+        other.snapshot = nullptr;
+    }
+
+    CVarSnapshotRef & operator = (CVarSnapshotRef && other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            snapshot = other.snapshot;
+            other.snapshot = nullptr;
+        }
+        return *this;
+    }
+
+    void reset();
+
+    bool isValid() const noexcept { return snapshot != nullptr; }
+    explicit operator bool() const noexcept { return isValid(); }
+
+    const CVarSnapshot * get() const noexcept { return snapshot; }
+    const CVarSnapshot * operator -> () const noexcept { return snapshot; }
+    const CVarSnapshot & operator * () const noexcept { return *snapshot; }
+
+private:
+
+    friend class CVarManagerImpl;
+    explicit CVarSnapshotRef(const CVarSnapshot * acquired) noexcept
+        : snapshot(acquired)
+    { }
+
+    const CVarSnapshot * snapshot = nullptr;
+};
+
 // ========================================================
 // class CVarManager:
 // ========================================================
@@ -266,7 +705,9 @@ public:
     // Allocator/factory:
     //
 
-    static CVarManager * createInstance(int cvarHashTableSizeHint = 0);
+    // If 'useMemoryArena' is set, the CVar objects and their strings are packed into
+    // large blocks owned by the manager instead of being allocated individually.
+    static CVarManager * createInstance(int cvarHashTableSizeHint = 0, bool useMemoryArena = false);
     static void destroyInstance(CVarManager * cvarManager);
 
     //
@@ -279,6 +720,18 @@ public:
     // Finds previously registered CVar or returns null if no such var is registered.
     virtual CVar * findCVar(const char * name) const = 0;
 
+    // Same as above, but skips hashing the name. See CFG_CVAR().
+    virtual CVar * findCVar(const HashedName & name) const = 0;
+
+    // Finds a CVar by name and binds a typed reference to it.
+    // Returns an empty reference if the var is not registered.
+    // Keep the reference around to avoid repeated name lookups.
+    template<typename T>
+    CVarRef<T> findCVarRef(const char * name) const
+    {
+        return CVarRef<T>(findCVar(name));
+    }
+
     // Find vars with name starting with the 'partialName' substring.
     // Returns the total number of matches found, which might be > than maxMatches,
     // but only up to maxMatches will be written to the output array in any case.
@@ -319,6 +772,12 @@ public:
     // No specific iteration order is guaranteed.
     virtual void enumerateAllCVars(CVarEnumerateCallback enumCallback, void * userContext) = 0;
 
+    // Same as above, but only for the CVars having any of the flags, which are kept indexed by
+    // flag bit, so the cost is proportional to the number of matches rather than all CVars.
+    // The callback can change the flags of the vars, e.g.: clearModified().
+    // Returns the number of vars visited.
+    virtual int enumerateCVarsWithFlags(std::uint32_t flags, CVarEnumerateCallback enumCallback, void * userContext) = 0;
+
     //
     // CVar registration:
     //
@@ -346,6 +805,13 @@ public:
                                     std::int64_t initValue, const std::int64_t * enumConstants, const char ** constNames,
                                     CVarValueCompletionCallback completionCb = nullptr) = 0;
 
+    // Registers a whole table of CVars (see CVarDesc). The hash table is grown once
+    // for the batch and the precomputed name hashes are used. Entries that fail are
+    // skipped with an error, as in the single registration methods. If 'outCVars' is
+    // not null, it receives the new CVar of each entry, or null for the failed ones.
+    // Returns the number of CVars registered.
+    virtual int registerCVars(const CVarDesc * descs, int count, CVar ** outCVars = nullptr) = 0;
+
     //
     // CVar value queries:
     //
@@ -359,6 +825,12 @@ public:
     virtual double getCVarValueFloat(const char * name) const = 0;
     virtual std::string getCVarValueString(const char * name) const = 0;
 
+    // Same as above, with a name that is hashed in advance. See CFG_CVAR().
+    virtual bool getCVarValueBool(const HashedName & name) const = 0;
+    virtual std::int64_t getCVarValueInt(const HashedName & name) const = 0;
+    virtual double getCVarValueFloat(const HashedName & name) const = 0;
+    virtual std::string getCVarValueString(const HashedName & name) const = 0;
+
     //
     // CVar value update with registration:
     //
@@ -372,6 +844,72 @@ public:
     virtual CVar * setCVarValueInt(const char * name, std::int64_t value, std::uint32_t flags) = 0;
     virtual CVar * setCVarValueFloat(const char * name, double value, std::uint32_t flags) = 0;
     virtual CVar * setCVarValueString(const char * name, const std::string & value, std::uint32_t flags) = 0;
+
+    //
+    // CVar change notifications:
+    //
+    // Listeners are called when the value of a CVar actually changes, be it from
+    // the C++ code, a 'set' command, a config file or a snapshot. Setting the value
+    // a var already has is not a change. This is tracked apart from the Modified flag,
+    // so clearModified() and saveConfig don't affect the listeners. CVars can only be
+    // changed from the main thread, so the listeners are also called from it.
+    //
+    // The add methods return an id > 0 for removeChangeListener(), or 0 on error.
+    // Listeners can be added or removed from inside a callback, but an Immediate
+    // callback must not remove the CVar it is being notified about.
+    //
+
+    // Listen to changes of a single CVar. The listener is removed with the CVar.
+    virtual int addChangeListener(CVar * cvar, CVarChangeCallback callback,
+                                  void * userContext, CVarChangeDelivery delivery) = 0;
+
+    // Listen to changes of any CVar with at least one of the given flags.
+    virtual int addChangeListenerForFlags(std::uint32_t flags, CVarChangeCallback callback,
+                                          void * userContext, CVarChangeDelivery delivery) = 0;
+
+    // Listen to changes of any CVar with a name starting with 'namePrefix'.
+    virtual int addChangeListenerForPrefix(const char * namePrefix, CVarChangeCallback callback,
+                                           void * userContext, CVarChangeDelivery delivery) = 0;
+
+    virtual bool removeChangeListener(int listenerId) = 0;
+
+    // Calls the Batched listeners once for each CVar changed since the last call,
+    // in the order of the first change, no matter how many times a var was changed.
+    // Changes made by the callbacks are delivered in the next call. Returns the number
+    // of changed CVars delivered. A good place to call it is after execBufferedCommands().
+    // Calls from inside a Batched callback do nothing and return zero.
+    virtual int deliverChangeNotifications() = 0;
+
+    // Number of changed CVars waiting for deliverChangeNotifications().
+    virtual int getPendingChangeNotificationsCount() const = 0;
+
+    //
+    // Versioned CVar snapshots:
+    //
+    // When enabled, the manager keeps an immutable copy of all CVar values (see CVarSnapshot),
+    // replaced by a new version when something changed. A CommandManager republishes it at the
+    // end of execBufferedCommands(), execConfigFile(), execCompiledConfig() and loadConfigSnapshot(),
+    // so readers never see a half-applied command batch or config file. The vars can also be
+    // changed from the C++ code and published explicitly with publishCVarSnapshot().
+    //
+    // Old versions are freed by the next publishCVarSnapshot() once no reader holds them.
+    // All references must be released before the manager is destroyed.
+    //
+
+    // Enabling publishes the first version right away. Disabling drops the current version;
+    // readers still holding it can keep using it.
+    virtual void setCVarSnapshotsEnabled(bool enable) = 0;
+    virtual bool isCVarSnapshotsEnabled() const = 0;
+
+    // Publishes a new version if any CVar changed, was registered or removed since the last one,
+    // and frees the old versions no longer used. Returns true if a new version was published.
+    // Only the vars changed since are converted again, the others are copied from the last version.
+    // Must be called from the thread that changes the CVars.
+    virtual bool publishCVarSnapshot() = 0;
+
+    // Grabs the current version in O(1), without locks. Can be called from any thread.
+    // Returns an empty reference if snapshots are not enabled.
+    virtual CVarSnapshotRef acquireCVarSnapshot() const = 0;
 };
 
 // ================================================================================================
@@ -389,7 +927,7 @@ constexpr int  MaxCommandDescLength   = 100;    // Max length in chars of the de
 constexpr int  MaxCommandArgStrLength = 2048;   // Maximum length in chars of a string of arguments, including the '\0'.
 constexpr int  MaxCommandArguments    = 64;     // Maximum number of argument strings for a single command.
 constexpr int  MaxReentrantCommands   = 999999; // If this many commands are executed in a single frame, there's probably a reentrant loop.
-constexpr int  CommandBufferSize      = 65535;  // Max length in chars of the command buffer used by CommandManager, including a '\0'.
+constexpr int  CommandBufferSize      = 65535;  // Default max length in chars of the command buffer used by CommandManager. See setCommandBufferSize().
 constexpr char CommandTextSeparator   = ';';    // Character assumed to be the separator between different commands on the same line.
 
 // Command execution modes for CommandManager::execute() and friends.
@@ -401,6 +939,33 @@ enum class CommandExecMode
     Append     // Append to end of the command buffer for future execution by execBufferedCommands().
 };
 
+// Number of latency buckets in CommandProfile::histogram. Bucket 0 counts runs under 1 microsecond,
+// bucket N counts runs from 2^(N-1) to 2^N microseconds, and the last one counts everything longer.
+constexpr int CommandProfileHistogramSize = 24;
+
+// Handler time of one command, from CommandManager::getCommandProfiles().
+// Only filled in while profiling is enabled. Aliases include the time of
+// the commands they run immediately. Times are in nanoseconds.
+struct CommandProfile
+{
+    const Command * command;
+    std::uint64_t   callCount;
+    std::uint64_t   totalTime;
+    std::uint64_t   minTime;
+    std::uint64_t   maxTime;
+    std::uint32_t   histogram[CommandProfileHistogramSize];
+};
+
+// Time spent by the CommandManager outside the command handlers, in nanoseconds.
+struct CommandExecProfile
+{
+    std::uint64_t parseTime;      // Splitting the command text and expanding $(var)s.
+    std::uint64_t tokenizeTime;   // Splitting the commands into arguments.
+    std::uint64_t lookupTime;     // Finding the commands by name.
+    std::uint64_t lookupMisses;   // Names not found ("Command not found").
+    std::uint64_t commandsRun;    // Handler calls.
+};
+
 // ========================================================
 // class CommandArgs:
 // ========================================================
@@ -427,10 +992,21 @@ public:
     // First entry is assumed to be the program name; 'argc' is expected to be >= 1.
     CommandArgs(int argc, const char * argv[]);
 
-    // Copy/assignment.
+    // Copy/assignment. A copy always owns its argument strings.
     CommandArgs(const CommandArgs & other);
     CommandArgs & operator = (const CommandArgs & other);
 
+    // Move/assignment. Only the used portion of the token buffer
+    // is copied, or nothing at all if the source was tokenized in-place.
+    CommandArgs(CommandArgs && other) noexcept;
+    CommandArgs & operator = (CommandArgs && other) noexcept;
+
+    // Same rules of the string constructor, but the buffer is tokenized in-place:
+    // whitespace after each argument and closing quotes are replaced by null chars
+    // and the argument strings point directly into 'cmdStr', so no copies are made.
+    // The buffer must remain valid for as long as this CommandArgs refers to it.
+    void tokenizeInPlace(char * cmdStr);
+
     // Get the first argument (the command/program name).
     const char * getCommandName() const noexcept;
 
@@ -445,6 +1021,10 @@ public:
     const char * operator[](int index) const;
     const char * getArgAt(int index)   const;
 
+    // Length in chars of an argument string, not counting the null terminator.
+    // Fails with an assertion if the index is out-of-bounds.
+    int getArgLength(int index) const;
+
     // Begin/end range to allow "range-based for" iteration of arguments.
     // No validation done if you deref the end or a past-the-end pointer!
     const char * const * begin() const noexcept;
@@ -456,9 +1036,16 @@ public:
 
 private:
 
-    void parseArgString(const char * argStr);
-    bool addArgString(const char * argStr);
+    // For compiled config programs, which keep the tokens pre-split.
+    friend class CommandManagerImpl;
+    void setTokens(const char * name, const char * const * args, const std::uint16_t * lengths, int count);
+
+    void reset() noexcept;
+    void copyTokensFrom(const CommandArgs & other);
+    void parseArgString(const char * argStr, bool inPlace);
+    bool addArgString(const char * argStr, int argLen);
     const char * appendToken(const char * token, int tokenLen);
+    const char * makeToken(const char * token, int * tokenLen, bool inPlace);
 
     // Number of arguments parsed and inserted in the argStrings[] array.
     int argCount;
@@ -472,9 +1059,16 @@ private:
     // parameters that follow the command name but won't include this name.
     const char * cmdName;
 
-    // Array of arguments. Each one points to a slice of tokenizedArgStr[].
+    // True if the strings point into an external buffer (see tokenizeInPlace()).
+    bool inPlaceTokens;
+
+    // Array of arguments. Each one points to a slice of tokenizedArgStr[]
+    // or to the buffer given to tokenizeInPlace().
     const char * argStrings[MaxCommandArguments];
 
+    // Length of each entry in argStrings[], not counting the '\0'.
+    std::uint16_t argLengths[MaxCommandArguments];
+
     // Tokenized string of arguments. Each arg is separated by a null char.
     // Each entry in argStrings[] points to a slice of this buffer.
     char tokenizedArgStr[MaxCommandArgStrLength];
@@ -667,6 +1261,123 @@ CommandHandlerMemFunc makeMemFuncCommandArgCompletion(const ClassType * const ob
     return CommandHandlerMemFunc(objPtr, pArgCompl);
 }
 
+//
+// Fixed-size delegate that stores its callable in place, so binding
+// never allocates and invoking it is a single indirect call. Accepts
+// plain function pointers and lambdas, provided the callable is trivially
+// copyable and fits in CFG_INLINE_DELEGATE_SIZE bytes. Both are checked
+// at compile time. The callable is invoked through a const reference,
+// so mutable lambdas are not accepted.
+//
+template<typename Signature>
+class InlineDelegate;
+
+template<typename RetType, typename... Args>
+class InlineDelegate<RetType(Args...)> final
+{
+public:
+
+    InlineDelegate() noexcept { }
+
+    template<
+        typename FuncType,
+        typename = typename std::enable_if<!std::is_same<typename std::decay<FuncType>::type, InlineDelegate>::value>::type
+    >
+    InlineDelegate(FuncType func)
+    {
+        using Callable = typename std::decay<FuncType>::type;
+        static_assert(sizeof(Callable) <= sizeof(Storage), "Callable too big for InlineDelegate! Increase CFG_INLINE_DELEGATE_SIZE.");
+        static_assert(alignof(Callable) <= alignof(Storage), "Callable alignment too strict for InlineDelegate!");
+        static_assert(std::is_trivially_copyable<Callable>::value, "InlineDelegate callables must be trivially copyable!");
+
+        ::new(static_cast<void *>(storage.bytes)) Callable(std::move(func));
+        invoker = &invokeCallable<Callable>;
+    }
+
+    RetType operator()(Args... args) const
+    {
+        CFG_ASSERT(invoker != nullptr);
+        return invoker(storage.bytes, std::forward<Args>(args)...);
+    }
+
+    // nullptr interop:
+    InlineDelegate(std::nullptr_t) noexcept { }
+    bool operator == (std::nullptr_t) const noexcept { return invoker == nullptr; }
+    bool operator != (std::nullptr_t) const noexcept { return invoker != nullptr; }
+
+private:
+
+    using Invoker = RetType (*)(const void *, Args...);
+
+    template<typename Callable>
+    static RetType invokeCallable(const void * callable, Args... args)
+    {
+        return (*static_cast<const Callable *>(callable))(std::forward<Args>(args)...);
+    }
+
+    // Same trick as CommandHandlerMemFunc: a union provides the
+    // alignment since Visual Studio dislikes alignas(). Pointer/double
+    // alignment is enough for any closure and keeps the delegate
+    // storable in a MemoryArena.
+    union Storage
+    {
+        void * pointer;
+        void (*function)();
+        double number;
+        std::uint64_t integer;
+        unsigned char bytes[CFG_INLINE_DELEGATE_SIZE];
+    };
+
+    Invoker invoker = nullptr;
+    Storage storage;
+};
+
+using CommandHandlerInline = InlineDelegate<void(const CommandArgs &)>;
+using CommandArgCompletionInline = InlineDelegate<int(const char *, std::string *, int)>;
+
+//
+// Bind an object and a member function to an inline delegate.
+// The member func can optionally be const qualified.
+//
+// The pointers must not be null.
+//
+// Example:
+//  MyClass obj{};
+//  auto handler = makeInlineCommandHandler(&obj, &MyClass::someMethod);
+//
+
+template<typename ClassType>
+CommandHandlerInline makeInlineCommandHandler(ClassType * objPtr, void (ClassType::*pCmdExec)(const CommandArgs &))
+{
+    CFG_ASSERT(objPtr != nullptr && pCmdExec != nullptr);
+    return [objPtr, pCmdExec](const CommandArgs & args) { (objPtr->*pCmdExec)(args); };
+}
+template<typename ClassType>
+CommandHandlerInline makeInlineCommandHandler(const ClassType * const objPtr, void (ClassType::*pCmdExec)(const CommandArgs &) const)
+{
+    CFG_ASSERT(objPtr != nullptr && pCmdExec != nullptr);
+    return [objPtr, pCmdExec](const CommandArgs & args) { (objPtr->*pCmdExec)(args); };
+}
+
+template<typename ClassType>
+CommandArgCompletionInline makeInlineCommandArgCompletion(ClassType * objPtr, int (ClassType::*pArgCompl)(const char *, std::string *, int))
+{
+    CFG_ASSERT(objPtr != nullptr && pArgCompl != nullptr);
+    return [objPtr, pArgCompl](const char * partialArg, std::string * outMatches, int maxMatches)
+    {
+        return (objPtr->*pArgCompl)(partialArg, outMatches, maxMatches);
+    };
+}
+template<typename ClassType>
+CommandArgCompletionInline makeInlineCommandArgCompletion(const ClassType * const objPtr, int (ClassType::*pArgCompl)(const char *, std::string *, int) const)
+{
+    CFG_ASSERT(objPtr != nullptr && pArgCompl != nullptr);
+    return [objPtr, pArgCompl](const char * partialArg, std::string * outMatches, int maxMatches)
+    {
+        return (objPtr->*pArgCompl)(partialArg, outMatches, maxMatches);
+    };
+}
+
 // ========================================================
 // class Command:
 // ========================================================
@@ -689,6 +1400,11 @@ public:
     virtual int getMaxArgs() const = 0;
     virtual bool isAlias()   const = 0;
 
+    // Expected run time of the command in microseconds, or zero if
+    // unknown. See CommandManager::execBufferedCommandsForTime().
+    virtual std::uint32_t getCostHintMicros() const = 0;
+    virtual void setCostHintMicros(std::uint32_t microseconds) = 0;
+
     // Calls the command argument completion callback, if any.
     // It will write up to 'maxMatches' in the output array. The returned value is the total
     // numbers of matches available (which can be > maxMatches), or -1 if there was an error.
@@ -707,7 +1423,10 @@ public:
     // Allocator/factory:
     //
 
-    static CommandManager * createInstance(int cmdHashTableSizeHint = 0, CVarManager * cvarMgr = nullptr);
+    // If 'useMemoryArena' is set, the Command objects and alias strings are packed into
+    // large blocks owned by the manager instead of being allocated individually.
+    static CommandManager * createInstance(int cmdHashTableSizeHint = 0, CVarManager * cvarMgr = nullptr,
+                                           bool useMemoryArena = false);
     static void destroyInstance(CommandManager * cmdManager);
 
     //
@@ -733,6 +1452,9 @@ public:
     // Finds previously registered command or returns null if no such command is registered.
     virtual Command * findCommand(const char * name) const = 0;
 
+    // Same as above, but skips hashing the name. See CFG_CMD().
+    virtual Command * findCommand(const HashedName & name) const = 0;
+
     // Find commands with name starting with the 'partialName' substring.
     // Returns the total number of matches found, which might be > than maxMatches,
     // but only up to maxMatches will be written to the output array in any case.
@@ -782,6 +1504,9 @@ public:
     // No specific iteration order is guaranteed.
     virtual void enumerateAllCommands(CommandEnumerateCallback enumCallback, void * userContext) = 0;
 
+    // Same as above, but only for the commands having any of the flags. See CVarManager::enumerateCVarsWithFlags().
+    virtual int enumerateCommandsWithFlags(std::uint32_t flags, CommandEnumerateCallback enumCallback, void * userContext) = 0;
+
     // All commands containing any of the specified flags will be
     // prevented from executing when processing command text.
     // 'DisableAll' prevents all commands from executing.
@@ -797,6 +1522,10 @@ public:
     //
     // Command registration / command aliases:
     //
+    // The optional cost hint is the expected run time of the command in microseconds,
+    // used by execBufferedCommandsForTime() to avoid starting a known-expensive command
+    // when the time budget is almost spent. Zero means unknown. See Command::setCostHintMicros().
+    //
 
     // Register with C-style function callback handlers.
     virtual bool registerCommand(const char * name,
@@ -806,7 +1535,8 @@ public:
                                  const char * description = "",
                                  std::uint32_t flags      =  0,
                                  int minArgs              = -1,
-                                 int maxArgs              = -1) = 0;
+                                 int maxArgs              = -1,
+                                 std::uint32_t costHintMicros = 0) = 0;
 
     // Register with delegate handlers (lambdas with possible capture).
     virtual bool registerCommand(const char * name,
@@ -815,7 +1545,8 @@ public:
                                  const char * description = "",
                                  std::uint32_t flags      =  0,
                                  int minArgs              = -1,
-                                 int maxArgs              = -1) = 0;
+                                 int maxArgs              = -1,
+                                 std::uint32_t costHintMicros = 0) = 0;
 
     // Register with pointer-to-member-function handlers.
     virtual bool registerCommand(const char * name,
@@ -824,7 +1555,21 @@ public:
                                  const char * description = "",
                                  std::uint32_t flags      =  0,
                                  int minArgs              = -1,
-                                 int maxArgs              = -1) = 0;
+                                 int maxArgs              = -1,
+                                 std::uint32_t costHintMicros = 0) = 0;
+
+    // Register with inline delegate handlers. Neither the delegates nor the command
+    // allocate beyond the manager's arena, and the handler is called directly when
+    // the command executes. Separate name to avoid ambiguity with the std::function
+    // overload when passing a lambda.
+    virtual bool registerInlineCommand(const char * name,
+                                       CommandHandlerInline handler,
+                                       CommandArgCompletionInline completionHandler = nullptr,
+                                       const char * description = "",
+                                       std::uint32_t flags      =  0,
+                                       int minArgs              = -1,
+                                       int maxArgs              = -1,
+                                       std::uint32_t costHintMicros = 0) = 0;
 
     // Create an alias for a command string. Execution mode for
     // each time the command alias is invoked can also be provided.
@@ -852,14 +1597,57 @@ public:
     // Execute a command string with any of the available modes.
     virtual void execute(CommandExecMode execMode, const char * str) = 0;
 
-    // Check if we have pending command text to execute.
+    // Thread-safe version of execAppend() that can be called from any thread.
+    // It never blocks nor allocates memory; the text goes into a fixed size lock-free
+    // queue (CFG_COMMAND_SUBMIT_QUEUE_SIZE) and is moved to the end of the command buffer
+    // by the next execBufferedCommands(), in the order it was submitted. Returns false if
+    // the queue is full. The owning thread also gets an error for the rejected submissions.
+    virtual bool submitCommandText(const char * str) = 0;
+
+    // Check if we have pending command text to execute, including submitCommandText().
     virtual bool hasBufferedCommands() const = 0;
 
+    // Number of individual commands waiting in the command buffer.
+    virtual int getBufferedCommandsCount() const = 0;
+
+    // Max number of chars of pending command text the buffer can hold (default = CommandBufferSize).
+    // The buffer grows on demand up to this limit. Text pushed past it is discarded with an error.
+    virtual void setCommandBufferSize(int maxSizeInChars) = 0;
+    virtual int getCommandBufferSize() const = 0;
+
     // Execute the command buffer text. You can specify a maximum number of commands
     // to execute in the call or allow all buffered commands to execute with 'ExecAll'.
     // Returns the number of commands executed.
     virtual int execBufferedCommands(std::uint32_t maxCommandsToExec = ExecAll) = 0;
 
+    // Same as above, but limited by wall-clock time instead. Commands run until the budget
+    // is spent, the rest stays buffered for the next call. A command with a cost hint is not
+    // started if it would overrun the budget. The first command always runs, so that the
+    // buffer makes progress even with a budget smaller than a single command. Optionally
+    // returns the time used (which may exceed the budget) and the number of commands left.
+    virtual int execBufferedCommandsForTime(std::uint32_t budgetMicroseconds,
+                                            std::uint32_t * outMicrosecondsUsed = nullptr,
+                                            int * outCommandsLeft = nullptr) = 0;
+
+    //
+    // Execution profiling:
+    //
+    // Opt-in timing of the command handlers and of the text parsing, tokenization and
+    // lookups done before them. While disabled the cost is a branch per measurement.
+    // The default 'profCmds' command prints a report of these stats.
+    //
+
+    virtual void setProfilingEnabled(bool enable) = 0;
+    virtual bool isProfilingEnabled() const = 0;
+
+    // Clears the stats. Stats of removed commands are lost when they are removed.
+    virtual void resetProfilingStats() = 0;
+
+    // Writes up to 'maxProfiles' entries, one for each command that ran since the last reset,
+    // in no specific order. Returns the total number of profiled commands, which can be > maxProfiles.
+    virtual int getCommandProfiles(CommandProfile * outProfiles, int maxProfiles) const = 0;
+    virtual CommandExecProfile getExecProfile() const = 0;
+
     // Tries to load and execute the given configuration file.
     // Same rules of command strings apply. Lines are assumed to be
     // whole commands, unless a CommandTextSeparator (;) is found.
@@ -870,6 +1658,60 @@ public:
     // command will also be echoed to that terminal.
     virtual bool execConfigFile(const char * filename, SimpleCommandTerminal * term) = 0;
 
+    // Loads a configuration file and compiles it into an in-memory program that is
+    // cached by filename. Commands are split and tokenized only once, and the Command
+    // pointers are resolved on the first run. Lines with '$(var)' expansions are kept
+    // as text and executed normally, since their values are only known at run time.
+    // Compiling a file that is already cached replaces the cached program.
+    virtual bool compileConfigFile(const char * filename) = 0;
+
+    // Runs a compiled configuration file with the same semantics of execConfigFile().
+    // The file is compiled first if not cached yet. Changes to the file on disk
+    // are not seen by a cached program until it is discarded or compiled again.
+    virtual bool execCompiledConfig(const char * filename, SimpleCommandTerminal * term) = 0;
+
+    // Discards the cached program of a configuration file. Null discards all of them.
+    virtual void discardCompiledConfig(const char * filename) = 0;
+
+    // Runs a list of configuration files, with the same results of executing them one
+    // after the other with execConfigFile(). The files are read and tokenized ahead of
+    // time, like compileConfigFile() does, but the programs are not cached. If the library
+    // is built with CFG_PARALLEL_CONFIG_LOADING, the loading is spread over up to
+    // 'maxWorkerThreads' threads (zero for one less than the hardware threads), while the
+    // calling thread runs the files already loaded. Commands and CVar updates only happen
+    // on the calling thread, in list order, so later files still override earlier ones.
+    // Since files are read before the earlier ones run, a file written by an earlier file
+    // is seen as it was before the call. The FileIOCallbacks, the MemoryAllocCallbacks and
+    // the error callback are called from the worker threads, so they must be thread-safe.
+    // Returns the number of files that could be loaded.
+    virtual int execConfigFiles(const char * const * filenames, int fileCount,
+                                SimpleCommandTerminal * term, int maxWorkerThreads = 0) = 0;
+
+    // Writes a binary snapshot of the persistent CVars and the command aliases.
+    // Values are stored raw, keyed by name hash, so loading it does no string parsing.
+    // Requires a CVarManager and FileIOCallbacks that implement writeBytes().
+    virtual bool saveConfigSnapshot(const char * filename) = 0;
+
+    // Loads a snapshot written by saveConfigSnapshot(), with the same write permissions of
+    // a 'set' command. Fails before changing anything if the file can't be mapped, comes
+    // from a different format version or byte order, or if its schema checksum doesn't
+    // match the currently registered persistent CVars. Callers should then fall back to
+    // the text config file. Requires FileIOCallbacks that implement mapFile().
+    virtual bool loadConfigSnapshot(const char * filename) = 0;
+
+    // Appends a 'set' command for each modified persistent CVar to the end of a journal
+    // file, then clears the modified flag of all CVars. The cost of saving is proportional
+    // to what changed since the last save, not to the number of CVars. Running the base
+    // config file followed by the journal restores the same values of a full save. Command
+    // aliases are not journaled. If 'outJournalEntries' is not null, the total number of
+    // entries in the journal is returned, so callers know when to compact it. The count is
+    // kept by the manager: a journal is only read back on the first append to it.
+    virtual bool appendConfigJournal(const char * filename, int * outJournalEntries) = 0;
+
+    // Truncates a journal file after it was compacted into the main config file,
+    // resetting its entry count. Used by the 'saveConfig' command after a full save.
+    virtual bool resetConfigJournal(const char * filename) = 0;
+
     // Process the program command line provided at initialization.
     // 'set' and 'reset' commands (modifying CVars) are executed immediately, while
     // other commands are buffered and executed when the command buffer is next flushed.
@@ -983,6 +1825,18 @@ public:
     void setTextColor(const char * ansiColorCode) noexcept;
     void restoreTextColor() noexcept;
 
+    // Output batching: Subclasses opt in by giving the terminal an output buffer and
+    // routing their print() and printLn() through bufferOutput(). Text then reaches
+    // writeOutput() in large blocks, when the buffer fills up, at every update() and
+    // when flushOutput() is called. Color changes are held until the next text is
+    // buffered or the next flush, so runs of color switches with no text in between
+    // are coalesced.
+    // While batching, printF() formats straight into the buffer and color codes are
+    // referenced until written, so they must be static strings like the color:: ones.
+    void setOutputBufferSize(int sizeInChars); // Flushes first. Zero disables batching.
+    int  getOutputBufferSize() const noexcept;
+    void flushOutput();
+
     //
     // Command/CVar managers:
     // (The terminal will not take ownership of the pointers).
@@ -1067,6 +1921,18 @@ protected:
     virtual void onSetClipboardString(const char * str);
     virtual const char * onGetClipboardString();
 
+    // Receives the batched output. The default is a no-op, so subclasses that call
+    // bufferOutput() must override it. Subclasses should also call flushOutput() in
+    // their destructors, since the base destructor can no longer reach this method.
+    virtual void writeOutput(const char * text, int length);
+
+    // Appends text to the output buffer, flushing it first if the text doesn't fit.
+    // If batching is disabled writes the text straight to writeOutput().
+    void bufferOutput(const char * text, int length);
+
+    // Buffers the pending color code, if it differs from the current one.
+    void bufferPendingTextColor();
+
     //
     // Other internal helpers:
     //
@@ -1138,6 +2004,11 @@ private:
     CommandManager *  cmdManager;                              // Optional CommandManager for command execution and name completion.
     CVarManager    *  cvarManager;                             // Optional CVarManager for CVar name and value completion and var value substitution.
     CommandExecMode   cmdExecMode;                             // Execution mode for the CommandManager commands. Initially = Append (buffered).
+    char           *  outputBuffer;                            // Batched output text waiting for writeOutput(). Null if output batching is disabled.
+    int               outputBufferSize;                        // Size in chars of outputBuffer[].
+    int               outputBufferUsed;                        // Chars of outputBuffer[] currently used.
+    const char     *  pendingTextColor;                        // Color code set but not written yet. Null if none.
+    const char     *  currentTextColor;                        // Last color code written to the output. Null if not known.
     const std::string newlineMarkerStr;                        // This string is printed at the start of every new input line.
     char              lineBuffer[LineBufferMaxSize];           // Buffer to hold a line of input.
     std::string       cmdHistory[CmdHistoryMaxSize];           // Buffer with recent lines typed into the console.
@@ -1164,6 +2035,11 @@ public:
     virtual bool hasInput() const = 0;
     virtual int  getInput()       = 0;
 
+    // Blocks the caller until hasInput() is true or the timeout expires.
+    // A negative timeout waits indefinitely. Returns hasInput(). The default
+    // implementation doesn't wait, so callers must still cope with false returns.
+    virtual bool waitForInput(int timeoutMilliseconds);
+
     //
     // Factory functions:
     //
@@ -1178,6 +2054,69 @@ public:
     static void destroyInstance(NativeTerminal * term);
 };
 
+// ========================================================
+// class RemoteTerminalServer:
+// ========================================================
+
+//
+// Serves the console to many remote clients over TCP and/or Unix domain sockets,
+// from a single event loop with non-blocking I/O. Each client session gets its own
+// terminal, with a line buffer, command history, [TAB] completion and the built-in
+// commands. Commands typed by the clients go into the CommandManager buffer in
+// Append mode, to be run by the next execBufferedCommands(). Sessions expect raw
+// keystrokes, e.g. from "socat -,raw,echo=0 TCP:host:port", or from telnet if the
+// listener was opened with telnet negotiation.
+//
+// The server itself is a terminal: everything printed to it is sent to all the
+// sessions. Pass it to registerDefaultCommands() for the command output to reach
+// the clients. The text is formatted once into a shared block that every session
+// references until it is sent, so it is never copied or formatted per client.
+//
+// Not thread safe. Call serve() from the thread that runs the CommandManager.
+// Only built on Unix-like systems when CFG_BUILD_REMOTE_TERMINAL is defined.
+//
+class RemoteTerminalServer
+    : public SimpleCommandTerminal
+{
+public:
+
+    virtual ~RemoteTerminalServer();
+
+    // Starts accepting connections on a TCP port. If 'telnetNegotiation' is set,
+    // clients are asked to switch to character mode and local echo off, as a
+    // telnet client expects. Returns false if the socket can't be opened.
+    virtual bool listenTcp(int port, const char * bindAddress = "127.0.0.1", bool telnetNegotiation = false) = 0;
+
+    // Starts accepting connections on a Unix domain socket. An existing file with
+    // the same name is replaced, and the socket file is removed by the destructor.
+    virtual bool listenUnix(const char * socketPath) = 0;
+
+    // Runs one iteration of the event loop: sends pending output, accepts clients
+    // and handles their input. Waits up to 'timeoutMilliseconds' for something to
+    // happen, or indefinitely if negative. Returns the number of sockets serviced.
+    virtual int serve(int timeoutMilliseconds) = 0;
+
+    // Number of clients currently connected.
+    virtual int getSessionCount() const = 0;
+
+    // Disconnects all clients after trying to send their pending output one last time.
+    virtual void closeAllSessions() = 0;
+
+    //
+    // Factory functions:
+    //
+
+    // Returns null if the server is not built for this platform (see CFG_BUILD_REMOTE_TERMINAL).
+    static RemoteTerminalServer * createInstance(CommandManager * cmdMgr, CVarManager * cvarMgr);
+
+    // Frees a previously allocated instance. Disconnects all clients.
+    static void destroyInstance(RemoteTerminalServer * server);
+
+protected:
+
+    RemoteTerminalServer(CommandManager * cmdMgr, CVarManager * cvarMgr);
+};
+
 // ========================================================
 // Colored text printing on the terminal:
 // ========================================================
@@ -1243,9 +2182,83 @@ struct MemoryAllocCallbacks final
 // Memory allocation and deallocation callbacks.
 // The default ones forward to std::malloc() and std::free().
 // Pass null to set() to restore the default callbacks.
+// With CFG_PARALLEL_CONFIG_LOADING, CommandManager::execConfigFiles()
+// calls them from its worker threads, so they must be thread-safe.
 void setMemoryAllocCallbacks(MemoryAllocCallbacks * memCallbacks) noexcept;
 MemoryAllocCallbacks getMemoryAllocCallbacks() noexcept;
 
+// ========================================================
+// Memory statistics:
+// ========================================================
+
+// What the memory allocated through the MemoryAllocCallbacks is used for.
+enum class MemoryCategory : std::uint8_t
+{
+    HashTables,    // Hash table slots and sorted name indexes of the managers.
+    CVars,         // CVar objects and the published CVarSnapshots.
+    Strings,       // CVar names/descriptions, alias command strings and long string CVar values.
+    ValueLists,    // Allowed strings and enum constants of the CVars, with their lookup indexes.
+    Commands,      // Command objects with their handler delegates, alias templates and profiles.
+    CommandBuffer, // Buffered command text, the submitCommandText() queue and compiled configs.
+    Terminals,     // Terminal objects, output buffers and remote terminal sessions.
+    MemoryArenas,  // Blocks of the manager memory arenas. The objects inside them are not broken down.
+    Other,         // Managers, config file reads, etc.
+
+    Count
+};
+
+struct MemoryCategoryStats final
+{
+    std::size_t   liveBytes;  // Bytes currently allocated.
+    std::size_t   peakBytes;  // Highest liveBytes since startup or resetMemoryPeaks().
+    std::uint64_t allocCount; // Number of allocations so far.
+    std::uint64_t freeCount;  // Number of deallocations so far.
+};
+
+struct MemoryStats final
+{
+    MemoryCategoryStats categories[static_cast<int>(MemoryCategory::Count)];
+    MemoryCategoryStats total; // Sum of all categories, with its own peak.
+};
+
+// Memory accounting is opt-in, since it adds a small header to each allocation.
+// cfg.cpp must be compiled with CFG_MEMORY_STATS defined to nonzero, otherwise
+// getMemoryStats() returns false and zeroed stats. Memory allocated by the std
+// containers and strings used internally is not accounted for.
+bool getMemoryStats(MemoryStats * outStats) noexcept;
+
+// Resets the peak bytes of every category to the current live bytes.
+void resetMemoryPeaks() noexcept;
+
+// Short printable name of a category, e.g. "hash tables".
+const char * getMemoryCategoryName(MemoryCategory category) noexcept;
+
+// ========================================================
+// Number <=> string conversions:
+// ========================================================
+
+//
+// Locale-independent number conversions used by the CVars.
+//
+// The parse functions accept the same syntax as std::strtoll(str, nullptr, 0)
+// and std::strtod(), but the decimal point is always '.'. The input doesn't
+// have to be null terminated. They return the number of chars consumed, or
+// zero if the string doesn't start with a number, in which case the output
+// value is zero. Out of range integers are clamped, like strtoll() does.
+//
+int parseInt64(const char * str, int length, std::int64_t * outValue);
+int parseDouble(const char * str, int length, double * outValue);
+
+//
+// The format functions write into a caller buffer, which is always null
+// terminated, and return the length of the whole number string, so a return
+// >= destSizeInChars means the output was truncated. Integers are decimal.
+// Doubles get the shortest string that parses back to the same value
+// (e.g.: "0.1", "1e+100"), so saved configs never lose precision.
+//
+int formatInt64(std::int64_t value, char * destBuf, int destSizeInChars);
+int formatDouble(double value, char * destBuf, int destSizeInChars);
+
 // ========================================================
 // File IO Callbacks:
 // ========================================================
@@ -1254,8 +2267,11 @@ using FileHandle = void *;
 
 enum class FileOpenMode
 {
-    Read, // "rt"
-    Write // "wt"
+    Read,        // "rt"
+    Write,       // "wt"
+    ReadBinary,  // "rb"
+    WriteBinary, // "wb"
+    Append       // "at"
 };
 
 class FileIOCallbacks
@@ -1264,6 +2280,8 @@ public:
     virtual ~FileIOCallbacks();
 
     // Open the file in *text mode*, for reading or writing.
+    // The binary modes are only used for config snapshots (see CommandManager::saveConfigSnapshot()).
+    // Append writes at the end of the file, creating it if needed (see CommandManager::appendConfigJournal()).
     // If open() fails, the output FileHandle is set to null, if the pointer itself wasn't null.
     virtual bool open(FileHandle * outHandle, const char * filename, FileOpenMode mode) = 0;
 
@@ -1287,6 +2305,20 @@ public:
 
     // Write a C-style format string. Max length limited to 2048-1 characters!
     virtual bool writeFormat(FileHandle fh, const char * fmt, ...) CFG_PRINTF_FUNC(3, 4) = 0;
+
+    // Optional bulk read of a file open()ed for reading. On success, outputs a pointer to
+    // the whole remaining contents of the file and its size in chars. The data doesn't have
+    // to be null terminated and must stay valid until unmapFile() is called. Callbacks that
+    // already have the file in memory (e.g.: an archive reader) can hand over their buffer.
+    // The default implementation returns false, so readLine() is used instead.
+    virtual bool mapFile(FileHandle fh, const char ** outData, std::size_t * outSizeInChars);
+
+    // Releases data returned by a successful mapFile(). Called before close().
+    virtual void unmapFile(FileHandle fh, const char * data);
+
+    // Write raw bytes to a file open in WriteBinary mode. Optional;
+    // the default implementation returns false (no binary snapshots).
+    virtual bool writeBytes(FileHandle fh, const void * data, std::size_t sizeInBytes);
 };
 
 // The FileIOCallbacks are used to read and write configuration files.
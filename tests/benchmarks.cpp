@@ -0,0 +1,691 @@
+// ================================================================================================
+// -*- C++ -*-
+// File: benchmarks.cpp
+// Author: Guilherme R. Lampert
+// Created on: 14/10/26
+// Brief: Micro-benchmarks for the hot paths of the library.
+// License: This source code is in the public domain.
+// ================================================================================================
+
+#include "cfg.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+// Usage: cfg_bench [-json | -csv] [-min=<count>] [-max=<count>]
+//
+// The scaling suite runs once for each power of ten between the min and max
+// counts of CVars/Commands (100 to 1M by default). The default output is a set
+// of human readable tables. With -json or -csv every measurement is written to
+// stdout as a record instead, to be collected by performance tracking tools.
+//
+
+// ========================================================
+// Timing helpers:
+// ========================================================
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchResult final
+{
+    double        nsPerOp;
+    std::uint64_t checksum; // Keeps the compiler from discarding the work.
+};
+
+enum class OutputFormat
+{
+    Text,
+    Json,
+    Csv
+};
+
+struct BenchRecord final
+{
+    std::string   suite;   // Section of the benchmark, e.g.: "scaling".
+    std::string   name;    // Operation measured.
+    std::string   variant; // "baseline"/"current" for comparisons, empty otherwise.
+    int           count;   // Number of CVars/Commands or input values the test ran with.
+    std::uint64_t ops;     // Number of operations timed.
+    double        nsPerOp;
+};
+
+static OutputFormat outputFormat = OutputFormat::Text;
+static std::vector<BenchRecord> benchRecords;
+static std::string currentSuite;
+
+static void addRecord(const char * const name, const char * const variant, const int count,
+                      const std::uint64_t ops, const double nsPerOp)
+{
+    benchRecords.push_back({ currentSuite, name, variant, count, ops, nsPerOp });
+}
+
+static double nsSince(const Clock::time_point start)
+{
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+template<typename Func>
+static BenchResult runBench(const int opCount, Func && func)
+{
+    std::uint64_t checksum = 0;
+    const auto start = Clock::now();
+    for (int i = 0; i < opCount; ++i)
+    {
+        checksum += func(i);
+    }
+    return { nsSince(start) / opCount, checksum };
+}
+
+static void printResult(const char * const name, const int count, const int opCount,
+                        const BenchResult & baseline, const BenchResult & current)
+{
+    addRecord(name, "baseline", count, opCount, baseline.nsPerOp);
+    addRecord(name, "current",  count, opCount, current.nsPerOp);
+
+    if (outputFormat != OutputFormat::Text)
+    {
+        return;
+    }
+    std::printf("%-28s | %9.2f ns/op | %9.2f ns/op | x%.2f\n",
+                name, baseline.nsPerOp, current.nsPerOp, baseline.nsPerOp / current.nsPerOp);
+}
+
+static void printHeader(const char * const title)
+{
+    currentSuite = title;
+    if (outputFormat != OutputFormat::Text)
+    {
+        return;
+    }
+
+    std::printf("\n%-28s | %15s | %15s | speedup\n", title, "baseline", "current");
+    std::printf("-----------------------------+-----------------+-----------------+--------\n");
+}
+
+// ========================================================
+// Number conversions:
+// ========================================================
+
+static void benchNumberConversions()
+{
+    constexpr int Count = 100000;
+    constexpr int Reps  = 10;
+
+    std::vector<std::string> intStrings;
+    std::vector<std::string> floatStrings;
+    std::vector<std::int64_t> intValues;
+    std::vector<double> floatValues;
+
+    std::srand(1234);
+    for (int i = 0; i < Count; ++i)
+    {
+        char str[64];
+        const std::int64_t iv = (static_cast<std::int64_t>(std::rand()) << 16) ^ std::rand();
+        std::snprintf(str, sizeof(str), "%" PRIi64, (i & 1) ? iv : -iv);
+        intStrings.emplace_back(str);
+        intValues.push_back((i & 1) ? iv : -iv);
+
+        const double fv = (std::rand() % 200000) / 1000.0 - 100.0;
+        std::snprintf(str, sizeof(str), "%.8g", fv);
+        floatStrings.emplace_back(str);
+        floatValues.push_back(fv);
+    }
+
+    printHeader("Number conversions");
+
+    // Baseline is the former path: a std::string was built, then strtoll()/strtod().
+    const auto parseIntOld = runBench(Count * Reps, [&](int i) {
+        const std::string & s = intStrings[i % Count];
+        const std::string temp(s.data(), s.size());
+        return static_cast<std::uint64_t>(std::strtoll(temp.c_str(), nullptr, 0));
+    });
+    const auto parseIntNew = runBench(Count * Reps, [&](int i) {
+        const std::string & s = intStrings[i % Count];
+        std::int64_t value;
+        cfg::parseInt64(s.data(), static_cast<int>(s.size()), &value);
+        return static_cast<std::uint64_t>(value);
+    });
+    printResult("parse int", Count, Count * Reps, parseIntOld, parseIntNew);
+
+    const auto parseFloatOld = runBench(Count * Reps, [&](int i) {
+        const std::string & s = floatStrings[i % Count];
+        const std::string temp(s.data(), s.size());
+        return static_cast<std::uint64_t>(std::strtod(temp.c_str(), nullptr) * 1000.0);
+    });
+    const auto parseFloatNew = runBench(Count * Reps, [&](int i) {
+        const std::string & s = floatStrings[i % Count];
+        double value;
+        cfg::parseDouble(s.data(), static_cast<int>(s.size()), &value);
+        return static_cast<std::uint64_t>(value * 1000.0);
+    });
+    printResult("parse float", Count, Count * Reps, parseFloatOld, parseFloatNew);
+
+    const auto formatIntOld = runBench(Count * Reps, [&](int i) {
+        char str[32];
+        return static_cast<std::uint64_t>(std::snprintf(str, sizeof(str), "%" PRIi64, intValues[i % Count]));
+    });
+    const auto formatIntNew = runBench(Count * Reps, [&](int i) {
+        char str[32];
+        return static_cast<std::uint64_t>(cfg::formatInt64(intValues[i % Count], str, sizeof(str)));
+    });
+    printResult("format int", Count, Count * Reps, formatIntOld, formatIntNew);
+
+    // The new output is round-trip exact, the baseline only keeps 8 digits.
+    const auto formatFloatOld = runBench(Count * Reps, [&](int i) {
+        char str[64];
+        return static_cast<std::uint64_t>(std::snprintf(str, sizeof(str), "%.8g", floatValues[i % Count]));
+    });
+    const auto formatFloatNew = runBench(Count * Reps, [&](int i) {
+        char str[64];
+        return static_cast<std::uint64_t>(cfg::formatDouble(floatValues[i % Count], str, sizeof(str)));
+    });
+    printResult("format float", Count, Count * Reps, formatFloatOld, formatFloatNew);
+}
+
+// ========================================================
+// CVar string get/set:
+// ========================================================
+
+static void benchCVarStrings()
+{
+    constexpr int VarCount = 10000;
+    constexpr int Reps     = 20;
+
+    auto cvarManager = cfg::CVarManager::createInstance();
+    std::vector<cfg::CVar *> floatVars;
+    std::vector<std::string> values;
+
+    for (int i = 0; i < VarCount; ++i)
+    {
+        char name[64];
+        std::snprintf(name, sizeof(name), "bench_float_%i", i);
+        floatVars.push_back(cvarManager->registerCVarFloat(name, "", 0, 0.0, -1e9, 1e9));
+
+        char value[64];
+        std::snprintf(value, sizeof(value), "%.6f", i * 0.125);
+        values.emplace_back(value);
+    }
+
+    printHeader("CVar set/get (float vars)");
+
+    // Like the 'set' command and config loading.
+    const auto setOld = runBench(VarCount * Reps, [&](int i) {
+        return static_cast<std::uint64_t>(floatVars[i % VarCount]->setStringValue(values[i % VarCount]));
+    });
+    const auto setNew = runBench(VarCount * Reps, [&](int i) {
+        const std::string & v = values[i % VarCount];
+        return static_cast<std::uint64_t>(floatVars[i % VarCount]->setStringValue(v.data(), static_cast<int>(v.size())));
+    });
+    printResult("setStringValue", VarCount, VarCount * Reps, setOld, setNew);
+
+    // Like saveConfig and listCVars.
+    const auto getOld = runBench(VarCount * Reps, [&](int i) {
+        return static_cast<std::uint64_t>(floatVars[i % VarCount]->getStringValue().size());
+    });
+    const auto getNew = runBench(VarCount * Reps, [&](int i) {
+        char str[64];
+        return static_cast<std::uint64_t>(floatVars[i % VarCount]->getStringValue(str, sizeof(str)));
+    });
+    printResult("getStringValue", VarCount, VarCount * Reps, getOld, getNew);
+
+    cfg::CVarManager::destroyInstance(cvarManager);
+}
+
+// ========================================================
+// Scaling suite helpers:
+// ========================================================
+
+// Small xorshift generator, so the inputs are the same on every platform.
+struct BenchRandom final
+{
+    std::uint32_t state;
+
+    explicit BenchRandom(const std::uint32_t seed) : state(seed) { }
+
+    std::uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    int nextIndex(const int count)
+    {
+        return static_cast<int>(next() % static_cast<std::uint32_t>(count));
+    }
+};
+
+// Terminal that discards all output. Also lets the benchmark set the input
+// line, which is only accessible to subclasses, before pressing [TAB].
+class BenchTerminal final
+    : public cfg::SimpleCommandTerminal
+{
+public:
+
+    BenchTerminal(cfg::CommandManager * cmdMgr, cfg::CVarManager * cvarMgr)
+        : cfg::SimpleCommandTerminal(cmdMgr, cvarMgr)
+    { }
+
+    void print(const char *)   override { }
+    void printLn(const char *) override { }
+    void printF(const char *, ...) override { }
+
+    std::uint64_t completeLine(const char * const partialLine)
+    {
+        // [ESCAPE] ends the previous completion, so every [TAB] searches again instead of cycling the matches.
+        handleKeyInput(cfg::SpecialKeys::Escape, 0);
+        setLineBuffer(partialLine);
+        handleKeyInput(cfg::SpecialKeys::Tab, 0);
+        return std::strlen(getLineBuffer());
+    }
+};
+
+static void benchCmdHandler(const cfg::CommandArgs & args, void * userContext)
+{
+    *static_cast<std::uint64_t *>(userContext) += args.getArgCount();
+}
+
+static void printScaleHeader(const int count)
+{
+    if (outputFormat != OutputFormat::Text)
+    {
+        return;
+    }
+    char title[64];
+    std::snprintf(title, sizeof(title), "Scaling (%i CVars/Commands)", count);
+    std::printf("\n%-42s | %18s | %10s\n", title, "time", "ops");
+    std::printf("-------------------------------------------+--------------------+-----------\n");
+}
+
+static void printScaleResult(const char * const name, const int count, const std::uint64_t ops, const double nsPerOp)
+{
+    addRecord(name, "", count, ops, nsPerOp);
+
+    if (outputFormat != OutputFormat::Text)
+    {
+        return;
+    }
+    std::printf("%-42s | %12.2f ns/op | %10" PRIu64 "\n", name, nsPerOp, ops);
+}
+
+// Finds pairs of distinct valid names that have the same hash, by a birthday search over
+// generated names. The names are all lowercase, so they collide in both the case sensitive
+// and the case insensitive hashes, independent of the CFG_*_CASE_SENSITIVE_NAMES settings.
+static std::vector<std::pair<std::string, std::string>> findCollidingNames(const int candidateCount)
+{
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(candidateCount);
+
+    for (int i = 0; i < candidateCount; ++i)
+    {
+        char name[64];
+        std::snprintf(name, sizeof(name), "bench_hc_%x", i);
+        hashes.push_back((static_cast<std::uint64_t>(cfg::HashedName::hashOf(name, false)) << 32) | static_cast<std::uint32_t>(i));
+    }
+    std::sort(hashes.begin(), hashes.end());
+
+    std::vector<std::pair<std::string, std::string>> pairs;
+    for (std::size_t i = 1; i < hashes.size(); ++i)
+    {
+        if ((hashes[i] >> 32) == (hashes[i - 1] >> 32))
+        {
+            char first[64], second[64];
+            std::snprintf(first,  sizeof(first),  "bench_hc_%x", static_cast<std::uint32_t>(hashes[i - 1]));
+            std::snprintf(second, sizeof(second), "bench_hc_%x", static_cast<std::uint32_t>(hashes[i]));
+            pairs.emplace_back(first, second);
+            ++i; // Only use each name once.
+        }
+    }
+    return pairs;
+}
+
+// ========================================================
+// Scaling suite:
+// ========================================================
+
+static void benchScaling(const int count, const std::vector<std::pair<std::string, std::string>> & collidingNames)
+{
+    constexpr int LookupOps     = 500000;
+    constexpr int ExecOps       = 200000;
+    constexpr int CompletionOps = 20000;
+    constexpr int ExecBatchSize = 256;
+    constexpr int FileLinesMin  = 100000; // Small files run repeatedly up to this many lines.
+
+    const char * const configFile = "cfg_bench_tmp.cfg";
+    const int fileReps = std::max(1, FileLinesMin / count);
+
+    BenchRandom rng(1234);
+    printScaleHeader(count);
+
+    // Names are registered in random order, like CVars spread over many modules would be.
+    std::vector<std::string> cvarNames(count);
+    std::vector<std::string> cmdNames(count);
+    std::vector<int> order(count);
+    for (int i = 0; i < count; ++i)
+    {
+        char name[64];
+        std::snprintf(name, sizeof(name), "bench_var_%07i", i);
+        cvarNames[i] = name;
+        std::snprintf(name, sizeof(name), "bench_cmd_%07i", i);
+        cmdNames[i] = name;
+        order[i] = i;
+    }
+    for (int i = count - 1; i > 0; --i)
+    {
+        std::swap(order[i], order[rng.nextIndex(i + 1)]);
+    }
+
+    auto cvarManager = cfg::CVarManager::createInstance();
+    auto cmdManager  = cfg::CommandManager::createInstance(0, cvarManager);
+    BenchTerminal terminal(cmdManager, cvarManager);
+    cfg::registerDefaultCommands(cmdManager, &terminal);
+
+    //
+    // Registration:
+    //
+    {
+        constexpr std::uint32_t Flags = cfg::CVar::Flags::Persistent;
+        std::uint64_t checksum = 0;
+
+        const auto start = Clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            const int index = order[i];
+            const char * const name = cvarNames[index].c_str();
+            cfg::CVar * cvar;
+            switch (index & 3)
+            {
+            case 0  : cvar = cvarManager->registerCVarInt(name, "", Flags, index, 0, count); break;
+            case 1  : cvar = cvarManager->registerCVarFloat(name, "", Flags, index * 0.5, 0.0, count); break;
+            case 2  : cvar = cvarManager->registerCVarBool(name, "", Flags, (index & 4) != 0); break;
+            default : cvar = cvarManager->registerCVarString(name, "", Flags, "value_" + cvarNames[index], nullptr); break;
+            } // switch (index & 3)
+            checksum += (cvar != nullptr);
+        }
+        printScaleResult("registerCVar*", count, count, nsSince(start) / count);
+
+        std::uint64_t cmdCalls = 0;
+        const auto startCmds = Clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            checksum += cmdManager->registerCommand(cmdNames[order[i]].c_str(), &benchCmdHandler, nullptr, &cmdCalls);
+        }
+        printScaleResult("registerCommand", count, count, nsSince(startCmds) / count);
+
+        if (checksum != static_cast<std::uint64_t>(count) * 2)
+        {
+            std::fprintf(stderr, "Registration failed for %i names!\n", count * 2 - static_cast<int>(checksum));
+        }
+    }
+
+    //
+    // Lookups:
+    //
+    {
+        // Names are looked up in random order, so large tables don't stay in cache.
+        std::vector<const char *> hitNames(LookupOps);
+        std::vector<cfg::HashedName> hitHashedNames;
+        hitHashedNames.reserve(LookupOps);
+        for (int i = 0; i < LookupOps; ++i)
+        {
+            hitNames[i] = cvarNames[rng.nextIndex(count)].c_str();
+            hitHashedNames.emplace_back(hitNames[i]);
+        }
+
+        std::vector<std::string> missNames(std::min(count, 65536));
+        for (std::size_t i = 0; i < missNames.size(); ++i)
+        {
+            char name[64];
+            std::snprintf(name, sizeof(name), "bench_miss_%07i", static_cast<int>(i));
+            missNames[i] = name;
+        }
+
+        // Each lookup of the second name of a pair first meets the CVar of the first name.
+        const int pairCount = std::max(1, std::min(static_cast<int>(collidingNames.size()), count / 10));
+        for (int i = 0; i < pairCount && i < static_cast<int>(collidingNames.size()); ++i)
+        {
+            cvarManager->registerCVarInt(collidingNames[i].first.c_str(),  "", 0, 0, 0, 1);
+            cvarManager->registerCVarInt(collidingNames[i].second.c_str(), "", 0, 1, 0, 1);
+        }
+
+        const auto hit = runBench(LookupOps, [&](int i) {
+            return static_cast<std::uint64_t>(cvarManager->findCVar(hitNames[i]) != nullptr);
+        });
+        printScaleResult("findCVar (hit)", count, LookupOps, hit.nsPerOp);
+
+        const auto hitHashed = runBench(LookupOps, [&](int i) {
+            return static_cast<std::uint64_t>(cvarManager->findCVar(hitHashedNames[i]) != nullptr);
+        });
+        printScaleResult("findCVar (hit, HashedName)", count, LookupOps, hitHashed.nsPerOp);
+
+        const auto miss = runBench(LookupOps, [&](int i) {
+            return static_cast<std::uint64_t>(cvarManager->findCVar(missNames[i % missNames.size()].c_str()) != nullptr);
+        });
+        printScaleResult("findCVar (miss)", count, LookupOps, miss.nsPerOp);
+
+        if (!collidingNames.empty())
+        {
+            const auto collide = runBench(LookupOps, [&](int i) {
+                return static_cast<std::uint64_t>(cvarManager->findCVar(collidingNames[i % pairCount].second.c_str()) != nullptr);
+            });
+            printScaleResult("findCVar (hash collision)", count, LookupOps, collide.nsPerOp);
+        }
+
+        // Dropping the last two digits gives prefixes with up to 100 matches.
+        std::vector<std::string> prefixes(CompletionOps);
+        for (int i = 0; i < CompletionOps; ++i)
+        {
+            const std::string & name = cvarNames[rng.nextIndex(count)];
+            prefixes[i] = name.substr(0, name.size() - 2);
+        }
+
+        // The first prefix query merges the registration tail into the sorted index.
+        const char * matches[128];
+        const auto startFirst = Clock::now();
+        cvarManager->findCVarsWithPartialName(prefixes[0].c_str(), matches, 128);
+        printScaleResult("findCVarsWithPartialName (first)", count, 1, nsSince(startFirst));
+
+        const auto partial = runBench(CompletionOps, [&](int i) {
+            return static_cast<std::uint64_t>(cvarManager->findCVarsWithPartialName(prefixes[i].c_str(), matches, 128));
+        });
+        printScaleResult("findCVarsWithPartialName", count, CompletionOps, partial.nsPerOp);
+
+        const auto complete = runBench(CompletionOps, [&](int i) {
+            return terminal.completeLine(prefixes[i].c_str());
+        });
+        printScaleResult("tabCompletion (CVar name)", count, CompletionOps, complete.nsPerOp);
+
+        const auto completeCmd = runBench(CompletionOps, [&](int i) {
+            std::string & prefix = prefixes[i];
+            prefix.replace(0, 9, "bench_cmd");
+            return terminal.completeLine(prefix.c_str());
+        });
+        printScaleResult("tabCompletion (command name)", count, CompletionOps, completeCmd.nsPerOp);
+    }
+
+    //
+    // Command execution:
+    //
+    {
+        constexpr int CmdStringCount = 4096;
+
+        std::vector<std::string> plainCmds(CmdStringCount);
+        std::vector<std::string> varCmds(CmdStringCount);
+        for (int i = 0; i < CmdStringCount; ++i)
+        {
+            const std::string & cmd = cmdNames[rng.nextIndex(count)];
+            plainCmds[i] = cmd + " 42 2.5 value";
+            varCmds[i]   = cmd + " $(" + cvarNames[rng.nextIndex(count)] + ") 2.5 value";
+        }
+
+        const auto execPlain = runBench(ExecOps, [&](int i) {
+            cmdManager->execNow(plainCmds[i % CmdStringCount].c_str());
+            return 1;
+        });
+        printScaleResult("execNow", count, ExecOps, execPlain.nsPerOp);
+
+        const auto execVars = runBench(ExecOps, [&](int i) {
+            cmdManager->execNow(varCmds[i % CmdStringCount].c_str());
+            return 1;
+        });
+        printScaleResult("execNow ($(var))", count, ExecOps, execVars.nsPerOp);
+
+        const auto runBuffered = [&](const std::vector<std::string> & cmds)
+        {
+            const auto start = Clock::now();
+            for (int i = 0; i < ExecOps; i += ExecBatchSize)
+            {
+                for (int j = i; j < i + ExecBatchSize; ++j)
+                {
+                    cmdManager->execAppend(cmds[j % CmdStringCount].c_str());
+                }
+                cmdManager->execBufferedCommands();
+            }
+            const int ops = ((ExecOps + ExecBatchSize - 1) / ExecBatchSize) * ExecBatchSize;
+            return nsSince(start) / ops;
+        };
+        printScaleResult("execAppend+execBufferedCommands", count, ExecOps, runBuffered(plainCmds));
+        printScaleResult("execAppend+execBufferedCommands ($(var))", count, ExecOps, runBuffered(varCmds));
+    }
+
+    //
+    // Config files:
+    //
+    {
+        // Same contents saveConfig would write, but in a different order.
+        if (FILE * file = std::fopen(configFile, "wt"))
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                const int index = order[count - 1 - i];
+                switch (index & 3)
+                {
+                case 0  : std::fprintf(file, "set %s %i\n", cvarNames[index].c_str(), count - index); break;
+                case 1  : std::fprintf(file, "set %s %.2f\n", cvarNames[index].c_str(), index * 0.25); break;
+                case 2  : std::fprintf(file, "set %s %s\n", cvarNames[index].c_str(), (index & 8) ? "true" : "false"); break;
+                default : std::fprintf(file, "set %s \"file_%i\"\n", cvarNames[index].c_str(), index); break;
+                } // switch (index & 3)
+            }
+            std::fclose(file);
+        }
+
+        auto start = Clock::now();
+        for (int r = 0; r < fileReps; ++r)
+        {
+            cmdManager->execConfigFile(configFile, nullptr);
+        }
+        printScaleResult("execConfigFile (per line)", count, static_cast<std::uint64_t>(count) * fileReps,
+                         nsSince(start) / (static_cast<double>(count) * fileReps));
+
+        char saveCmd[256];
+        char reloadCmd[256];
+        std::snprintf(saveCmd,   sizeof(saveCmd),   "saveConfig %s", configFile);
+        std::snprintf(reloadCmd, sizeof(reloadCmd), "reloadConfig %s -force", configFile);
+
+        start = Clock::now();
+        for (int r = 0; r < fileReps; ++r)
+        {
+            cmdManager->execNow(saveCmd);
+        }
+        printScaleResult("saveConfig (per CVar)", count, static_cast<std::uint64_t>(count) * fileReps,
+                         nsSince(start) / (static_cast<double>(count) * fileReps));
+
+        start = Clock::now();
+        for (int r = 0; r < fileReps; ++r)
+        {
+            cmdManager->execNow(reloadCmd);
+        }
+        printScaleResult("reloadConfig (per CVar)", count, static_cast<std::uint64_t>(count) * fileReps,
+                         nsSince(start) / (static_cast<double>(count) * fileReps));
+
+        // saveConfig also resets the journal of the file.
+        std::remove(configFile);
+        std::remove((std::string(configFile) + ".journal").c_str());
+    }
+
+    cfg::CommandManager::destroyInstance(cmdManager);
+    cfg::CVarManager::destroyInstance(cvarManager);
+}
+
+// ========================================================
+// Machine-readable output:
+// ========================================================
+
+static void writeRecordsJson()
+{
+    std::printf("{\n  \"benchmarks\": [\n");
+    for (std::size_t i = 0; i < benchRecords.size(); ++i)
+    {
+        const BenchRecord & r = benchRecords[i];
+        std::printf("    { \"suite\": \"%s\", \"name\": \"%s\", \"variant\": \"%s\", "
+                    "\"count\": %i, \"ops\": %" PRIu64 ", \"ns_per_op\": %.3f }%s\n",
+                    r.suite.c_str(), r.name.c_str(), r.variant.c_str(), r.count, r.ops, r.nsPerOp,
+                    (i + 1 < benchRecords.size()) ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+static void writeRecordsCsv()
+{
+    std::printf("suite,name,variant,count,ops,ns_per_op\n");
+    for (const BenchRecord & r : benchRecords)
+    {
+        std::printf("\"%s\",\"%s\",\"%s\",%i,%" PRIu64 ",%.3f\n",
+                    r.suite.c_str(), r.name.c_str(), r.variant.c_str(), r.count, r.ops, r.nsPerOp);
+    }
+}
+
+int main(const int argc, const char * argv[])
+{
+    int minCount = 100;
+    int maxCount = 1000000;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-json") == 0)
+        {
+            outputFormat = OutputFormat::Json;
+        }
+        else if (std::strcmp(argv[i], "-csv") == 0)
+        {
+            outputFormat = OutputFormat::Csv;
+        }
+        else if (std::strncmp(argv[i], "-min=", 5) == 0)
+        {
+            minCount = std::max(1, std::atoi(argv[i] + 5));
+        }
+        else if (std::strncmp(argv[i], "-max=", 5) == 0)
+        {
+            maxCount = std::max(1, std::atoi(argv[i] + 5));
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [-json | -csv] [-min=<count>] [-max=<count>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    benchNumberConversions();
+    benchCVarStrings();
+
+    currentSuite = "scaling";
+    const auto collidingNames = findCollidingNames(1 << 21);
+    for (long long count = minCount; count <= maxCount; count *= 10)
+    {
+        benchScaling(static_cast<int>(count), collidingNames);
+    }
+
+    switch (outputFormat)
+    {
+    case OutputFormat::Json : writeRecordsJson(); break;
+    case OutputFormat::Csv  : writeRecordsCsv();  break;
+    default                 : std::printf("\n");  break;
+    } // switch (outputFormat)
+}
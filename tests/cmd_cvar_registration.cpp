@@ -9,7 +9,28 @@
 // ================================================================================================
 
 #include "cfg.hpp"
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <thread>
+#include <vector>
+
+// Same default of cfg.cpp. Tests that need $(var) expansions check it.
+#ifndef CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    #define CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION 1
+#endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+#if defined(__APPLE__) || defined(__linux__) || defined(__unix__)
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    #define TEST_REMOTE_TERMINAL 1
+#endif // Apple/Linux/Unix
 
 static void addCommands(cfg::CommandManager * cmdManager)
 {
@@ -136,6 +157,1594 @@ static void addCVars(cfg::CVarManager * cvarManager)
     std::cout << "\n";
 }
 
+static void testCVarRefs(cfg::CVarManager * cvarManager)
+{
+    //
+    // Typed references to existing vars:
+    //
+    cfg::CVarRefInt   iRef = cvarManager->findCVarRef<std::int64_t>("iVar");
+    cfg::CVarRefFloat fRef = cvarManager->findCVarRef<double>("fVar");
+    cfg::CVarRefInt   eRef = cvarManager->findCVarRef<std::int64_t>("eVar");
+    CFG_ASSERT(iRef.isValid() && iRef.get() == 10);
+    CFG_ASSERT(fRef.isValid() && fRef.get() == 0.5);
+    CFG_ASSERT(eRef.isValid() && eRef.get() == 1); // Mustang
+
+    // References see the updates done via the CVar interface.
+    iRef.getCVar()->setIntValue(-5);
+    CFG_ASSERT(iRef.get() == -5);
+    iRef.getCVar()->setStringValue("7");
+    CFG_ASSERT(iRef.get() == 7);
+
+    // Type mismatch gives an empty reference.
+    cfg::CVarRefBool badRef = cvarManager->findCVarRef<bool>("iVar");
+    CFG_ASSERT(!badRef.isValid());
+
+    //
+    // References are nulled when the var is removed:
+    //
+    cfg::CVarRefString sRef{ cvarManager->registerCVarString("sVarRef", "", 0, "hello", nullptr) };
+    cfg::CVarRefString sRefCopy = sRef;
+    CFG_ASSERT(sRef.get() == "hello" && sRefCopy.get() == "hello");
+
+    cvarManager->removeCVar("sVarRef");
+    CFG_ASSERT(!sRef.isValid() && !sRefCopy.isValid());
+    CFG_ASSERT(sRef.getCVar() == nullptr);
+}
+
+static void testManyCVars(cfg::CVarManager * cvarManager)
+{
+    const int baseCount = cvarManager->getRegisteredCVarsCount();
+
+    //
+    // These two names have the same OAT hash, but must still
+    // resolve to different vars. Lookups compare the full name.
+    //
+    cfg::CVar * collA = cvarManager->registerCVarInt("var_35339",  "", 0, 1, 0, 10);
+    cfg::CVar * collB = cvarManager->registerCVarInt("var_165700", "", 0, 2, 0, 10);
+    CFG_ASSERT(collA != nullptr && collB != nullptr && collA != collB);
+    CFG_ASSERT(cvarManager->findCVar("var_35339")  == collA);
+    CFG_ASSERT(cvarManager->findCVar("var_165700") == collB);
+
+    //
+    // Enough vars to make the table grow a few times:
+    //
+    char name[64];
+    const int count = 5000;
+    for (int i = 0; i < count; ++i)
+    {
+        std::snprintf(name, sizeof(name), "many_%d", i);
+        CFG_ASSERT(cvarManager->registerCVarInt(name, "", 0, i, 0, count) != nullptr);
+    }
+    CFG_ASSERT(cvarManager->getRegisteredCVarsCount() == baseCount + count + 2);
+
+    // Remove every other one, then check what's left.
+    for (int i = 0; i < count; i += 2)
+    {
+        std::snprintf(name, sizeof(name), "many_%d", i);
+        CFG_ASSERT(cvarManager->removeCVar(name));
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        std::snprintf(name, sizeof(name), "many_%d", i);
+        cfg::CVar * cvar = cvarManager->findCVar(name);
+        CFG_ASSERT((i % 2 == 0) ? (cvar == nullptr) : (cvar != nullptr && cvar->getIntValue() == i));
+    }
+
+    //
+    // Prefix searches come back sorted, with the total match count:
+    //
+    const char * matches[8];
+    CFG_ASSERT(cvarManager->findCVarsWithPartialName("many_123", matches, 4) == 6); // many_123, many_1231..1239 (odd)
+    CFG_ASSERT(std::strcmp(matches[0], "many_123")  == 0);
+    CFG_ASSERT(std::strcmp(matches[1], "many_1231") == 0);
+    CFG_ASSERT(std::strcmp(matches[3], "many_1235") == 0);
+    CFG_ASSERT(cvarManager->findCVarsWithPartialName("many_", matches, 8) == count - count / 2);
+    CFG_ASSERT(cvarManager->findCVarsWithPartialName("many_x", matches, 8) == 0);
+
+    // Removing and adding between searches, in and out of the sorted range.
+    CFG_ASSERT(cvarManager->removeCVar("many_1231"));
+    CFG_ASSERT(cvarManager->registerCVarInt("many_1230", "", 0, 0, 0, count) != nullptr);
+    CFG_ASSERT(cvarManager->findCVarsWithPartialName("many_123", matches, 4) == 6);
+    CFG_ASSERT(std::strcmp(matches[1], "many_1230") == 0);
+    CFG_ASSERT(std::strcmp(matches[2], "many_1233") == 0);
+    CFG_ASSERT(cvarManager->removeCVar("many_1230"));
+    CFG_ASSERT(cvarManager->registerCVarInt("many_1231", "", 0, 1231, 0, count) != nullptr);
+
+    CFG_ASSERT(cvarManager->removeCVar(collA));
+    CFG_ASSERT(cvarManager->findCVar("var_35339")  == nullptr);
+    CFG_ASSERT(cvarManager->findCVar("var_165700") == collB);
+    CFG_ASSERT(cvarManager->removeCVar(collB));
+
+    for (int i = 1; i < count; i += 2)
+    {
+        std::snprintf(name, sizeof(name), "many_%d", i);
+        CFG_ASSERT(cvarManager->removeCVar(name));
+    }
+    CFG_ASSERT(cvarManager->getRegisteredCVarsCount() == baseCount);
+}
+
+static void testCommandArgs()
+{
+    cfg::CommandArgs args("  my_cmd one \"two words\" 'three'  ");
+    CFG_ASSERT(std::strcmp(args.getCommandName(), "my_cmd") == 0);
+    CFG_ASSERT(args.getArgCount() == 3);
+    CFG_ASSERT(args.compare(1, "two words") == 0 && args.getArgLength(1) == 9);
+    CFG_ASSERT(args.compare(2, "three") == 0 && args.getArgLength(2) == 5);
+
+    //
+    // In-place args point into the source buffer:
+    //
+    char buffer[] = "my_cmd one \"two words\" 'three'";
+    cfg::CommandArgs inPlaceArgs;
+    inPlaceArgs.tokenizeInPlace(buffer);
+    CFG_ASSERT(inPlaceArgs.getCommandName() == buffer);
+    CFG_ASSERT(inPlaceArgs.getArgCount() == 3);
+    CFG_ASSERT(inPlaceArgs[0] == buffer + 7 && inPlaceArgs.getArgLength(0) == 3);
+    CFG_ASSERT(std::strcmp(inPlaceArgs[1], "two words") == 0 && inPlaceArgs.getArgLength(1) == 9);
+    CFG_ASSERT(std::strcmp(inPlaceArgs[2], "three") == 0);
+
+    // A copy owns its strings; moving shares the source buffer.
+    cfg::CommandArgs copied = inPlaceArgs;
+    cfg::CommandArgs moved  = std::move(inPlaceArgs);
+    CFG_ASSERT(copied[0] != buffer + 7 && copied.compare(0, "one") == 0);
+    CFG_ASSERT(moved[0] == buffer + 7 && moved.getArgLength(2) == 5);
+
+    // Moving owned strings rebases them into the new object.
+    cfg::CommandArgs movedCopy = std::move(copied);
+    CFG_ASSERT(movedCopy.compare(1, "two words") == 0);
+    CFG_ASSERT(std::strcmp(movedCopy.getCommandName(), "my_cmd") == 0);
+}
+
+static void testCommandBuffer(cfg::CommandManager * cmdManager)
+{
+    // Each run of 'log_cmd' appends its argument to this string.
+    static std::string execLog;
+    cmdManager->registerCommand("log_cmd", [](const cfg::CommandArgs & args) { execLog += args[0]; });
+
+    // Pushes more commands from inside a handler:
+    struct PushHelper
+    {
+        cfg::CommandManager * mgr;
+        void run(const cfg::CommandArgs &) const
+        {
+            mgr->execInsert("log_cmd i1; log_cmd i2");
+            mgr->execAppend("log_cmd a1");
+        }
+    } pushHelper{ cmdManager };
+    cmdManager->registerCommand("push_cmds_mf", makeMemFuncCommandHandler(&pushHelper, &PushHelper::run));
+
+    //
+    // Insert goes in front of the buffered text, keeping its own order:
+    //
+    cmdManager->execAppend("log_cmd 1; log_cmd 2\nlog_cmd \"3;4\"");
+    cmdManager->execInsert("log_cmd 0a;log_cmd 0b");
+    CFG_ASSERT(cmdManager->getBufferedCommandsCount() == 5);
+    CFG_ASSERT(cmdManager->execBufferedCommands() == 5);
+    CFG_ASSERT(execLog == "0a0b123;4");
+    CFG_ASSERT(!cmdManager->hasBufferedCommands());
+
+    //
+    // Commands pushed by a handler run in the same frame:
+    //
+    execLog.clear();
+    cmdManager->execAppend("log_cmd x; push_cmds_mf; log_cmd y");
+    CFG_ASSERT(cmdManager->execBufferedCommands(2) == 2);
+    CFG_ASSERT(cmdManager->getBufferedCommandsCount() == 4);
+    CFG_ASSERT(cmdManager->execBufferedCommands() == 4);
+    CFG_ASSERT(execLog == "xi1i2ya1");
+
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    // CVar expansion still happens when the command runs.
+    execLog.clear();
+    cmdManager->execAppend("log_cmd $(sVar2)");
+    cmdManager->execBufferedCommands();
+    CFG_ASSERT(execLog == "1234");
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+    //
+    // Lots of commands, bigger than the default buffer size:
+    //
+    execLog.clear();
+    cmdManager->setCommandBufferSize(1024 * 1024);
+    for (int i = 0; i < 20000; ++i)
+    {
+        cmdManager->execAppend("log_cmd .");
+    }
+    CFG_ASSERT(cmdManager->getBufferedCommandsCount() == 20000);
+    CFG_ASSERT(cmdManager->execBufferedCommands() == 20000);
+    CFG_ASSERT(execLog.size() == 20000);
+
+    // Text past the limit is discarded.
+    cmdManager->setCommandBufferSize(16);
+    cmdManager->execAppend("log_cmd 0123456789");
+    CFG_ASSERT(!cmdManager->hasBufferedCommands());
+    cmdManager->setCommandBufferSize(cfg::CommandBufferSize);
+    CFG_ASSERT(cmdManager->getCommandBufferSize() == cfg::CommandBufferSize);
+
+    CFG_ASSERT(cmdManager->removeCommand("log_cmd"));
+    CFG_ASSERT(cmdManager->removeCommand("push_cmds_mf"));
+}
+
+static void testCompiledConfig(cfg::CommandManager * cmdManager)
+{
+    static std::string execLog;
+    cmdManager->registerCommand("log_cfg", [](const cfg::CommandArgs & args) { execLog += args[0]; });
+
+    const char * const filename = "test_compiled.cfg";
+    FILE * file = std::fopen(filename, "wt");
+    CFG_ASSERT(file != nullptr);
+    std::fputs("# comment line\n", file);
+    std::fputs("log_cfg a; log_cfg \"b c\"\n", file);
+    std::fputs("// another comment\n", file);
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    std::fputs("log_cfg $(sVar2)\n", file);
+    const std::string expanded = "1234";
+    #else // !CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    const std::string expanded;
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    std::fputs("log_cfg d\n", file);
+    std::fclose(file);
+
+    // The program is accounted to the command buffer category, if memory stats are on.
+    const int cmdBuffer = static_cast<int>(cfg::MemoryCategory::CommandBuffer);
+    cfg::MemoryStats beforeCompile, afterCompile;
+    const bool hasMemoryStats = cfg::getMemoryStats(&beforeCompile);
+
+    CFG_ASSERT(cmdManager->compileConfigFile(filename));
+    CFG_ASSERT(cmdManager->execCompiledConfig(filename, nullptr));
+    CFG_ASSERT(execLog == "ab c" + expanded + "d");
+
+    CFG_ASSERT(cfg::getMemoryStats(&afterCompile) == hasMemoryStats);
+    CFG_ASSERT(!hasMemoryStats || afterCompile.categories[cmdBuffer].liveBytes > beforeCompile.categories[cmdBuffer].liveBytes);
+
+    // The cached program doesn't read the file again.
+    std::remove(filename);
+    execLog.clear();
+    CFG_ASSERT(cmdManager->execCompiledConfig(filename, nullptr));
+    CFG_ASSERT(execLog == "ab c" + expanded + "d");
+
+    // Removing a command makes the program look it up again.
+    CFG_ASSERT(cmdManager->removeCommand("log_cfg"));
+    cmdManager->registerCommand("log_cfg", [](const cfg::CommandArgs & args) { execLog += "+"; execLog += args[0]; });
+    execLog.clear();
+    CFG_ASSERT(cmdManager->execCompiledConfig(filename, nullptr));
+    CFG_ASSERT(execLog == "+a+b c" + (expanded.empty() ? "" : "+" + expanded) + "+d");
+
+    // Discarded programs need the file again.
+    cmdManager->discardCompiledConfig(filename);
+    CFG_ASSERT(!cmdManager->execCompiledConfig(filename, nullptr));
+
+    cfg::MemoryStats afterDiscard;
+    CFG_ASSERT(cfg::getMemoryStats(&afterDiscard) == hasMemoryStats);
+    CFG_ASSERT(!hasMemoryStats || afterDiscard.categories[cmdBuffer].liveBytes < afterCompile.categories[cmdBuffer].liveBytes);
+    CFG_ASSERT(cmdManager->removeCommand("log_cfg"));
+}
+
+static void testMappedConfigFile(cfg::CommandManager * cmdManager)
+{
+    // File IO that serves a single in-memory file, like an archive reader would.
+    struct MemoryFileIO final
+        : public cfg::FileIOCallbacks
+    {
+        const char * contents = "log_mem a\n# comment\nlog_mem b; log_mem c\nlog_mem d";
+        int unmapCount = 0;
+
+        bool open(cfg::FileHandle * outHandle, const char *, cfg::FileOpenMode mode) override
+        {
+            (*outHandle) = (mode == cfg::FileOpenMode::Read) ? this : nullptr;
+            return (*outHandle) != nullptr;
+        }
+        void close(cfg::FileHandle) override { }
+        bool isAtEOF(cfg::FileHandle) const override { return true; }
+        void rewind(cfg::FileHandle) override { }
+        bool readLine(cfg::FileHandle, char *, int) override { return false; }
+        bool writeString(cfg::FileHandle, const char *) override { return false; }
+        bool writeFormat(cfg::FileHandle, const char *, ...) override { return false; }
+
+        bool mapFile(cfg::FileHandle, const char ** outData, std::size_t * outSizeInChars) override
+        {
+            (*outData) = contents;
+            (*outSizeInChars) = std::strlen(contents);
+            return true;
+        }
+        void unmapFile(cfg::FileHandle, const char * data) override
+        {
+            CFG_ASSERT(data == contents);
+            ++unmapCount;
+        }
+    } memoryIO;
+
+    static std::string execLog;
+    cmdManager->registerCommand("log_mem", [](const cfg::CommandArgs & args) { execLog += args[0]; });
+
+    cfg::setFileIOCallbacks(&memoryIO);
+    CFG_ASSERT(cmdManager->execConfigFile("memory.cfg", nullptr));
+    cfg::setFileIOCallbacks(nullptr);
+
+    CFG_ASSERT(execLog == "abcd");
+    CFG_ASSERT(memoryIO.unmapCount == 1);
+    CFG_ASSERT(cmdManager->removeCommand("log_mem"));
+}
+
+static void testConfigSnapshot(cfg::CVarManager * cvarManager, cfg::CommandManager * cmdManager)
+{
+    using Flags = cfg::CVar::Flags;
+    const char * enumNames[] { "Low", "Medium", "High", nullptr };
+    const std::int64_t enumValues[] { 10, 20, 30, 0 };
+
+    cfg::CVar * iVar = cvarManager->registerCVarInt("snap_int", "", Flags::Persistent, 5, 0, 100);
+    cfg::CVar * fVar = cvarManager->registerCVarFloat("snap_float", "", Flags::Persistent, 0.0, -1.0, 1.0);
+    cfg::CVar * sVar = cvarManager->registerCVarString("snap_str", "", Flags::Persistent, "abc", nullptr);
+    cfg::CVar * eVar = cvarManager->registerCVarEnum("snap_enum", "", Flags::Persistent | Flags::RangeCheck,
+                                                     20, enumValues, enumNames);
+    cfg::CVar * bVar = cvarManager->registerCVarBool("snap_bool", "", Flags::Persistent, false);
+
+    // Same name hash, so these need the full names in the snapshot.
+    cfg::CVar * collA = cvarManager->registerCVarInt("var_35339",  "", Flags::Persistent, 1, 0, 10);
+    cfg::CVar * collB = cvarManager->registerCVarInt("var_165700", "", Flags::Persistent, 2, 0, 10);
+
+    // Vars created at runtime come back from the snapshot.
+    cvarManager->setCVarValueString("snap_user", "user value", Flags::Persistent | Flags::UserDefined);
+    cmdManager->createCommandAlias("snap_alias", "echo hi", cfg::CommandExecMode::Append);
+
+    iVar->setIntValue(42);
+    fVar->setFloatValue(0.1 + 0.2); // Not exact in text with the default float format.
+    sVar->setStringValue("with \"quotes\"; and separators");
+    eVar->setStringValue("High");
+    bVar->setBoolValue(true);
+
+    const char * const filename = "test_snapshot.bin";
+    CFG_ASSERT(cmdManager->saveConfigSnapshot(filename));
+
+    iVar->setIntValue(0);
+    fVar->setFloatValue(0.0);
+    sVar->setStringValue("");
+    eVar->setStringValue("Low");
+    bVar->setBoolValue(false);
+    collA->setIntValue(9);
+    collB->setIntValue(8);
+    CFG_ASSERT(cvarManager->removeCVar("snap_user"));
+    CFG_ASSERT(cmdManager->removeCommandAlias("snap_alias"));
+
+    CFG_ASSERT(cmdManager->loadConfigSnapshot(filename));
+    CFG_ASSERT(iVar->getIntValue() == 42);
+    CFG_ASSERT(fVar->getFloatValue() == 0.1 + 0.2);
+    CFG_ASSERT(sVar->getStringValue() == "with \"quotes\"; and separators");
+    CFG_ASSERT(eVar->getIntValue() == 30 && eVar->getStringValue() == "High");
+    CFG_ASSERT(bVar->getBoolValue() == true);
+    CFG_ASSERT(collA->getIntValue() == 1 && collB->getIntValue() == 2);
+    CFG_ASSERT(cvarManager->getCVarValueString("snap_user") == "user value");
+    CFG_ASSERT(cmdManager->findCommand("snap_alias") != nullptr);
+
+    // A new persistent var changes the schema, so the snapshot is refused.
+    iVar->setIntValue(1);
+    cfg::CVar * newVar = cvarManager->registerCVarInt("snap_new", "", Flags::Persistent, 0, 0, 1);
+    CFG_ASSERT(!cmdManager->loadConfigSnapshot(filename));
+    CFG_ASSERT(iVar->getIntValue() == 1);
+
+    std::remove(filename);
+    CFG_ASSERT(!cmdManager->loadConfigSnapshot(filename));
+
+    for (cfg::CVar * cvar : { iVar, fVar, sVar, eVar, bVar, collA, collB, newVar })
+    {
+        CFG_ASSERT(cvarManager->removeCVar(cvar));
+    }
+    CFG_ASSERT(cvarManager->removeCVar("snap_user"));
+    CFG_ASSERT(cmdManager->removeCommandAlias("snap_alias"));
+}
+
+static void testConfigJournal(cfg::CVarManager * cvarManager, cfg::CommandManager * cmdManager)
+{
+    using Flags = cfg::CVar::Flags;
+    cfg::CVar * iVar = cvarManager->registerCVarInt("journal_int", "", Flags::Persistent, 1, 0, 100);
+    cfg::CVar * sVar = cvarManager->registerCVarString("journal_str", "", Flags::Persistent, "a", nullptr);
+    cfg::CVar * vVar = cvarManager->registerCVarInt("journal_volatile", "", Flags::Volatile, 1, 0, 100);
+
+    // Start from a clean state, so only the changes below are journaled.
+    cvarManager->enumerateAllCVars([](cfg::CVar * cvar, void *) { cvar->clearModified(); return true; }, nullptr);
+
+    const char * const filename = "test_config.journal";
+    std::remove(filename);
+
+    iVar->setIntValue(10);
+    iVar->setIntValue(20);
+    vVar->setIntValue(30);
+
+    int entries = 0;
+    CFG_ASSERT(cmdManager->appendConfigJournal(filename, &entries));
+    CFG_ASSERT(entries == 1);
+    CFG_ASSERT(!iVar->isModified() && !vVar->isModified());
+
+    // Nothing modified, nothing appended.
+    CFG_ASSERT(cmdManager->appendConfigJournal(filename, &entries));
+    CFG_ASSERT(entries == 1);
+
+    sVar->setStringValue("journal \"value\"");
+    iVar->setIntValue(40);
+    CFG_ASSERT(cmdManager->appendConfigJournal(filename, &entries));
+    CFG_ASSERT(entries == 3);
+
+    // Replaying the journal restores the latest values.
+    // Stand-in for the default 'set' command, which needs a terminal.
+    static cfg::CVarManager * journalCVars = cvarManager;
+    cmdManager->registerCommand("set", [](const cfg::CommandArgs & args)
+                                { journalCVars->findCVar(args[0])->setStringValue(args[1]); });
+    iVar->setIntValue(0);
+    sVar->setStringValue("");
+    CFG_ASSERT(cmdManager->execConfigFile(filename, nullptr));
+    CFG_ASSERT(iVar->getIntValue() == 40);
+    CFG_ASSERT(sVar->getStringValue() == "journal \"value\"");
+    CFG_ASSERT(vVar->getIntValue() == 30);
+    CFG_ASSERT(cmdManager->removeCommand("set"));
+
+    // Compaction truncates the journal and restarts the count.
+    CFG_ASSERT(cmdManager->resetConfigJournal(filename));
+    sVar->clearModified();
+    iVar->setIntValue(50);
+    CFG_ASSERT(cmdManager->appendConfigJournal(filename, &entries));
+    CFG_ASSERT(entries == 1);
+
+    std::remove(filename);
+    for (cfg::CVar * cvar : { iVar, sVar, vVar })
+    {
+        CFG_ASSERT(cvarManager->removeCVar(cvar));
+    }
+}
+
+static void testChangeListeners(cfg::CVarManager * cvarManager)
+{
+    using Flags = cfg::CVar::Flags;
+    using Delivery = cfg::CVarChangeDelivery;
+
+    cfg::CVar * iVar = cvarManager->registerCVarInt("r_width", "", Flags::Persistent, 640, 0, 8192);
+    cfg::CVar * sVar = cvarManager->registerCVarString("r_mode", "", Flags::Volatile, "window", nullptr);
+    cfg::CVar * xVar = cvarManager->registerCVarInt("snd_volume", "", Flags::Persistent, 5, 0, 10);
+
+    // Counts the notifications received in the context int.
+    auto countCallback = [](cfg::CVar *, void * userContext) { ++(*static_cast<int *>(userContext)); };
+
+    int widthNow = 0, prefixBatched = 0, persistentNow = 0;
+    const int widthId = cvarManager->addChangeListener(iVar, countCallback, &widthNow, Delivery::Immediate);
+    const int prefixId = cvarManager->addChangeListenerForPrefix("r_", countCallback, &prefixBatched, Delivery::Batched);
+    const int flagsId = cvarManager->addChangeListenerForFlags(Flags::Persistent, countCallback, &persistentNow, Delivery::Immediate);
+    CFG_ASSERT(widthId > 0 && prefixId > 0 && flagsId > 0);
+    CFG_ASSERT(cvarManager->addChangeListener(nullptr, countCallback, nullptr, Delivery::Immediate) == 0);
+
+    iVar->setIntValue(800);
+    iVar->setIntValue(800); // Same value, not a change.
+    iVar->setIntValue(1024);
+    sVar->setStringValue("fullscreen");
+    xVar->setIntValue(7);
+    CFG_ASSERT(widthNow == 2 && persistentNow == 3);
+
+    // Batched: once per var, no matter how many times it changed.
+    CFG_ASSERT(prefixBatched == 0);
+    CFG_ASSERT(cvarManager->getPendingChangeNotificationsCount() == 2);
+    CFG_ASSERT(cvarManager->deliverChangeNotifications() == 2);
+    CFG_ASSERT(prefixBatched == 2);
+    CFG_ASSERT(cvarManager->deliverChangeNotifications() == 0);
+
+    // Separate from the Modified flag.
+    iVar->clearModified();
+    iVar->setDefaultValue();
+    CFG_ASSERT(widthNow == 3 && persistentNow == 4);
+
+    // Removed vars take their listeners and pending notifications with them.
+    sVar->setStringValue("window");
+    CFG_ASSERT(cvarManager->getPendingChangeNotificationsCount() == 2);
+    CFG_ASSERT(cvarManager->removeCVar(sVar));
+    CFG_ASSERT(cvarManager->removeCVar(iVar));
+    CFG_ASSERT(!cvarManager->removeChangeListener(widthId));
+    CFG_ASSERT(cvarManager->getPendingChangeNotificationsCount() == 0);
+
+    CFG_ASSERT(cvarManager->removeChangeListener(prefixId));
+    CFG_ASSERT(cvarManager->removeChangeListener(flagsId));
+    CFG_ASSERT(!cvarManager->removeChangeListener(flagsId));
+    xVar->setIntValue(1);
+    CFG_ASSERT(persistentNow == 4);
+    CFG_ASSERT(cvarManager->removeCVar(xVar));
+
+    // The listener prefixes are accounted in the memory stats, if enabled.
+    cfg::MemoryStats beforeListener, withListener;
+    if (cfg::getMemoryStats(&beforeListener))
+    {
+        const int strings = static_cast<int>(cfg::MemoryCategory::Strings);
+        const int longId = cvarManager->addChangeListenerForPrefix("a_rather_long_cvar_name_prefix_", countCallback,
+                                                                   nullptr, Delivery::Immediate);
+        CFG_ASSERT(cfg::getMemoryStats(&withListener));
+        CFG_ASSERT(withListener.categories[strings].liveBytes > beforeListener.categories[strings].liveBytes);
+        CFG_ASSERT(cvarManager->removeChangeListener(longId));
+        CFG_ASSERT(cfg::getMemoryStats(&withListener));
+        CFG_ASSERT(withListener.categories[strings].liveBytes == beforeListener.categories[strings].liveBytes);
+    }
+}
+
+static void testMemoryArena()
+{
+    using Flags = cfg::CVar::Flags;
+    auto cvarManager = cfg::CVarManager::createInstance(0, /* useMemoryArena = */ true);
+    auto cmdManager  = cfg::CommandManager::createInstance(0, cvarManager, /* useMemoryArena = */ true);
+
+    const char * allowed[] { "one", "two", "three", nullptr };
+    const char * enumNames[] { "A", "B", nullptr };
+    const std::int64_t enumValues[] { 1, 2, 0 };
+
+    // Counts the allocations that reach the callbacks.
+    static int allocCount;
+    cfg::MemoryAllocCallbacks countingCallbacks;
+    countingCallbacks.userContext = nullptr;
+    countingCallbacks.alloc   = [](std::size_t sizeInBytes, void *) { ++allocCount; return std::malloc(sizeInBytes); };
+    countingCallbacks.dealloc = [](void * ptrToFree, void *) { std::free(ptrToFree); };
+
+    for (int round = 0; round < 2; ++round)
+    {
+        char name[64];
+        allocCount = 0;
+        cfg::setMemoryAllocCallbacks(&countingCallbacks);
+        for (int i = 0; i < 500; ++i)
+        {
+            std::snprintf(name, sizeof(name), "arena_var_%i", i);
+            CFG_ASSERT(cvarManager->registerCVarInt(name, "arena var description", 0, i, 0, 1000) != nullptr);
+        }
+        cfg::setMemoryAllocCallbacks(nullptr);
+        CFG_ASSERT(allocCount < 100); // Versus 1000+ without the arena.
+
+        cfg::CVar * sVar = cvarManager->registerCVarString("arena_str", "", Flags::RangeCheck, "two", allowed);
+        cfg::CVar * eVar = cvarManager->registerCVarEnum("arena_enum", "", 0, 2, enumValues, enumNames);
+        CFG_ASSERT(sVar->getStringValue() == "two" && !sVar->setStringValue("four"));
+        CFG_ASSERT(eVar->getStringValue() == "B");
+
+        // Removed entries are reused by new ones of the same size.
+        CFG_ASSERT(cvarManager->removeCVar("arena_var_10"));
+        CFG_ASSERT(cvarManager->registerCVarInt("arena_var_10", "arena var description", 0, 10, 0, 1000) != nullptr);
+        CFG_ASSERT(cvarManager->getCVarValueInt("arena_var_499") == 499);
+
+        cmdManager->registerCommand("arena_cmd", [](const cfg::CommandArgs &) { });
+        CFG_ASSERT(cmdManager->createCommandAlias("arena_alias", std::string(600, 'x').c_str(), cfg::CommandExecMode::Append));
+        CFG_ASSERT(cmdManager->removeCommandAlias("arena_alias"));
+        CFG_ASSERT(cmdManager->createCommandAlias("arena_alias", "arena_cmd", cfg::CommandExecMode::Append));
+
+        cmdManager->removeAllCommands();
+        cvarManager->removeAllCVars();
+        CFG_ASSERT(cvarManager->getRegisteredCVarsCount() == 0);
+    }
+
+    cvarManager->registerCVarBool("arena_last", "", 0, true);
+    cfg::CommandManager::destroyInstance(cmdManager);
+    cfg::CVarManager::destroyInstance(cvarManager);
+}
+
+static const char * bulkModes[] { "window", "fullscreen", nullptr };
+static const char * bulkQualityNames[] { "Low", "High", nullptr };
+static const std::int64_t bulkQualityValues[] { 0, 10, 0 };
+
+static constexpr cfg::CVarDesc bulkCVars[]
+{
+    cfg::CVarDesc::makeInt("bulk_int", "an int", cfg::CVar::Flags::RangeCheck, 5, 0, 10),
+    cfg::CVarDesc::makeBool("bulk_bool", nullptr, 0, true),
+    cfg::CVarDesc::makeFloat("bulk_float", "a float", 0, 0.5, 0.0, 1.0),
+    cfg::CVarDesc::makeString("bulk_mode", "", cfg::CVar::Flags::RangeCheck, "window", bulkModes),
+    cfg::CVarDesc::makeEnum("bulk_quality", "an enum", cfg::CVar::Flags::RangeCheck, 10, bulkQualityValues, bulkQualityNames),
+    cfg::CVarDesc::makeInt("bulk_int", "duplicate", 0, 1, 0, 10),
+    cfg::CVarDesc::makeInt("bulk int", "invalid name", 0, 1, 0, 10),
+};
+
+// Hashed at compile time.
+static_assert(bulkCVars[0].name.hash == cfg::HashedName::hashOf("bulk_int", false), "");
+static_assert(cfg::HashedName("ABC").hashNoCase == cfg::HashedName("abc").hash, "");
+
+static void testBulkRegistration(cfg::CVarManager * cvarManager)
+{
+    constexpr int count = sizeof(bulkCVars) / sizeof(bulkCVars[0]);
+    cfg::CVar * cvars[count];
+    CFG_ASSERT(cvarManager->registerCVars(bulkCVars, count, cvars) == count - 2);
+    CFG_ASSERT(cvars[count - 2] == nullptr && cvars[count - 1] == nullptr);
+
+    // Found by the run-time hashes as well.
+    CFG_ASSERT(cvarManager->findCVar("bulk_int") == cvars[0]);
+    CFG_ASSERT(cvars[0]->getIntValue() == 5 && !cvars[0]->setIntValue(11));
+    CFG_ASSERT(cvars[0]->getDescCString() == bulkCVars[0].description); // Referenced, not copied.
+    CFG_ASSERT(cvarManager->getCVarValueBool("bulk_bool") == true);
+    CFG_ASSERT(cvarManager->getCVarValueFloat("bulk_float") == 0.5);
+    CFG_ASSERT(!cvars[3]->setStringValue("borderless") && cvars[3]->setStringValue("fullscreen"));
+    CFG_ASSERT(cvars[4]->getStringValue() == "High" && cvars[4]->setStringValue("Low") && cvars[4]->getIntValue() == 0);
+
+    for (int i = 0; i < count - 2; ++i)
+    {
+        CFG_ASSERT(cvarManager->removeCVar(cvars[i]));
+    }
+}
+
+static void testHashedNameLookups(cfg::CVarManager * cvarManager, cfg::CommandManager * cmdManager)
+{
+    CFG_ASSERT(cvarManager->findCVar(CFG_CVAR("iVar")) == cvarManager->findCVar("iVar"));
+    CFG_ASSERT(cvarManager->findCVar(CFG_CVAR("iVar")) != nullptr);
+    CFG_ASSERT(cvarManager->findCVar(CFG_CVAR("no_such_var")) == nullptr);
+    CFG_ASSERT(cvarManager->findCVar(CFG_CVAR("")) == nullptr);
+
+    CFG_ASSERT(cvarManager->getCVarValueBool(CFG_CVAR("bVar"))    == cvarManager->getCVarValueBool("bVar"));
+    CFG_ASSERT(cvarManager->getCVarValueInt(CFG_CVAR("iVar"))     == cvarManager->getCVarValueInt("iVar"));
+    CFG_ASSERT(cvarManager->getCVarValueFloat(CFG_CVAR("fVar"))   == cvarManager->getCVarValueFloat("fVar"));
+    CFG_ASSERT(cvarManager->getCVarValueString(CFG_CVAR("sVar2")) == cvarManager->getCVarValueString("sVar2"));
+
+    // Command names are case-insensitive by default.
+    CFG_ASSERT(cmdManager->findCommand(CFG_CMD("cmd_1")) == cmdManager->findCommand("cmd_1"));
+    CFG_ASSERT(cmdManager->findCommand(CFG_CMD("cmd_1")) != nullptr);
+    CFG_ASSERT(cmdManager->findCommand(CFG_CMD("CMD_1")) == cmdManager->findCommand("CMD_1"));
+    CFG_ASSERT(cmdManager->findCommand(CFG_CMD("no_such_cmd")) == nullptr);
+
+    // Only ASCII letters are lowered, so hashes match in any locale,
+    // even one where tolower('I') is not 'i'.
+    CFG_ASSERT(cmdManager->registerCommand("fire_cmd", [](const cfg::CommandArgs &) { }));
+    const std::string savedLocale = std::setlocale(LC_CTYPE, nullptr);
+    std::setlocale(LC_CTYPE, "tr_TR.ISO-8859-9");
+    CFG_ASSERT(cmdManager->findCommand(CFG_CMD("FIRE_CMD")) == cmdManager->findCommand("FIRE_CMD"));
+    CFG_ASSERT(cmdManager->findCommand("FIRE_CMD") != nullptr);
+    std::setlocale(LC_CTYPE, savedLocale.c_str());
+    CFG_ASSERT(cmdManager->removeCommand("fire_cmd"));
+}
+
+static void testStringValueAccess(cfg::CVarManager * cvarManager)
+{
+    cfg::CVar * sVar = cvarManager->registerCVarString("str_access", "", 0, "hello", nullptr);
+    cfg::CVar * iVar = cvarManager->registerCVarInt("int_access", "", 0, 42, 0, 100000);
+
+    // Formatted into a caller buffer. Returns the length of the whole string.
+    char buf[8];
+    CFG_ASSERT(iVar->getStringValue(buf, sizeof(buf)) == 2 && std::strcmp(buf, "42") == 0);
+    CFG_ASSERT(sVar->getStringValue(buf, 3) == 5 && std::strcmp(buf, "he") == 0);
+    CFG_ASSERT(iVar->getDefaultValueString(buf, sizeof(buf)) == 2 && std::strcmp(buf, "42") == 0);
+
+    // Set from strings that are not null terminated.
+    CFG_ASSERT(iVar->setStringValue("12345", 3) && iVar->getIntValue() == 123);
+    CFG_ASSERT(sVar->setStringValue("world!", 5) && sVar->getStringValue() == "world");
+
+    // Only string vars can be viewed in place.
+    const char * view = nullptr;
+    int viewLength = 0;
+    CFG_ASSERT(sVar->getStringValueView(&view, &viewLength) && viewLength == 5 && std::strncmp(view, "world", 5) == 0);
+    CFG_ASSERT(!iVar->getStringValueView(&view, &viewLength));
+
+    // Short values are stored inline and never reach the allocator.
+    static int allocCount;
+    cfg::MemoryAllocCallbacks countingCallbacks;
+    countingCallbacks.userContext = nullptr;
+    countingCallbacks.alloc   = [](std::size_t sizeInBytes, void *) { ++allocCount; return std::malloc(sizeInBytes); };
+    countingCallbacks.dealloc = [](void * ptrToFree, void *) { std::free(ptrToFree); };
+
+    allocCount = 0;
+    cfg::setMemoryAllocCallbacks(&countingCallbacks);
+    for (int i = 0; i < 100; ++i)
+    {
+        const int length = std::snprintf(buf, sizeof(buf), "v%d", i);
+        CFG_ASSERT(sVar->setStringValue(buf, length) && iVar->setStringValue(buf + 1, length - 1));
+        CFG_ASSERT(sVar->getStringValue(buf, sizeof(buf)) == length && iVar->getIntValue() == i);
+    }
+    cfg::setMemoryAllocCallbacks(nullptr);
+    CFG_ASSERT(allocCount == 0);
+
+    // Long values still work, from the heap.
+    const std::string longValue(200, 'x');
+    CFG_ASSERT(sVar->setStringValue(longValue) && sVar->getStringValue() == longValue);
+    CFG_ASSERT(sVar->getStringValue(buf, sizeof(buf)) == 200 && std::strcmp(buf, "xxxxxxx") == 0);
+    CFG_ASSERT(sVar->compareEqual(*sVar) && !sVar->compareEqual(*iVar));
+
+    CFG_ASSERT(cvarManager->removeCVar(sVar));
+    CFG_ASSERT(cvarManager->removeCVar(iVar));
+}
+
+static void testNumberConversions(cfg::CVarManager * cvarManager)
+{
+    std::int64_t i64;
+    double dbl;
+    char buf[64];
+
+    // Same syntax as strtoll(str, nullptr, 0) and strtod(), but only up to 'length' chars.
+    CFG_ASSERT(cfg::parseInt64("  0x1F rest", 11, &i64) == 6 && i64 == 31);
+    CFG_ASSERT(cfg::parseInt64("017", 3, &i64) == 3 && i64 == 15);
+    CFG_ASSERT(cfg::parseInt64("12345", 3, &i64) == 3 && i64 == 123);
+    CFG_ASSERT(cfg::parseInt64("99999999999999999999", 20, &i64) == 20 && i64 == INT64_MAX);
+    CFG_ASSERT(cfg::parseInt64("abc", 3, &i64) == 0 && i64 == 0);
+    CFG_ASSERT(cfg::parseDouble("-2.5e3x", 7, &dbl) == 6 && dbl == -2500.0);
+    CFG_ASSERT(cfg::parseDouble("0.1", 3, &dbl) == 3 && dbl == 0.1);
+    CFG_ASSERT(cfg::parseDouble("1e", 2, &dbl) == 1 && dbl == 1.0);
+    CFG_ASSERT(cfg::parseDouble(".", 1, &dbl) == 0 && dbl == 0.0);
+
+    CFG_ASSERT(cfg::formatInt64(INT64_MIN, buf, sizeof(buf)) == 20 && std::strcmp(buf, "-9223372036854775808") == 0);
+    CFG_ASSERT(cfg::formatDouble(0.1, buf, sizeof(buf)) == 3 && std::strcmp(buf, "0.1") == 0);
+    CFG_ASSERT(cfg::formatDouble(1e100, buf, sizeof(buf)) == 6 && std::strcmp(buf, "1e+100") == 0);
+    CFG_ASSERT(cfg::formatDouble(-0.000125, buf, sizeof(buf)) == 9 && std::strcmp(buf, "-0.000125") == 0);
+    CFG_ASSERT(cfg::formatDouble(1234.5, buf, 3) == 6 && std::strcmp(buf, "12") == 0);
+
+    // Shortest round-trip output, so no precision is lost when saving.
+    const double values[] { 1.0 / 3.0, 0.1 + 0.2, 1e-300, 123456789.123, 5e-324 };
+    for (const double value : values)
+    {
+        const int length = cfg::formatDouble(value, buf, sizeof(buf));
+        CFG_ASSERT(cfg::parseDouble(buf, length, &dbl) == length && dbl == value);
+    }
+
+    cfg::CVar * fVar = cvarManager->registerCVarFloat("float_round_trip", "", 0, 0.0, -1.0, 1.0);
+    CFG_ASSERT(fVar->setFloatValue(0.1 + 0.2) && fVar->getStringValue() == "0.30000000000000004");
+    CFG_ASSERT(fVar->setStringValue(fVar->getStringValue()) && fVar->getFloatValue() == 0.1 + 0.2);
+    CFG_ASSERT(cvarManager->removeCVar(fVar));
+}
+
+#if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+static void testAliasTemplates(cfg::CVarManager * cvarManager, cfg::CommandManager * cmdManager)
+{
+    static std::string execLog;
+    static cfg::CommandManager * aliasManager = cmdManager;
+    static cfg::CVarManager * waveVarManager = cvarManager;
+    cmdManager->registerCommand("tmpl_log", [](const cfg::CommandArgs & args)
+    {
+        for (auto arg : args)
+        {
+            execLog += arg;
+            execLog += ',';
+        }
+    });
+    cmdManager->registerCommand("tmpl_unalias", [](const cfg::CommandArgs & args) { aliasManager->removeCommandAlias(args[0]); });
+    cmdManager->registerCommand("tmpl_set_count", [](const cfg::CommandArgs & args) { waveVarManager->setCVarValueString("wave_count", args[0], 0); });
+
+    cvarManager->registerCVarString("wave_type", "", 0, "grunt", nullptr);
+    cvarManager->registerCVarInt("wave_count", "", 0, 3, 0, 100);
+    cvarManager->registerCVarString("wave_var", "", 0, "wave_count", nullptr);
+
+    // Immediate aliases expand straight from the precompiled template.
+    CFG_ASSERT(cmdManager->createCommandAlias("spawn_wave", "tmpl_log $(wave_type) $( wave_count ); tmpl_log x$(wave_count)x",
+                                              cfg::CommandExecMode::Immediate));
+    cmdManager->execNow("spawn_wave");
+    CFG_ASSERT(execLog == "grunt,3,x3x,");
+
+    // Values are read each time and removed vars are looked up again.
+    // An undefined var discards the rest of the alias, like with execNow().
+    execLog.clear();
+    cvarManager->setCVarValueInt("wave_count", 12, 0);
+    CFG_ASSERT(cvarManager->removeCVar("wave_type"));
+    cmdManager->execNow("spawn_wave");
+    CFG_ASSERT(execLog.empty());
+    execLog.clear();
+    cvarManager->registerCVarString("wave_type", "", 0, "boss", nullptr);
+    cmdManager->execNow("spawn_wave");
+    CFG_ASSERT(execLog == "boss,12,x12x,");
+
+    // Buffered aliases expand when each command runs, not when the alias does.
+    execLog.clear();
+    CFG_ASSERT(cmdManager->createCommandAlias("spawn_wave_later", "tmpl_log $(wave_count)", cfg::CommandExecMode::Append));
+    cmdManager->execAppend("spawn_wave_later; tmpl_set_count 7");
+    CFG_ASSERT(cmdManager->execBufferedCommands() == 3);
+    CFG_ASSERT(execLog == "7,");
+
+    // Reentrant expansions are not precompiled, but still work.
+    execLog.clear();
+    CFG_ASSERT(cmdManager->createCommandAlias("spawn_wave_nested", "tmpl_log $($(wave_var))", cfg::CommandExecMode::Insert));
+    cmdManager->execAppend("spawn_wave_nested");
+    CFG_ASSERT(cmdManager->execBufferedCommands() == 2);
+    CFG_ASSERT(execLog == "7,");
+
+    // Aliases can be removed while running or with commands still in the buffer.
+    execLog.clear();
+    CFG_ASSERT(cmdManager->createCommandAlias("spawn_wave_once", "tmpl_unalias spawn_wave_once; tmpl_log $(wave_count)",
+                                              cfg::CommandExecMode::Immediate));
+    cmdManager->execNow("spawn_wave_once");
+    CFG_ASSERT(cmdManager->findCommand("spawn_wave_once") == nullptr);
+    cmdManager->execAppend("spawn_wave_later; tmpl_unalias spawn_wave_later");
+    CFG_ASSERT(cmdManager->execBufferedCommands() == 3);
+    CFG_ASSERT(execLog == "7,7,");
+
+    CFG_ASSERT(cmdManager->removeCommandAlias("spawn_wave"));
+    CFG_ASSERT(cmdManager->removeCommandAlias("spawn_wave_nested"));
+    CFG_ASSERT(cmdManager->removeCommand("tmpl_log"));
+    CFG_ASSERT(cmdManager->removeCommand("tmpl_unalias"));
+    CFG_ASSERT(cmdManager->removeCommand("tmpl_set_count"));
+    CFG_ASSERT(cvarManager->removeCVar("wave_type"));
+    CFG_ASSERT(cvarManager->removeCVar("wave_count"));
+    CFG_ASSERT(cvarManager->removeCVar("wave_var"));
+}
+
+#endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+static void testSubmitCommandText(cfg::CommandManager * cmdManager)
+{
+    // Counts the runs of 'submit_cmd' from each thread, which must arrive in order.
+    static int nextSeq[4];
+    static bool inOrder;
+    inOrder = true;
+    cmdManager->registerCommand("submit_cmd", [](const cfg::CommandArgs & args)
+    {
+        const int thread = std::atoi(args[0]);
+        inOrder = inOrder && (std::atoi(args[1]) == nextSeq[thread]++);
+    });
+
+    // Goes after the text already buffered.
+    cmdManager->execAppend("submit_cmd 0 0");
+    CFG_ASSERT(cmdManager->submitCommandText("submit_cmd 0 1; submit_cmd 0 2"));
+    CFG_ASSERT(cmdManager->hasBufferedCommands());
+    CFG_ASSERT(cmdManager->execBufferedCommands() == 3);
+    CFG_ASSERT(inOrder && nextSeq[0] == 3);
+
+    // Rejected when full, never blocking.
+    const std::string longCmd = "submit_cmd 0 3 " + std::string(1000, 'x');
+    int submitted = 0;
+    while (cmdManager->submitCommandText(longCmd.c_str()))
+    {
+        ++submitted;
+    }
+    CFG_ASSERT(submitted > 0 && submitted < 1000);
+    CFG_ASSERT(cmdManager->execBufferedCommands(1) == 1);
+    CFG_ASSERT(cmdManager->execBufferedCommands() == submitted - 1);
+    CFG_ASSERT(!cmdManager->hasBufferedCommands());
+
+    // Many producer threads while the owner drains, wrapping around the queue a few times.
+    constexpr int ThreadCount = 4;
+    constexpr int CmdsPerThread = 2000;
+    std::memset(nextSeq, 0, sizeof(nextSeq));
+    inOrder = true;
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < ThreadCount; ++t)
+    {
+        producers.emplace_back([cmdManager, t]()
+        {
+            char cmd[64];
+            for (int i = 0; i < CmdsPerThread; ++i)
+            {
+                std::snprintf(cmd, sizeof(cmd), "submit_cmd %i %i", t, i);
+                while (!cmdManager->submitCommandText(cmd))
+                {
+                    std::this_thread::yield(); // Full. Wait for the owner to drain it.
+                }
+            }
+        });
+    }
+
+    int executed = 0;
+    while (executed < ThreadCount * CmdsPerThread)
+    {
+        executed += cmdManager->execBufferedCommands();
+    }
+    for (std::thread & producer : producers)
+    {
+        producer.join();
+    }
+
+    CFG_ASSERT(inOrder);
+    for (int t = 0; t < ThreadCount; ++t)
+    {
+        CFG_ASSERT(nextSeq[t] == CmdsPerThread);
+    }
+    CFG_ASSERT(!cmdManager->hasBufferedCommands());
+    CFG_ASSERT(cmdManager->removeCommand("submit_cmd"));
+}
+
+static void testExecTimeBudget(cfg::CommandManager * cmdManager)
+{
+    static std::string execLog;
+    execLog.clear();
+
+    // 'budget_busy' takes about 2 milliseconds. 'budget_slow' is fast, but claims to take a second.
+    cmdManager->registerCommand("budget_fast", [](const cfg::CommandArgs &) { execLog += 'f'; });
+    cmdManager->registerCommand("budget_busy", [](const cfg::CommandArgs &)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        while ((std::chrono::steady_clock::now() - start) < std::chrono::milliseconds(2)) { }
+        execLog += 'b';
+    });
+    cmdManager->registerCommand("budget_slow", [](const cfg::CommandArgs &) { execLog += 's'; },
+                                nullptr, "", 0, -1, -1, 1000000);
+    CFG_ASSERT(cmdManager->findCommand("budget_slow")->getCostHintMicros() == 1000000);
+
+    std::uint32_t timeUsed = 0;
+    int commandsLeft = -1;
+
+    // The first command always runs, even with no budget.
+    cmdManager->execAppend("budget_fast; budget_fast; budget_fast");
+    CFG_ASSERT(cmdManager->execBufferedCommandsForTime(0, &timeUsed, &commandsLeft) == 1);
+    CFG_ASSERT(commandsLeft == 2 && execLog == "f");
+    CFG_ASSERT(cmdManager->execBufferedCommandsForTime(1000000, &timeUsed, &commandsLeft) == 2);
+    CFG_ASSERT(commandsLeft == 0 && execLog == "fff");
+
+    // Stops once the budget is spent.
+    execLog.clear();
+    cmdManager->execAppend("budget_busy; budget_fast");
+    CFG_ASSERT(cmdManager->execBufferedCommandsForTime(1000, &timeUsed, &commandsLeft) == 1);
+    CFG_ASSERT(timeUsed >= 2000 && commandsLeft == 1 && execLog == "b");
+    cmdManager->execBufferedCommands();
+
+    // Known-expensive commands wait for the next call, where they go first.
+    execLog.clear();
+    cmdManager->execAppend("budget_fast; budget_slow; budget_fast");
+    CFG_ASSERT(cmdManager->execBufferedCommandsForTime(10000, &timeUsed, &commandsLeft) == 1);
+    CFG_ASSERT(commandsLeft == 2 && execLog == "f");
+    CFG_ASSERT(cmdManager->execBufferedCommandsForTime(10000, nullptr, &commandsLeft) == 2);
+    CFG_ASSERT(commandsLeft == 0 && execLog == "fsf");
+
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    // Commands left for the next call are not parsed before that,
+    // so the error of the undefined var is only reported once.
+    int errorCount = 0;
+    cfg::setErrorCallback([](const char * message, void * userContext)
+                          {
+                              if (std::strstr(message, "budget_undefined") != nullptr)
+                              {
+                                  ++(*static_cast<int *>(userContext));
+                              }
+                          }, &errorCount);
+    execLog.clear();
+    cmdManager->execAppend("budget_busy; budget_fast $(budget_undefined)");
+    CFG_ASSERT(cmdManager->execBufferedCommandsForTime(1000, nullptr, &commandsLeft) == 1);
+    CFG_ASSERT(commandsLeft == 1 && execLog == "b" && errorCount == 0);
+    cmdManager->execBufferedCommands();
+    CFG_ASSERT(errorCount == 1);
+    cfg::setErrorCallback(nullptr, nullptr);
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+
+    CFG_ASSERT(cmdManager->removeCommand("budget_fast"));
+    CFG_ASSERT(cmdManager->removeCommand("budget_busy"));
+    CFG_ASSERT(cmdManager->removeCommand("budget_slow"));
+}
+
+static void testCommandProfiling(cfg::CommandManager * cmdManager)
+{
+    cmdManager->registerCommand("prof_cmd", [](const cfg::CommandArgs &) { });
+    CFG_ASSERT(cmdManager->createCommandAlias("prof_alias", "prof_cmd; prof_cmd", cfg::CommandExecMode::Immediate));
+
+    cfg::CommandProfile profiles[8];
+    CFG_ASSERT(!cmdManager->isProfilingEnabled());
+    cmdManager->execNow("prof_cmd");
+    CFG_ASSERT(cmdManager->getCommandProfiles(profiles, 8) == 0);
+
+    cmdManager->setProfilingEnabled(true);
+    cmdManager->execNow("prof_cmd; prof_alias; prof_missing");
+    cmdManager->execAppend("prof_cmd");
+    cmdManager->execBufferedCommands();
+    cmdManager->setProfilingEnabled(false);
+    cmdManager->execNow("prof_cmd");
+
+    CFG_ASSERT(cmdManager->getCommandProfiles(profiles, 8) == 2);
+    const int cmdIndex = (profiles[0].command == cmdManager->findCommand("prof_cmd")) ? 0 : 1;
+    const cfg::CommandProfile & cmdProfile   = profiles[cmdIndex];
+    const cfg::CommandProfile & aliasProfile = profiles[cmdIndex ^ 1];
+
+    CFG_ASSERT(cmdProfile.callCount == 4 && aliasProfile.callCount == 1);
+    CFG_ASSERT(cmdProfile.minTime <= cmdProfile.maxTime && cmdProfile.maxTime <= cmdProfile.totalTime);
+    CFG_ASSERT(aliasProfile.command->isAlias());
+
+    std::uint64_t histogramTotal = 0;
+    for (const std::uint32_t count : cmdProfile.histogram)
+    {
+        histogramTotal += count;
+    }
+    CFG_ASSERT(histogramTotal == 4);
+
+    const cfg::CommandExecProfile execProfile = cmdManager->getExecProfile();
+    CFG_ASSERT(execProfile.commandsRun == 5 && execProfile.lookupMisses == 1);
+    CFG_ASSERT(execProfile.parseTime > 0 && execProfile.tokenizeTime > 0 && execProfile.lookupTime > 0);
+
+    cmdManager->resetProfilingStats();
+    CFG_ASSERT(cmdManager->getCommandProfiles(profiles, 8) == 0);
+    CFG_ASSERT(cmdManager->getExecProfile().commandsRun == 0);
+
+    CFG_ASSERT(cmdManager->removeCommandAlias("prof_alias"));
+    CFG_ASSERT(cmdManager->removeCommand("prof_cmd"));
+}
+
+static void testTerminalOutputBatching()
+{
+    class BatchingTerminal final
+        : public cfg::SimpleCommandTerminal
+    {
+    public:
+        std::string written;
+        int writeCount = 0;
+
+        void print(const char * text) override
+        {
+            bufferOutput(text, static_cast<int>(std::strlen(text)));
+        }
+        void printLn(const char * text) override
+        {
+            print(text);
+            print("\n");
+        }
+        void writeOutput(const char * text, const int length) override
+        {
+            written.append(text, length);
+            ++writeCount;
+        }
+    };
+
+    const char * const red   = "\033[31m";
+    const char * const green = "\033[32m";
+
+    BatchingTerminal term;
+    term.setOutputBufferSize(64);
+    CFG_ASSERT(term.getOutputBufferSize() == 64);
+
+    // Nothing is written until a flush. Color switches without text in between are dropped.
+    term.print("abc");
+    term.printF("%i-%s", 42, "x");
+    term.setTextColor(red);
+    term.setTextColor(green);
+    term.print("G");
+    term.setTextColor(green);
+    term.printF("%s", "g");
+    CFG_ASSERT(term.writeCount == 0);
+    term.flushOutput();
+    CFG_ASSERT(term.writeCount == 1);
+    CFG_ASSERT(term.written == std::string("abc42-x") + green + "Gg");
+
+    // Filling the buffer flushes it. Text larger than the buffer is written directly.
+    const std::string bigText(100, '#');
+    term.print("def");
+    term.print(bigText.c_str());
+    CFG_ASSERT(term.writeCount == 3);
+    CFG_ASSERT(term.written.compare(term.written.size() - 103, 103, "def" + bigText) == 0);
+
+    // update() flushes after printing the new line marker.
+    term.printLn("z");
+    term.update();
+    CFG_ASSERT(term.writeCount == 4);
+    CFG_ASSERT(term.written.compare(term.written.size() - 4, 4, "z\n> ") == 0);
+
+    // A color restore with no text after it still goes out with the flush.
+    const std::string coloredText = std::string(red) + "r" + cfg::color::restore();
+    term.setTextColor(red);
+    term.print("r");
+    term.restoreTextColor();
+    term.flushOutput();
+    CFG_ASSERT(term.writeCount == 5);
+    CFG_ASSERT(term.written.compare(term.written.size() - coloredText.size(), coloredText.size(), coloredText) == 0);
+
+    // Without a buffer every print is written immediately.
+    term.setOutputBufferSize(0);
+    term.print("w");
+    CFG_ASSERT(term.writeCount == 6 && term.written.back() == 'w');
+}
+
+static cfg::CVarManager * g_snapshotCVarManager = nullptr;
+static std::int64_t         g_snapshotValueInBatch = -1;
+
+static void testCVarSnapshots(cfg::CVarManager * cvarManager, cfg::CommandManager * cmdManager)
+{
+    CFG_ASSERT(!cvarManager->isCVarSnapshotsEnabled());
+    CFG_ASSERT(!cvarManager->acquireCVarSnapshot().isValid());
+
+    cfg::CVar * snapA = cvarManager->registerCVarInt("snap_a", "", 0, 1, 0, 0);
+    cfg::CVar * snapB = cvarManager->registerCVarString("snap_b", "", 0, "yes", nullptr);
+    cfg::CVar * snapX = cvarManager->registerCVarInt("snap_x", "", 0, 0, 0, 0);
+    cfg::CVar * snapY = cvarManager->registerCVarInt("snap_y", "", 0, 0, 0, 0);
+    CFG_ASSERT(snapA != nullptr && snapB != nullptr && snapX != nullptr && snapY != nullptr);
+
+    cvarManager->setCVarSnapshotsEnabled(true);
+    cfg::CVarSnapshotRef first = cvarManager->acquireCVarSnapshot();
+    CFG_ASSERT(first.isValid());
+    CFG_ASSERT(first->getCVarCount() == cvarManager->getRegisteredCVarsCount());
+    CFG_ASSERT(first->getInt("snap_a") == 1 && first->getFloat(CFG_CVAR("snap_a")) == 1.0);
+    CFG_ASSERT(std::strcmp(first->getString("snap_b"), "yes") == 0 && first->getBool(CFG_CVAR("snap_b")));
+    CFG_ASSERT(!first->hasCVar("snap_missing") && first->getInt("snap_missing", 42) == 42);
+    const std::uint64_t firstVersion = first->getVersion();
+
+    // The held version doesn't change, the next one has the new value.
+    CFG_ASSERT(snapA->setIntValue(2));
+    CFG_ASSERT(first->getInt("snap_a") == 1);
+    CFG_ASSERT(cvarManager->publishCVarSnapshot());
+    CFG_ASSERT(!cvarManager->publishCVarSnapshot());
+    CFG_ASSERT(first->getInt("snap_a") == 1);
+    {
+        cfg::CVarSnapshotRef second = cvarManager->acquireCVarSnapshot();
+        CFG_ASSERT(second->getVersion() == firstVersion + 1 && second->getInt("snap_a") == 2);
+    }
+    first.reset();
+    CFG_ASSERT(!first.isValid());
+
+    // Commands see the version published before the batch until it ends.
+    g_snapshotCVarManager = cvarManager;
+    cmdManager->registerCommand("snap_set",
+            [](const cfg::CommandArgs &) { g_snapshotCVarManager->setCVarValueInt("snap_a", 5, 0); });
+    cmdManager->registerCommand("snap_check",
+            [](const cfg::CommandArgs &)
+            {
+                g_snapshotValueInBatch = g_snapshotCVarManager->acquireCVarSnapshot()->getInt("snap_a");
+            });
+    cmdManager->execAppend("snap_set; snap_check");
+    cmdManager->execBufferedCommands();
+    CFG_ASSERT(snapA->getIntValue() == 5 && g_snapshotValueInBatch == 2);
+    CFG_ASSERT(cvarManager->acquireCVarSnapshot()->getInt("snap_a") == 5);
+
+    // Reader threads always see both vars of a pair updated together.
+    // Old versions are freed while they keep acquiring, so the memory
+    // doesn't grow with the versions published.
+    const int cvars = static_cast<int>(cfg::MemoryCategory::CVars);
+    cfg::MemoryStats early, late;
+    bool hasMemoryStats = false;
+    std::atomic<bool> stopReaders{ false };
+    std::atomic<int>  tornReads{ 0 };
+    std::thread readers[4];
+    for (std::thread & reader : readers)
+    {
+        reader = std::thread([cvarManager, &stopReaders, &tornReads]()
+        {
+            while (!stopReaders.load())
+            {
+                cfg::CVarSnapshotRef snapshot = cvarManager->acquireCVarSnapshot();
+                if (snapshot->getInt(CFG_CVAR("snap_x")) != snapshot->getInt(CFG_CVAR("snap_y")))
+                {
+                    ++tornReads;
+                }
+            }
+        });
+    }
+    for (int i = 1; i <= 2000; ++i)
+    {
+        snapX->setIntValue(i);
+        snapY->setIntValue(i);
+        cvarManager->publishCVarSnapshot();
+        if (i == 100)
+        {
+            hasMemoryStats = cfg::getMemoryStats(&early);
+        }
+    }
+    CFG_ASSERT(cfg::getMemoryStats(&late) == hasMemoryStats);
+    stopReaders = true;
+    for (std::thread & reader : readers)
+    {
+        reader.join();
+    }
+    CFG_ASSERT(tornReads == 0);
+    CFG_ASSERT(!hasMemoryStats || late.categories[cvars].liveBytes < early.categories[cvars].liveBytes * 2);
+
+    // New versions only encode the changed vars again. Check them against the live values
+    // through enough changes, removals and registrations for a few full rebuilds.
+    cfg::CVar * snapZ = nullptr;
+    for (int i = 0; i < 300; ++i)
+    {
+        char value[32];
+        std::snprintf(value, sizeof(value), "value_%i", i);
+        CFG_ASSERT(snapB->setStringValue(value));
+        if (i % 3 == 0)
+        {
+            CFG_ASSERT(snapZ == nullptr || cvarManager->removeCVar(snapZ));
+            snapZ = cvarManager->registerCVarInt("snap_z", "", 0, i, 0, 0);
+        }
+        if (i % 7 == 0)
+        {
+            CFG_ASSERT(cvarManager->removeCVar(snapZ));
+            snapZ = nullptr;
+        }
+        if (i % 2 == 0)
+        {
+            snapY->setIntValue(i);
+        }
+        cvarManager->publishCVarSnapshot();
+
+        cfg::CVarSnapshotRef snapshot = cvarManager->acquireCVarSnapshot();
+        CFG_ASSERT(snapshot->getCVarCount() == cvarManager->getRegisteredCVarsCount());
+        CFG_ASSERT(std::strcmp(snapshot->getString("snap_b"), value) == 0);
+        CFG_ASSERT(snapshot->getInt("snap_y") == snapY->getIntValue());
+        CFG_ASSERT(snapshot->getInt("snap_a") == 5 && snapshot->getInt("snap_x") == 2000);
+        CFG_ASSERT(snapshot->hasCVar("snap_z") == (snapZ != nullptr));
+        CFG_ASSERT(snapZ == nullptr || snapshot->getInt("snap_z") == snapZ->getIntValue());
+    }
+    CFG_ASSERT(snapZ == nullptr || cvarManager->removeCVar(snapZ));
+
+    // Removing a var also publishes a new version.
+    CFG_ASSERT(cmdManager->removeCommand("snap_set") && cmdManager->removeCommand("snap_check"));
+    CFG_ASSERT(cvarManager->removeCVar("snap_x"));
+    CFG_ASSERT(cvarManager->publishCVarSnapshot());
+    CFG_ASSERT(!cvarManager->acquireCVarSnapshot()->hasCVar("snap_x"));
+
+    cvarManager->setCVarSnapshotsEnabled(false);
+    CFG_ASSERT(!cvarManager->acquireCVarSnapshot().isValid());
+    CFG_ASSERT(cvarManager->removeCVar("snap_a") && cvarManager->removeCVar("snap_b") && cvarManager->removeCVar("snap_y"));
+}
+
+#if CFG_THREAD_SAFE_CVARS
+static void testThreadSafeCVars(cfg::CVarManager * cvarManager)
+{
+    // Every value written can be told apart from a mix of two of them:
+    // ints repeat the same 32 bits twice, floats are multiples of 1.1 and
+    // strings repeat a letter a number of times that depends on the letter.
+    auto makeString = [](const int k) { return std::string(8 + (k % 26) * 3, static_cast<char>('a' + k % 26)); };
+
+    cfg::CVar * iVar = cvarManager->registerCVarInt("ts_int", "", 0, 0, 0, 0);
+    cfg::CVar * fVar = cvarManager->registerCVarFloat("ts_float", "", 0, 0.0, 0.0, 0.0);
+    cfg::CVar * sVar = cvarManager->registerCVarString("ts_string", "", 0, makeString(0), nullptr);
+    CFG_ASSERT(iVar != nullptr && fVar != nullptr && sVar != nullptr);
+
+    const cfg::CVarRefInt    iRef{ iVar };
+    const cfg::CVarRefFloat  fRef{ fVar };
+    const cfg::CVarRefString sRef{ sVar };
+
+    std::atomic<bool> stopReaders{ false };
+    std::atomic<int>  tornReads{ 0 };
+    std::atomic<int>  readCount{ 0 };
+    std::thread readers[4];
+    for (std::thread & reader : readers)
+    {
+        reader = std::thread([&]()
+        {
+            for (int n = 0; !stopReaders.load(); ++n)
+            {
+                const std::int64_t i = iRef.get();
+                const double f = fRef.get();
+                const std::string s = (n & 1) ? sRef.get() : sVar->getStringValue();
+
+                const bool intOk    = ((i >> 32) == (i & 0xFFFFFFFF));
+                const bool floatOk  = (static_cast<double>(std::llround(f / 1.1)) * 1.1 == f);
+                const bool stringOk = (!s.empty() && s.find_first_not_of(s[0]) == std::string::npos &&
+                                       s.size() == static_cast<std::size_t>(8 + (s[0] - 'a') * 3));
+                if (!intOk || !floatOk || !stringOk)
+                {
+                    ++tornReads;
+                }
+                ++readCount;
+            }
+        });
+    }
+
+    // The owner thread writes while the readers hammer the values.
+    for (int k = 1; k <= 20000; ++k)
+    {
+        CFG_ASSERT(iVar->setIntValue((static_cast<std::int64_t>(k) << 32) | k));
+        CFG_ASSERT(fVar->setFloatValue(k * 1.1));
+        CFG_ASSERT(sVar->setStringValue(makeString(k)));
+    }
+    while (readCount.load() < 1000)
+    {
+        std::this_thread::yield();
+    }
+
+    stopReaders = true;
+    for (std::thread & reader : readers)
+    {
+        reader.join();
+    }
+    CFG_ASSERT(tornReads == 0);
+    CFG_ASSERT(iRef.get() == ((20000ll << 32) | 20000) && sRef.get() == makeString(20000));
+
+    CFG_ASSERT(cvarManager->removeCVar(iVar) && cvarManager->removeCVar(fVar) && cvarManager->removeCVar(sVar));
+}
+#endif // CFG_THREAD_SAFE_CVARS
+
+static void testFlagIndexes(cfg::CVarManager * cvarManager, cfg::CommandManager * cmdManager)
+{
+    constexpr std::uint32_t UserFlag = 1u << 20;
+
+    cfg::CVar * flagA = cvarManager->registerCVarInt("flag_a", "", cfg::CVar::Flags::Persistent, 0, 0, 0);
+    cfg::CVar * flagB = cvarManager->registerCVarInt("flag_b", "", UserFlag, 0, 0, 0);
+    CFG_ASSERT(flagA != nullptr && flagB != nullptr);
+
+    cfg::CVar * matches[4];
+    CFG_ASSERT(cvarManager->findCVarsWithFlags(UserFlag, matches, 4) == 1 && matches[0] == flagB);
+
+    // Vars with more than one of the flags are only reported once.
+    flagB->setFlags(UserFlag | cfg::CVar::Flags::Persistent);
+    CFG_ASSERT(cvarManager->findCVarsWithFlags(UserFlag | cfg::CVar::Flags::Persistent, matches, 4) ==
+               cvarManager->findCVarsWithFlags(cfg::CVar::Flags::Persistent, matches, 4));
+    flagB->setFlags(0);
+    CFG_ASSERT(cvarManager->findCVarsWithFlags(UserFlag, matches, 4) == 0);
+
+    // Clearing the modified flag in the callback, like saveConfig does.
+    cvarManager->enumerateCVarsWithFlags(cfg::CVar::Flags::Modified,
+            [](cfg::CVar * cvar, void *) { cvar->clearModified(); return true; }, nullptr);
+    CFG_ASSERT(flagA->setIntValue(1) && flagB->setIntValue(2));
+    CFG_ASSERT(cvarManager->enumerateCVarsWithFlags(cfg::CVar::Flags::Modified,
+            [](cfg::CVar * cvar, void *) { cvar->clearModified(); return true; }, nullptr) == 2);
+    CFG_ASSERT(!flagA->isModified() && !flagB->isModified());
+    CFG_ASSERT(cvarManager->findCVarsWithFlags(cfg::CVar::Flags::Modified, matches, 4) == 0);
+    CFG_ASSERT(flagB->setIntValue(3));
+    CFG_ASSERT(cvarManager->findCVarsWithFlags(cfg::CVar::Flags::Modified, matches, 4) == 1 && matches[0] == flagB);
+
+    CFG_ASSERT(cvarManager->removeCVar(flagA) && cvarManager->removeCVar(flagB));
+    CFG_ASSERT(cvarManager->findCVarsWithFlags(cfg::CVar::Flags::Modified, matches, 4) == 0);
+
+    // The callback can remove the visited var or others not visited yet.
+    // Every var still registered when reached is visited exactly once.
+    static cfg::CVarManager * walkManager;
+    static std::vector<std::string> walkVisited;
+    walkManager = cvarManager;
+    walkVisited.clear();
+    char walkName[32];
+    for (int i = 0; i < 8; ++i)
+    {
+        std::snprintf(walkName, sizeof(walkName), "walk_%i", i);
+        CFG_ASSERT(cvarManager->registerCVarInt(walkName, "", UserFlag, i, 0, 8) != nullptr);
+    }
+    const int walked = cvarManager->enumerateCVarsWithFlags(UserFlag,
+            [](cfg::CVar * cvar, void *)
+            {
+                walkVisited.push_back(cvar->getName());
+                if (walkVisited.size() == 1)
+                {
+                    // Remove two others, wherever they are in the index.
+                    for (const char * other : { "walk_0", "walk_3", "walk_7" })
+                    {
+                        if (cvar->getName() != other && walkVisited.size() < 3)
+                        {
+                            CFG_ASSERT(walkManager->removeCVar(other));
+                            walkVisited.push_back(std::string("-") + other);
+                        }
+                    }
+                }
+                CFG_ASSERT(walkManager->removeCVar(cvar));
+                return true;
+            }, nullptr);
+    CFG_ASSERT(walked == 6 && walkVisited.size() == 8);
+    for (std::size_t i = 0; i < walkVisited.size(); ++i)
+    {
+        for (std::size_t j = i + 1; j < walkVisited.size(); ++j)
+        {
+            CFG_ASSERT(walkVisited[i] != walkVisited[j]);
+        }
+    }
+    CFG_ASSERT(cvarManager->findCVarsWithFlags(UserFlag, matches, 4) == 0);
+
+    // Commands are indexed the same way.
+    CFG_ASSERT(cmdManager->registerCommand("flag_cmd", [](const cfg::CommandArgs &) { }, nullptr, "", UserFlag));
+    cfg::Command * cmdMatches[4];
+    CFG_ASSERT(cmdManager->findCommandsWithFlags(UserFlag, cmdMatches, 4) == 1);
+    cmdMatches[0]->setFlags(0);
+    CFG_ASSERT(cmdManager->findCommandsWithFlags(UserFlag, cmdMatches, 4) == 0);
+    cmdManager->findCommand("flag_cmd")->setFlags(UserFlag);
+    CFG_ASSERT(cmdManager->enumerateCommandsWithFlags(UserFlag,
+            [](cfg::Command *, void *) { return true; }, nullptr) == 1);
+    CFG_ASSERT(cmdManager->removeCommand("flag_cmd"));
+    CFG_ASSERT(cmdManager->findCommandsWithFlags(UserFlag, cmdMatches, 4) == 0);
+}
+
+static void testLargeValueLists(cfg::CVarManager * cvarManager)
+{
+    constexpr int count = 2000;
+    std::vector<std::string> nameStrings;
+    std::vector<const char *> names;
+    std::vector<std::int64_t> values;
+    for (int i = 0; i < count; ++i)
+    {
+        nameStrings.push_back("asset_" + std::to_string(count - i));
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        names.push_back(nameStrings[i].c_str());
+        values.push_back((count - i) * 10);
+    }
+    names.push_back(nullptr);
+
+    cfg::CVar * eVar = cvarManager->registerCVarEnum("large_enum", "", cfg::CVar::Flags::RangeCheck,
+                                                     10, values.data(), names.data());
+    cfg::CVar * sVar = cvarManager->registerCVarString("large_str", "", cfg::CVar::Flags::RangeCheck,
+                                                       "asset_1", names.data());
+    CFG_ASSERT(eVar != nullptr && sVar != nullptr);
+    CFG_ASSERT(eVar->getStringValue() == "asset_1" && eVar->getAllowedValueCount() == count);
+
+    // Name to value and value to name.
+    CFG_ASSERT(eVar->setStringValue("asset_1234") && eVar->getIntValue() == 12340);
+    CFG_ASSERT(eVar->setIntValue(570) && eVar->getStringValue() == "asset_57");
+    CFG_ASSERT(!eVar->setStringValue("asset_0") && !eVar->setIntValue(5));
+    CFG_ASSERT(sVar->setStringValue("asset_2000") && !sVar->setStringValue("asset_2001"));
+
+    // Completion only lists the values starting with the partial value, sorted.
+    std::string matches[16];
+    CFG_ASSERT(eVar->valueCompletion("asset_199", matches, 16) == 11);
+    CFG_ASSERT(matches[0] == "asset_199" && matches[1] == "asset_1990" && matches[10] == "asset_1999");
+    CFG_ASSERT(sVar->valueCompletion("asset_2", matches, 16) == 112);
+    CFG_ASSERT(matches[0] == "asset_2" && matches[1] == "asset_20");
+    CFG_ASSERT(sVar->valueCompletion("nope", matches, 16) == 0);
+    CFG_ASSERT(eVar->valueCompletion("", matches, 16) == count);
+
+    CFG_ASSERT(cvarManager->removeCVar(eVar) && cvarManager->removeCVar(sVar));
+}
+
+static void testMemoryStats(cfg::CVarManager * cvarManager)
+{
+    cfg::MemoryStats before;
+    if (!cfg::getMemoryStats(&before))
+    {
+        CFG_ASSERT(before.total.liveBytes == 0 && before.total.allocCount == 0);
+        return; // Library built without CFG_MEMORY_STATS.
+    }
+
+    const char * allowed[] = { "low", "medium", "high", nullptr };
+    cfg::CVar * cvar = cvarManager->registerCVarString("mem_var", "described", 0, "low", allowed);
+    CFG_ASSERT(cvar != nullptr);
+
+    cfg::MemoryStats after;
+    CFG_ASSERT(cfg::getMemoryStats(&after));
+    const int cvars   = static_cast<int>(cfg::MemoryCategory::CVars);
+    const int strings = static_cast<int>(cfg::MemoryCategory::Strings);
+    const int lists   = static_cast<int>(cfg::MemoryCategory::ValueLists);
+    CFG_ASSERT(after.categories[cvars].liveBytes   > before.categories[cvars].liveBytes);
+    CFG_ASSERT(after.categories[strings].liveBytes > before.categories[strings].liveBytes);
+    CFG_ASSERT(after.categories[lists].liveBytes   > before.categories[lists].liveBytes);
+    CFG_ASSERT(after.total.peakBytes >= after.total.liveBytes);
+
+    // Everything is given back on removal.
+    CFG_ASSERT(cvarManager->removeCVar(cvar));
+    CFG_ASSERT(cfg::getMemoryStats(&after));
+    CFG_ASSERT(after.categories[cvars].liveBytes   == before.categories[cvars].liveBytes);
+    CFG_ASSERT(after.categories[strings].liveBytes == before.categories[strings].liveBytes);
+    CFG_ASSERT(after.categories[lists].liveBytes   == before.categories[lists].liveBytes);
+    CFG_ASSERT(after.categories[cvars].freeCount   == before.categories[cvars].freeCount + 1);
+
+    cfg::resetMemoryPeaks();
+    CFG_ASSERT(cfg::getMemoryStats(&after) && after.total.peakBytes == after.total.liveBytes);
+    CFG_ASSERT(std::strcmp(cfg::getMemoryCategoryName(cfg::MemoryCategory::HashTables), "hash tables") == 0);
+}
+
+struct InlineCmdTarget
+{
+    int lastArgCount = -1;
+    void onFire(const cfg::CommandArgs & args) { lastArgCount = args.getArgCount(); }
+    int complete(const char *, std::string * outMatches, int maxMatches) const
+    {
+        if (maxMatches > 0) { *outMatches = "inline_arg"; }
+        return 1;
+    }
+};
+
+static void testInlineCommands(cfg::CommandManager * cmdManager)
+{
+    int fired = 0;
+    int * counter = &fired;
+
+    // Capturing lambda stored in place.
+    CFG_ASSERT(cmdManager->registerInlineCommand("inline_attack",
+               [counter](const cfg::CommandArgs &) { ++(*counter); }));
+
+    // Member function handler and completion.
+    InlineCmdTarget target;
+    CFG_ASSERT(cmdManager->registerInlineCommand("inline_member",
+               cfg::makeInlineCommandHandler(&target, &InlineCmdTarget::onFire),
+               cfg::makeInlineCommandArgCompletion(&target, &InlineCmdTarget::complete), "", 0, 0, 2));
+
+    // Null handler is rejected.
+    CFG_ASSERT(!cmdManager->registerInlineCommand("inline_null", nullptr));
+
+    cmdManager->execNow("inline_attack; inline_attack");
+    cmdManager->execNow("inline_member a b");
+    CFG_ASSERT(fired == 2);
+    CFG_ASSERT(target.lastArgCount == 2);
+
+    // Argument count validation still applies.
+    cmdManager->execNow("inline_member a b c");
+    CFG_ASSERT(target.lastArgCount == 2);
+
+    std::string match;
+    CFG_ASSERT(cmdManager->findCommand("inline_member")->argumentCompletion("in", &match, 1) == 1);
+    CFG_ASSERT(match == "inline_arg");
+    CFG_ASSERT(cmdManager->findCommand("inline_attack")->argumentCompletion("in", &match, 1) == 0);
+
+    CFG_ASSERT(cmdManager->removeCommand("inline_attack"));
+    CFG_ASSERT(cmdManager->removeCommand("inline_member"));
+}
+
+static void testExecConfigFiles(cfg::CVarManager * cvarManager, cfg::CommandManager * cmdManager)
+{
+    static std::string execLog;
+    static cfg::CVar * layer;
+    layer = cvarManager->registerCVarInt("cfg_layer", "", 0, -1, -1, 1000);
+    CFG_ASSERT(layer != nullptr);
+    cmdManager->registerCommand("log_files", [](const cfg::CommandArgs & args) { execLog += args[0]; });
+    cmdManager->registerCommand("set_layer", [](const cfg::CommandArgs & args) { layer->setStringValue(args[0]); });
+
+    // Every file overrides the CVar set by the one before it.
+    constexpr int FileCount = 24;
+    std::string names[FileCount];
+    const char * filenames[FileCount + 1];
+    std::string expectedLog;
+    for (int i = 0; i < FileCount; ++i)
+    {
+        names[i] = "test_files_" + std::to_string(i) + ".cfg";
+        filenames[i] = names[i].c_str();
+
+        FILE * file = std::fopen(filenames[i], "wt");
+        CFG_ASSERT(file != nullptr);
+        #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        std::fprintf(file, "# layer %i\nset_layer %i\nlog_files %c; log_files $(cfg_layer)\n", i, i, 'a' + i);
+        #else // !CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        std::fprintf(file, "# layer %i\nset_layer %i\nlog_files %c; log_files %i\n", i, i, 'a' + i, i);
+        #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+        std::fclose(file);
+        expectedLog += static_cast<char>('a' + i) + std::to_string(i);
+    }
+    filenames[FileCount] = "test_files_missing.cfg";
+
+    CFG_ASSERT(cmdManager->execConfigFiles(filenames, FileCount + 1, nullptr, 4) == FileCount);
+    CFG_ASSERT(execLog == expectedLog);
+    CFG_ASSERT(layer->getIntValue() == FileCount - 1);
+
+    // Same results as running them one by one.
+    execLog.clear();
+    for (int i = 0; i < FileCount; ++i)
+    {
+        CFG_ASSERT(cmdManager->execConfigFile(filenames[i], nullptr));
+        std::remove(filenames[i]);
+    }
+    CFG_ASSERT(execLog == expectedLog);
+
+    CFG_ASSERT(cmdManager->execConfigFiles(filenames, FileCount, nullptr) == 0);
+    CFG_ASSERT(cmdManager->removeCommand("log_files") && cmdManager->removeCommand("set_layer"));
+    CFG_ASSERT(cvarManager->removeCVar(layer));
+}
+
+#ifdef TEST_REMOTE_TERMINAL
+static void testRemoteTerminal(cfg::CVarManager * cvarManager, cfg::CommandManager * cmdManager)
+{
+    auto server = cfg::RemoteTerminalServer::createInstance(cmdManager, cvarManager);
+    if (server == nullptr)
+    {
+        return; // Not built with CFG_BUILD_REMOTE_TERMINAL.
+    }
+
+    const char * const socketPath = "test_remote.sock";
+    CFG_ASSERT(server->listenUnix(socketPath));
+
+    cmdManager->registerCommand("remote_cmd",
+            [server](const cfg::CommandArgs & args)
+            {
+                server->printF("remote_cmd ran with %i args\n", args.getArgCount());
+            });
+
+    int clients[2];
+    for (int & client : clients)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, socketPath);
+
+        client = socket(AF_UNIX, SOCK_STREAM, 0);
+        CFG_ASSERT(connect(client, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0);
+    }
+
+    const auto readClient = [server](const int client)
+    {
+        std::string received;
+        for (int i = 0; i < 20; ++i)
+        {
+            server->serve(1);
+            char buffer[4096];
+            ssize_t count;
+            while ((count = recv(client, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0)
+            {
+                received.append(buffer, count);
+            }
+        }
+        return received;
+    };
+
+    CFG_ASSERT(readClient(clients[0]).find("Session #") != std::string::npos);
+    CFG_ASSERT(readClient(clients[1]).find("Session #") != std::string::npos);
+    CFG_ASSERT(server->getSessionCount() == 2);
+
+    // Commands typed in a session go to the command buffer. Their output reaches all the sessions.
+    const char typed[] = "remote_cmd a b\r";
+    CFG_ASSERT(send(clients[0], typed, sizeof(typed) - 1, 0) == sizeof(typed) - 1);
+    const std::string echo = readClient(clients[0]);
+    CFG_ASSERT(echo.find("remote_cmd a b") != std::string::npos);
+    CFG_ASSERT(cmdManager->hasBufferedCommands());
+
+    cmdManager->execBufferedCommands();
+    CFG_ASSERT(readClient(clients[0]).find("remote_cmd ran with 2 args\r\n") != std::string::npos);
+    CFG_ASSERT(readClient(clients[1]).find("remote_cmd ran with 2 args\r\n") != std::string::npos);
+
+    // Clients that stop reading are dropped once too much output is waiting for them.
+    const std::string line(1023, '#');
+    for (int i = 0; i < 4096 && server->getSessionCount() > 0; ++i)
+    {
+        server->printLn(line.c_str());
+        server->serve(0);
+    }
+    CFG_ASSERT(server->getSessionCount() == 0);
+
+    close(clients[0]);
+    close(clients[1]);
+    CFG_ASSERT(cmdManager->removeCommand("remote_cmd"));
+    cfg::RemoteTerminalServer::destroyInstance(server);
+}
+#endif // TEST_REMOTE_TERMINAL
+
 int main()
 {
     auto cvarManager = cfg::CVarManager::createInstance();
@@ -148,6 +1757,39 @@ int main()
 
     addCVars(cvarManager);
     addCommands(cmdManager);
+    testCVarRefs(cvarManager);
+    testManyCVars(cvarManager);
+    testCommandArgs();
+    testCommandBuffer(cmdManager);
+    testCompiledConfig(cmdManager);
+    testMappedConfigFile(cmdManager);
+    testConfigSnapshot(cvarManager, cmdManager);
+    testConfigJournal(cvarManager, cmdManager);
+    testChangeListeners(cvarManager);
+    testMemoryArena();
+    testBulkRegistration(cvarManager);
+    testHashedNameLookups(cvarManager, cmdManager);
+    testStringValueAccess(cvarManager);
+    testNumberConversions(cvarManager);
+    #if CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    testAliasTemplates(cvarManager, cmdManager);
+    #endif // CFG_COMMAND_PERFORM_CVAR_SUBSTITUTION
+    testSubmitCommandText(cmdManager);
+    testExecTimeBudget(cmdManager);
+    testCommandProfiling(cmdManager);
+    testTerminalOutputBatching();
+    testCVarSnapshots(cvarManager, cmdManager);
+    #if CFG_THREAD_SAFE_CVARS
+    testThreadSafeCVars(cvarManager);
+    #endif // CFG_THREAD_SAFE_CVARS
+    testFlagIndexes(cvarManager, cmdManager);
+    testLargeValueLists(cvarManager);
+    testMemoryStats(cvarManager);
+    testInlineCommands(cmdManager);
+    testExecConfigFiles(cvarManager, cmdManager);
+    #ifdef TEST_REMOTE_TERMINAL
+    testRemoteTerminal(cvarManager, cmdManager);
+    #endif // TEST_REMOTE_TERMINAL
 
     // All CVars and Commands are deleted when the mangers are destroyed.
     cfg::CommandManager::destroyInstance(cmdManager);
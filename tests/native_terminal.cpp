@@ -40,7 +40,15 @@ int main(const int argc, const char * argv[])
 
         terminal->update();
 
-        if (terminal->hasInput())
+        // Sleep until there's some input instead of spinning. The timeout
+        // lets us pick up commands submitted from other threads sometimes.
+        if (!terminal->waitForInput(100))
+        {
+            continue;
+        }
+
+        // Take all the keys already typed or pasted, until they complete a command.
+        while (terminal->hasInput() && !cmdManager->hasBufferedCommands() && !terminal->exit())
         {
             const int keyCode = terminal->getInput();
 
@@ -0,0 +1,69 @@
+// ================================================================================================
+// -*- C++ -*-
+// File: remote_terminal.cpp
+// Author: Guilherme R. Lampert
+// Created on: 14/10/26
+// Brief: Minimal test application for the RemoteTerminalServer.
+// License: This source code is in the public domain.
+// ================================================================================================
+
+#include "cfg.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+//
+// Usage: cfg_remote_terminal [port] [unix-socket-path]
+//
+// Connect with: socat -,raw,echo=0 TCP:127.0.0.1:<port>
+// Or with:      socat -,raw,echo=0 UNIX-CONNECT:<unix-socket-path>
+//
+// Running "stopServer" from any session shuts the server down.
+//
+int main(const int argc, const char * argv[])
+{
+    using namespace cfg;
+
+    const int port = (argc > 1 ? std::atoi(argv[1]) : 4321);
+
+    auto cvarManager = CVarManager::createInstance();
+    auto cmdManager  = CommandManager::createInstance(0, cvarManager);
+    auto server      = RemoteTerminalServer::createInstance(cmdManager, cvarManager);
+
+    if (server == nullptr)
+    {
+        std::fprintf(stderr, "The RemoteTerminalServer is not available on this platform.\n");
+        return EXIT_FAILURE;
+    }
+
+    // The command output goes to all connected sessions.
+    registerDefaultCommands(cmdManager, server);
+
+    bool stopServer = false;
+    cmdManager->registerCommand("stopServer",
+            [&stopServer](const CommandArgs &)
+            {
+                stopServer = true;
+            },
+            nullptr, "Shuts down the remote terminal server.");
+
+    if (!server->listenTcp(port) || (argc > 2 && !server->listenUnix(argv[2])))
+    {
+        RemoteTerminalServer::destroyInstance(server);
+        return EXIT_FAILURE;
+    }
+    std::printf("Remote terminal listening on 127.0.0.1:%i\n", port);
+
+    while (!stopServer)
+    {
+        // Sleeps until a client needs attention or the timeout.
+        server->serve(100);
+        cmdManager->execBufferedCommands();
+    }
+
+    server->printLn("Server shutting down.");
+
+    // Destroys any registered CVars and Commands.
+    RemoteTerminalServer::destroyInstance(server);
+    CommandManager::destroyInstance(cmdManager);
+    CVarManager::destroyInstance(cvarManager);
+}